@@ -15,6 +15,7 @@
 #include <atomic>
 #include <chrono>  // NOLINT
 #include <cstdint>
+#include <string>
 
 /** Cycle detection is performed every CYCLE_DETECTION_INTERVAL milliseconds. */
 extern std::chrono::milliseconds cycle_detection_interval;
@@ -33,7 +34,10 @@ static constexpr int INVALID_LSN = -1;                                        //
 static constexpr int HEADER_PAGE_ID = 0;                                      // the header page id
 static constexpr int PAGE_SIZE = 4096;                                        // size of a data page in byte
 static constexpr int BUFFER_POOL_SIZE = 65536;                                // size of buffer pool
+static constexpr int BUFFER_POOL_INSTANCES = 16;                              // number of buffer pool partitions
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * PAGE_SIZE);  // size of a log buffer in byte
+static constexpr bool BUFFER_POOL_HUGE_PAGES = true;                          // back frame data with 2MB pages
+static constexpr bool BUFFER_POOL_NUMA_INTERLEAVE = true;                     // spread frame data over NUMA nodes
 static constexpr int BUCKET_SIZE = 50;                                        // size of extendible hash bucket
 
 using frame_id_t = int32_t;  // frame id type, 帧页ID, 页在BufferPool中的存储单元称为帧,一帧对应一页
@@ -48,4 +52,43 @@ using timestamp_t = int32_t;  // timestamp type, used for transaction concurrenc
 static const std::string LOG_FILE_NAME = "db.log";
 
 // replacer
-static const std::string REPLACER_TYPE = "LRU";
+static const std::string REPLACER_TYPE = "LRU";  // default policy: "LRU", "CLOCK", "ATOMIC-CLOCK" or "LRU-K"
+static constexpr size_t LRUK_REPLACER_K = 2;      // LRU-K ranks frames by their K-th most recent reference
+static constexpr size_t LRUK_CORRELATED_PERIOD = 8;  // re-references within this many accesses count as one
+
+// async io
+static constexpr unsigned IO_QUEUE_DEPTH = 128;  // max in-flight requests of the io_uring engine
+static constexpr size_t IO_WORKER_THREADS = 4;   // worker threads of the pread/pwrite fallback engine
+static constexpr int PREFETCH_WINDOW = 32;       // pages kept in flight by scan read-ahead, 0 disables it
+
+// direct io
+static constexpr bool DISK_DIRECT_IO = false;        // open data files with O_DIRECT, bypassing the OS page cache
+static constexpr size_t DIRECT_IO_ALIGNMENT = 4096;  // alignment of buffer, offset and length required by O_DIRECT
+
+// page cleaner
+static constexpr double PAGE_CLEANER_CLEAN_RATIO = 0.25;  // share of victim candidates the page cleaner keeps clean
+static constexpr int PAGE_CLEANER_INTERVAL_MS = 100;      // how often the page cleaner wakes up
+static constexpr int PAGE_CLEANER_MAX_RUN = 32;           // max adjacent pages coalesced into one write
+
+// index bulk load
+static constexpr bool IX_BULK_LOAD = true;                    // CREATE INDEX builds the tree bottom-up instead of row by row
+static constexpr double IX_BULK_LOAD_FILL_FACTOR = 0.9;       // share of each node filled by CREATE INDEX bulk load
+static constexpr size_t IX_BULK_LOAD_SORT_MEMORY = 64 << 20;  // bytes of (key, rid) sorted in memory before spilling
+static constexpr int IX_BULK_LOAD_WRITE_PAGES = 64;           // max adjacent nodes written by one request
+
+// index key compression
+static constexpr bool IX_COMPRESS_STRING_KEYS = true;  // CHAR(n) indexes store a per-node prefix and truncated keys
+
+// index upper levels
+static constexpr int IX_PINNED_LEVELS = 2;         // top internal levels of each B+tree kept pinned, 0 disables it
+static constexpr size_t IX_PINNED_MAX_PAGES = 64;  // max pinned pages per index, also capped at 1/16 of the buffer pool
+
+// query planning
+static constexpr double BITMAP_HEAP_SCAN_SELECTIVITY = 0.01;  // index ranges covering at least this share of entries fetch heap pages in rid order
+
+// query execution
+static constexpr size_t EXECUTION_BATCH_SIZE = 1024;         // tuples per NextBatch call between executors
+static constexpr size_t HASH_JOIN_MEMORY_BUDGET = 64 << 20;  // bytes of build tuples a hash join keeps in memory before spilling
+static constexpr int HASH_JOIN_PARTITIONS = 16;              // partitions per spill pass of a hash join
+static constexpr size_t SORT_MEMORY_BUDGET = 64 << 20;       // bytes of tuples an external sort keeps in memory per run
+static constexpr int SPILL_FILE_BLOCK_PAGES = 16;            // pages per I/O of a spill file (sort runs, hash join partitions)
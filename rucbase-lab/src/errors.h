@@ -3,6 +3,7 @@
 #include <cerrno>
 #include <cstring>
 #include <string>
+#include <vector>
 
 class RedBaseError : public std::exception {
     std::string _msg;
@@ -93,16 +94,36 @@ class ColumnNotFoundError : public RedBaseError {
     ColumnNotFoundError(const std::string &col_name) : RedBaseError("Column not found: " + col_name) {}
 };
 
+/**
+ * @brief 错误信息中索引的列名: 单列索引为".a", 多列索引为"(a, b)"
+ */
+inline std::string index_cols_str(const std::vector<std::string> &col_names) {
+    if (col_names.size() == 1) {
+        return '.' + col_names[0];
+    }
+    std::string str = "(";
+    for (size_t i = 0; i < col_names.size(); i++) {
+        str += (i > 0 ? ", " : "") + col_names[i];
+    }
+    return str + ')';
+}
+
 class IndexNotFoundError : public RedBaseError {
    public:
     IndexNotFoundError(const std::string &tab_name, const std::string &col_name)
         : RedBaseError("Index not found: " + tab_name + '.' + col_name) {}
+
+    IndexNotFoundError(const std::string &tab_name, const std::vector<std::string> &col_names)
+        : RedBaseError("Index not found: " + tab_name + index_cols_str(col_names)) {}
 };
 
 class IndexExistsError : public RedBaseError {
    public:
     IndexExistsError(const std::string &tab_name, const std::string &col_name)
         : RedBaseError("Index already exists: " + tab_name + '.' + col_name) {}
+
+    IndexExistsError(const std::string &tab_name, const std::vector<std::string> &col_names)
+        : RedBaseError("Index already exists: " + tab_name + index_cols_str(col_names)) {}
 };
 
 // QL errors
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "errors.h"
+#include "execution_manager.h"
+
+/**
+ * @brief 在编译时确定比较运算符的比较, a与b的关系同ix_compare(a, b)的结果与0的关系
+ */
+template <CompOp op, typename T>
+inline bool compare_op(const T &a, const T &b) {
+    if constexpr (op == OP_EQ) {
+        return a == b;
+    } else if constexpr (op == OP_NE) {
+        return a != b;
+    } else if constexpr (op == OP_LT) {
+        return a < b;
+    } else if constexpr (op == OP_GT) {
+        return a > b;
+    } else if constexpr (op == OP_LE) {
+        return a <= b;
+    } else {
+        return a >= b;
+    }
+}
+
+/**
+ * @brief 编译后的谓词: 把一组合取的Condition编译成按列类型、比较运算符和右边是常量还是列特化的比较函数.
+ * 列在记录中的位置在编译时从ColMeta中解析出来, 常量复制到谓词内部, 判断每条记录时不再按表名和列名查找列,
+ * 也不再按类型和运算符分支. 条件改变(如连接时feed了新的值)后需要重新编译
+ */
+class CompiledPredicate {
+   private:
+    struct Term;
+    using EvalFn = bool (*)(const Term &term, const char *rec);
+
+    struct Term {
+        EvalFn eval;
+        ColType type;
+        int lhs_offset;
+        int lhs_len;
+        int rhs_offset;       // 右边是列时该列在记录中的位置
+        int rhs_len;
+        int int_val;          // 右边是常量时的值, 按列类型使用其中一个
+        float float_val;
+        std::string str_val;  // CHAR常量, 按左边的列长补齐'\0'
+    };
+
+    std::vector<Term> terms_;  // 数值比较在前, 字符串比较在后, 尽早排除不满足的记录
+
+   public:
+    /** 没有条件的谓词, 所有记录都满足 */
+    CompiledPredicate() = default;
+
+    /**
+     * @param cols 记录的各列, 条件中的列按表名和列名在其中查找
+     * @param conds 合取的条件, 左边是cols中的列, 右边是常量或cols中的列
+     */
+    CompiledPredicate(const std::vector<ColMeta> &cols, const std::vector<Condition> &conds) {
+        for (auto &cond : conds) {
+            auto &lhs_col = find_col(cols, cond.lhs_col);
+            Term term{};
+            term.type = lhs_col.type;
+            term.lhs_offset = lhs_col.offset;
+            term.lhs_len = lhs_col.len;
+            if (cond.is_rhs_val) {
+                assert(cond.rhs_val.type == lhs_col.type);  // TODO convert to common type
+                const RmRecord &raw = *cond.rhs_val.raw;
+                if (lhs_col.type == TYPE_INT) {
+                    memcpy(&term.int_val, raw.data, sizeof(int));
+                } else if (lhs_col.type == TYPE_FLOAT) {
+                    memcpy(&term.float_val, raw.data, sizeof(float));
+                } else {
+                    term.str_val.assign(lhs_col.len, '\0');
+                    memcpy(term.str_val.data(), raw.data, std::min(raw.size, lhs_col.len));
+                }
+            } else {
+                auto &rhs_col = find_col(cols, cond.rhs_col);
+                assert(rhs_col.type == lhs_col.type);
+                term.rhs_offset = rhs_col.offset;
+                term.rhs_len = rhs_col.len;
+            }
+            term.eval = select(lhs_col.type, cond.op, cond.is_rhs_val);
+            terms_.push_back(std::move(term));
+        }
+        std::stable_partition(terms_.begin(), terms_.end(),
+                              [](const Term &term) { return term.type != TYPE_STRING; });
+    }
+
+    bool empty() const { return terms_.empty(); }
+
+    /** @return rec是否满足所有条件 */
+    bool eval(const char *rec) const {
+        for (auto &term : terms_) {
+            if (!term.eval(term, rec)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+   private:
+    static const ColMeta &find_col(const std::vector<ColMeta> &cols, const TabCol &target) {
+        auto pos = std::find_if(cols.begin(), cols.end(), [&](const ColMeta &col) {
+            return col.tab_name == target.tab_name && col.name == target.col_name;
+        });
+        if (pos == cols.end()) {
+            throw ColumnNotFoundError(target.tab_name + '.' + target.col_name);
+        }
+        return *pos;
+    }
+
+    template <typename T>
+    static T load(const char *p) {
+        T val;
+        memcpy(&val, p, sizeof(T));
+        return val;
+    }
+
+    template <CompOp op>
+    static bool int_val(const Term &term, const char *rec) {
+        return compare_op<op>(load<int>(rec + term.lhs_offset), term.int_val);
+    }
+
+    template <CompOp op>
+    static bool int_col(const Term &term, const char *rec) {
+        return compare_op<op>(load<int>(rec + term.lhs_offset), load<int>(rec + term.rhs_offset));
+    }
+
+    template <CompOp op>
+    static bool float_val(const Term &term, const char *rec) {
+        return compare_op<op>(load<float>(rec + term.lhs_offset), term.float_val);
+    }
+
+    template <CompOp op>
+    static bool float_col(const Term &term, const char *rec) {
+        return compare_op<op>(load<float>(rec + term.lhs_offset), load<float>(rec + term.rhs_offset));
+    }
+
+    template <CompOp op>
+    static bool str_val(const Term &term, const char *rec) {
+        return compare_op<op>(memcmp(rec + term.lhs_offset, term.str_val.data(), term.lhs_len), 0);
+    }
+
+    /** 两列CHAR的长度不同时, 较短的一边视为用'\0'补齐 */
+    template <CompOp op>
+    static bool str_col(const Term &term, const char *rec) {
+        const char *a = rec + term.lhs_offset;
+        const char *b = rec + term.rhs_offset;
+        int len = std::min(term.lhs_len, term.rhs_len);
+        int cmp = memcmp(a, b, len);
+        if (cmp == 0 && term.lhs_len != term.rhs_len) {
+            auto nonzero = [](char c) { return c != 0; };
+            if (std::any_of(a + len, a + term.lhs_len, nonzero)) {
+                cmp = 1;
+            } else if (std::any_of(b + len, b + term.rhs_len, nonzero)) {
+                cmp = -1;
+            }
+        }
+        return compare_op<op>(cmp, 0);
+    }
+
+    template <CompOp op>
+    static EvalFn select(ColType type, bool is_rhs_val) {
+        switch (type) {
+            case TYPE_INT:
+                return is_rhs_val ? int_val<op> : int_col<op>;
+            case TYPE_FLOAT:
+                return is_rhs_val ? float_val<op> : float_col<op>;
+            case TYPE_STRING:
+                return is_rhs_val ? str_val<op> : str_col<op>;
+            default:
+                throw InternalError("Unexpected data type");
+        }
+    }
+
+    static EvalFn select(ColType type, CompOp op, bool is_rhs_val) {
+        switch (op) {
+            case OP_EQ:
+                return select<OP_EQ>(type, is_rhs_val);
+            case OP_NE:
+                return select<OP_NE>(type, is_rhs_val);
+            case OP_LT:
+                return select<OP_LT>(type, is_rhs_val);
+            case OP_GT:
+                return select<OP_GT>(type, is_rhs_val);
+            case OP_LE:
+                return select<OP_LE>(type, is_rhs_val);
+            case OP_GE:
+                return select<OP_GE>(type, is_rhs_val);
+            default:
+                throw InternalError("Unexpected op type");
+        }
+    }
+};
@@ -0,0 +1,185 @@
+#undef NDEBUG
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "compiled_predicate.h"
+#include "gtest/gtest.h"
+#include "index/ix.h"
+
+/**
+ * @brief 原来扫描算子中的eval_cond: 每次判断都按名字查找列, 再按类型和运算符比较, 作为正确性和性能的参照
+ */
+static bool ReferenceEval(const std::vector<ColMeta> &cols, const std::vector<Condition> &conds, const char *rec) {
+    auto get_col = [&](const TabCol &target) {
+        return std::find_if(cols.begin(), cols.end(), [&](const ColMeta &col) {
+            return col.tab_name == target.tab_name && col.name == target.col_name;
+        });
+    };
+    for (auto &cond : conds) {
+        auto lhs_col = get_col(cond.lhs_col);
+        const char *lhs = rec + lhs_col->offset;
+        const char *rhs = cond.is_rhs_val ? cond.rhs_val.raw->data : rec + get_col(cond.rhs_col)->offset;
+        int cmp = ix_compare(lhs, rhs, lhs_col->type, lhs_col->len);
+        bool ok = cond.op == OP_EQ   ? cmp == 0
+                  : cond.op == OP_NE ? cmp != 0
+                  : cond.op == OP_LT ? cmp < 0
+                  : cond.op == OP_GT ? cmp > 0
+                  : cond.op == OP_LE ? cmp <= 0
+                                     : cmp >= 0;
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief t(a int, b float, c char(8), d int, e float, f char(8))的记录, 取值范围较小, 使各种比较都有真有假
+ */
+class CompiledPredicateTest : public ::testing::Test {
+   public:
+    std::vector<ColMeta> cols_;
+    int len_ = 0;
+    std::mt19937 rng_{0};
+
+   public:
+    void SetUp() override {
+        ::testing::Test::SetUp();
+        std::vector<std::pair<std::string, ColType>> defs = {{"a", TYPE_INT},    {"b", TYPE_FLOAT},
+                                                             {"c", TYPE_STRING}, {"d", TYPE_INT},
+                                                             {"e", TYPE_FLOAT},  {"f", TYPE_STRING}};
+        for (auto &[name, type] : defs) {
+            ColMeta col = {.tab_name = "t", .name = name, .type = type, .len = type == TYPE_STRING ? 8 : 4,
+                           .offset = len_, .index = false};
+            len_ += col.len;
+            cols_.push_back(col);
+        }
+    }
+
+    /** @brief 按列的类型生成一个随机值, 写入buf */
+    void random_value(const ColMeta &col, char *buf) {
+        if (col.type == TYPE_INT) {
+            int val = static_cast<int>(rng_() % 16) - 8;
+            memcpy(buf, &val, sizeof(int));
+        } else if (col.type == TYPE_FLOAT) {
+            float val = static_cast<float>(static_cast<int>(rng_() % 16) - 8) / 2;
+            memcpy(buf, &val, sizeof(float));
+        } else {
+            memset(buf, 0, col.len);
+            int n = static_cast<int>(rng_() % col.len);
+            for (int i = 0; i < n; i++) {
+                buf[i] = static_cast<char>('a' + rng_() % 3);
+            }
+        }
+    }
+
+    std::vector<char> random_records(int num_recs) {
+        std::vector<char> recs(static_cast<size_t>(num_recs) * len_);
+        for (int i = 0; i < num_recs; i++) {
+            for (auto &col : cols_) {
+                random_value(col, &recs[static_cast<size_t>(i) * len_ + col.offset]);
+            }
+        }
+        return recs;
+    }
+
+    /** @brief 随机生成num_conds个条件, 右边是常量或同类型的另一列 */
+    std::vector<Condition> random_conds(int num_conds) {
+        std::vector<Condition> conds;
+        for (int i = 0; i < num_conds; i++) {
+            auto &lhs = cols_[rng_() % cols_.size()];
+            Condition cond;
+            cond.lhs_col = {.tab_name = lhs.tab_name, .col_name = lhs.name};
+            cond.op = static_cast<CompOp>(rng_() % 6);
+            cond.is_rhs_val = rng_() % 2 == 0;
+            if (cond.is_rhs_val) {
+                cond.rhs_val.type = lhs.type;
+                cond.rhs_val.raw = std::make_shared<RmRecord>(lhs.len);
+                random_value(lhs, cond.rhs_val.raw->data);
+            } else {
+                auto &rhs = cols_[(&lhs - cols_.data() + 3) % cols_.size()];  // 同类型的另一列
+                cond.rhs_col = {.tab_name = rhs.tab_name, .col_name = rhs.name};
+            }
+            conds.push_back(cond);
+        }
+        return conds;
+    }
+};
+
+// 随机的条件组合在随机的记录上, 编译后的结果与逐条解释的结果相同
+TEST_F(CompiledPredicateTest, MatchesReference) {
+    const int num_recs = 2000;
+    auto recs = random_records(num_recs);
+    for (int round = 0; round < 200; round++) {
+        auto conds = random_conds(1 + round % 4);
+        CompiledPredicate pred(cols_, conds);
+        for (int i = 0; i < num_recs; i++) {
+            const char *rec = &recs[static_cast<size_t>(i) * len_];
+            ASSERT_EQ(pred.eval(rec), ReferenceEval(cols_, conds, rec)) << "round " << round << " record " << i;
+        }
+    }
+    // 没有条件时所有记录都满足
+    EXPECT_TRUE(CompiledPredicate().eval(recs.data()));
+    EXPECT_TRUE(CompiledPredicate(cols_, {}).empty());
+    // 条件中的列不存在
+    Condition cond;
+    cond.lhs_col = {.tab_name = "t", .col_name = "z"};
+    cond.op = OP_EQ;
+    cond.is_rhs_val = false;
+    cond.rhs_col = {.tab_name = "t", .col_name = "a"};
+    EXPECT_THROW(CompiledPredicate(cols_, {cond}), ColumnNotFoundError);
+}
+
+// 在记录上判断多个大多为真的条件, 比较逐条解释和编译后的每条记录耗时
+TEST_F(CompiledPredicateTest, PredicateBenchmark) {
+    const int num_recs = 1 << 18;
+    const int rounds = 8;
+    auto recs = random_records(num_recs);
+    auto value_cond = [&](const std::string &col_name, CompOp op, ColType type, const void *val, int len) {
+        Condition cond;
+        cond.lhs_col = {.tab_name = "t", .col_name = col_name};
+        cond.op = op;
+        cond.is_rhs_val = true;
+        cond.rhs_val.type = type;
+        cond.rhs_val.raw = std::make_shared<RmRecord>(len);
+        memset(cond.rhs_val.raw->data, 0, len);
+        memcpy(cond.rhs_val.raw->data, val, std::min(len, static_cast<int>(sizeof(int))));
+        return cond;
+    };
+    int lo = -8, hi = 7;
+    float flo = -4.5f;
+    char str[4] = "zz";
+    std::vector<Condition> conds = {
+        value_cond("a", OP_GE, TYPE_INT, &lo, 4),    value_cond("d", OP_LE, TYPE_INT, &hi, 4),
+        value_cond("b", OP_GT, TYPE_FLOAT, &flo, 4), value_cond("e", OP_NE, TYPE_FLOAT, &flo, 4),
+        value_cond("c", OP_LT, TYPE_STRING, str, 8), value_cond("f", OP_NE, TYPE_STRING, str, 8),
+    };
+    // 返回每条记录的平均纳秒数, 满足条件的记录数存入matched
+    auto measure = [&](const std::function<bool(const char *)> &eval, size_t *matched) {
+        *matched = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; r++) {
+            for (int i = 0; i < num_recs; i++) {
+                *matched += eval(&recs[static_cast<size_t>(i) * len_]);
+            }
+        }
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / (static_cast<double>(num_recs) * rounds);
+    };
+    size_t expected = 0, matched = 0;
+    double reference_ns = measure([&](const char *rec) { return ReferenceEval(cols_, conds, rec); }, &expected);
+    CompiledPredicate pred(cols_, conds);
+    double compiled_ns = measure([&](const char *rec) { return pred.eval(rec); }, &matched);
+    EXPECT_EQ(matched, expected);
+    EXPECT_GT(expected, 0u);
+    printf("%-12s %12s\n", "mode", "ns/record");
+    printf("%-12s %10.1fns\n", "interpreted", reference_ns);
+    printf("%-12s %10.1fns\n", "compiled", compiled_ns);
+}
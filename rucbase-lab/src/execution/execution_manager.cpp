@@ -1,11 +1,16 @@
 #include "execution_manager.h"
 
+#include "executor_bitmap_heap_scan.h"
 #include "executor_delete.h"
+#include "executor_hash_join.h"
+#include "executor_index_only_scan.h"
 #include "executor_index_scan.h"
 #include "executor_insert.h"
 #include "executor_nestedloop_join.h"
 #include "executor_projection.h"
 #include "executor_seq_scan.h"
+#include "executor_sort.h"
+#include "executor_sort_merge_join.h"
 #include "executor_update.h"
 #include "index/ix.h"
 #include "record_printer.h"
@@ -76,21 +81,84 @@ std::vector<Condition> QlManager::check_where_clause(const std::vector<std::stri
     return res_conds;
 }
 
-int QlManager::get_indexNo(std::string tab_name, std::vector<Condition> curr_conds) {
-    int index_no = -1;
+/**
+ * @brief 为表上的条件选择扫描使用的索引
+ * 索引从第一列开始连续的等值条件越多越好, 等值前缀相同时, 前缀后的下一列有范围条件的更好;
+ * 一个条件也用不上的索引不选
+ *
+ * @return 选中的索引, 没有可用的索引时返回nullptr
+ */
+const IndexMeta *QlManager::get_index(std::string tab_name, std::vector<Condition> curr_conds) {
     TabMeta &tab = sm_manager_->db_.get_table(tab_name);
-    for (auto &cond : curr_conds) {
-        if (cond.is_rhs_val && cond.op != OP_NE) {
-            // If rhs is value and op is not "!=", find if lhs has index
-            auto lhs_col = tab.get_col(cond.lhs_col.col_name);
-            if (lhs_col->index) {
-                // This column has index, use it
-                index_no = lhs_col - tab.cols.begin();
-                break;
-            }
+    const IndexMeta *best_index = nullptr;
+    size_t best_num_eq = 0;
+    bool best_range = false;
+    for (auto &index : tab.indexes) {
+        // If rhs is value and op is not "!=", find if lhs is an index column
+        auto has_cond = [&](int col_idx, bool eq) {
+            return std::any_of(curr_conds.begin(), curr_conds.end(), [&](const Condition &cond) {
+                return cond.is_rhs_val && cond.op != OP_NE && (cond.op == OP_EQ) == eq &&
+                       cond.lhs_col.tab_name == tab_name && cond.lhs_col.col_name == tab.cols[col_idx].name;
+            });
+        };
+        size_t num_eq = 0;
+        while (num_eq < index.col_idxs.size() && has_cond(index.col_idxs[num_eq], true)) {
+            num_eq++;
+        }
+        bool range = num_eq < index.col_idxs.size() && has_cond(index.col_idxs[num_eq], false);
+        if (num_eq == 0 && !range) {
+            continue;
+        }
+        if (best_index == nullptr || num_eq > best_num_eq || (num_eq == best_num_eq && range && !best_range)) {
+            best_index = &index;
+            best_num_eq = num_eq;
+            best_range = range;
         }
     }
-    return index_no;
+    return best_index;
+}
+
+/**
+ * @brief 索引是否覆盖查询在表tab_name上用到的所有列: 投影的列, 以及所有条件(包括连接条件)中属于这个表的列
+ */
+bool QlManager::is_covering_index(const std::string &tab_name, const IndexMeta &index,
+                                  const std::vector<TabCol> &sel_cols, const std::vector<Condition> &conds) {
+    TabMeta &tab = sm_manager_->db_.get_table(tab_name);
+    auto covered = [&](const TabCol &col) {
+        return col.tab_name != tab_name ||
+               std::any_of(index.col_idxs.begin(), index.col_idxs.end(),
+                           [&](int col_idx) { return tab.cols[col_idx].name == col.col_name; });
+    };
+    return std::all_of(sel_cols.begin(), sel_cols.end(), covered) &&
+           std::all_of(conds.begin(), conds.end(), [&](const Condition &cond) {
+               return covered(cond.lhs_col) && (cond.is_rhs_val || covered(cond.rhs_col));
+           });
+}
+
+/**
+ * @brief 选择可以代替排序的索引: 索引的前几列依次是order_cols(都是升序), 并且覆盖查询用到的本表的列.
+ * 扫描整个覆盖索引就能按顺序得到元组; 不覆盖的索引要按key的顺序随机读取记录, 不如顺序扫描后排序, 不选
+ *
+ * @return 选中的索引, 没有可用的索引时返回nullptr
+ */
+const IndexMeta *QlManager::get_order_index(const std::string &tab_name, const std::vector<OrderByCol> &order_cols,
+                                            const std::vector<TabCol> &sel_cols, const std::vector<Condition> &conds) {
+    TabMeta &tab = sm_manager_->db_.get_table(tab_name);
+    for (auto &index : tab.indexes) {
+        if (index.col_idxs.size() < order_cols.size()) {
+            continue;
+        }
+        bool ordered = true;
+        for (size_t i = 0; i < order_cols.size(); i++) {
+            auto &order_col = order_cols[i];
+            ordered = ordered && !order_col.desc && order_col.col.tab_name == tab_name &&
+                      order_col.col.col_name == tab.cols[index.col_idxs[i]].name;
+        }
+        if (ordered && is_covering_index(tab_name, index, sel_cols, conds)) {
+            return &index;
+        }
+    }
+    return nullptr;
 }
 
 void QlManager::insert_into(const std::string &tab_name, std::vector<Value> values, Context *context) {
@@ -110,12 +178,12 @@ void QlManager::delete_from(const std::string &tab_name, std::vector<Condition>
     // make scan executor
     std::unique_ptr<AbstractExecutor> scanExecutor;
     // lab3 task3 Todo
-    // 根据get_indexNo判断conds上有无索引
+    // 根据get_index判断conds上有无索引
     // 创建合适的scan executor(有索引优先用索引)
     // lab3 task3 Todo end
-	int index_no = get_indexNo(tab_name, conds);
-    if(index_no != -1) // 有索引
-        scanExecutor = std::make_unique<IndexScanExecutor>(sm_manager_, tab_name, conds, index_no, context); 
+	const IndexMeta *index = get_index(tab_name, conds);
+    if(index != nullptr) // 有索引
+        scanExecutor = std::make_unique<IndexScanExecutor>(sm_manager_, tab_name, conds, *index, context); 
     else 
         scanExecutor = std::make_unique<SeqScanExecutor>(sm_manager_, tab_name, conds, context);
 
@@ -157,9 +225,9 @@ void QlManager::update_set(const std::string &tab_name, std::vector<SetClause> s
 
 	//create scanExecutor with index or not
 	std::unique_ptr<AbstractExecutor> scanExecutor;
-    int index_no = get_indexNo(tab_name, conds);
-    if(index_no != -1) // 有索引
-        scanExecutor = std::make_unique<IndexScanExecutor>(sm_manager_, tab_name, conds, index_no, context); 
+    const IndexMeta *index = get_index(tab_name, conds);
+    if(index != nullptr) // 有索引
+        scanExecutor = std::make_unique<IndexScanExecutor>(sm_manager_, tab_name, conds, *index, context); 
     else 
         scanExecutor = std::make_unique<SeqScanExecutor>(sm_manager_, tab_name, conds, context);
 	//rid -> rids
@@ -196,15 +264,42 @@ std::vector<Condition> pop_conds(std::vector<Condition> &conds, const std::vecto
     return solved_conds;
 }
 
+/**
+ * @brief 取出tab_name与其他表之间的连接条件, 交给哈希连接
+ *
+ * @return 连接条件; 其中没有等值条件时不能使用哈希连接, 不取出任何条件, 返回空
+ */
+std::vector<Condition> pop_join_conds(std::vector<Condition> &conds, const std::string &tab_name) {
+    auto is_join_cond = [&](const Condition &cond) {
+        return !cond.is_rhs_val && (cond.lhs_col.tab_name == tab_name) != (cond.rhs_col.tab_name == tab_name);
+    };
+    if (std::none_of(conds.begin(), conds.end(),
+                     [&](const Condition &cond) { return is_join_cond(cond) && cond.op == OP_EQ; })) {
+        return {};
+    }
+    std::vector<Condition> join_conds;
+    auto it = conds.begin();
+    while (it != conds.end()) {
+        if (is_join_cond(*it)) {
+            join_conds.emplace_back(std::move(*it));
+            it = conds.erase(it);
+        } else {
+            it++;
+        }
+    }
+    return join_conds;
+}
+
 /**
  * @brief select plan 生成
  *
  * @param sel_cols select plan 选取的列
  * @param tab_names select plan 目标的表
  * @param conds select plan 选取条件
+ * @param order_cols ORDER BY的各列, 为空时不排序
  */
 void QlManager::select_from(std::vector<TabCol> sel_cols, const std::vector<std::string> &tab_names,
-                            std::vector<Condition> conds, Context *context) {
+                            std::vector<Condition> conds, std::vector<OrderByCol> order_cols, Context *context) {
     // Parse selector
     auto all_cols = get_all_cols(tab_names);
     if (sel_cols.empty()) {
@@ -219,35 +314,103 @@ void QlManager::select_from(std::vector<TabCol> sel_cols, const std::vector<std:
             sel_col = check_column(all_cols, sel_col);  //列元数据校验
         }
     }
+    // 投影和排序用到的列, 判断覆盖索引时使用
+    std::vector<TabCol> used_cols = sel_cols;
+    for (auto &order_col : order_cols) {
+        order_col.col = check_column(all_cols, order_col.col);
+        used_cols.push_back(order_col.col);
+    }
     // Parse where clause
     conds = check_where_clause(tab_names, conds);
+    const std::vector<Condition> all_conds = conds;  // 判断覆盖索引时需要其他表上引用本表列的连接条件
     // Scan table , 生成表算子列表tab_nodes
     std::vector<std::unique_ptr<AbstractExecutor>> table_scan_executors(tab_names.size());
+    std::vector<std::vector<Condition>> join_conds(tab_names.size());  // 与前面的表哈希连接或归并连接时的连接条件
+    std::vector<std::vector<Condition>> scan_conds(tab_names.size());  // 扫描算子上的条件
     for (size_t i = 0; i < tab_names.size(); i++) {
         auto curr_conds = pop_conds(conds, {tab_names.begin(), tab_names.begin() + i + 1});
-        int index_no = get_indexNo(tab_names[i], curr_conds);
+        if (i > 0) {
+            join_conds[i] = pop_join_conds(curr_conds, tab_names[i]);
+        }
+        scan_conds[i] = curr_conds;
+        const IndexMeta *index = get_index(tab_names[i], curr_conds);
         // lab3 task2 Todo
-        // 根据get_indexNo判断conds上有无索引
+        // 根据get_index判断conds上有无索引
         // 创建合适的scan executor(有索引优先用索引)存入table_scan_executors
         // lab3 task2 Todo end
-		if(index_no != -1){ //have index
-			table_scan_executors[i] = std::make_unique<IndexScanExecutor>(sm_manager_, tab_names[i], curr_conds, index_no, context);
+		if(index != nullptr && is_covering_index(tab_names[i], *index, used_cols, all_conds)){ // 不需要读取记录
+			table_scan_executors[i] = std::make_unique<IndexOnlyScanExecutor>(sm_manager_, tab_names[i], curr_conds, *index, context);
+		}else if(index != nullptr){ //have index
+			auto index_scan = std::make_unique<IndexScanExecutor>(sm_manager_, tab_names[i], curr_conds, *index, context);
+			// 范围很小时逐条读取记录; 范围较大时先收集rid排序, 每个记录页面只读一次
+			if(index_scan->estimate_selectivity() >= BITMAP_HEAP_SCAN_SELECTIVITY){
+				table_scan_executors[i] = std::make_unique<BitmapHeapScanExecutor>(sm_manager_, tab_names[i], curr_conds, *index, context);
+			}else{
+				table_scan_executors[i] = std::move(index_scan);
+			}
 		}else{//no index, search in order
 			table_scan_executors[i] = std::make_unique<SeqScanExecutor>(sm_manager_, tab_names[i], curr_conds, context);
 		}
     }
     assert(conds.empty());
 
-    std::unique_ptr<AbstractExecutor> executorTreeRoot = std::move(table_scan_executors.back());
+    std::unique_ptr<AbstractExecutor> executorTreeRoot = std::move(table_scan_executors.front());
 
     // lab3 task2 Todo
     // 构建算子二叉树
     // 逆序遍历tab_nodes为左节点, 现query_plan为右节点,生成joinNode作为新query_plan 根节点
     // 生成query_plan tree完毕后, 根节点转换成投影算子
     // lab3 task2 Todo End
-	for(int i = tab_names.size()-2; i >=0; --i){
-		executorTreeRoot = std::make_unique<NestedLoopJoinExecutor>(std::move(table_scan_executors[i]),std::move(executorTreeRoot));
-	} 
+	// 让第i个表上的扫描scan按order有序: 已经有序时不变; 是顺序扫描并且有可用的覆盖索引时, apply为true则换成
+	// 扫描整个索引. 左深树中只有第一个表的扫描会作为左孩子, 其他情况下scan是连接算子, 只检查它的顺序
+	auto order_scan = [&](std::unique_ptr<AbstractExecutor> &scan, size_t i, const std::vector<OrderByCol> &order,
+	                      bool apply) {
+		if(has_order_prefix(scan->sorted_by(), order)){
+			return true;
+		}
+		if(dynamic_cast<SeqScanExecutor *>(scan.get()) == nullptr){
+			return false;
+		}
+		const IndexMeta *index = get_order_index(tab_names[i], order, used_cols, all_conds);
+		if(index != nullptr && apply){
+			scan = std::make_unique<IndexOnlyScanExecutor>(sm_manager_, tab_names[i], scan_conds[i], *index, context);
+		}
+		return index != nullptr;
+	};
+	// 左深树: 前面所有表的连接结果作为左孩子(外层), 第i个表作为右孩子. 与前面的表之间有等值连接条件时, 两边已经
+	// 按某个等值连接列有序(如索引扫描)则用归并连接, 否则用哈希连接; 没有等值连接条件时用嵌套循环连接, 由左孩子的
+	// 每个元组feed右孩子的扫描条件. 哈希连接(不溢出时)和嵌套循环连接的结果按左孩子的顺序排列, 归并连接按连接列排列
+	for(size_t i = 1; i < tab_names.size(); ++i){
+		if(join_conds[i].empty()){
+			executorTreeRoot = std::make_unique<NestedLoopJoinExecutor>(std::move(executorTreeRoot), std::move(table_scan_executors[i]));
+			continue;
+		}
+		bool merge = std::any_of(join_conds[i].begin(), join_conds[i].end(), [&](const Condition &cond) {
+			if(cond.op != OP_EQ){
+				return false;
+			}
+			bool lhs_right = cond.lhs_col.tab_name == tab_names[i];
+			std::vector<OrderByCol> left_order = {{.col = lhs_right ? cond.rhs_col : cond.lhs_col, .desc = false}};
+			std::vector<OrderByCol> right_order = {{.col = lhs_right ? cond.lhs_col : cond.rhs_col, .desc = false}};
+			if(!order_scan(executorTreeRoot, 0, left_order, false) || !order_scan(table_scan_executors[i], i, right_order, false)){
+				return false;
+			}
+			order_scan(executorTreeRoot, 0, left_order, true);
+			order_scan(table_scan_executors[i], i, right_order, true);
+			return true;
+		});
+		if(merge){
+			executorTreeRoot = std::make_unique<SortMergeJoinExecutor>(std::move(executorTreeRoot), std::move(table_scan_executors[i]),
+			                                                           join_conds[i], sm_manager_->get_disk_manager());
+		}else{
+			executorTreeRoot = std::make_unique<HashJoinExecutor>(std::move(executorTreeRoot), std::move(table_scan_executors[i]),
+			                                                      join_conds[i], sm_manager_->get_disk_manager());
+		}
+	}
+	// ORDER BY: 连接树已经按要求的顺序输出, 或者单表查询可以换成扫描覆盖索引时不需要排序
+	if(!order_cols.empty() && !order_scan(executorTreeRoot, 0, order_cols, true)){
+		executorTreeRoot = std::make_unique<SortExecutor>(std::move(executorTreeRoot), order_cols, sm_manager_->get_disk_manager());
+	}
 	executorTreeRoot = std::make_unique<ProjectionExecutor>(std::move(executorTreeRoot), sel_cols);
     // Column titles
     std::vector<std::string> captions;
@@ -262,25 +425,29 @@ void QlManager::select_from(std::vector<TabCol> sel_cols, const std::vector<std:
     rec_printer.print_separator(context);
     // Print records
     size_t num_rec = 0;
-    // 执行query_plan
-    for (executorTreeRoot->beginTuple(); !executorTreeRoot->is_end(); executorTreeRoot->nextTuple()) {
-        auto Tuple = executorTreeRoot->Next();
-        std::vector<std::string> columns;
-        for (auto &col : executorTreeRoot->cols()) {
-            std::string col_str;
-            char *rec_buf = Tuple->data + col.offset;
-            if (col.type == TYPE_INT) {
-                col_str = std::to_string(*(int *)rec_buf);
-            } else if (col.type == TYPE_FLOAT) {
-                col_str = std::to_string(*(float *)rec_buf);
-            } else if (col.type == TYPE_STRING) {
-                col_str = std::string((char *)rec_buf, col.len);
-                col_str.resize(strlen(col_str.c_str()));
+    // 执行query_plan, 每次从根取出一批元组
+    TupleBatch batch(executorTreeRoot->tupleLen(), EXECUTION_BATCH_SIZE);
+    executorTreeRoot->beginTuple();
+    for (executorTreeRoot->NextBatch(&batch); !batch.empty(); executorTreeRoot->NextBatch(&batch)) {
+        for (size_t i = 0; i < batch.size(); i++) {
+            const char *tuple = batch.get(i);
+            std::vector<std::string> columns;
+            for (auto &col : executorTreeRoot->cols()) {
+                std::string col_str;
+                const char *rec_buf = tuple + col.offset;
+                if (col.type == TYPE_INT) {
+                    col_str = std::to_string(*(int *)rec_buf);
+                } else if (col.type == TYPE_FLOAT) {
+                    col_str = std::to_string(*(float *)rec_buf);
+                } else if (col.type == TYPE_STRING) {
+                    col_str = std::string(rec_buf, col.len);
+                    col_str.resize(strlen(col_str.c_str()));
+                }
+                columns.push_back(col_str);
             }
-            columns.push_back(col_str);
+            rec_printer.print_record(columns, context);
+            num_rec++;
         }
-        rec_printer.print_record(columns, context);
-        num_rec++;
     }
     // Print footer
     rec_printer.print_separator(context);
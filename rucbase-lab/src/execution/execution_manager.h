@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <memory>
@@ -18,6 +19,10 @@ struct TabCol {
     friend bool operator<(const TabCol &x, const TabCol &y) {
         return std::make_pair(x.tab_name, x.col_name) < std::make_pair(y.tab_name, y.col_name);
     }
+
+    friend bool operator==(const TabCol &x, const TabCol &y) {
+        return x.tab_name == y.tab_name && x.col_name == y.col_name;
+    }
 };
 
 struct Value {
@@ -79,6 +84,20 @@ struct SetClause {
     Value rhs;
 };
 
+struct OrderByCol {
+    TabCol col;
+    bool desc;  // 降序
+
+    friend bool operator==(const OrderByCol &x, const OrderByCol &y) { return x.col == y.col && x.desc == y.desc; }
+};
+
+/**
+ * @brief 按order有序的元组是否也按prefix有序, 即order是否以prefix开头
+ */
+inline bool has_order_prefix(const std::vector<OrderByCol> &order, const std::vector<OrderByCol> &prefix) {
+    return prefix.size() <= order.size() && std::equal(prefix.begin(), prefix.end(), order.begin());
+}
+
 class QlManager {
    private:
     SmManager *sm_manager_;
@@ -94,12 +113,16 @@ class QlManager {
                     std::vector<Condition> conds, Context *context);
 
     void select_from(std::vector<TabCol> sel_cols, const std::vector<std::string> &tab_names,
-                     std::vector<Condition> conds, Context *context);
+                     std::vector<Condition> conds, std::vector<OrderByCol> order_cols, Context *context);
 
    private:
     TabCol check_column(const std::vector<ColMeta> &all_cols, TabCol target);
     std::vector<ColMeta> get_all_cols(const std::vector<std::string> &tab_names);
     std::vector<Condition> check_where_clause(const std::vector<std::string> &tab_names,
                                               const std::vector<Condition> &conds);
-    int get_indexNo(std::string tab_name, std::vector<Condition> curr_conds);
+    const IndexMeta *get_index(std::string tab_name, std::vector<Condition> curr_conds);
+    bool is_covering_index(const std::string &tab_name, const IndexMeta &index, const std::vector<TabCol> &sel_cols,
+                           const std::vector<Condition> &conds);
+    const IndexMeta *get_order_index(const std::string &tab_name, const std::vector<OrderByCol> &order_cols,
+                                     const std::vector<TabCol> &sel_cols, const std::vector<Condition> &conds);
 };
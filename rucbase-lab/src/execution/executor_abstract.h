@@ -4,6 +4,7 @@
 #include "execution_manager.h"
 #include "index/ix.h"
 #include "system/sm.h"
+#include "tuple_batch.h"
 
 class AbstractExecutor {
    public:
@@ -32,8 +33,25 @@ class AbstractExecutor {
 
     virtual std::unique_ptr<RmRecord> Next() = 0;
 
+    /**
+     * @brief 按批读取: 清空batch, 从当前位置开始放入最多batch->capacity()个元组, 并移动到这些元组之后.
+     * beginTuple之后反复调用, 得到空的batch表示已经读完. batch的元组长度由调用者按tupleLen()设置.
+     * 默认逐个调用Next()和nextTuple(), 算子可以覆盖它, 省去每个元组的虚调用和RmRecord分配
+     */
+    virtual void NextBatch(TupleBatch *batch) {
+        batch->clear();
+        for (; !is_end() && !batch->full(); nextTuple()) {
+            batch->push_back(Next()->data);
+        }
+    }
+
     virtual void feed(const std::map<TabCol, Value> &feed_dict){};
 
+    /**
+     * @brief 输出元组的顺序: 依次按返回的各列有序, 没有确定的顺序时返回空. 顺序已经满足要求时不需要再排序
+     */
+    virtual std::vector<OrderByCol> sorted_by() const { return {}; }
+
     std::vector<ColMeta>::const_iterator get_col(const std::vector<ColMeta> &rec_cols, const TabCol &target) {
         auto pos = std::find_if(rec_cols.begin(), rec_cols.end(), [&](const ColMeta &col) {
             return col.tab_name == target.tab_name && col.name == target.col_name;
@@ -65,4 +83,41 @@ class AbstractExecutor {
         }
         return rec_dict;
     }
-};
\ No newline at end of file
+};
+
+/**
+ * @brief 按批从孩子算子读取元组, 再逐个交给需要逐个处理元组的上层算子(如连接的各个孩子)
+ */
+class BatchReader {
+   private:
+    AbstractExecutor *child_ = nullptr;
+    TupleBatch batch_;
+    size_t pos_ = 0;
+
+   public:
+    /** 从child的第一个元组开始读取 */
+    void begin(AbstractExecutor *child) {
+        child_ = child;
+        batch_.reset(child_->tupleLen(), EXECUTION_BATCH_SIZE);
+        child_->beginTuple();
+        fill();
+    }
+
+    bool is_end() const { return pos_ == batch_.size(); }
+
+    /** @return 当前元组, 在下一次next之前有效 */
+    const char *get() const { return batch_.get(pos_); }
+
+    void next() {
+        assert(!is_end());
+        if (++pos_ == batch_.size()) {
+            fill();
+        }
+    }
+
+   private:
+    void fill() {
+        pos_ = 0;
+        child_->NextBatch(&batch_);
+    }
+};
@@ -0,0 +1,257 @@
+#undef NDEBUG
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "executor_bitmap_heap_scan.h"
+#include "executor_hash_join.h"
+#include "executor_index_only_scan.h"
+#include "executor_index_scan.h"
+#include "executor_nestedloop_join.h"
+#include "executor_projection.h"
+#include "executor_seq_scan.h"
+#include "executor_sort.h"
+#include "executor_sort_merge_join.h"
+#include "gtest/gtest.h"
+
+const std::string TEST_DB_NAME = "ExecutorBatchTest_db";  // 测试数据库的目录名
+
+/**
+ * @brief 按行(Next)与按批(NextBatch)执行同一个算子树, 比较输出并测量吞吐量.
+ * ta(a int, b float, c char(16))有NUM_ROWS条记录, a打乱顺序插入且在a上有索引; tb(a int, d int)的a有重复
+ */
+class ExecutorBatchTest : public ::testing::Test {
+   public:
+    static constexpr int NUM_ROWS = 100000;
+    static constexpr int NUM_TB_ROWS = 2000;
+
+    std::unique_ptr<DiskManager> disk_manager_;
+    std::unique_ptr<BufferPoolManager> buffer_pool_manager_;
+    std::unique_ptr<RmManager> rm_manager_;
+    std::unique_ptr<IxManager> ix_manager_;
+    std::unique_ptr<SmManager> sm_manager_;
+    std::unique_ptr<Context> context_;
+
+   public:
+    void SetUp() override {
+        ::testing::Test::SetUp();
+        disk_manager_ = std::make_unique<DiskManager>();
+        buffer_pool_manager_ = std::make_unique<BufferPoolManager>(BUFFER_POOL_SIZE, disk_manager_.get());
+        rm_manager_ = std::make_unique<RmManager>(disk_manager_.get(), buffer_pool_manager_.get());
+        ix_manager_ = std::make_unique<IxManager>(disk_manager_.get(), buffer_pool_manager_.get());
+        sm_manager_ = std::make_unique<SmManager>(disk_manager_.get(), buffer_pool_manager_.get(), rm_manager_.get(),
+                                                  ix_manager_.get());
+        context_ = std::make_unique<Context>(nullptr, nullptr, nullptr);
+        if (sm_manager_->is_dir(TEST_DB_NAME)) {
+            sm_manager_->drop_db(TEST_DB_NAME);
+        }
+        sm_manager_->create_db(TEST_DB_NAME);
+        sm_manager_->open_db(TEST_DB_NAME);
+
+        sm_manager_->create_table("ta",
+                                  {{.name = "a", .type = TYPE_INT, .len = 4},
+                                   {.name = "b", .type = TYPE_FLOAT, .len = 4},
+                                   {.name = "c", .type = TYPE_STRING, .len = 16}},
+                                  context_.get());
+        std::vector<int> keys(NUM_ROWS);
+        for (int i = 0; i < NUM_ROWS; i++) {
+            keys[i] = i;
+        }
+        std::shuffle(keys.begin(), keys.end(), std::mt19937(0));
+        RmRecord rec(24);
+        for (int a : keys) {
+            memset(rec.data, 0, rec.size);
+            float b = a * 0.5f;
+            memcpy(rec.data, &a, sizeof(int));
+            memcpy(rec.data + 4, &b, sizeof(float));
+            snprintf(rec.data + 8, 16, "str%d", a % 97);
+            sm_manager_->fhs_.at("ta")->insert_record(rec.data, context_.get());
+        }
+        sm_manager_->create_index("ta", "a", context_.get());
+
+        sm_manager_->create_table(
+            "tb", {{.name = "a", .type = TYPE_INT, .len = 4}, {.name = "d", .type = TYPE_INT, .len = 4}},
+            context_.get());
+        RmRecord tb_rec(8);
+        for (int i = 0; i < NUM_TB_ROWS; i++) {
+            int a = i % 500 * 7;
+            memcpy(tb_rec.data, &a, sizeof(int));
+            memcpy(tb_rec.data + 4, &i, sizeof(int));
+            sm_manager_->fhs_.at("tb")->insert_record(tb_rec.data, context_.get());
+        }
+    }
+
+    void TearDown() override {
+        sm_manager_->close_db();
+        sm_manager_->drop_db(TEST_DB_NAME);
+    }
+
+    static Condition value_cond(const std::string &tab, const std::string &col, CompOp op, int val) {
+        Condition cond;
+        cond.lhs_col = {.tab_name = tab, .col_name = col};
+        cond.op = op;
+        cond.is_rhs_val = true;
+        cond.rhs_val.set_int(val);
+        cond.rhs_val.init_raw(sizeof(int));
+        return cond;
+    }
+
+    static Condition join_cond(const std::string &lhs_tab, const std::string &rhs_tab, const std::string &col) {
+        Condition cond;
+        cond.lhs_col = {.tab_name = lhs_tab, .col_name = col};
+        cond.op = OP_EQ;
+        cond.is_rhs_val = false;
+        cond.rhs_col = {.tab_name = rhs_tab, .col_name = col};
+        return cond;
+    }
+
+    std::unique_ptr<AbstractExecutor> seq_scan(const std::string &tab, std::vector<Condition> conds) {
+        return std::make_unique<SeqScanExecutor>(sm_manager_.get(), tab, std::move(conds), context_.get());
+    }
+
+    std::unique_ptr<AbstractExecutor> index_scan(std::vector<Condition> conds) {
+        auto &index = sm_manager_->db_.get_table("ta").indexes.front();
+        return std::make_unique<IndexScanExecutor>(sm_manager_.get(), "ta", std::move(conds), index, context_.get());
+    }
+
+    static std::vector<std::string> run_rows(AbstractExecutor *root) {
+        std::vector<std::string> tuples;
+        for (root->beginTuple(); !root->is_end(); root->nextTuple()) {
+            auto tuple = root->Next();
+            tuples.emplace_back(tuple->data, tuple->size);
+        }
+        return tuples;
+    }
+
+    static std::vector<std::string> run_batches(AbstractExecutor *root, size_t batch_size) {
+        std::vector<std::string> tuples;
+        TupleBatch batch(root->tupleLen(), batch_size);
+        root->beginTuple();
+        for (root->NextBatch(&batch); !batch.empty(); root->NextBatch(&batch)) {
+            for (size_t i = 0; i < batch.size(); i++) {
+                tuples.emplace_back(batch.get(i), batch.tuple_len());
+            }
+        }
+        return tuples;
+    }
+};
+
+// 各种算子按批输出的元组与按行输出的相同, 且与批的大小无关
+TEST_F(ExecutorBatchTest, BatchMatchesRows) {
+    std::vector<std::pair<std::string, std::function<std::unique_ptr<AbstractExecutor>()>>> plans = {
+        {"SeqScan", [&]() { return seq_scan("ta", {value_cond("ta", "a", OP_LT, NUM_ROWS / 3)}); }},
+        {"IndexScan",
+         [&]() { return index_scan({value_cond("ta", "a", OP_GE, 1000), value_cond("ta", "a", OP_LT, 9000)}); }},
+        {"Projection",
+         [&]() {
+             return std::make_unique<ProjectionExecutor>(seq_scan("ta", {value_cond("ta", "a", OP_NE, 5)}),
+                                                         std::vector<TabCol>{{"ta", "c"}, {"ta", "a"}});
+         }},
+        {"NestedLoopJoin",
+         [&]() {
+             return std::make_unique<NestedLoopJoinExecutor>(seq_scan("tb", {value_cond("tb", "d", OP_LT, 50)}),
+                                                             seq_scan("tb", {value_cond("tb", "d", OP_GE, 1900)}));
+         }},
+        {"HashJoin",
+         [&]() {
+             return std::make_unique<HashJoinExecutor>(seq_scan("ta", {value_cond("ta", "a", OP_LT, 5000)}),
+                                                       seq_scan("tb", {}),
+                                                       std::vector<Condition>{join_cond("ta", "tb", "a")},
+                                                       disk_manager_.get());
+         }},
+        {"HashJoinSpill",
+         [&]() {
+             return std::make_unique<HashJoinExecutor>(seq_scan("ta", {value_cond("ta", "a", OP_LT, 5000)}),
+                                                       seq_scan("tb", {}),
+                                                       std::vector<Condition>{join_cond("ta", "tb", "a")},
+                                                       disk_manager_.get(), 4096);
+         }},
+        {"SortMergeJoin",
+         [&]() {
+             return std::make_unique<SortMergeJoinExecutor>(index_scan({value_cond("ta", "a", OP_LT, 5000)}),
+                                                            seq_scan("tb", {}),
+                                                            std::vector<Condition>{join_cond("ta", "tb", "a")},
+                                                            disk_manager_.get());
+         }},
+        {"Sort",
+         [&]() {
+             return std::make_unique<SortExecutor>(
+                 seq_scan("tb", {}), std::vector<OrderByCol>{{.col = {"tb", "a"}, .desc = true}}, disk_manager_.get());
+         }},
+    };
+    for (auto &[name, make_plan] : plans) {
+        auto expected = run_rows(make_plan().get());
+        ASSERT_FALSE(expected.empty()) << name;
+        for (size_t batch_size : {size_t{1}, size_t{7}, EXECUTION_BATCH_SIZE}) {
+            EXPECT_EQ(run_batches(make_plan().get(), batch_size), expected) << name << " batch " << batch_size;
+        }
+    }
+}
+
+// 索引扫描的范围与条件的各种组合(包括同一列上同时有等值和范围条件)下, 各种索引扫描与全表扫描得到的记录相同
+TEST_F(ExecutorBatchTest, IndexRangeMatchesSeqScan) {
+    std::vector<std::vector<Condition>> cond_sets = {
+        {value_cond("ta", "a", OP_EQ, 5), value_cond("ta", "a", OP_GT, 3)},
+        {value_cond("ta", "a", OP_EQ, 5), value_cond("ta", "a", OP_LT, 9)},
+        {value_cond("ta", "a", OP_EQ, 5), value_cond("ta", "a", OP_GE, 5), value_cond("ta", "a", OP_LE, 5)},
+        {value_cond("ta", "a", OP_EQ, 5), value_cond("ta", "a", OP_GT, 5)},
+        {value_cond("ta", "a", OP_EQ, 5), value_cond("ta", "a", OP_LT, 2)},
+        {value_cond("ta", "a", OP_GT, 100), value_cond("ta", "a", OP_LE, 200)},
+        {value_cond("ta", "a", OP_EQ, 7)},
+    };
+    auto &index = sm_manager_->db_.get_table("ta").indexes.front();
+    // 按a排序后的a, 索引扫描的元组和覆盖索引扫描的key都以a开头
+    auto keys = [](AbstractExecutor *root) {
+        std::vector<int> result;
+        for (auto &tuple : run_rows(root)) {
+            result.push_back(*reinterpret_cast<const int *>(tuple.data()));
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    };
+    for (size_t i = 0; i < cond_sets.size(); i++) {
+        auto &conds = cond_sets[i];
+        auto expected = keys(seq_scan("ta", conds).get());
+        IndexScanExecutor index_scan(sm_manager_.get(), "ta", conds, index, context_.get());
+        EXPECT_EQ(keys(&index_scan), expected) << "conds " << i;
+        IndexOnlyScanExecutor index_only_scan(sm_manager_.get(), "ta", conds, index, context_.get());
+        EXPECT_EQ(keys(&index_only_scan), expected) << "conds " << i;
+        BitmapHeapScanExecutor bitmap_scan(sm_manager_.get(), "ta", conds, index, context_.get());
+        EXPECT_EQ(keys(&bitmap_scan), expected) << "conds " << i;
+        if (!expected.empty()) {
+            EXPECT_GT(index_scan.estimate_selectivity(), 0) << "conds " << i;
+        }
+    }
+}
+
+// 对ta做带条件的全表扫描和投影, 比较按行和按批执行的吞吐量
+TEST_F(ExecutorBatchTest, ScanBenchmark) {
+    const int rounds = 5;
+    auto make_plan = [&]() {
+        return std::make_unique<ProjectionExecutor>(seq_scan("ta", {value_cond("ta", "a", OP_GE, NUM_ROWS / 10)}),
+                                                    std::vector<TabCol>{{"ta", "a"}, {"ta", "c"}});
+    };
+    // 返回每秒输出的元组数
+    auto measure = [&](const std::function<std::vector<std::string>(AbstractExecutor *)> &run, size_t *count) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < rounds; i++) {
+            *count = run(make_plan().get()).size();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return *count * rounds / elapsed.count();
+    };
+    size_t row_count = 0, batch_count = 0;
+    double row_rate = measure(run_rows, &row_count);
+    double batch_rate = measure([](AbstractExecutor *root) { return run_batches(root, EXECUTION_BATCH_SIZE); },
+                                &batch_count);
+    EXPECT_EQ(row_count, static_cast<size_t>(NUM_ROWS - NUM_ROWS / 10));
+    EXPECT_EQ(batch_count, row_count);
+    printf("%-12s %14s\n", "mode", "tuples/s");
+    printf("%-12s %14.0f\n", "Next", row_rate);
+    printf("%-12s %14.0f\n", "NextBatch", batch_rate);
+}
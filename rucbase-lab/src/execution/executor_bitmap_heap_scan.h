@@ -0,0 +1,123 @@
+#pragma once
+
+#include <algorithm>
+
+#include "executor_index_scan.h"
+
+/**
+ * @brief 按rid顺序读取记录的索引扫描(bitmap heap scan)
+ * 先从索引范围中收集所有rid并按(page_no, slot_no)排序, 再逐个页面读取: 每个页面只fetch一次, 页面中所有
+ * 符合条件的记录一起计算, 并按页面顺序预读后面的页面. 索引范围较大时, 避免了按key顺序逐条读取记录造成的
+ * 随机I/O和同一页面的重复读取; 代价是结果按记录在文件中的位置而不是key排列
+ */
+class BitmapHeapScanExecutor : public IndexScanExecutor {
+   private:
+    std::vector<Rid> rids_;       // 范围内的所有rid, 按(page_no, slot_no)排序
+    size_t next_rid_ = 0;         // rids_中下一个要读取的页面的第一个rid
+    std::vector<page_id_t> pages_;  // rids_涉及的页面, 按页号排序
+    size_t next_page_ = 0;          // pages_中下一个要读取的页面
+    size_t prefetch_end_ = 0;       // pages_[next_page_, prefetch_end_)已经发出预读
+
+    std::vector<Rid> page_rids_;                      // 当前页面中满足条件的记录
+    std::vector<std::unique_ptr<RmRecord>> page_recs_;
+    size_t page_pos_ = 0;                             // 当前记录在page_rids_中的下标
+
+   public:
+    BitmapHeapScanExecutor(SmManager *sm_manager, std::string tab_name, std::vector<Condition> conds,
+                           const IndexMeta &index, Context *context)
+        : IndexScanExecutor(sm_manager, std::move(tab_name), std::move(conds), index, context) {}
+
+    std::string getType() override { return "bitmapHeapScan"; }
+
+    void beginTuple() override {
+        check_runtime_conds();
+        auto ih = sm_manager_->get_index_handle(tab_name_, index_);
+        Iid lower = ih->leaf_begin();
+        Iid upper = ih->leaf_end();
+        get_scan_range(ih, &lower, &upper);
+        rids_.clear();
+        for (IxScan scan(ih, lower, upper, sm_manager_->get_bpm()); !scan.is_end(); scan.next()) {
+            rids_.push_back(scan.rid());
+        }
+        std::sort(rids_.begin(), rids_.end(), [](const Rid &a, const Rid &b) {
+            return a.page_no != b.page_no ? a.page_no < b.page_no : a.slot_no < b.slot_no;
+        });
+        pages_.clear();
+        for (auto &rid : rids_) {
+            if (pages_.empty() || pages_.back() != rid.page_no) {
+                pages_.push_back(rid.page_no);
+            }
+        }
+        next_rid_ = next_page_ = prefetch_end_ = 0;
+        load_next_page();
+    }
+
+    void nextTuple() override {
+        assert(!is_end());
+        if (++page_pos_ == page_rids_.size()) {
+            load_next_page();
+        } else {
+            rid_ = page_rids_[page_pos_];
+        }
+    }
+
+    bool is_end() const override { return page_pos_ == page_rids_.size(); }
+
+    std::unique_ptr<RmRecord> Next() override {
+        assert(!is_end());
+        return std::make_unique<RmRecord>(*page_recs_[page_pos_]);
+    }
+
+    void NextBatch(TupleBatch *batch) override {
+        batch->clear();
+        for (; !is_end() && !batch->full(); nextTuple()) {
+            batch->push_back(page_recs_[page_pos_]->data);
+        }
+    }
+
+    /** 按rid而不是key的顺序输出 */
+    std::vector<OrderByCol> sorted_by() const override { return {}; }
+
+   private:
+    /**
+     * @brief 读取后面的页面, 直到某个页面中有满足条件的记录或所有页面都已读完
+     */
+    void load_next_page() {
+        page_rids_.clear();
+        page_recs_.clear();
+        page_pos_ = 0;
+        while (page_rids_.empty() && next_page_ < pages_.size()) {
+            read_ahead();
+            page_id_t page_no = pages_[next_page_++];
+            std::vector<int> slot_nos;
+            for (; next_rid_ < rids_.size() && rids_[next_rid_].page_no == page_no; next_rid_++) {
+                slot_nos.push_back(rids_[next_rid_].slot_no);
+            }
+            auto recs = fh_->get_page_records(page_no, slot_nos, context_);
+            for (size_t i = 0; i < slot_nos.size(); i++) {
+                if (recs[i] != nullptr && pred_.eval(recs[i]->data)) {
+                    page_rids_.push_back(Rid{page_no, slot_nos[i]});
+                    page_recs_.push_back(std::move(recs[i]));
+                }
+            }
+        }
+        if (!page_rids_.empty()) {
+            rid_ = page_rids_[0];
+        }
+    }
+
+    /**
+     * @brief 已发出预读的页面不足半个窗口时, 预读后面的页面补足到PREFETCH_WINDOW个
+     */
+    void read_ahead() {
+        if (PREFETCH_WINDOW <= 0 || prefetch_end_ > next_page_ + PREFETCH_WINDOW / 2) {
+            return;
+        }
+        size_t begin = std::max(prefetch_end_, next_page_ + 1);  // 当前页面马上就要读取, 不需要预读
+        prefetch_end_ = std::min(pages_.size(), next_page_ + 1 + PREFETCH_WINDOW);
+        if (begin < prefetch_end_) {
+            std::vector<page_id_t> page_nos(pages_.begin() + begin, pages_.begin() + prefetch_end_);
+            sm_manager_->get_bpm()->PrefetchPages(fh_->GetFd(), page_nos);
+        }
+    }
+};
@@ -27,14 +27,12 @@ class DeleteExecutor : public AbstractExecutor {
     }
     std::unique_ptr<RmRecord> Next() override {
         // Get all index files
-        std::vector<IxIndexHandle *> ihs(tab_.cols.size(), nullptr);
-        for (size_t col_i = 0; col_i < tab_.cols.size(); col_i++) {
-            if (tab_.cols[col_i].index) {
-                // lab3 task3 Todo
-                // 获取需要的索引句柄,填充vector ihs
-                // lab3 task3 Todo end
-				ihs[col_i] =  sm_manager_->ihs_.at(sm_manager_->get_ix_manager()->get_index_name(tab_name_,col_i)).get();
-            }
+        std::vector<IxIndexHandle *> ihs(tab_.indexes.size(), nullptr);
+        for (size_t index_i = 0; index_i < tab_.indexes.size(); index_i++) {
+            // lab3 task3 Todo
+            // 获取需要的索引句柄,填充vector ihs
+            // lab3 task3 Todo end
+			ihs[index_i] = sm_manager_->get_index_handle(tab_name_, tab_.indexes[index_i]);
         }
         // Delete each rid from record file and index file
         for (auto &rid : rids_) {
@@ -44,9 +42,10 @@ class DeleteExecutor : public AbstractExecutor {
             // Delete from record file
             // lab3 task3 Todo end
 			// delete from index file
-            for(size_t i = 0; i < tab_.cols.size(); ++i){
-                if(tab_.cols[i].index)
-                    ihs[i]->delete_entry(rec->data+tab_.cols[i].offset, context_->txn_);
+            for(size_t i = 0; i < tab_.indexes.size(); ++i){
+                std::vector<char> key(tab_.indexes[i].col_tot_len);
+                tab_.get_index_key(tab_.indexes[i], rec->data, key.data());
+                ihs[i]->delete_entry(key.data(), rid, context_->txn_);
             }
             // delete from record file
             fh_->delete_record(rid, context_);
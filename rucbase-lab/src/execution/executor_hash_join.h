@@ -0,0 +1,337 @@
+#pragma once
+
+#include <functional>
+#include <unordered_map>
+
+#include "compiled_predicate.h"
+#include "execution_defs.h"
+#include "execution_manager.h"
+#include "executor_abstract.h"
+#include "index/ix.h"
+#include "storage/spill_file.h"
+#include "system/sm.h"
+
+/**
+ * @brief 等值连接: 用右孩子(build)的元组按连接列建立哈希表, 左孩子(probe)的每个元组在哈希表中查找匹配的元组
+ * build的元组超过memory_budget时, 按连接列的哈希值把两边都分区写入临时文件(grace hash join), 再逐个分区
+ * 建立哈希表; 某个分区仍然放不下时用哈希值的其他位继续分区. 不溢出时结果的顺序与NestedLoopJoinExecutor相同:
+ * 按左孩子的顺序, 同一个左元组的匹配按右孩子的顺序
+ */
+class HashJoinExecutor : public AbstractExecutor {
+   private:
+    static constexpr int MAX_SPILL_DEPTH = 4;  // 最多分区的次数, 同一个key的元组再分区也分不开
+
+    /** 一对待处理的分区: 两边连接key的哈希值落在同一个分区的元组 */
+    struct Partition {
+        std::unique_ptr<SpillFile> build;
+        std::unique_ptr<SpillFile> probe;
+        int depth;  // 已经分区的次数
+    };
+
+    std::unique_ptr<AbstractExecutor> left_;   // probe
+    std::unique_ptr<AbstractExecutor> right_;  // build
+    size_t len_;
+    std::vector<ColMeta> cols_;
+    std::vector<ColMeta> left_keys_;   // 等值连接条件在左孩子中的列
+    std::vector<ColMeta> right_keys_;  // 对应的右孩子中的列
+    std::vector<int> key_lens_;        // 连接key中每一列的长度, 两边CHAR的长度不同时取较长的
+    std::vector<Condition> conds_;     // 其余的连接条件, 在连接结果上判断
+    CompiledPredicate pred_;           // conds_编译后的谓词
+    DiskManager *disk_manager_;        // 创建溢出的分区文件
+    size_t memory_budget_;
+
+    // 哈希表: build元组依次存放在build_tuples_中, 按连接key记录元组的序号, 同一个key的序号按插入顺序排列
+    std::vector<char> build_tuples_;
+    std::unordered_map<std::string, std::vector<size_t>> table_;
+    size_t table_bytes_ = 0;  // 哈希表大致占用的内存
+
+    bool spilled_ = false;
+    std::vector<Partition> partitions_;      // 溢出后待处理的分区, 从末尾取
+    std::unique_ptr<SpillFile> probe_file_;  // 正在处理的分区的probe元组
+
+    BatchReader probe_reader_;                      // 按批读取左孩子
+    std::unique_ptr<RmRecord> probe_;               // 当前的probe元组
+    const std::vector<size_t> *matches_ = nullptr;  // probe_在哈希表中匹配的build元组
+    size_t match_idx_ = 0;
+    std::unique_ptr<RmRecord> joined_;  // 当前的连接结果
+    bool is_end_ = true;
+
+   public:
+    /**
+     * @param conds 两个孩子之间的连接条件, 至少有一个等值条件
+     */
+    HashJoinExecutor(std::unique_ptr<AbstractExecutor> left, std::unique_ptr<AbstractExecutor> right,
+                     std::vector<Condition> conds, DiskManager *disk_manager,
+                     size_t memory_budget = HASH_JOIN_MEMORY_BUDGET)
+        : left_(std::move(left)), right_(std::move(right)), disk_manager_(disk_manager), memory_budget_(memory_budget) {
+        len_ = left_->tupleLen() + right_->tupleLen();
+        cols_ = left_->cols();
+        auto right_cols = right_->cols();
+        for (auto &col : right_cols) {
+            col.offset += left_->tupleLen();
+        }
+        cols_.insert(cols_.end(), right_cols.begin(), right_cols.end());
+
+        auto in_left = [&](const TabCol &col) {
+            return std::any_of(left_->cols().begin(), left_->cols().end(), [&](const ColMeta &left_col) {
+                return left_col.tab_name == col.tab_name && left_col.name == col.col_name;
+            });
+        };
+        for (auto &cond : conds) {
+            assert(!cond.is_rhs_val);
+            if (cond.op != OP_EQ) {
+                conds_.push_back(cond);
+                continue;
+            }
+            TabCol left_col = cond.lhs_col, right_col = cond.rhs_col;
+            if (!in_left(left_col)) {
+                std::swap(left_col, right_col);
+            }
+            left_keys_.push_back(*get_col(left_->cols(), left_col));
+            right_keys_.push_back(*get_col(right_->cols(), right_col));
+            key_lens_.push_back(std::max(left_keys_.back().len, right_keys_.back().len));
+        }
+        assert(!left_keys_.empty());
+        pred_ = CompiledPredicate(cols_, conds_);
+    }
+
+    std::string getType() override { return "HashJoin"; }
+
+    size_t tupleLen() const override { return len_; }
+
+    const std::vector<ColMeta> &cols() const override { return cols_; }
+
+    void beginTuple() override {
+        build_tuples_.clear();
+        table_.clear();
+        table_bytes_ = 0;
+        spilled_ = false;
+        partitions_.clear();
+        probe_file_.reset();
+        joined_ = std::make_unique<RmRecord>(len_);
+        probe_ = std::make_unique<RmRecord>(left_->tupleLen());
+        build();
+        probe_reader_.begin(left_.get());
+        if (spilled_) {
+            // 左孩子也按同样的方式分区, 然后从第一个分区开始
+            for (; !probe_reader_.is_end(); probe_reader_.next()) {
+                const char *tuple = probe_reader_.get();
+                partitions_[partition_of(get_key(left_keys_, tuple), 0)].probe->write(tuple);
+            }
+            drop_empty_partitions(&partitions_);
+            load_partition();
+        }
+        matches_ = nullptr;
+        is_end_ = false;
+        find_match();
+    }
+
+    void nextTuple() override {
+        assert(!is_end());
+        match_idx_++;
+        find_match();
+    }
+
+    bool is_end() const override { return is_end_; }
+
+    std::unique_ptr<RmRecord> Next() override {
+        assert(!is_end());
+        return std::make_unique<RmRecord>(*joined_);
+    }
+
+    void NextBatch(TupleBatch *batch) override {
+        batch->clear();
+        for (; !is_end() && !batch->full(); nextTuple()) {
+            batch->push_back(joined_->data);
+        }
+    }
+
+    // build在beginTuple中一次建好, 连接条件只对左孩子更新
+    void feed(const std::map<TabCol, Value> &feed_dict) override { left_->feed(feed_dict); }
+
+    Rid &rid() override { return _abstract_rid; }
+
+   private:
+    /**
+     * @brief 读取右孩子的所有元组建立哈希表, 超过内存预算时改为写入分区
+     */
+    void build() {
+        BatchReader reader;
+        for (reader.begin(right_.get()); !reader.is_end(); reader.next()) {
+            const char *tuple = reader.get();
+            if (spilled_) {
+                partitions_[partition_of(get_key(right_keys_, tuple), 0)].build->write(tuple);
+                continue;
+            }
+            insert(tuple);
+            if (table_bytes_ > memory_budget_) {
+                spill();
+            }
+        }
+    }
+
+    /**
+     * @brief 把哈希表中已有的元组写入分区, 之后的build元组直接写入分区
+     */
+    void spill() {
+        spilled_ = true;
+        partitions_ = make_partitions(0);
+        size_t right_len = right_->tupleLen();
+        for (size_t i = 0; i * right_len < build_tuples_.size(); i++) {
+            const char *tuple = &build_tuples_[i * right_len];
+            partitions_[partition_of(get_key(right_keys_, tuple), 0)].build->write(tuple);
+        }
+        build_tuples_.clear();
+        build_tuples_.shrink_to_fit();
+        table_.clear();
+        table_bytes_ = 0;
+    }
+
+    void insert(const char *tuple) {
+        size_t right_len = right_->tupleLen();
+        size_t idx = build_tuples_.size() / right_len;
+        build_tuples_.insert(build_tuples_.end(), tuple, tuple + right_len);
+        std::string key = get_key(right_keys_, tuple);
+        table_bytes_ += right_len + key.size() + sizeof(size_t);
+        table_[std::move(key)].push_back(idx);
+    }
+
+    /**
+     * @brief 取出下一个分区建立哈希表, 放不下的分区再分区
+     * @return 是否还有分区
+     */
+    bool load_partition() {
+        while (!partitions_.empty()) {
+            Partition part = std::move(partitions_.back());
+            partitions_.pop_back();
+            if (part.build->size() > memory_budget_ && part.depth + 1 < MAX_SPILL_DEPTH) {
+                repartition(&part);
+                continue;
+            }
+            build_tuples_.clear();
+            table_.clear();
+            table_bytes_ = 0;
+            part.build->rewind();
+            std::vector<char> tuple(right_->tupleLen());
+            while (part.build->read(tuple.data())) {
+                insert(tuple.data());
+            }
+            probe_file_ = std::move(part.probe);
+            probe_file_->rewind();
+            return true;
+        }
+        probe_file_.reset();
+        return false;
+    }
+
+    void repartition(Partition *part) {
+        auto parts = make_partitions(part->depth + 1);
+        std::vector<char> tuple(std::max(left_->tupleLen(), right_->tupleLen()));
+        part->build->rewind();
+        while (part->build->read(tuple.data())) {
+            parts[partition_of(get_key(right_keys_, tuple.data()), part->depth + 1)].build->write(tuple.data());
+        }
+        part->probe->rewind();
+        while (part->probe->read(tuple.data())) {
+            parts[partition_of(get_key(left_keys_, tuple.data()), part->depth + 1)].probe->write(tuple.data());
+        }
+        drop_empty_partitions(&parts);
+        for (auto &sub : parts) {
+            partitions_.push_back(std::move(sub));
+        }
+    }
+
+    std::vector<Partition> make_partitions(int depth) {
+        std::vector<Partition> parts(HASH_JOIN_PARTITIONS);
+        for (auto &part : parts) {
+            part.build = std::make_unique<SpillFile>(disk_manager_, right_->tupleLen());
+            part.probe = std::make_unique<SpillFile>(disk_manager_, left_->tupleLen());
+            part.depth = depth;
+        }
+        return parts;
+    }
+
+    /**
+     * @brief 去掉有一边为空(不会产生连接结果)的分区, 剩下的分区倒序排列, 使得从末尾取出时按分区号的顺序处理
+     */
+    static void drop_empty_partitions(std::vector<Partition> *parts) {
+        parts->erase(std::remove_if(parts->begin(), parts->end(),
+                                    [](const Partition &part) { return part.build->size() == 0 || part.probe->size() == 0; }),
+                     parts->end());
+        std::reverse(parts->begin(), parts->end());
+    }
+
+    /**
+     * @brief 第depth次分区时key所在的分区, 每次使用哈希值的不同位
+     */
+    static size_t partition_of(const std::string &key, int depth) {
+        return (std::hash<std::string>{}(key) >> (depth * 8)) % HASH_JOIN_PARTITIONS;
+    }
+
+    /**
+     * @brief 元组在key_cols上的连接key: 各列按key_lens_补齐后拼接, 使两边相等的值得到相同的key
+     */
+    std::string get_key(const std::vector<ColMeta> &key_cols, const char *tuple) const {
+        std::string key;
+        for (size_t i = 0; i < key_cols.size(); i++) {
+            const char *val = tuple + key_cols[i].offset;
+            size_t len = key_cols[i].len;
+            if (key_cols[i].type == TYPE_STRING) {
+                len = strnlen(val, len);
+            } else if (key_cols[i].type == TYPE_FLOAT && *(const float *)val == 0) {
+                val = "\0\0\0\0";  // -0.0与0.0相等
+            }
+            key.append(val, len);
+            key.append(key_lens_[i] - len, '\0');
+        }
+        return key;
+    }
+
+    /**
+     * @brief 读取下一个probe元组并在哈希表中查找, 跳过没有匹配的元组
+     * @return 是否还有probe元组
+     */
+    bool next_probe() {
+        while (true) {
+            if (!spilled_) {
+                if (probe_reader_.is_end()) {
+                    return false;
+                }
+                memcpy(probe_->data, probe_reader_.get(), left_->tupleLen());
+                probe_reader_.next();
+            } else if (probe_file_ == nullptr || !probe_file_->read(probe_->data)) {
+                if (!load_partition()) {
+                    return false;
+                }
+                continue;
+            }
+            auto it = table_.find(get_key(left_keys_, probe_->data));
+            if (it != table_.end()) {
+                matches_ = &it->second;
+                match_idx_ = 0;
+                return true;
+            }
+        }
+    }
+
+    /**
+     * @brief 从当前位置开始找到下一个满足其余连接条件的连接结果, 存入joined_
+     */
+    void find_match() {
+        size_t left_len = left_->tupleLen(), right_len = right_->tupleLen();
+        while (true) {
+            for (; matches_ != nullptr && match_idx_ < matches_->size(); match_idx_++) {
+                memcpy(joined_->data, probe_->data, left_len);
+                memcpy(joined_->data + left_len, &build_tuples_[(*matches_)[match_idx_] * right_len], right_len);
+                if (pred_.eval(joined_->data)) {
+                    return;
+                }
+            }
+            matches_ = nullptr;
+            if (!next_probe()) {
+                is_end_ = true;
+                return;
+            }
+        }
+    }
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "executor_index_scan.h"
+
+/**
+ * @brief 覆盖索引扫描: 查询用到的列(投影和条件中的列)都在索引中时, 直接由B+树中的key生成元组,
+ * 不再为每个索引项到记录文件中随机读取记录.
+ * 扫描范围与IndexScanExecutor相同; 元组只包含索引的各列, 按它们在key中的位置排列, 条件也在key上计算
+ */
+class IndexOnlyScanExecutor : public IndexScanExecutor {
+   private:
+    std::vector<ColMeta> key_cols_;  // 索引的各列, offset为该列在key中的位置
+    RmRecord key_;                   // 当前的key, 容纳得下非唯一索引附加的rid
+
+   public:
+    IndexOnlyScanExecutor(SmManager *sm_manager, std::string tab_name, std::vector<Condition> conds,
+                          const IndexMeta &index, Context *context)
+        : IndexScanExecutor(sm_manager, std::move(tab_name), std::move(conds), index, context), key_(IX_MAX_COL_LEN) {
+        int offset = 0;
+        for (int col_idx : index_.col_idxs) {
+            ColMeta col = cols_[col_idx];
+            col.offset = offset;
+            offset += col.len;
+            key_cols_.push_back(col);
+        }
+        compile_conds();
+    }
+
+    std::string getType() override { return "indexOnlyScan"; }
+
+    void beginTuple() override {
+        check_runtime_conds();
+        auto ih = sm_manager_->get_index_handle(tab_name_, index_);
+        Iid lower = ih->leaf_begin();
+        Iid upper = ih->leaf_end();
+        get_scan_range(ih, &lower, &upper);
+        scan_ = std::make_unique<IxScan>(ih, lower, upper, sm_manager_->get_bpm(), PREFETCH_WINDOW, true);
+        for (; !scan_->is_end(); scan_->next()) {
+            if (load_key()) {
+                break;
+            }
+        }
+    }
+
+    void nextTuple() override {
+        assert(!is_end());
+        for (scan_->next(); !scan_->is_end(); scan_->next()) {
+            if (load_key()) {
+                break;
+            }
+        }
+    }
+
+    size_t tupleLen() const override { return index_.col_tot_len; }
+
+    const std::vector<ColMeta> &cols() const override { return key_cols_; }
+
+    std::unique_ptr<RmRecord> Next() override {
+        assert(!is_end());
+        auto rec = std::make_unique<RmRecord>(index_.col_tot_len);
+        memcpy(rec->data, key_.data, index_.col_tot_len);
+        return rec;
+    }
+
+    void NextBatch(TupleBatch *batch) override {
+        batch->clear();
+        for (; !is_end() && !batch->full(); nextTuple()) {
+            batch->push_back(key_.data);
+        }
+    }
+
+   private:
+    /** 条件在key上判断 */
+    void compile_conds() override { pred_ = CompiledPredicate(key_cols_, fed_conds_); }
+
+    /** @brief 读出扫描当前位置的key和rid, 返回key是否满足条件 */
+    bool load_key() {
+        rid_ = scan_->entry(key_.data);
+        return pred_.eval(key_.data);
+    }
+};
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <limits>
+#include <optional>
+
+#include "compiled_predicate.h"
 #include "execution_defs.h"
 #include "execution_manager.h"
 #include "executor_abstract.h"
@@ -7,31 +11,32 @@
 #include "system/sm.h"
 
 class IndexScanExecutor : public AbstractExecutor {
-   private:
+   protected:
     std::string tab_name_;
     std::vector<Condition> conds_;
     RmFileHandle *fh_;
     std::vector<ColMeta> cols_;
     size_t len_;
     std::vector<Condition> fed_conds_;
+    CompiledPredicate pred_;  // fed_conds_编译后的谓词, 在每条记录上判断
 
-    int index_no_;
+    IndexMeta index_;  // 扫描使用的索引
 
     Rid rid_;
-    std::unique_ptr<RecScan> scan_;
+    std::unique_ptr<IxScan> scan_;
 
     SmManager *sm_manager_;
 
    public:
-    IndexScanExecutor(SmManager *sm_manager, std::string tab_name, std::vector<Condition> conds, int index_no,
-                      Context *context) {
+    IndexScanExecutor(SmManager *sm_manager, std::string tab_name, std::vector<Condition> conds,
+                      const IndexMeta &index, Context *context) {
         // lab3 task2 todo
         // 参考seqscan作法,实现indexscan构造方法
         // lab3 task2 todo
 		sm_manager_ = sm_manager;
         tab_name_ = std::move(tab_name);
         conds_ = std::move(conds);
-		index_no_ = index_no;
+		index_ = index;
         TabMeta &tab = sm_manager_->db_.get_table(tab_name_);
         fh_ = sm_manager_->fhs_.at(tab_name_).get();
         cols_ = tab.cols;
@@ -51,6 +56,7 @@ class IndexScanExecutor : public AbstractExecutor {
             }
         }
         fed_conds_ = conds_;
+        compile_conds();
     }
 
     std::string getType() { return "indexScan"; }
@@ -59,42 +65,19 @@ class IndexScanExecutor : public AbstractExecutor {
         check_runtime_conds();
 
         // index is available, scan index
-        auto ih = sm_manager_->ihs_.at(sm_manager_->get_ix_manager()->get_index_name(tab_name_, index_no_)).get();
+        auto ih = sm_manager_->get_index_handle(tab_name_, index_);
         Iid lower = ih->leaf_begin();
         Iid upper = ih->leaf_end();
-        auto &index_col = cols_[index_no_];
-        for (auto &cond : fed_conds_) {
-            if (cond.is_rhs_val && cond.op != OP_NE && cond.lhs_col.col_name == index_col.name) {
-                char *rhs_key = cond.rhs_val.raw->data;
-                if (cond.op == OP_EQ) {
-                    lower = ih->lower_bound(rhs_key);
-                    upper = ih->upper_bound(rhs_key);
-                }
-                // lab3 task2 todo
-				else if(cond.op == OP_LT){
-                    upper = ih->upper_bound(rhs_key);
-                }else if(cond.op == OP_GT){
-                	lower = ih->lower_bound(rhs_key);
-                }else if(cond.op == OP_LE){
-                	lower = ih->upper_bound(rhs_key);
-                }else if(cond.op == OP_GE){
-                	upper = ih->lower_bound(rhs_key); 
-                }
-                else{
-                 	throw InternalError("Unexpected op type");
-                }
-                 
-                // 利用cond 进行索引扫描
-                // lab3 task2 todo end
-                break;
-            }
-        }
+        // lab3 task2 todo
+        // 利用cond 进行索引扫描
+        // lab3 task2 todo end
+        get_scan_range(ih, &lower, &upper);
         scan_ = std::make_unique<IxScan>(ih, lower, upper, sm_manager_->get_bpm());
         // Get the first record
         while (!scan_->is_end()) {
             rid_ = scan_->rid();
             auto rec = fh_->get_record(rid_, context_);
-            if (eval_conds(cols_, fed_conds_, rec.get())) {
+            if (pred_.eval(rec->data)) {
                 break;
             }
             scan_->next();
@@ -102,7 +85,6 @@ class IndexScanExecutor : public AbstractExecutor {
     }
 
     void nextTuple() {
-        check_runtime_conds();
         assert(!is_end());
         // lab3 task2 todo
         // 扫描到下一个满足条件的记录,赋rid_,中止循环
@@ -111,7 +93,7 @@ class IndexScanExecutor : public AbstractExecutor {
 			rid_ = scan_->rid();
 			try {
                 auto rec = fh_->get_record(rid_, context_);
-				if(eval_conds(cols_, fed_conds_,rec.get())){
+				if(pred_.eval(rec->data)){
 					break;
 				}
             } catch (RecordNotFoundError &e) {
@@ -131,6 +113,42 @@ class IndexScanExecutor : public AbstractExecutor {
         return fh_->get_record(rid_, context_);
     }
 
+    /**
+     * @brief 按索引顺序读取记录, 连续落在同一个页面上的记录只fetch一次页面, 直接在页面中判断条件.
+     * 结束时scan_停在下一个满足条件的记录上, 与nextTuple之后的状态相同
+     */
+    void NextBatch(TupleBatch *batch) override {
+        batch->clear();
+        std::optional<RmPageHandle> page_handle;
+        auto bpm = sm_manager_->get_bpm();
+        for (; !scan_->is_end(); scan_->next()) {
+            Rid rid = scan_->rid();
+            if (!page_handle.has_value() || page_handle->page->GetPageId().page_no != rid.page_no) {
+                if (page_handle.has_value()) {
+                    bpm->UnpinPage(page_handle->page->GetPageId(), false);
+                }
+                page_handle.emplace(fh_->fetch_page_handle(rid.page_no));
+            }
+            if (!Bitmap::is_set(page_handle->bitmap, rid.slot_no)) {
+                continue;  // 与nextTuple中的RecordNotFoundError相同, 跳过
+            }
+            const char *rec = page_handle->get_slot(rid.slot_no);
+            if (!pred_.eval(rec)) {
+                continue;
+            }
+            if (batch->full()) {
+                break;
+            }
+            batch->push_back(rec);
+        }
+        if (page_handle.has_value()) {
+            bpm->UnpinPage(page_handle->page->GetPageId(), false);
+        }
+        if (!scan_->is_end()) {
+            rid_ = scan_->rid();
+        }
+    }
+
     void feed(const std::map<TabCol, Value> &feed_dict) override {
         fed_conds_ = conds_;
         for (auto &cond : fed_conds_) {
@@ -143,54 +161,149 @@ class IndexScanExecutor : public AbstractExecutor {
             }
         }
         check_runtime_conds();
+        compile_conds();
     }
 
     Rid &rid() override { return rid_; }
 
-    void check_runtime_conds() {
-        for (auto &cond : fed_conds_) {
-            assert(cond.lhs_col.tab_name == tab_name_);
-            if (!cond.is_rhs_val) {
-                assert(cond.rhs_col.tab_name == tab_name_);
+    /** 按索引的各列升序, 包括等值条件确定的前缀 */
+    std::vector<OrderByCol> sorted_by() const override {
+        std::vector<OrderByCol> order;
+        for (int col_idx : index_.col_idxs) {
+            order.push_back({.col = {.tab_name = tab_name_, .col_name = cols_[col_idx].name}, .desc = false});
+        }
+        return order;
+    }
+
+    /**
+     * @brief 估计按当前条件扫描的范围占索引中所有键值对的比例, 用于选择扫描方式
+     */
+    double estimate_selectivity() {
+        auto ih = sm_manager_->get_index_handle(tab_name_, index_);
+        Iid lower = ih->leaf_begin();
+        Iid upper = ih->leaf_end();
+        get_scan_range(ih, &lower, &upper);
+        if (lower == upper) {
+            return 0;
+        }
+        return std::max(0.0, ih->estimate_position(upper) - ih->estimate_position(lower));
+    }
+
+    /**
+     * @brief 根据条件计算索引扫描的范围[lower, upper)
+     * 从索引的第一列开始连续的等值条件确定key的前缀, 前缀之后的下一列可以再有范围条件(<, <=, >, >=);
+     * key中剩下的列填充该类型的最小值或最大值, 使范围包含前缀相同的所有key. 其余条件在扫描时由pred_过滤
+     */
+    void get_scan_range(IxIndexHandle *ih, Iid *lower, Iid *upper) {
+        std::vector<char> lower_key(index_.col_tot_len), upper_key(index_.col_tot_len);
+        const Condition *lower_cond = nullptr;  // 范围列上最紧的>或>=条件
+        const Condition *upper_cond = nullptr;  // 范围列上最紧的<或<=条件
+        size_t num_eq = 0;
+        int offset = 0;
+        for (; num_eq < index_.col_idxs.size(); num_eq++) {
+            auto &col = cols_[index_.col_idxs[num_eq]];
+            const Condition *eq_cond = nullptr;
+            lower_cond = upper_cond = nullptr;
+            for (auto &cond : fed_conds_) {
+                if (!cond.is_rhs_val || cond.lhs_col.col_name != col.name) {
+                    continue;
+                }
+                if (cond.op == OP_EQ) {
+                    eq_cond = &cond;
+                } else if ((cond.op == OP_GT || cond.op == OP_GE) && is_tighter(cond, lower_cond, col)) {
+                    lower_cond = &cond;
+                } else if ((cond.op == OP_LT || cond.op == OP_LE) && is_tighter(cond, upper_cond, col)) {
+                    upper_cond = &cond;
+                }
+            }
+            if (eq_cond == nullptr) {
+                break;
+            }
+            memcpy(lower_key.data() + offset, eq_cond->rhs_val.raw->data, col.len);
+            memcpy(upper_key.data() + offset, eq_cond->rhs_val.raw->data, col.len);
+            offset += col.len;
+        }
+        if (num_eq == index_.col_idxs.size()) {
+            // 所有列都有等值条件, 最后一列上的范围条件不参与确定范围, 由pred_过滤
+            lower_cond = upper_cond = nullptr;
+        }
+        if (num_eq == 0 && lower_cond == nullptr && upper_cond == nullptr) {
+            return;  // 没有可用的条件, 扫描整个索引
+        }
+        // >v: 跳过所有前缀+v开头的key, 剩下的列填最大值后取upper_bound; <v: 剩下的列填最小值后取lower_bound
+        bool lower_exclusive = lower_cond != nullptr && lower_cond->op == OP_GT;
+        bool upper_exclusive = upper_cond != nullptr && upper_cond->op == OP_LT;
+        for (size_t i = num_eq; i < index_.col_idxs.size(); i++) {
+            auto &col = cols_[index_.col_idxs[i]];
+            if (i == num_eq && lower_cond != nullptr) {
+                memcpy(lower_key.data() + offset, lower_cond->rhs_val.raw->data, col.len);
+            } else {
+                fill_key(lower_key.data() + offset, col, lower_exclusive);
+            }
+            if (i == num_eq && upper_cond != nullptr) {
+                memcpy(upper_key.data() + offset, upper_cond->rhs_val.raw->data, col.len);
+            } else {
+                fill_key(upper_key.data() + offset, col, !upper_exclusive);
             }
+            offset += col.len;
         }
+        int cmp = compare_keys(lower_key.data(), upper_key.data());
+        *upper = upper_exclusive ? ih->lower_bound(upper_key.data()) : ih->upper_bound(upper_key.data());
+        if (cmp > 0 || (cmp == 0 && (lower_exclusive || upper_exclusive))) {
+            *lower = *upper;  // 范围为空
+            return;
+        }
+        *lower = lower_exclusive ? ih->upper_bound(lower_key.data()) : ih->lower_bound(lower_key.data());
     }
 
-    bool eval_cond(const std::vector<ColMeta> &rec_cols, const Condition &cond, const RmRecord *rec) {
-        auto lhs_col = get_col(rec_cols, cond.lhs_col);
-        char *lhs = rec->data + lhs_col->offset;
-        char *rhs;
-        ColType rhs_type;
-        if (cond.is_rhs_val) {
-            rhs_type = cond.rhs_val.type;
-            rhs = cond.rhs_val.raw->data;
-        } else {
-            // rhs is a column
-            auto rhs_col = get_col(rec_cols, cond.rhs_col);
-            rhs_type = rhs_col->type;
-            rhs = rec->data + rhs_col->offset;
-        }
-        assert(rhs_type == lhs_col->type);  // TODO convert to common type
-        int cmp = ix_compare(lhs, rhs, rhs_type, lhs_col->len);
-        if (cond.op == OP_EQ) {
-            return cmp == 0;
-        } else if (cond.op == OP_NE) {
-            return cmp != 0;
-        } else if (cond.op == OP_LT) {
-            return cmp < 0;
-        } else if (cond.op == OP_GT) {
-            return cmp > 0;
-        } else if (cond.op == OP_LE) {
-            return cmp <= 0;
-        } else if (cond.op == OP_GE) {
-            return cmp >= 0;
+    /** @return 范围条件cond是否比cur更紧, cur为nullptr时总是更紧 */
+    static bool is_tighter(const Condition &cond, const Condition *cur, const ColMeta &col) {
+        if (cur == nullptr) {
+            return true;
+        }
+        int cmp = ix_compare(cond.rhs_val.raw->data, cur->rhs_val.raw->data, col.type, col.len);
+        if (cond.op == OP_GT || cond.op == OP_GE) {
+            return cmp > 0 || (cmp == 0 && cond.op == OP_GT);
+        }
+        return cmp < 0 || (cmp == 0 && cond.op == OP_LT);
+    }
+
+    /** @brief 把key中col对应的部分填充为该类型的最大值或最小值 */
+    static void fill_key(char *key, const ColMeta &col, bool max) {
+        if (col.type == TYPE_INT) {
+            int val = max ? std::numeric_limits<int>::max() : std::numeric_limits<int>::min();
+            memcpy(key, &val, sizeof(int));
+        } else if (col.type == TYPE_FLOAT) {
+            float val = max ? std::numeric_limits<float>::infinity() : -std::numeric_limits<float>::infinity();
+            memcpy(key, &val, sizeof(float));
         } else {
-            throw InternalError("Unexpected op type");
+            memset(key, max ? 0xff : 0, col.len);
+        }
+    }
+
+    /** @brief 按索引的各列逐列比较两个key */
+    int compare_keys(const char *a, const char *b) const {
+        for (int col_idx : index_.col_idxs) {
+            auto &col = cols_[col_idx];
+            int cmp = ix_compare(a, b, col.type, col.len);
+            if (cmp != 0) {
+                return cmp;
+            }
+            a += col.len;
+            b += col.len;
         }
+        return 0;
     }
 
-    bool eval_conds(const std::vector<ColMeta> &rec_cols, const std::vector<Condition> &conds, const RmRecord *rec) {
-        return std::all_of(conds.begin(), conds.end(),
-                           [&](const Condition &cond) { return eval_cond(rec_cols, cond, rec); });
+    /** @brief 把fed_conds_编译为pred_, 在cols_描述的记录上判断 */
+    virtual void compile_conds() { pred_ = CompiledPredicate(cols_, fed_conds_); }
+
+    void check_runtime_conds() {
+        for (auto &cond : fed_conds_) {
+            assert(cond.lhs_col.tab_name == tab_name_);
+            if (!cond.is_rhs_val) {
+                assert(cond.rhs_col.tab_name == tab_name_);
+            }
+        }
     }
 };
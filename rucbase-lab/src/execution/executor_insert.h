@@ -51,12 +51,10 @@ class InsertExecutor : public AbstractExecutor {
 		WriteRecord *write_record = new WriteRecord(WType::INSERT_TUPLE, tab_name_, rid_);
         context_->txn_->AppendWriteRecord(write_record);
         //Insert into index'
-		for(size_t i = 0; i< tab_.cols.size();i++){
-			auto &col = tab_.cols[i];
-			if (col.index) {
-	            auto ih = sm_manager_->ihs_.at(sm_manager_->get_ix_manager()->get_index_name(tab_name_, i)).get();
-	            ih->insert_entry(rec.data + col.offset, rid_, context_->txn_);
-            }
+		for(auto &index : tab_.indexes){
+			std::vector<char> key(index.col_tot_len);
+			tab_.get_index_key(index, rec.data, key.data());
+			sm_manager_->get_index_handle(tab_name_, index)->insert_entry(key.data(), rid_, context_->txn_);
 		}
 		return nullptr;
     }
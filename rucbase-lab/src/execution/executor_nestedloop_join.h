@@ -13,6 +13,7 @@ class NestedLoopJoinExecutor : public AbstractExecutor {
     std::vector<ColMeta> cols_;
 
     std::map<TabCol, Value> prev_feed_dict_;
+    TupleBatch right_batch_;  // NextBatch从右孩子读取的一批元组
 
    public:
     NestedLoopJoinExecutor(std::unique_ptr<AbstractExecutor> left, std::unique_ptr<AbstractExecutor> right) {
@@ -37,6 +38,9 @@ class NestedLoopJoinExecutor : public AbstractExecutor {
 
     const std::vector<ColMeta> &cols() const override { return cols_; }
 
+    // 对左孩子的每个元组依次输出匹配的右元组, 保持左孩子的顺序
+    std::vector<OrderByCol> sorted_by() const override { return left_->sorted_by(); }
+
     void beginTuple() override {
         left_->beginTuple();
         if (left_->is_end()) {
@@ -92,6 +96,32 @@ class NestedLoopJoinExecutor : public AbstractExecutor {
         return record;
     }
 
+    /**
+     * @brief 对当前的左元组按批读取右孩子, 左元组每批只读取一次; 右孩子读完后与nextTuple一样移动到下一个左元组
+     */
+    void NextBatch(TupleBatch *batch) override {
+        batch->clear();
+        size_t left_len = left_->tupleLen(), right_len = right_->tupleLen();
+        while (!is_end() && !batch->full()) {
+            auto record_l = left_->Next();
+            right_batch_.reset(right_len, batch->capacity() - batch->size());
+            right_->NextBatch(&right_batch_);
+            for (size_t i = 0; i < right_batch_.size(); i++) {
+                char *record = batch->append();
+                memcpy(record, record_l->data, left_len);
+                memcpy(record + left_len, right_batch_.get(i), right_len);
+            }
+            while (right_->is_end()) {
+                left_->nextTuple();
+                if (left_->is_end()) {
+                    break;
+                }
+                feed_right();
+                right_->beginTuple();
+            }
+        }
+    }
+
     // 递归更新条件谓词
     void feed(const std::map<TabCol, Value> &feed_dict) override {
         prev_feed_dict_ = feed_dict;
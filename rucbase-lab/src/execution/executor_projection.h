@@ -11,6 +11,7 @@ class ProjectionExecutor : public AbstractExecutor {
     std::vector<ColMeta> cols_;
     size_t len_;
     std::vector<size_t> sel_idxs_;
+    TupleBatch prev_batch_;  // NextBatch从孩子读取的一批元组
 
    public:
     ProjectionExecutor(std::unique_ptr<AbstractExecutor> prev, const std::vector<TabCol> &sel_cols) {
@@ -62,6 +63,21 @@ class ProjectionExecutor : public AbstractExecutor {
         return proj_rec;
     }
 
+    void NextBatch(TupleBatch *batch) override {
+        prev_batch_.reset(prev_->tupleLen(), batch->capacity());
+        prev_->NextBatch(&prev_batch_);
+        batch->clear();
+        auto &prev_cols = prev_->cols();
+        for (size_t i = 0; i < prev_batch_.size(); i++) {
+            const char *prev_rec = prev_batch_.get(i);
+            char *proj_rec = batch->append();
+            for (size_t proj_idx = 0; proj_idx < cols_.size(); proj_idx++) {
+                auto &prev_col = prev_cols[sel_idxs_[proj_idx]];
+                memcpy(proj_rec + cols_[proj_idx].offset, prev_rec + prev_col.offset, prev_col.len);
+            }
+        }
+    }
+
     void feed(const std::map<TabCol, Value> &feed_dict) override {
         throw InternalError("Cannot feed a projection node");
     }
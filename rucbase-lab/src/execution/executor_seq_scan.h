@@ -1,9 +1,11 @@
 #pragma once
 
+#include "compiled_predicate.h"
 #include "execution_defs.h"
 #include "execution_manager.h"
 #include "executor_abstract.h"
 #include "index/ix.h"
+#include "page_filter.h"
 #include "system/sm.h"
 
 class SeqScanExecutor : public AbstractExecutor {
@@ -13,10 +15,13 @@ class SeqScanExecutor : public AbstractExecutor {
     RmFileHandle *fh_;              // TableHeap
     std::vector<ColMeta> cols_;
     size_t len_;
-    std::vector<Condition> fed_conds_;  // 实际扫描条件(可能由于连接运算动态改变)
+    std::vector<Condition> fed_conds_;         // 实际扫描条件(可能由于连接运算动态改变)
+    CompiledPredicate pred_;                   // fed_conds_编译后的谓词, 在每条记录上判断
+    std::unique_ptr<PageFilter> page_filter_;  // fed_conds_中有INT/FLOAT列与常量比较时, NextBatch按页面过滤
+    std::vector<int> page_slots_;              // NextBatch中当前页面满足条件的slot号
 
-    Rid rid_;                        // 当前扫描到的记录的rid
-    std::unique_ptr<RecScan> scan_;  // table_iterator
+    Rid rid_;                       // 当前扫描到的记录的rid
+    std::unique_ptr<RmScan> scan_;  // table_iterator
 
     SmManager *sm_manager_;
 
@@ -44,6 +49,7 @@ class SeqScanExecutor : public AbstractExecutor {
             }
         }
         fed_conds_ = conds_;
+        compile_conds();
     }
 
     std::string getType() override { return "SeqScan"; }
@@ -66,7 +72,7 @@ class SeqScanExecutor : public AbstractExecutor {
                 // 利用eval_conds判断是否当前记录(rec.get())满足谓词条件
                 // 满足则中止循环
                 // lab3 task2 todo end
-				if(eval_conds(cols_, fed_conds_,rec.get())){
+				if(pred_.eval(rec->data)){
 					break;
 				}
             } catch (RecordNotFoundError &e) {
@@ -78,7 +84,6 @@ class SeqScanExecutor : public AbstractExecutor {
     }
 
     void nextTuple() override {
-        check_runtime_conds();
         assert(!is_end());
         for (scan_->next(); !scan_->is_end(); scan_->next()) {  // 用TableIterator遍历TableHeap中的所有Tuple
             // lab3 task2 todo
@@ -89,7 +94,7 @@ class SeqScanExecutor : public AbstractExecutor {
 			rid_ = scan_->rid();
 			try {
                 auto rec = fh_->get_record(rid_, context_);
-				if(eval_conds(cols_, fed_conds_,rec.get())){
+				if(pred_.eval(rec->data)){
 					break;
 				}
             } catch (RecordNotFoundError &e) {
@@ -111,6 +116,32 @@ class SeqScanExecutor : public AbstractExecutor {
 		return fh_->get_record(rid_,context_);
     }
 
+    /**
+     * @brief 按页面读取: 每个页面只fetch一次, 在页面中scan_当前位置及之后的记录上判断条件, 满足条件的依次复制到batch中.
+     * batch满时scan_停在下一个满足条件的记录上, 与nextTuple之后的状态相同; 页面处理完后跳到下一个页面
+     */
+    void NextBatch(TupleBatch *batch) override {
+        batch->clear();
+        page_slots_.resize(fh_->get_file_hdr().num_records_per_page);
+        while (!scan_->is_end()) {
+            Rid cur = scan_->rid();
+            RmPageHandle page_handle = fh_->fetch_page_handle(cur.page_no);
+            int count = page_filter_ != nullptr ? page_filter_->filter(page_handle, cur.slot_no, page_slots_.data())
+                                                : eval_page(page_handle, cur.slot_no);
+            int i = 0;
+            for (; i < count && !batch->full(); i++) {
+                batch->push_back(page_handle.get_slot(page_slots_[i]));
+            }
+            sm_manager_->get_bpm()->UnpinPage(page_handle.page->GetPageId(), false);
+            if (i < count) {
+                scan_->seek(Rid{cur.page_no, page_slots_[i]});
+                rid_ = scan_->rid();
+                return;
+            }
+            scan_->seek(Rid{cur.page_no + 1, 0});
+        }
+    }
+
     void feed(const std::map<TabCol, Value> &feed_dict) override {
         fed_conds_ = conds_;
         for (auto &cond : fed_conds_) {
@@ -125,54 +156,41 @@ class SeqScanExecutor : public AbstractExecutor {
             }
         }
         check_runtime_conds();
+        compile_conds();
     }
 
     Rid &rid() override { return rid_; }
 
-    void check_runtime_conds() {
-        for (auto &cond : fed_conds_) {
-            assert(cond.lhs_col.tab_name == tab_name_);
-            if (!cond.is_rhs_val) {
-                assert(cond.rhs_col.tab_name == tab_name_);
+    /**
+     * @brief 没有page_filter_时, 沿页面bitmap逐个判断slot号不小于begin_slot的记录
+     * @return 满足条件的记录数, slot号依次存入page_slots_
+     */
+    int eval_page(const RmPageHandle &page_handle, int begin_slot) {
+        int num_slots = fh_->get_file_hdr().num_records_per_page;
+        int count = 0;
+        for (int slot_no = Bitmap::next_bit(true, page_handle.bitmap, num_slots, begin_slot - 1); slot_no < num_slots;
+             slot_no = Bitmap::next_bit(true, page_handle.bitmap, num_slots, slot_no)) {
+            if (pred_.eval(page_handle.get_slot(slot_no))) {
+                page_slots_[count++] = slot_no;
             }
         }
+        return count;
     }
 
-    bool eval_cond(const std::vector<ColMeta> &rec_cols, const Condition &cond, const RmRecord *rec) {
-        auto lhs_col = get_col(rec_cols, cond.lhs_col);
-        char *lhs = rec->data + lhs_col->offset;
-        char *rhs;
-        ColType rhs_type;
-        if (cond.is_rhs_val) {
-            rhs_type = cond.rhs_val.type;
-            rhs = cond.rhs_val.raw->data;
-        } else {
-            // rhs is a column
-            auto rhs_col = get_col(rec_cols, cond.rhs_col);
-            rhs_type = rhs_col->type;
-            rhs = rec->data + rhs_col->offset;
-        }
-        assert(rhs_type == lhs_col->type);  // TODO convert to common type
-        int cmp = ix_compare(lhs, rhs, rhs_type, lhs_col->len);
-        if (cond.op == OP_EQ) {
-            return cmp == 0;
-        } else if (cond.op == OP_NE) {
-            return cmp != 0;
-        } else if (cond.op == OP_LT) {
-            return cmp < 0;
-        } else if (cond.op == OP_GT) {
-            return cmp > 0;
-        } else if (cond.op == OP_LE) {
-            return cmp <= 0;
-        } else if (cond.op == OP_GE) {
-            return cmp >= 0;
-        } else {
-            throw InternalError("Unexpected op type");
+    void compile_conds() {
+        pred_ = CompiledPredicate(cols_, fed_conds_);
+        page_filter_.reset();
+        if (PageFilter::Supports(cols_, fed_conds_)) {
+            page_filter_ = std::make_unique<PageFilter>(cols_, fed_conds_);
         }
     }
 
-    bool eval_conds(const std::vector<ColMeta> &rec_cols, const std::vector<Condition> &conds, const RmRecord *rec) {
-        return std::all_of(conds.begin(), conds.end(),
-                           [&](const Condition &cond) { return eval_cond(rec_cols, cond, rec); });
+    void check_runtime_conds() {
+        for (auto &cond : fed_conds_) {
+            assert(cond.lhs_col.tab_name == tab_name_);
+            if (!cond.is_rhs_val) {
+                assert(cond.rhs_col.tab_name == tab_name_);
+            }
+        }
     }
 };
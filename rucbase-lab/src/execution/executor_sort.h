@@ -0,0 +1,142 @@
+#pragma once
+
+#include <functional>
+
+#include "execution_defs.h"
+#include "execution_manager.h"
+#include "executor_abstract.h"
+#include "index/ix.h"
+#include "storage/run_merger.h"
+#include "system/sm.h"
+
+/**
+ * @brief 外部归并排序: 读取孩子的元组, 内存中的元组达到memory_budget时排好序作为一个run写入SpillFile;
+ * 所有元组都在内存中时直接输出, 否则用败者树归并所有run. run的个数超过一次能归并的个数(每个run占用一个
+ * SpillFile的块)时, 先分组归并成较少的较长的run. 排序是稳定的: 排序列相等的元组保持孩子中的顺序
+ */
+class SortExecutor : public AbstractExecutor {
+   private:
+    std::unique_ptr<AbstractExecutor> child_;
+    std::vector<OrderByCol> order_;
+    std::vector<ColMeta> key_cols_;  // order_中的各列在孩子元组中的位置
+    size_t len_;
+    DiskManager *disk_manager_;  // 创建run的文件
+    size_t memory_budget_;
+
+    std::vector<char> tuples_;    // 内存中的元组
+    std::vector<size_t> sorted_;  // tuples_中各元组的偏移, 按排序后的顺序
+    size_t pos_ = 0;              // 不溢出时下一个输出的元组在sorted_中的下标
+    std::unique_ptr<RunMerger> merger_;  // 溢出时归并所有run
+
+   public:
+    SortExecutor(std::unique_ptr<AbstractExecutor> child, std::vector<OrderByCol> order, DiskManager *disk_manager,
+                 size_t memory_budget = SORT_MEMORY_BUDGET)
+        : child_(std::move(child)),
+          order_(std::move(order)),
+          len_(child_->tupleLen()),
+          disk_manager_(disk_manager),
+          memory_budget_(memory_budget) {
+        for (auto &order_col : order_) {
+            key_cols_.push_back(*get_col(child_->cols(), order_col.col));
+        }
+    }
+
+    std::string getType() override { return "Sort"; }
+
+    size_t tupleLen() const override { return len_; }
+
+    const std::vector<ColMeta> &cols() const override { return child_->cols(); }
+
+    std::vector<OrderByCol> sorted_by() const override { return order_; }
+
+    void beginTuple() override {
+        tuples_.clear();
+        sorted_.clear();
+        pos_ = 0;
+        merger_.reset();
+        std::vector<std::unique_ptr<SpillFile>> runs;
+        BatchReader reader;
+        for (reader.begin(child_.get()); !reader.is_end(); reader.next()) {
+            tuples_.insert(tuples_.end(), reader.get(), reader.get() + len_);
+            if (tuples_.size() >= memory_budget_) {
+                runs.push_back(write_run());
+            }
+        }
+        if (runs.empty()) {
+            sort_tuples();
+            return;
+        }
+        if (!tuples_.empty()) {
+            runs.push_back(write_run());
+        }
+        auto compare = [this](const char *a, const char *b) { return compare_tuples(a, b); };
+        size_t fan_in = RunMerger::fan_in(memory_budget_, len_);
+        runs = RunMerger::reduce(std::move(runs), disk_manager_, len_, compare, fan_in);
+        merger_ = std::make_unique<RunMerger>(std::move(runs), len_, compare);
+    }
+
+    void nextTuple() override {
+        assert(!is_end());
+        if (merger_ != nullptr) {
+            merger_->pop();
+        } else {
+            pos_++;
+        }
+    }
+
+    bool is_end() const override { return merger_ != nullptr ? merger_->is_end() : pos_ == sorted_.size(); }
+
+    std::unique_ptr<RmRecord> Next() override {
+        assert(!is_end());
+        auto tuple = std::make_unique<RmRecord>(len_);
+        memcpy(tuple->data, merger_ != nullptr ? merger_->top() : &tuples_[sorted_[pos_]], len_);
+        return tuple;
+    }
+
+    void NextBatch(TupleBatch *batch) override {
+        batch->clear();
+        for (; !is_end() && !batch->full(); nextTuple()) {
+            batch->push_back(merger_ != nullptr ? merger_->top() : &tuples_[sorted_[pos_]]);
+        }
+    }
+
+    void feed(const std::map<TabCol, Value> &feed_dict) override { child_->feed(feed_dict); }
+
+    Rid &rid() override { return _abstract_rid; }
+
+   private:
+    void sort_tuples() {
+        sorted_.clear();
+        for (size_t offset = 0; offset < tuples_.size(); offset += len_) {
+            sorted_.push_back(offset);
+        }
+        std::stable_sort(sorted_.begin(), sorted_.end(), [this](size_t a, size_t b) {
+            return compare_tuples(&tuples_[a], &tuples_[b]) < 0;
+        });
+    }
+
+    /**
+     * @brief 把内存中的元组排序后写入一个新的run, 清空内存
+     */
+    std::unique_ptr<SpillFile> write_run() {
+        sort_tuples();
+        auto run = std::make_unique<SpillFile>(disk_manager_, len_);
+        for (size_t offset : sorted_) {
+            run->write(&tuples_[offset]);
+        }
+        tuples_.clear();
+        sorted_.clear();
+        return run;
+    }
+
+    int compare_tuples(const char *a, const char *b) const {
+        for (size_t i = 0; i < key_cols_.size(); i++) {
+            auto &col = key_cols_[i];
+            int cmp = ix_compare(a + col.offset, b + col.offset, col.type, col.len);
+            if (cmp != 0) {
+                return order_[i].desc ? -cmp : cmp;
+            }
+        }
+        return 0;
+    }
+};
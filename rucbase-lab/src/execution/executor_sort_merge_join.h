@@ -0,0 +1,230 @@
+#pragma once
+
+#include "compiled_predicate.h"
+#include "execution_defs.h"
+#include "execution_manager.h"
+#include "executor_abstract.h"
+#include "executor_sort.h"
+#include "index/ix.h"
+#include "system/sm.h"
+
+/**
+ * @brief 排序归并等值连接: 两个孩子都按连接key升序输出, 同时向前推进, 右孩子中key相同的一组元组缓存在内存中,
+ * 与key相同的每个左元组连接. 孩子已经有序(如索引扫描)时直接归并, 否则套一个SortExecutor.
+ * 结果按左孩子的顺序, 同一个左元组的匹配按右孩子的顺序
+ */
+class SortMergeJoinExecutor : public AbstractExecutor {
+   private:
+    std::unique_ptr<AbstractExecutor> left_;
+    std::unique_ptr<AbstractExecutor> right_;
+    size_t len_;
+    std::vector<ColMeta> cols_;
+    std::vector<ColMeta> left_keys_;   // 归并使用的等值连接条件在左孩子中的列
+    std::vector<ColMeta> right_keys_;  // 对应的右孩子中的列
+    std::vector<Condition> conds_;     // 其余的连接条件, 在连接结果上判断
+    CompiledPredicate pred_;           // conds_编译后的谓词
+
+    BatchReader left_reader_, right_reader_;  // 按批读取两个孩子
+    std::vector<char> group_;                 // 右孩子中key与当前左元组相同的元组
+    size_t group_size_ = 0;
+    std::unique_ptr<RmRecord> left_tuple_;  // 当前的左元组
+    size_t match_idx_ = 0;                  // 下一个与left_tuple_连接的元组在group_中的下标
+    std::unique_ptr<RmRecord> joined_;      // 当前的连接结果
+    bool is_end_ = true;
+
+   public:
+    /**
+     * @param conds 两个孩子之间的连接条件, 至少有一个等值条件
+     * @param disk_manager 孩子需要排序时, 排序溢出的run写入的位置
+     */
+    SortMergeJoinExecutor(std::unique_ptr<AbstractExecutor> left, std::unique_ptr<AbstractExecutor> right,
+                          std::vector<Condition> conds, DiskManager *disk_manager)
+        : left_(std::move(left)), right_(std::move(right)) {
+        len_ = left_->tupleLen() + right_->tupleLen();
+        cols_ = left_->cols();
+        auto right_cols = right_->cols();
+        for (auto &col : right_cols) {
+            col.offset += left_->tupleLen();
+        }
+        cols_.insert(cols_.end(), right_cols.begin(), right_cols.end());
+
+        // 等值条件, 左边的列在前
+        std::vector<std::pair<TabCol, TabCol>> eq_cols;
+        for (auto &cond : conds) {
+            assert(!cond.is_rhs_val);
+            if (cond.op != OP_EQ) {
+                conds_.push_back(cond);
+                continue;
+            }
+            bool in_left = std::any_of(left_->cols().begin(), left_->cols().end(), [&](const ColMeta &col) {
+                return col.tab_name == cond.lhs_col.tab_name && col.name == cond.lhs_col.col_name;
+            });
+            eq_cols.emplace_back(in_left ? cond.lhs_col : cond.rhs_col, in_left ? cond.rhs_col : cond.lhs_col);
+        }
+        assert(!eq_cols.empty());
+        // 左孩子已经依次按某些连接列有序时只用这些列归并, 不需要对左孩子排序; 否则按所有等值条件排序
+        std::vector<OrderByCol> left_order, right_order;
+        auto left_sorted = left_->sorted_by();
+        for (auto &order_col : left_sorted) {
+            auto it = std::find_if(eq_cols.begin(), eq_cols.end(),
+                                   [&](const std::pair<TabCol, TabCol> &eq) { return eq.first == order_col.col; });
+            if (order_col.desc || it == eq_cols.end()) {
+                break;
+            }
+            left_order.push_back({.col = it->first, .desc = false});
+            right_order.push_back({.col = it->second, .desc = false});
+            eq_cols.erase(it);
+        }
+        if (left_order.empty()) {
+            for (auto &eq : eq_cols) {
+                left_order.push_back({.col = eq.first, .desc = false});
+                right_order.push_back({.col = eq.second, .desc = false});
+            }
+            eq_cols.clear();
+        }
+        for (auto &eq : eq_cols) {
+            Condition cond;
+            cond.lhs_col = eq.first;
+            cond.op = OP_EQ;
+            cond.is_rhs_val = false;
+            cond.rhs_col = eq.second;
+            conds_.push_back(cond);
+        }
+        pred_ = CompiledPredicate(cols_, conds_);
+        for (size_t i = 0; i < left_order.size(); i++) {
+            left_keys_.push_back(*get_col(left_->cols(), left_order[i].col));
+            right_keys_.push_back(*get_col(right_->cols(), right_order[i].col));
+        }
+        if (!has_order_prefix(left_sorted, left_order)) {
+            left_ = std::make_unique<SortExecutor>(std::move(left_), left_order, disk_manager);
+        }
+        if (!has_order_prefix(right_->sorted_by(), right_order)) {
+            right_ = std::make_unique<SortExecutor>(std::move(right_), right_order, disk_manager);
+        }
+    }
+
+    std::string getType() override { return "SortMergeJoin"; }
+
+    size_t tupleLen() const override { return len_; }
+
+    const std::vector<ColMeta> &cols() const override { return cols_; }
+
+    std::vector<OrderByCol> sorted_by() const override { return left_->sorted_by(); }
+
+    void beginTuple() override {
+        joined_ = std::make_unique<RmRecord>(len_);
+        left_tuple_ = std::make_unique<RmRecord>(left_->tupleLen());
+        left_reader_.begin(left_.get());
+        right_reader_.begin(right_.get());
+        group_.clear();
+        group_size_ = 0;
+        match_idx_ = 0;
+        is_end_ = false;
+        find_match();
+    }
+
+    void nextTuple() override {
+        assert(!is_end());
+        match_idx_++;
+        find_match();
+    }
+
+    bool is_end() const override { return is_end_; }
+
+    std::unique_ptr<RmRecord> Next() override {
+        assert(!is_end());
+        return std::make_unique<RmRecord>(*joined_);
+    }
+
+    void NextBatch(TupleBatch *batch) override {
+        batch->clear();
+        for (; !is_end() && !batch->full(); nextTuple()) {
+            batch->push_back(joined_->data);
+        }
+    }
+
+    // 右孩子在beginTuple中从头归并, 连接条件只对左孩子更新
+    void feed(const std::map<TabCol, Value> &feed_dict) override { left_->feed(feed_dict); }
+
+    Rid &rid() override { return _abstract_rid; }
+
+   private:
+    /**
+     * @brief 从当前位置开始找到下一个满足其余连接条件的连接结果, 存入joined_
+     */
+    void find_match() {
+        size_t left_len = left_->tupleLen(), right_len = right_->tupleLen();
+        while (true) {
+            for (; match_idx_ < group_size_; match_idx_++) {
+                memcpy(joined_->data, left_tuple_->data, left_len);
+                memcpy(joined_->data + left_len, &group_[match_idx_ * right_len], right_len);
+                if (pred_.eval(joined_->data)) {
+                    return;
+                }
+            }
+            if (left_reader_.is_end()) {
+                is_end_ = true;
+                return;
+            }
+            memcpy(left_tuple_->data, left_reader_.get(), left_tuple_->size);
+            left_reader_.next();
+            match_idx_ = 0;
+            load_group();
+        }
+    }
+
+    /**
+     * @brief 准备与left_tuple_的key相同的右元组: 与上一个左元组的key相同时沿用group_,
+     * 否则跳过右孩子中key更小的元组, 读出key相同的一组
+     */
+    void load_group() {
+        size_t right_len = right_->tupleLen();
+        if (group_size_ > 0 && compare_keys(left_tuple_->data, group_.data()) == 0) {
+            return;
+        }
+        group_.clear();
+        group_size_ = 0;
+        for (; !right_reader_.is_end(); right_reader_.next()) {
+            const char *tuple = right_reader_.get();
+            int cmp = compare_keys(left_tuple_->data, tuple);
+            if (cmp < 0) {
+                break;
+            }
+            if (cmp == 0) {
+                group_.insert(group_.end(), tuple, tuple + right_len);
+                group_size_++;
+            }
+        }
+    }
+
+    /**
+     * @brief 比较左元组与右元组的连接key. 两边CHAR的长度不同时, 较短的一边视为用'\0'补齐
+     */
+    int compare_keys(const char *left, const char *right) const {
+        for (size_t i = 0; i < left_keys_.size(); i++) {
+            auto &lcol = left_keys_[i];
+            auto &rcol = right_keys_[i];
+            const char *a = left + lcol.offset;
+            const char *b = right + rcol.offset;
+            int cmp;
+            if (lcol.type == TYPE_STRING && lcol.len != rcol.len) {
+                int len = std::min(lcol.len, rcol.len);
+                cmp = memcmp(a, b, len);
+                if (cmp == 0) {
+                    auto nonzero = [](char c) { return c != 0; };
+                    if (std::any_of(a + len, a + lcol.len, nonzero)) {
+                        cmp = 1;
+                    } else if (std::any_of(b + len, b + rcol.len, nonzero)) {
+                        cmp = -1;
+                    }
+                }
+            } else {
+                cmp = ix_compare(a, b, lcol.type, lcol.len);
+            }
+            if (cmp != 0) {
+                return cmp;
+            }
+        }
+        return 0;
+    }
+};
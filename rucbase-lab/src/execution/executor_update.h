@@ -29,15 +29,20 @@ class UpdateExecutor : public AbstractExecutor {
     }
     std::unique_ptr<RmRecord> Next() override {
         // Get all necessary index files
-        std::vector<IxIndexHandle *> ihs(tab_.cols.size(), nullptr);
-        for (auto &set_clause : set_clauses_) {
-            auto lhs_col = tab_.get_col(set_clause.lhs.col_name);
-            if (lhs_col->index) {
-                size_t lhs_col_idx = lhs_col - tab_.cols.begin();
+        // 只有包含被更新列的索引需要维护
+        std::vector<const IndexMeta *> indexes;
+        std::vector<IxIndexHandle *> ihs;
+        for (auto &index : tab_.indexes) {
+            bool updated = std::any_of(set_clauses_.begin(), set_clauses_.end(), [&](const SetClause &set_clause) {
+                int col_idx = tab_.get_col(set_clause.lhs.col_name) - tab_.cols.begin();
+                return std::find(index.col_idxs.begin(), index.col_idxs.end(), col_idx) != index.col_idxs.end();
+            });
+            if (updated) {
                 // lab3 task3 Todo
                 // 获取需要的索引句柄,填充vector ihs
                 // lab3 task3 Todo end
-				ihs[lhs_col_idx] = sm_manager_->ihs_.at(sm_manager_->get_ix_manager()->get_index_name(tab_name_, lhs_col_idx)).get();
+                indexes.push_back(&index);
+                ihs.push_back(sm_manager_->get_index_handle(tab_name_, index));
             }
         }
         // Update each rid from record file and index file
@@ -46,15 +51,16 @@ class UpdateExecutor : public AbstractExecutor {
             // lab3 task3 Todo
             // Remove old entry from index
             // lab3 task3 Todo end
+			//delete each old entry
+			for(size_t i = 0; i < indexes.size(); i++) {
+				std::vector<char> key(indexes[i]->col_tot_len);
+				tab_.get_index_key(*indexes[i], rec->data, key.data());
+				ihs[i]->delete_entry(key.data(), rid, context_->txn_);
+			}
+			//update each rid
 			for(auto &set_clause : set_clauses_) {
 				auto lhs_col = tab_.get_col(set_clause.lhs.col_name);
-				//update each rid
 				memcpy(rec->data + lhs_col->offset, set_clause.rhs.raw->data, lhs_col->len);
-				//delete each old entry
-				if(lhs_col->index){
-					size_t lhs_col_idx = lhs_col - tab_.cols.begin();
-					ihs[lhs_col_idx]->delete_entry(rec->data + lhs_col->offset, context_->txn_);
-				}
 			}
 
             // record a update operation into the transaction
@@ -70,13 +76,11 @@ class UpdateExecutor : public AbstractExecutor {
             // lab3 task3 Todo
             // Insert new entry into index
             // lab3 task3 Todo end
-			for(auto &set_clause : set_clauses_) {
-                auto lhs_col = tab_.get_col(set_clause.lhs.col_name);
-                if(lhs_col->index) {
-                    size_t lhs_col_idx = lhs_col - tab_.cols.begin();
-                    auto ih = sm_manager_->ihs_.at(sm_manager_->get_ix_manager()->get_index_name(tab_name_, lhs_col_idx)).get();
-                    ih->insert_entry(rec->data + lhs_col->offset, rid, context_->txn_);}
-            }
+			for(size_t i = 0; i < indexes.size(); i++) {
+				std::vector<char> key(indexes[i]->col_tot_len);
+				tab_.get_index_key(*indexes[i], rec->data, key.data());
+				ihs[i]->insert_entry(key.data(), rid, context_->txn_);
+			}
         }
         return nullptr;
     }
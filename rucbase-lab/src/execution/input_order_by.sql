@@ -0,0 +1,25 @@
+create table student (id int, name char(32), major char(32));
+create table grade (course char(32), student_id int, score float);
+create index grade (student_id);
+insert into student values (2, 'Jerry', 'Computer Science');
+insert into student values (4, 'Mike', 'Mathematics');
+insert into student values (1, 'Tom', 'Computer Science');
+insert into student values (3, 'Jack', 'Electrical Engineering');
+insert into grade values ('Data Structure', 1, 90.0);
+insert into grade values ('Data Structure', 2, 95.0);
+insert into grade values ('Calculus', 2, 82.0);
+insert into grade values ('Calculus', 1, 88.5);
+insert into grade values ('Calculus', 3, 70.0);
+insert into grade values ('Linear Algebra', 4, 88.5);
+select * from student order by id;
+select * from student order by id asc;
+select * from student order by id desc;
+select * from student where id > 1 order by name DESC;
+select * from student order by major, id desc;
+select id, name from student order by major desc, name asc;
+select * from grade order by score desc, course;
+select * from grade where student_id >= 2 order by student_id desc;
+select id, name, course, score from student, grade where student.id = grade.student_id order by score, name;
+select id, name, course, score from student join grade where student.id = grade.student_id order by id desc, course asc;
+drop table student;
+drop table grade;
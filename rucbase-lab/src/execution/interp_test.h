@@ -15,12 +15,15 @@ const char *help_info =
     "command:\n"
     "  CREATE TABLE table_name (column_name type [, column_name type ...])\n"
     "  DROP TABLE table_name\n"
-    "  CREATE INDEX table_name (column_name)\n"
-    "  DROP INDEX table_name (column_name)\n"
+    "  CREATE INDEX table_name (column_name [, column_name ...])\n"
+    "  DROP INDEX table_name (column_name [, column_name ...])\n"
+    "  VACUUM table_name\n"
+    "  SHOW BUFFER STATS\n"
+    "  SHOW INDEX STATS\n"
     "  INSERT INTO table_name VALUES (value [, value ...])\n"
     "  DELETE FROM table_name [WHERE where_clause]\n"
     "  UPDATE table_name SET column_name = value [, column_name = value ...] [WHERE where_clause]\n"
-    "  SELECT selector FROM table_name [WHERE where_clause]\n"
+    "  SELECT selector FROM table_name [WHERE where_clause] [ORDER BY order_column [, order_column ...]]\n"
     "type:\n"
     "  {INT | FLOAT | CHAR(n)}\n"
     "where_clause:\n"
@@ -31,6 +34,8 @@ const char *help_info =
     "  [table_name.]column_name\n"
     "op:\n"
     "  {= | <> | < | > | <= | >=}\n"
+    "order_column:\n"
+    "  column [ASC | DESC]\n"
     "selector:\n"
     "  {* | column [, column ...]}\n";
 
@@ -51,6 +56,16 @@ class InterpForTest {
             // show tables;
             sm_manager_->show_tables(context);
 
+        } else if (auto x = std::dynamic_pointer_cast<ast::ShowBufferStats>(root)) {
+            // show buffer stats;
+
+            sm_manager_->show_buffer_stats(context);
+
+        } else if (auto x = std::dynamic_pointer_cast<ast::ShowIndexStats>(root)) {
+            // show index stats;
+
+            sm_manager_->show_index_stats(context);
+
         } else if (auto x = std::dynamic_pointer_cast<ast::DescTable>(root)) {
             // desc table;
 
@@ -80,12 +95,17 @@ class InterpForTest {
         } else if (auto x = std::dynamic_pointer_cast<ast::CreateIndex>(root)) {
             // create index;
 
-            sm_manager_->create_index(x->tab_name, x->col_name, context);
+            sm_manager_->create_index(x->tab_name, x->col_names, context);
 
         } else if (auto x = std::dynamic_pointer_cast<ast::DropIndex>(root)) {
             // drop index
 
-            sm_manager_->drop_index(x->tab_name, x->col_name, context);
+            sm_manager_->drop_index(x->tab_name, x->col_names, context);
+
+        } else if (auto x = std::dynamic_pointer_cast<ast::VacuumTable>(root)) {
+            // vacuum table
+
+            sm_manager_->vacuum_table(x->tab_name, context);
 
         } else if (auto x = std::dynamic_pointer_cast<ast::InsertStmt>(root)) {
             // insert;
@@ -122,8 +142,13 @@ class InterpForTest {
                 TabCol sel_col = {.tab_name = sv_sel_col->tab_name, .col_name = sv_sel_col->col_name};
                 sel_cols.push_back(sel_col);
             }
+            std::vector<OrderByCol> order_cols;
+            for (auto &sv_order : x->orders) {
+                TabCol order_col = {.tab_name = sv_order->col->tab_name, .col_name = sv_order->col->col_name};
+                order_cols.push_back({.col = order_col, .desc = sv_order->desc});
+            }
 
-            ql_manager_->select_from(sel_cols, x->tabs, conds, context);
+            ql_manager_->select_from(sel_cols, x->tabs, conds, order_cols, context);
 
         } else {
             throw InternalError("Unexpected AST root");
@@ -34,5 +34,13 @@ if [ "$result" == "$pass" ];then
 else 
     echo -e "\033[34mlab03 taskall failed\033[0m"
 fi
+
+chmod 755 order_by_test.sh
+result=$(./order_by_test.sh | tail -n 1)
+if [ "$result" == "$pass" ];then
+    echo -e "\033[34mlab03 order by passed\033[0m"
+else 
+    echo -e "\033[34mlab03 order by failed\033[0m"
+fi
 cd -
 
@@ -0,0 +1,255 @@
+#include "page_filter.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <type_traits>
+
+#include "errors.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief bitmap中slot按字节的最高位在前(Bitmap::get_bit), 选择掩码中按最低位在前, 与movemask的顺序一致
+ */
+static constexpr std::array<uint8_t, 256> MakeReverseTable() {
+    std::array<uint8_t, 256> table{};
+    for (int b = 0; b < 256; b++) {
+        int r = 0;
+        for (int k = 0; k < 8; k++) {
+            r |= ((b >> k) & 1) << (7 - k);
+        }
+        table[b] = static_cast<uint8_t>(r);
+    }
+    return table;
+}
+
+static constexpr std::array<uint8_t, 256> reverse_bits = MakeReverseTable();
+
+template <typename T>
+static inline T Load(const char *p) {
+    T val;
+    memcpy(&val, p, sizeof(T));
+    return val;
+}
+
+template <typename T>
+static inline T TermValue(const PageFilter::Term &term) {
+    if constexpr (std::is_same_v<T, int>) {
+        return term.int_val;
+    } else {
+        return term.float_val;
+    }
+}
+
+/**
+ * @brief 逐个slot计算, 只计算选择掩码中还剩下的记录
+ */
+template <typename T, CompOp op>
+static void ScalarKernel(const PageFilter::Term &term, const char *slots, int record_size, int group_begin,
+                         int group_end, uint8_t *masks) {
+    T val = TermValue<T>(term);
+    for (int g = group_begin; g < group_end; g++) {
+        unsigned mask = masks[g];
+        unsigned keep = 0;
+        while (mask != 0) {
+            int k = __builtin_ctz(mask);
+            mask &= mask - 1;
+            const char *rec = slots + static_cast<size_t>(g * 8 + k) * record_size;
+            keep |= static_cast<unsigned>(compare_op<op>(Load<T>(rec + term.offset), val)) << k;
+        }
+        masks[g] = static_cast<uint8_t>(keep);
+    }
+}
+
+#if defined(__x86_64__)
+/**
+ * @brief 比较8个INT, 每个lane全1表示满足; AVX2只有相等和大于, 其余由它们取反或交换得到
+ */
+template <CompOp op>
+__attribute__((target("avx2"))) static inline __m256i Avx2CompareInt(__m256i v, __m256i t) {
+    const __m256i ones = _mm256_set1_epi32(-1);
+    if constexpr (op == OP_EQ) {
+        return _mm256_cmpeq_epi32(v, t);
+    } else if constexpr (op == OP_NE) {
+        return _mm256_xor_si256(_mm256_cmpeq_epi32(v, t), ones);
+    } else if constexpr (op == OP_LT) {
+        return _mm256_cmpgt_epi32(t, v);
+    } else if constexpr (op == OP_GT) {
+        return _mm256_cmpgt_epi32(v, t);
+    } else if constexpr (op == OP_LE) {
+        return _mm256_xor_si256(_mm256_cmpgt_epi32(v, t), ones);
+    } else {
+        return _mm256_xor_si256(_mm256_cmpgt_epi32(t, v), ones);
+    }
+}
+
+/**
+ * @brief 比较8个FLOAT, 与标量比较一样遇到NaN时只有!=成立
+ */
+template <CompOp op>
+__attribute__((target("avx2"))) static inline __m256 Avx2CompareFloat(__m256 v, __m256 t) {
+    if constexpr (op == OP_EQ) {
+        return _mm256_cmp_ps(v, t, _CMP_EQ_OQ);
+    } else if constexpr (op == OP_NE) {
+        return _mm256_cmp_ps(v, t, _CMP_NEQ_UQ);
+    } else if constexpr (op == OP_LT) {
+        return _mm256_cmp_ps(v, t, _CMP_LT_OQ);
+    } else if constexpr (op == OP_GT) {
+        return _mm256_cmp_ps(v, t, _CMP_GT_OQ);
+    } else if constexpr (op == OP_LE) {
+        return _mm256_cmp_ps(v, t, _CMP_LE_OQ);
+    } else {
+        return _mm256_cmp_ps(v, t, _CMP_GE_OQ);
+    }
+}
+
+/**
+ * @brief 每次从8个相邻的记录中按记录长度的步长gather出该列, 比较得到8位掩码; 已经全部排除的组跳过
+ */
+template <typename T, CompOp op>
+__attribute__((target("avx2"))) static void Avx2Kernel(const PageFilter::Term &term, const char *slots,
+                                                       int record_size, int group_begin, int group_end,
+                                                       uint8_t *masks) {
+    const __m256i strides =
+        _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(record_size));
+    const char *col = slots + term.offset;
+    const __m256i int_val = _mm256_set1_epi32(term.int_val);
+    const __m256 float_val = _mm256_set1_ps(term.float_val);
+    for (int g = group_begin; g < group_end; g++) {
+        if (masks[g] == 0) {
+            continue;
+        }
+        const char *base = col + static_cast<size_t>(g) * 8 * record_size;
+        int bits;
+        if constexpr (std::is_same_v<T, int>) {
+            __m256i v = _mm256_i32gather_epi32(reinterpret_cast<const int *>(base), strides, 1);
+            __m256i cmp = Avx2CompareInt<op>(v, int_val);
+            bits = _mm256_movemask_ps(_mm256_castsi256_ps(cmp));
+        } else {
+            __m256 v = _mm256_i32gather_ps(reinterpret_cast<const float *>(base), strides, 1);
+            bits = _mm256_movemask_ps(Avx2CompareFloat<op>(v, float_val));
+        }
+        masks[g] &= static_cast<uint8_t>(bits);
+    }
+}
+#endif
+
+template <typename T, CompOp op>
+static void SelectKernels(PageFilter::Term *term, PageFilterIsa isa) {
+    term->scalar = ScalarKernel<T, op>;
+    term->kernel = term->scalar;
+#if defined(__x86_64__)
+    if (isa == PageFilterIsa::AVX2) {
+        term->kernel = Avx2Kernel<T, op>;
+    }
+#endif
+}
+
+template <typename T>
+static void SelectKernels(PageFilter::Term *term, CompOp op, PageFilterIsa isa) {
+    switch (op) {
+        case OP_EQ:
+            return SelectKernels<T, OP_EQ>(term, isa);
+        case OP_NE:
+            return SelectKernels<T, OP_NE>(term, isa);
+        case OP_LT:
+            return SelectKernels<T, OP_LT>(term, isa);
+        case OP_GT:
+            return SelectKernels<T, OP_GT>(term, isa);
+        case OP_LE:
+            return SelectKernels<T, OP_LE>(term, isa);
+        case OP_GE:
+            return SelectKernels<T, OP_GE>(term, isa);
+        default:
+            throw InternalError("Unexpected op type");
+    }
+}
+
+/** @return 条件的左边是INT/FLOAT列且右边是常量时, 返回该列; 否则返回nullptr */
+static const ColMeta *PageTermCol(const std::vector<ColMeta> &cols, const Condition &cond) {
+    if (!cond.is_rhs_val) {
+        return nullptr;
+    }
+    auto pos = std::find_if(cols.begin(), cols.end(), [&](const ColMeta &col) {
+        return col.tab_name == cond.lhs_col.tab_name && col.name == cond.lhs_col.col_name;
+    });
+    if (pos == cols.end() || (pos->type != TYPE_INT && pos->type != TYPE_FLOAT)) {
+        return nullptr;
+    }
+    return &*pos;
+}
+
+PageFilter::PageFilter(const std::vector<ColMeta> &cols, const std::vector<Condition> &conds, PageFilterIsa isa) {
+    if (isa > GetBestIsa()) {
+        isa = GetBestIsa();
+    }
+    std::vector<Condition> residual;
+    for (auto &cond : conds) {
+        const ColMeta *col = PageTermCol(cols, cond);
+        if (col == nullptr) {
+            residual.push_back(cond);
+            continue;
+        }
+        assert(cond.rhs_val.type == col->type);
+        Term term{};
+        term.offset = col->offset;
+        if (col->type == TYPE_INT) {
+            memcpy(&term.int_val, cond.rhs_val.raw->data, sizeof(int));
+            SelectKernels<int>(&term, cond.op, isa);
+        } else {
+            memcpy(&term.float_val, cond.rhs_val.raw->data, sizeof(float));
+            SelectKernels<float>(&term, cond.op, isa);
+        }
+        terms_.push_back(term);
+    }
+    residual_ = CompiledPredicate(cols, residual);
+}
+
+bool PageFilter::Supports(const std::vector<ColMeta> &cols, const std::vector<Condition> &conds) {
+    return std::any_of(conds.begin(), conds.end(),
+                       [&](const Condition &cond) { return PageTermCol(cols, cond) != nullptr; });
+}
+
+PageFilterIsa PageFilter::GetBestIsa() {
+#if defined(__x86_64__)
+    static const PageFilterIsa best_isa =
+        __builtin_cpu_supports("avx2") ? PageFilterIsa::AVX2 : PageFilterIsa::SCALAR;
+    return best_isa;
+#else
+    return PageFilterIsa::SCALAR;
+#endif
+}
+
+int PageFilter::filter(const char *bitmap, const char *slots, int num_slots, int record_size, int begin_slot,
+                       int *slot_nos) const {
+    int num_groups = (num_slots + 7) / 8;
+    int full_groups = num_slots / 8;  // 8个slot都在页面中的组, 之后的组gather会越过页面
+    int group_begin = begin_slot / 8;
+    masks_.resize(num_groups);
+    for (int g = group_begin; g < num_groups; g++) {
+        masks_[g] = reverse_bits[static_cast<uint8_t>(bitmap[g])];
+    }
+    if (group_begin < num_groups) {
+        masks_[group_begin] &= static_cast<uint8_t>(0xffu << (begin_slot % 8));
+    }
+    if (num_slots % 8 != 0) {
+        masks_[num_groups - 1] &= static_cast<uint8_t>((1u << (num_slots % 8)) - 1);
+    }
+    for (auto &term : terms_) {
+        term.kernel(term, slots, record_size, group_begin, std::max(group_begin, full_groups), masks_.data());
+        term.scalar(term, slots, record_size, std::max(group_begin, full_groups), num_groups, masks_.data());
+    }
+    int count = 0;
+    for (int g = group_begin; g < num_groups; g++) {
+        for (unsigned mask = masks_[g]; mask != 0; mask &= mask - 1) {
+            int slot_no = g * 8 + __builtin_ctz(mask);
+            if (residual_.empty() || residual_.eval(slots + static_cast<size_t>(slot_no) * record_size)) {
+                slot_nos[count++] = slot_no;
+            }
+        }
+    }
+    return count;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "compiled_predicate.h"
+#include "execution_manager.h"
+#include "record/rm_file_handle.h"
+
+/** 页面过滤使用的指令集 */
+enum class PageFilterIsa { SCALAR, AVX2 };
+
+/**
+ * @brief 按页面过滤记录: 一次计算一个页面中所有记录是否满足条件, 输出满足条件的slot号.
+ * 每个页面维护一个选择掩码(每8个slot一个字节), 初始为页面bitmap中已使用的slot; 对于INT/FLOAT列与常量比较的条件,
+ * 按ColMeta::offset和记录长度的步长一次取出8个记录中的该列(AVX2 gather), 比较得到8位掩码后与选择掩码相与.
+ * 其余条件(CHAR列, 两列比较)在剩下的记录上由CompiledPredicate逐条判断
+ */
+class PageFilter {
+   public:
+    struct Term;
+    /** 在[group_begin, group_end)这些8个slot一组的记录上计算term, 结果与masks相与 */
+    using KernelFn = void (*)(const Term &term, const char *slots, int record_size, int group_begin, int group_end,
+                              uint8_t *masks);
+
+    /** INT/FLOAT列与常量的一个比较 */
+    struct Term {
+        int offset;  // 列在记录中的位置
+        int int_val;
+        float float_val;
+        KernelFn kernel;  // 按指令集选择, 只处理8个slot都在页面中的组
+        KernelFn scalar;  // 页面末尾不满8个slot的组
+    };
+
+   private:
+    std::vector<Term> terms_;
+    CompiledPredicate residual_;          // 不能按页面计算的条件
+    mutable std::vector<uint8_t> masks_;  // 当前页面的选择掩码, 第g个字节的第k位对应slot 8g+k
+
+   public:
+    /**
+     * @param cols 记录的各列
+     * @param conds 合取的条件, 左边是cols中的列
+     * @param isa 使用的指令集, CPU不支持时退回到标量实现
+     */
+    PageFilter(const std::vector<ColMeta> &cols, const std::vector<Condition> &conds,
+               PageFilterIsa isa = GetBestIsa());
+
+    /** @return conds中是否有可以按页面计算的条件(INT/FLOAT列与常量比较) */
+    static bool Supports(const std::vector<ColMeta> &cols, const std::vector<Condition> &conds);
+
+    /** @return 当前CPU支持的最好的指令集 */
+    static PageFilterIsa GetBestIsa();
+
+    /**
+     * @brief 过滤一个页面中slot号不小于begin_slot的记录
+     * @param bitmap 页面的bitmap, 只有已使用的slot参与过滤
+     * @param slots 第一个slot的位置
+     * @param slot_nos 按slot号递增输出满足条件的slot号, 至少能容纳num_slots - begin_slot个
+     * @return 满足条件的记录数
+     */
+    int filter(const char *bitmap, const char *slots, int num_slots, int record_size, int begin_slot,
+               int *slot_nos) const;
+
+    int filter(const RmPageHandle &page_handle, int begin_slot, int *slot_nos) const {
+        return filter(page_handle.bitmap, page_handle.slots, page_handle.file_hdr->num_records_per_page,
+                      page_handle.file_hdr->record_size, begin_slot, slot_nos);
+    }
+};
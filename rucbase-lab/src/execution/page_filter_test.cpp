@@ -0,0 +1,195 @@
+#undef NDEBUG
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "page_filter.h"
+#include "record/bitmap.h"
+
+static const PageFilterIsa all_isas[] = {PageFilterIsa::SCALAR, PageFilterIsa::AVX2};
+
+/**
+ * @brief 在内存中构造与记录页面相同布局的bitmap和slots: t(a int, b float, c char(7), d int), 记录长度19,
+ * 使各列在slots中不对齐
+ */
+class PageFilterTest : public ::testing::Test {
+   public:
+    std::vector<ColMeta> cols_;
+    int record_size_ = 0;
+    std::mt19937 rng_{0};
+
+   public:
+    void SetUp() override {
+        ::testing::Test::SetUp();
+        std::vector<std::pair<std::string, ColType>> defs = {
+            {"a", TYPE_INT}, {"b", TYPE_FLOAT}, {"c", TYPE_STRING}, {"d", TYPE_INT}};
+        for (auto &[name, type] : defs) {
+            ColMeta col = {.tab_name = "t", .name = name, .type = type, .len = type == TYPE_STRING ? 7 : 4,
+                           .offset = record_size_, .index = false};
+            record_size_ += col.len;
+            cols_.push_back(col);
+        }
+    }
+
+    /** @brief 随机填充num_slots个记录, 每个slot以fill_ratio的概率被使用 */
+    void random_page(int num_slots, double fill_ratio, std::vector<char> *bitmap, std::vector<char> *slots) {
+        bitmap->assign((num_slots + 7) / 8, 0);
+        slots->assign(static_cast<size_t>(num_slots) * record_size_, 0);
+        std::uniform_real_distribution<double> dist(0, 1);
+        for (int i = 0; i < num_slots; i++) {
+            if (dist(rng_) < fill_ratio) {
+                Bitmap::set(bitmap->data(), i);
+            }
+            char *rec = slots->data() + static_cast<size_t>(i) * record_size_;
+            int a = static_cast<int>(rng_() % 64) - 32;
+            float b = static_cast<float>(static_cast<int>(rng_() % 64) - 32) / 4;
+            int d = static_cast<int>(rng_());
+            memcpy(rec, &a, sizeof(int));
+            memcpy(rec + 4, &b, sizeof(float));
+            rec[8] = static_cast<char>('a' + rng_() % 4);
+            memcpy(rec + 15, &d, sizeof(int));
+        }
+    }
+
+    Condition value_cond(const std::string &col_name, CompOp op, const void *val) {
+        auto &col = *std::find_if(cols_.begin(), cols_.end(), [&](const ColMeta &c) { return c.name == col_name; });
+        Condition cond;
+        cond.lhs_col = {.tab_name = "t", .col_name = col_name};
+        cond.op = op;
+        cond.is_rhs_val = true;
+        cond.rhs_val.type = col.type;
+        cond.rhs_val.raw = std::make_shared<RmRecord>(col.len);
+        memcpy(cond.rhs_val.raw->data, val, col.len);
+        return cond;
+    }
+
+    /** @brief 随机生成条件: a, b与常量比较(可按页面计算), 有时加上c与常量或a与d比较(由CompiledPredicate计算) */
+    std::vector<Condition> random_conds() {
+        std::vector<Condition> conds;
+        int num_conds = 1 + static_cast<int>(rng_() % 3);
+        for (int i = 0; i < num_conds; i++) {
+            auto op = static_cast<CompOp>(rng_() % 6);
+            if (rng_() % 2 == 0) {
+                int val = static_cast<int>(rng_() % 64) - 32;
+                conds.push_back(value_cond("a", op, &val));
+            } else {
+                float val = static_cast<float>(static_cast<int>(rng_() % 64) - 32) / 4;
+                conds.push_back(value_cond("b", op, &val));
+            }
+        }
+        if (rng_() % 3 == 0) {
+            char val[7] = {static_cast<char>('a' + rng_() % 4)};
+            conds.push_back(value_cond("c", static_cast<CompOp>(rng_() % 6), val));
+        }
+        if (rng_() % 3 == 0) {
+            Condition cond;
+            cond.lhs_col = {.tab_name = "t", .col_name = "a"};
+            cond.op = OP_LT;
+            cond.is_rhs_val = false;
+            cond.rhs_col = {.tab_name = "t", .col_name = "d"};
+            conds.push_back(cond);
+        }
+        return conds;
+    }
+
+    /** @brief 逐个slot用CompiledPredicate判断, 作为参照 */
+    std::vector<int> reference_filter(const std::vector<Condition> &conds, const std::vector<char> &bitmap,
+                                      const std::vector<char> &slots, int num_slots, int begin_slot) {
+        CompiledPredicate pred(cols_, conds);
+        std::vector<int> result;
+        for (int i = begin_slot; i < num_slots; i++) {
+            if (Bitmap::is_set(bitmap.data(), i) && pred.eval(slots.data() + static_cast<size_t>(i) * record_size_)) {
+                result.push_back(i);
+            }
+        }
+        return result;
+    }
+};
+
+// 各种页面大小, 起始slot和条件组合下, 各指令集的结果都与逐条判断相同
+TEST_F(PageFilterTest, MatchesReference) {
+    std::vector<char> bitmap, slots;
+    for (int num_slots : {1, 7, 8, 9, 64, 203, 215}) {
+        for (int round = 0; round < 100; round++) {
+            random_page(num_slots, round % 4 == 0 ? 1.0 : 0.7, &bitmap, &slots);
+            auto conds = random_conds();
+            int begin_slot = round % 2 == 0 ? 0 : static_cast<int>(rng_() % num_slots);
+            auto expected = reference_filter(conds, bitmap, slots, num_slots, begin_slot);
+            for (auto isa : all_isas) {
+                PageFilter filter(cols_, conds, isa);
+                std::vector<int> slot_nos(num_slots);
+                int count = filter.filter(bitmap.data(), slots.data(), num_slots, record_size_, begin_slot,
+                                          slot_nos.data());
+                slot_nos.resize(count);
+                ASSERT_EQ(slot_nos, expected) << "slots " << num_slots << " round " << round;
+            }
+        }
+    }
+    // 只有不能按页面计算的条件时不使用页面过滤
+    char val[7] = "a";
+    EXPECT_FALSE(PageFilter::Supports(cols_, {value_cond("c", OP_EQ, val)}));
+    int a = 0;
+    EXPECT_TRUE(PageFilter::Supports(cols_, {value_cond("c", OP_EQ, val), value_cond("a", OP_GT, &a)}));
+}
+
+// 在整页的记录上计算两个INT/FLOAT条件, 比较逐条判断和按页面过滤的每条记录耗时
+TEST_F(PageFilterTest, FilterBenchmark) {
+    const int num_slots = 215;  // 4KB页面中19字节的记录
+    const int num_pages = 256;
+    const int rounds = 64;
+    std::vector<std::vector<char>> bitmaps(num_pages), pages(num_pages);
+    for (int i = 0; i < num_pages; i++) {
+        random_page(num_slots, 0.95, &bitmaps[i], &pages[i]);
+    }
+    int lo = -16;
+    float hi = 4;
+    std::vector<Condition> conds = {value_cond("a", OP_GE, &lo), value_cond("b", OP_LT, &hi)};
+    std::vector<int> slot_nos(num_slots);
+    // 返回每条记录的平均纳秒数, 满足条件的记录数存入matched
+    auto measure = [&](const std::function<int(int)> &filter_page, size_t *matched) {
+        *matched = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; r++) {
+            for (int i = 0; i < num_pages; i++) {
+                *matched += filter_page(i);
+            }
+        }
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / (static_cast<double>(num_slots) * num_pages * rounds);
+    };
+    CompiledPredicate pred(cols_, conds);
+    size_t expected = 0;
+    double reference_ns = measure(
+        [&](int i) {
+            int count = 0;
+            for (int s = Bitmap::first_bit(true, bitmaps[i].data(), num_slots); s < num_slots;
+                 s = Bitmap::next_bit(true, bitmaps[i].data(), num_slots, s)) {
+                if (pred.eval(pages[i].data() + static_cast<size_t>(s) * record_size_)) {
+                    slot_nos[count++] = s;
+                }
+            }
+            return count;
+        },
+        &expected);
+    EXPECT_GT(expected, 0u);
+    printf("%-12s %12s\n", "mode", "ns/record");
+    printf("%-12s %10.2fns\n", "per-record", reference_ns);
+    const char *isa_names[] = {"scalar", "avx2"};
+    for (auto isa : all_isas) {
+        PageFilter filter(cols_, conds, isa);
+        size_t matched = 0;
+        double ns = measure(
+            [&](int i) {
+                return filter.filter(bitmaps[i].data(), pages[i].data(), num_slots, record_size_, 0, slot_nos.data());
+            },
+            &matched);
+        EXPECT_EQ(matched, expected);
+        printf("%-12s %10.2fns\n", isa_names[static_cast<int>(isa)], ns);
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cassert>
+#include <cstring>
+#include <vector>
+
+/**
+ * @brief 一批定长元组, 按行连续存放在一块可以复用的缓冲区中, 用于算子之间按批传递元组(NextBatch),
+ * 不再为每个元组分配一个RmRecord
+ */
+class TupleBatch {
+   private:
+    size_t tuple_len_ = 0;
+    size_t capacity_ = 0;
+    size_t size_ = 0;
+    std::vector<char> data_;
+
+   public:
+    TupleBatch() = default;
+
+    TupleBatch(size_t tuple_len, size_t capacity) { reset(tuple_len, capacity); }
+
+    /**
+     * @brief 设置元组长度和一批最多的元组数, 并清空; 缓冲区只在变大时重新分配
+     */
+    void reset(size_t tuple_len, size_t capacity) {
+        tuple_len_ = tuple_len;
+        capacity_ = capacity;
+        size_ = 0;
+        if (data_.size() < tuple_len * capacity) {
+            data_.resize(tuple_len * capacity);
+        }
+    }
+
+    void clear() { size_ = 0; }
+
+    size_t size() const { return size_; }
+
+    size_t capacity() const { return capacity_; }
+
+    size_t tuple_len() const { return tuple_len_; }
+
+    bool empty() const { return size_ == 0; }
+
+    bool full() const { return size_ == capacity_; }
+
+    const char *get(size_t idx) const {
+        assert(idx < size_);
+        return data_.data() + idx * tuple_len_;
+    }
+
+    /** @return 在末尾新增的元组的位置, 由调用者写入 */
+    char *append() {
+        assert(!full());
+        return data_.data() + tuple_len_ * size_++;
+    }
+
+    void push_back(const char *tuple) { memcpy(append(), tuple, tuple_len_); }
+};
@@ -22,6 +22,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <atomic>
 #include <chrono>  // NOLINT
 #include <cstdio>
 #include <functional>
@@ -361,3 +362,119 @@ TEST_F(BPlusTreeConcurrentTest, MixScaleTest) {
     }
     EXPECT_EQ(size, keys.size() - delete_keys.size());
 }
+
+/**
+ * @brief 吞吐量测试：不同线程数下并发执行点查(80%)、插入(10%)和删除(10%)，输出每秒操作数
+ * @note 每个线程只在自己的key区间内插入和删除，点查覆盖预先插入的key；每轮结束后树中只剩预先插入的key
+ */
+TEST_F(BPlusTreeConcurrentTest, ThroughputBenchmark) {
+    const int64_t preload = 10000;
+    const int ops_per_thread = 20000;
+    const int order = 255;
+
+    assert(order > 2 && order <= ih_->file_hdr_.btree_order);
+    ih_->file_hdr_.btree_order = order;
+
+    std::vector<int64_t> keys;
+    for (int64_t key = 1; key <= preload; key++) {
+        keys.push_back(key);
+    }
+    InsertHelper(ih_.get(), keys);
+
+    for (int thread_num : {1, 2, 4, 8}) {
+        auto worker = [&](uint64_t thread_itr) {
+            Transaction transaction(thread_itr);
+            std::default_random_engine rng(thread_itr);
+            int64_t first_key = preload + 1 + static_cast<int64_t>(thread_itr) * ops_per_thread;
+            int64_t next_insert = first_key;
+            int64_t next_delete = first_key;
+            std::vector<Rid> rids;
+            for (int i = 0; i < ops_per_thread; i++) {
+                int op = rng() % 10;
+                if (op == 0) {
+                    int64_t key = next_insert++;
+                    Rid rid = {.page_no = 0, .slot_no = static_cast<int>(key)};
+                    EXPECT_TRUE(ih_->insert_entry((const char *)&key, rid, &transaction));
+                } else if (op == 1 && next_delete < next_insert) {
+                    int64_t key = next_delete++;
+                    EXPECT_TRUE(ih_->delete_entry((const char *)&key, &transaction));
+                } else {
+                    int64_t key = 1 + rng() % preload;
+                    rids.clear();
+                    EXPECT_TRUE(ih_->GetValue((const char *)&key, &rids, &transaction));
+                }
+            }
+            for (int64_t key = next_delete; key < next_insert; key++) {
+                EXPECT_TRUE(ih_->delete_entry((const char *)&key, &transaction));
+            }
+        };
+        auto start = std::chrono::steady_clock::now();
+        LaunchParallelTest(thread_num, worker);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        printf("threads=%d ops=%d time=%.3fs throughput=%.0f ops/s\n", thread_num, thread_num * ops_per_thread,
+               elapsed.count(), thread_num * ops_per_thread / elapsed.count());
+    }
+
+    int64_t current_key = 1;
+    IxScan scan(ih_.get(), ih_->leaf_begin(), ih_->leaf_end(), buffer_pool_manager_.get());
+    while (!scan.is_end()) {
+        EXPECT_EQ(scan.rid().slot_no, current_key);
+        current_key++;
+        scan.next();
+    }
+    EXPECT_EQ(current_key, preload + 1);
+}
+
+/**
+ * @brief 扫描与修改并发：读线程带预读反复扫描预先插入的key，写线程在右侧的key区间插入和删除，
+ * 使扫描记下的父结点被分裂、重分配或回收；扫描的结果不受影响
+ */
+TEST_F(BPlusTreeConcurrentTest, ScanWhileModifyTest) {
+    const int64_t preload = 20000;
+    const int64_t buffer_keys = 1000;  // 扫描范围右侧不扫描的key, 使写线程修改的叶子与扫描的叶子分开
+    const int64_t write_base = 1000000;
+    const int num_writers = 4;
+    const int num_readers = 4;
+    const int order = 255;
+
+    assert(order > 2 && order <= ih_->file_hdr_.btree_order);
+    ih_->file_hdr_.btree_order = order;
+
+    std::vector<int64_t> keys;
+    for (int64_t key = 1; key <= preload + buffer_keys; key++) {
+        keys.push_back(key);
+    }
+    InsertHelper(ih_.get(), keys);
+
+    std::atomic<int> writers_done{0};
+    auto worker = [&](uint64_t thread_itr) {
+        if (thread_itr < num_writers) {
+            Transaction transaction(thread_itr);
+            int64_t first_key = write_base + static_cast<int64_t>(thread_itr) * 100000;
+            for (int round = 0; round < 4; round++) {
+                for (int64_t key = first_key; key < first_key + 5000; key++) {
+                    Rid rid = {.page_no = 0, .slot_no = static_cast<int>(key)};
+                    EXPECT_TRUE(ih_->insert_entry((const char *)&key, rid, &transaction));
+                }
+                for (int64_t key = first_key; key < first_key + 5000; key++) {
+                    EXPECT_TRUE(ih_->delete_entry((const char *)&key, &transaction));
+                }
+            }
+            writers_done++;
+            return;
+        }
+        int64_t lower_key = 1;
+        int64_t upper_key = preload;
+        do {
+            IxScan scan(ih_.get(), ih_->lower_bound((const char *)&lower_key), ih_->upper_bound((const char *)&upper_key),
+                        buffer_pool_manager_.get(), 8);
+            int64_t current_key = 1;
+            for (; !scan.is_end(); scan.next()) {
+                EXPECT_EQ(scan.rid().slot_no, current_key);
+                current_key++;
+            }
+            EXPECT_EQ(current_key, preload + 1);
+        } while (writers_done < num_writers);
+    };
+    LaunchParallelTest(num_writers + num_readers, worker);
+}
@@ -494,3 +494,290 @@ TEST_F(BPlusTreeTests, LargeScaleTest) {
     std::cout << "Insert keys count: " << add_cnt << '\n' << "Delete keys count: " << del_cnt << '\n';
     check_all(ih_.get(), mock);
 }
+
+/**
+ * @brief 删除时合并掉的结点页面被回收, 再次插入时复用, 关闭索引后链表仍能恢复
+ */
+TEST_F(BPlusTreeTests, PageReuseTest) {
+    const int order = 16;
+    const int scale = 2000;
+
+    if (order >= 2 && order <= ih_->file_hdr_.btree_order) {
+        ih_->file_hdr_.btree_order = order;
+    }
+    int fd = ih_->GetFd();
+    std::multimap<int, Rid> mock;
+    for (int key = 0; key < scale; key++) {
+        Rid value = {.page_no = key, .slot_no = key};
+        ASSERT_EQ(ih_->insert_entry((const char *)&key, value, txn_.get()), true);
+        mock.insert(std::make_pair(key, value));
+    }
+    page_id_t num_pages = disk_manager_->get_fd2pageno(fd);
+    EXPECT_EQ(disk_manager_->GetNumFreePages(fd), 0u);
+
+    // 删除大部分key, 合并掉的结点进入回收链表
+    for (int key = 0; key < scale; key++) {
+        if (key % 10 != 0) {
+            ASSERT_EQ(ih_->delete_entry((const char *)&key, txn_.get()), true);
+            mock.erase(key);
+        }
+    }
+    size_t num_free_pages = disk_manager_->GetNumFreePages(fd);
+    EXPECT_GT(num_free_pages, 0u);
+    EXPECT_EQ(ih_->file_hdr_.num_pages + static_cast<int>(num_free_pages), num_pages);
+    check_all(ih_.get(), mock);
+
+    // 重新打开索引, 从文件头恢复回收链表
+    ix_manager_->close_index(ih_.get());
+    ih_ = ix_manager_->open_index(TEST_FILE_NAME, index_no);
+    fd = ih_->GetFd();
+    EXPECT_EQ(disk_manager_->GetNumFreePages(fd), num_free_pages);
+    EXPECT_EQ(disk_manager_->get_fd2pageno(fd), num_pages);
+
+    // 重新插入时优先复用回收的页面
+    for (int key = 0; key < scale; key++) {
+        if (key % 10 != 0) {
+            Rid value = {.page_no = key, .slot_no = key};
+            ASSERT_EQ(ih_->insert_entry((const char *)&key, value, txn_.get()), true);
+            mock.insert(std::make_pair(key, value));
+        }
+    }
+    EXPECT_LT(disk_manager_->GetNumFreePages(fd), num_free_pages);
+    EXPECT_LE(disk_manager_->get_fd2pageno(fd), num_pages + static_cast<page_id_t>(num_free_pages));
+    check_all(ih_.get(), mock);
+}
+
+/**
+ * @brief 上层结点常驻后查找不再经过缓冲池, 分裂/合并/重分配计入统计, 删除和关闭索引时常驻结点的pin被释放
+ */
+TEST_F(BPlusTreeTests, IndexStatsTest) {
+    const int order = 8;
+    const int scale = 2000;
+
+    if (order >= 2 && order <= ih_->file_hdr_.btree_order) {
+        ih_->file_hdr_.btree_order = order;
+    }
+    std::multimap<int, Rid> mock;
+    for (int key = 0; key < scale; key++) {
+        Rid value = {.page_no = key, .slot_no = key};
+        ASSERT_EQ(ih_->insert_entry((const char *)&key, value, txn_.get()), true);
+        mock.insert(std::make_pair(key, value));
+    }
+    IxIndexStats stats = ih_->GetStats();
+    EXPECT_GT(stats.splits, 0u);
+    EXPECT_EQ(stats.merges, 0u);
+    ASSERT_GT(stats.height, IX_PINNED_LEVELS);
+    EXPECT_GT(stats.pinned_pages, 0u);
+    EXPECT_LE(stats.pinned_pages, ih_->max_pinned_pages_);
+    // 常驻结点只持有一个pin
+    for (auto &[page_no, pinned] : ih_->pinned_nodes_) {
+        EXPECT_EQ(pinned->page->pin_count_, 1);
+        EXPECT_LT(pinned->depth, IX_PINNED_LEVELS);
+    }
+
+    // 常驻的上层结点不经过缓冲池
+    size_t descents = stats.descents;
+    for (int key = 0; key < scale; key++) {
+        std::vector<Rid> result;
+        ASSERT_EQ(ih_->GetValue((const char *)&key, &result, txn_.get()), true);
+        ASSERT_EQ(result.front().page_no, key);
+    }
+    size_t descent_levels = stats.descent_levels;
+    size_t pinned_hits = stats.pinned_hits;
+    stats = ih_->GetStats();
+    EXPECT_EQ(stats.descents - descents, static_cast<size_t>(scale));
+    EXPECT_EQ(stats.descent_levels - descent_levels, static_cast<size_t>(scale * stats.height));
+    EXPECT_GE(stats.pinned_hits - pinned_hits, static_cast<size_t>(scale));  // 至少根结点每次都命中
+    int height = stats.height;
+
+    // 随机删除大部分key, 合并掉的常驻结点被移出
+    std::vector<int> keys;
+    for (int key = 0; key < scale; key++) {
+        keys.push_back(key);
+    }
+    std::shuffle(keys.begin(), keys.end(), std::default_random_engine(0));
+    for (int i = 0; i < scale - 10; i++) {
+        ASSERT_EQ(ih_->delete_entry((const char *)&keys[i], txn_.get()), true);
+        mock.erase(keys[i]);
+        for (int key = 0; key < scale; key += 97) {  // 保持上层结点常驻
+            std::vector<Rid> result;
+            ih_->GetValue((const char *)&key, &result, txn_.get());
+        }
+    }
+    stats = ih_->GetStats();
+    EXPECT_GT(stats.merges, 0u);
+    EXPECT_GT(stats.redistributions, 0u);
+    EXPECT_LT(stats.height, height);
+    for (auto &[page_no, pinned] : ih_->pinned_nodes_) {
+        EXPECT_EQ(pinned->page->GetPageId().page_no, page_no);
+        EXPECT_EQ(pinned->page->pin_count_, 1);
+    }
+    check_all(ih_.get(), mock);
+
+    ih_->UnpinUpperLevels();
+    EXPECT_EQ(ih_->GetStats().pinned_pages, 0u);
+    for (size_t i = 0; i < buffer_pool_manager_->GetPoolSize(); i++) {
+        EXPECT_EQ(buffer_pool_manager_->pages_[i].pin_count_, 0);
+    }
+}
+
+/**
+ * @brief 检查压缩格式的子树: 每个key在结点的fence之间, 孩子的fence等于父结点中的分隔key, 父指针正确
+ *
+ * @return 子树的高度
+ */
+static int CheckCompressedSubtree(IxIndexHandle *ih, page_id_t page_no, page_id_t parent_page_no) {
+    IxNodeHandle *node = ih->FetchNode(page_no);
+    int col_len = ih->file_hdr_.col_len;
+    EXPECT_EQ(node->GetParentPageNo(), parent_page_no);
+    EXPECT_LE(node->GetUsedBytes(), IxNodeHandle::GetCapacity(&ih->file_hdr_));
+    IxFence low = node->GetLowFence();
+    IxFence high = node->GetHighFence();
+    std::vector<IxEntry> entries = node->GetEntries();
+    for (int i = 0; i < node->GetSize(); i++) {
+        char key[IX_MAX_COL_LEN];
+        node->GetKey(i, key);
+        EXPECT_EQ(IxNodeHandle::TrimKey(key, col_len), entries[i].key);
+        EXPECT_EQ(node->CompareKey(i, key), 0);
+        EXPECT_TRUE(low.inf || low.key <= entries[i].key);
+        EXPECT_TRUE(high.inf || entries[i].key < high.key);
+        if (i > 0) {
+            EXPECT_LT(entries[i - 1].key, entries[i].key);
+        }
+    }
+    int height = 1;
+    if (!node->IsLeafPage()) {
+        for (int i = 0; i < node->GetSize(); i++) {
+            IxNodeHandle *child = ih->FetchNode(node->ValueAt(i));
+            IxFence child_low = child->GetLowFence();
+            IxFence child_high = child->GetHighFence();
+            EXPECT_EQ(child_low.inf, i == 0 && low.inf);
+            EXPECT_EQ(child_low.key, entries[i].key);
+            if (i + 1 < node->GetSize()) {
+                EXPECT_EQ(child_high.key, entries[i + 1].key);
+            } else {
+                EXPECT_EQ(child_high.inf, high.inf);
+                EXPECT_EQ(child_high.key, high.key);
+            }
+            ih->buffer_pool_manager_->UnpinPage(child->GetPageId(), false);
+            delete child;
+            height = CheckCompressedSubtree(ih, node->ValueAt(i), page_no) + 1;
+        }
+    }
+    ih->buffer_pool_manager_->UnpinPage(node->GetPageId(), false);
+    delete node;
+    return height;
+}
+
+/** @return 叶子链表中的叶子数量 */
+static int CountLeaves(IxIndexHandle *ih) {
+    int num_leaves = 0;
+    page_id_t page_no = ih->file_hdr_.first_leaf;
+    while (page_no != IX_LEAF_HEADER_PAGE) {
+        IxNodeHandle *leaf = ih->FetchNode(page_no);
+        page_no = leaf->GetNextLeaf();
+        ih->buffer_pool_manager_->UnpinPage(leaf->GetPageId(), false);
+        delete leaf;
+        num_leaves++;
+    }
+    return num_leaves;
+}
+
+/**
+ * @brief CHAR(64)的key有很长的公共前缀: 随机插入和删除时压缩格式与定长格式的查找和扫描结果一致,
+ * 压缩格式的叶子数量少几倍, 树也不会更高; 批量构建的压缩格式索引同样正确
+ */
+TEST_F(BPlusTreeTests, CompressedStringKeyTest) {
+    const int col_len = 64;
+    const int scale = 20000;
+    const int num_indexes = 3;  // 1: 定长格式, 2: 压缩格式, 3: 批量构建的压缩格式
+    std::unique_ptr<IxIndexHandle> ihs[num_indexes + 1];
+    for (int no = 1; no <= num_indexes; no++) {
+        if (ix_manager_->exists(TEST_FILE_NAME, no)) {
+            ix_manager_->destroy_index(TEST_FILE_NAME, no);
+        }
+        ix_manager_->create_index(TEST_FILE_NAME, no, TYPE_STRING, col_len, no != 1);
+        ihs[no] = ix_manager_->open_index(TEST_FILE_NAME, no);
+        EXPECT_EQ(ihs[no]->file_hdr_.compress_keys, no != 1);
+    }
+    auto make_key = [&](int n, char *key) {
+        memset(key, 0, col_len);
+        snprintf(key, col_len, "warehouse/%02d/district/%02d/customer/%06d", n % 3, n % 7, n);
+    };
+
+    std::mt19937 rng(0);
+    std::map<std::string, Rid> mock;
+    char key[IX_MAX_COL_LEN];
+    for (int op = 0; op < scale; op++) {
+        int n = static_cast<int>(rng() % scale);
+        make_key(n, key);
+        std::string mock_key(key, col_len);
+        bool insert = mock.size() < scale / 4 || rng() % 3 != 0;
+        for (int no = 1; no <= 2; no++) {
+            if (insert) {
+                ASSERT_EQ(ihs[no]->insert_entry(key, {n, n}, txn_.get()), mock.count(mock_key) == 0);
+            } else {
+                ASSERT_EQ(ihs[no]->delete_entry(key, txn_.get()), mock.count(mock_key) == 1);
+            }
+        }
+        if (insert) {
+            mock.emplace(mock_key, Rid{n, n});
+        } else {
+            mock.erase(mock_key);
+        }
+    }
+    IxBulkLoader loader(ihs[3].get());
+    for (auto &entry : mock) {
+        loader.Add(entry.first.data(), entry.second);
+    }
+    EXPECT_EQ(loader.Finish(), static_cast<int>(mock.size()));
+
+    for (int no = 2; no <= num_indexes; no++) {
+        IxIndexHandle *ih = ihs[no].get();
+        CheckCompressedSubtree(ih, ih->file_hdr_.root_page, IX_NO_PAGE);
+        for (int n = 0; n < scale; n += 7) {
+            make_key(n, key);
+            auto it = mock.find(std::string(key, col_len));
+            std::vector<Rid> result;
+            ASSERT_EQ(ih->GetValue(key, &result, txn_.get()), it != mock.end());
+            if (it != mock.end()) {
+                ASSERT_EQ(result[0], it->second);
+                ASSERT_EQ(ih->get_rid(ih->lower_bound(key)), it->second);
+            }
+        }
+        IxScan scan(ih, ih->leaf_begin(), ih->leaf_end(), buffer_pool_manager_.get());
+        for (auto &entry : mock) {
+            ASSERT_FALSE(scan.is_end());
+            ASSERT_EQ(scan.rid(), entry.second);
+            scan.next();
+        }
+        ASSERT_TRUE(scan.is_end());
+    }
+    // 压缩格式的叶子和内部结点都能放下更多的key
+    int fixed_height = 0;
+    for (page_id_t page_no = ihs[1]->file_hdr_.root_page;; fixed_height++) {
+        IxNodeHandle *node = ihs[1]->FetchNode(page_no);
+        bool is_leaf = node->IsLeafPage();
+        page_id_t child = is_leaf ? IX_NO_PAGE : node->ValueAt(0);
+        buffer_pool_manager_->UnpinPage(node->GetPageId(), false);
+        delete node;
+        if (is_leaf) {
+            fixed_height++;
+            break;
+        }
+        page_no = child;
+    }
+    int compressed_height = CheckCompressedSubtree(ihs[2].get(), ihs[2]->file_hdr_.root_page, IX_NO_PAGE);
+    int fixed_leaves = CountLeaves(ihs[1].get());
+    int compressed_leaves = CountLeaves(ihs[2].get());
+    std::cout << "fixed: " << fixed_leaves << " leaves, height " << fixed_height << "; compressed: " << compressed_leaves
+              << " leaves, height " << compressed_height << "; bulk loaded: " << CountLeaves(ihs[3].get())
+              << " leaves\n";
+    EXPECT_GE(fixed_leaves, compressed_leaves * 2);
+    EXPECT_GE(fixed_leaves, CountLeaves(ihs[3].get()) * 3);
+    EXPECT_LE(compressed_height, fixed_height);
+
+    for (int no = 1; no <= num_indexes; no++) {
+        ix_manager_->close_index(ihs[no].get());
+    }
+}
@@ -23,6 +23,7 @@
 //===----------------------------------------------------------------------===//
 
 #include <algorithm>
+#include <chrono>  // NOLINT
 #include <cstdio>
 #include <random>  // for std::default_random_engine
 
@@ -312,3 +313,276 @@ TEST_F(BPlusTreeTests, LargeScaleTest) {
     }
     EXPECT_EQ(current_key, keys.size() + 1);
 }
+
+/**
+ * @brief 检查以node为根的子树: 结点大小, 父结点指针, 以及父结点中的key等于孩子的第一个key
+ *
+ * @return 子树中键值对的数量
+ */
+static int CheckSubtree(IxIndexHandle *ih, page_id_t page_no, page_id_t parent_page_no) {
+    IxNodeHandle *node = ih->FetchNode(page_no);
+    EXPECT_EQ(node->GetParentPageNo(), parent_page_no);
+    EXPECT_LT(node->GetSize(), node->GetMaxSize());
+    if (parent_page_no != IX_NO_PAGE) {
+        EXPECT_GE(node->GetSize(), node->GetMinSize());
+    }
+    int num_entries = node->GetSize();
+    if (!node->IsLeafPage()) {
+        num_entries = 0;
+        for (int i = 0; i < node->GetSize(); i++) {
+            IxNodeHandle *child = ih->FetchNode(node->ValueAt(i));
+            EXPECT_EQ(node->KeyAt(i), child->KeyAt(0));
+            ih->buffer_pool_manager_->UnpinPage(child->GetPageId(), false);
+            num_entries += CheckSubtree(ih, node->ValueAt(i), page_no);
+        }
+    }
+    ih->buffer_pool_manager_->UnpinPage(node->GetPageId(), false);
+    return num_entries;
+}
+
+/**
+ * @brief 乱序批量加载1~20000(其中每个key重复一次), 排序时溢出多个有序段,
+ * 检查树的结构、GetValue和IxScan的结果, 之后的插入和删除仍然正确
+ */
+TEST_F(BPlusTreeTests, BulkLoadTest) {
+    const int scale = 20000;
+    const int order = 16;
+
+    assert(order > 2 && order <= ih_->file_hdr_.btree_order);
+    ih_->file_hdr_.btree_order = order;
+
+    std::vector<int> keys;
+    for (int key = 1; key <= scale; key++) {
+        keys.push_back(key);
+        keys.push_back(key);
+    }
+    auto rng = std::default_random_engine{};
+    std::shuffle(keys.begin(), keys.end(), rng);
+
+    // 每个有序段最多1000个条目
+    IxBulkLoader bulk_loader(ih_.get(), 0.75, 1000 * (sizeof(int) + sizeof(Rid)));
+    std::vector<int> min_slot_no(scale + 1, static_cast<int>(keys.size()));
+    for (size_t i = 0; i < keys.size(); i++) {
+        // 同一个key先加入的条目rid较大, 应当保留rid较小的那个
+        Rid rid = {.page_no = keys[i], .slot_no = static_cast<int>(keys.size() - i)};
+        bulk_loader.Add((const char *)&keys[i], rid);
+        min_slot_no[keys[i]] = std::min(min_slot_no[keys[i]], rid.slot_no);
+    }
+    EXPECT_GT(bulk_loader.GetNumRuns(), 1);
+    EXPECT_EQ(bulk_loader.Finish(), scale);
+    EXPECT_EQ(bulk_loader.GetNumRuns(), 1);
+
+    EXPECT_EQ(CheckSubtree(ih_.get(), ih_->file_hdr_.root_page, IX_NO_PAGE), scale);
+    EXPECT_EQ(ih_->file_hdr_.first_leaf, IX_INIT_ROOT_PAGE);
+
+    std::vector<Rid> rids;
+    for (int key = 1; key <= scale; key++) {
+        rids.clear();
+        ih_->GetValue((const char *)&key, &rids, txn_.get());
+        ASSERT_EQ(rids.size(), 1);
+        EXPECT_EQ(rids[0].page_no, key);
+        EXPECT_EQ(rids[0].slot_no, min_slot_no[key]);
+    }
+
+    int current_key = 1;
+    IxScan scan(ih_.get(), ih_->leaf_begin(), ih_->leaf_end(), buffer_pool_manager_.get());
+    while (!scan.is_end()) {
+        EXPECT_EQ(scan.rid().page_no, current_key);
+        current_key++;
+        scan.next();
+    }
+    EXPECT_EQ(current_key, scale + 1);
+
+    // 批量加载之后的树支持正常的插入和删除
+    for (int key = scale + 1; key <= scale + 1000; key++) {
+        ASSERT_TRUE(ih_->insert_entry((const char *)&key, Rid{key, 0}, txn_.get()));
+    }
+    for (int key = 1; key <= scale; key += 2) {
+        ASSERT_TRUE(ih_->delete_entry((const char *)&key, txn_.get()));
+    }
+    EXPECT_EQ(CheckSubtree(ih_.get(), ih_->file_hdr_.root_page, IX_NO_PAGE), scale / 2 + 1000);
+    EXPECT_THROW(IxBulkLoader(ih_.get()).Finish(), InternalError);
+}
+
+/**
+ * @brief 关闭SetUp中创建的唯一索引, 改为在编号为1的INT列上创建并打开非唯一索引
+ */
+static void OpenNonUniqueIndex(IxManager *ix_manager, std::unique_ptr<IxIndexHandle> *ih) {
+    const int non_unique_index_no = 1;
+    ix_manager->close_index(ih->get());
+    if (ix_manager->exists(TEST_FILE_NAME, non_unique_index_no)) {
+        ix_manager->destroy_index(TEST_FILE_NAME, non_unique_index_no);
+    }
+    ix_manager->create_index(TEST_FILE_NAME, non_unique_index_no, TYPE_INT, sizeof(int), false, false);
+    *ih = ix_manager->open_index(TEST_FILE_NAME, non_unique_index_no);
+}
+
+/**
+ * @brief 非唯一索引: 1~200每个key乱序插入20个不同的rid, GetValue和lower_bound/upper_bound之间的扫描
+ * 返回key的所有rid(按rid排序); 按(key, rid)删除一半后结果仍然正确
+ */
+TEST_F(BPlusTreeTests, DuplicateKeyTest) {
+    const int num_keys = 200;
+    const int dup = 20;
+    OpenNonUniqueIndex(ix_manager_.get(), &ih_);
+    ASSERT_FALSE(ih_->file_hdr_.unique);
+    ASSERT_EQ(ih_->file_hdr_.col_len, sizeof(int) + IX_RID_KEY_LEN);
+    ih_->file_hdr_.btree_order = 8;  // 每个key的重复项跨越多个叶子
+
+    std::vector<Rid> entries;
+    for (int key = 1; key <= num_keys; key++) {
+        for (int i = 0; i < dup; i++) {
+            entries.push_back(Rid{key, i * 7 + key % 3});
+        }
+    }
+    // 最小的键值对最先插入: 插入不会修改最左边路径上内部结点的第一个key, 之后CheckSubtree才能检查key与孩子一致
+    std::shuffle(entries.begin() + 1, entries.end(), std::default_random_engine{});
+    for (auto &rid : entries) {
+        int key = rid.page_no;
+        ASSERT_TRUE(ih_->insert_entry((const char *)&key, rid, txn_.get()));
+    }
+    // (key, rid)完全相同的键值对不能重复插入
+    int key = entries[0].page_no;
+    EXPECT_FALSE(ih_->insert_entry((const char *)&key, entries[0], txn_.get()));
+    EXPECT_EQ(CheckSubtree(ih_.get(), ih_->file_hdr_.root_page, IX_NO_PAGE), num_keys * dup);
+
+    // 返回key的所有rid, 同时检查GetValue与扫描[lower_bound(key), upper_bound(key))的结果一致
+    auto lookup = [&](int key) {
+        std::vector<Rid> rids;
+        bool found = ih_->GetValue((const char *)&key, &rids, txn_.get());
+        EXPECT_EQ(found, !rids.empty());
+        std::vector<Rid> scanned;
+        IxScan scan(ih_.get(), ih_->lower_bound((const char *)&key), ih_->upper_bound((const char *)&key),
+                    buffer_pool_manager_.get());
+        for (; !scan.is_end(); scan.next()) {
+            scanned.push_back(scan.rid());
+        }
+        EXPECT_EQ(scanned, rids);
+        return rids;
+    };
+    for (int key = 0; key <= num_keys + 1; key++) {
+        std::vector<Rid> expected;
+        if (key >= 1 && key <= num_keys) {
+            for (int i = 0; i < dup; i++) {
+                expected.push_back(Rid{key, i * 7 + key % 3});
+            }
+        }
+        ASSERT_EQ(lookup(key), expected);
+    }
+
+    // 删除每个key的偶数个rid, 删除不存在的(key, rid)失败
+    for (int key = 1; key <= num_keys; key++) {
+        for (int i = 0; i < dup; i += 2) {
+            ASSERT_TRUE(ih_->delete_entry((const char *)&key, Rid{key, i * 7 + key % 3}, txn_.get()));
+        }
+        EXPECT_FALSE(ih_->delete_entry((const char *)&key, Rid{key, 0 * 7 + key % 3}, txn_.get()));
+        EXPECT_FALSE(ih_->delete_entry((const char *)&key, Rid{key + 1, 1 * 7 + key % 3}, txn_.get()));
+    }
+    EXPECT_EQ(CheckSubtree(ih_.get(), ih_->file_hdr_.root_page, IX_NO_PAGE), num_keys * dup / 2);
+    for (int key = 1; key <= num_keys; key++) {
+        std::vector<Rid> expected;
+        for (int i = 1; i < dup; i += 2) {
+            expected.push_back(Rid{key, i * 7 + key % 3});
+        }
+        ASSERT_EQ(lookup(key), expected);
+    }
+}
+
+/**
+ * @brief 每个key有1000个重复项的非唯一索引: 插入、GetValue取出一个key的所有rid、扫描整个索引的耗时
+ */
+TEST_F(BPlusTreeTests, DuplicateKeyBenchmark) {
+    const int num_keys = 100;
+    const int dup = 1000;
+    OpenNonUniqueIndex(ix_manager_.get(), &ih_);
+
+    std::vector<Rid> entries;
+    for (int key = 0; key < num_keys; key++) {
+        for (int i = 0; i < dup; i++) {
+            entries.push_back(Rid{key, i});
+        }
+    }
+    std::shuffle(entries.begin(), entries.end(), std::default_random_engine{});
+
+    auto start = std::chrono::steady_clock::now();
+    for (auto &rid : entries) {
+        int key = rid.page_no;
+        ASSERT_TRUE(ih_->insert_entry((const char *)&key, rid, txn_.get()));
+    }
+    std::chrono::duration<double> insert_time = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    std::vector<Rid> rids;
+    for (int key = 0; key < num_keys; key++) {
+        rids.clear();
+        ASSERT_TRUE(ih_->GetValue((const char *)&key, &rids, txn_.get()));
+        ASSERT_EQ(rids.size(), dup);
+        for (int i = 0; i < dup; i++) {
+            ASSERT_EQ(rids[i], (Rid{key, i}));
+        }
+    }
+    std::chrono::duration<double> lookup_time = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    int scanned = 0;
+    for (IxScan scan(ih_.get(), ih_->leaf_begin(), ih_->leaf_end(), buffer_pool_manager_.get()); !scan.is_end();
+         scan.next()) {
+        scanned++;
+    }
+    std::chrono::duration<double> scan_time = std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(scanned, num_keys * dup);
+
+    printf("keys=%d duplicates=%d insert=%.3fs GetValue=%.1fus/key scan=%.3fs pages=%d\n", num_keys, dup,
+           insert_time.count(), lookup_time.count() * 1e6 / num_keys, scan_time.count(), ih_->file_hdr_.num_pages);
+}
+
+/**
+ * @brief 改为成批复制之前IxScan的做法: 每个键值对都fetch叶子读取rid, 再fetch一次叶子移动到下一个位置
+ */
+static std::vector<Rid> PerEntryScan(IxIndexHandle *ih, Iid iid, const Iid &end) {
+    std::vector<Rid> rids;
+    while (iid != end) {
+        rids.push_back(ih->get_rid(iid));
+        IxNodeHandle *node = ih->FetchNode(iid.page_no);
+        iid.slot_no++;
+        if (iid.page_no != ih->file_hdr_.last_leaf && iid.slot_no == node->GetSize()) {
+            iid = {.page_no = node->GetNextLeaf(), .slot_no = 0};
+        }
+        ih->buffer_pool_manager_->UnpinPage(node->GetPageId(), false);
+        delete node;
+    }
+    return rids;
+}
+
+/**
+ * @brief 在批量加载的50万个key上做长范围扫描, 比较逐个键值对访问叶子和每个叶子只访问一次的IxScan的扫描速度
+ */
+TEST_F(BPlusTreeTests, ScanBenchmark) {
+    const int scale = 500000;
+    IxBulkLoader bulk_loader(ih_.get());
+    for (int key = 0; key < scale; key++) {
+        bulk_loader.Add((const char *)&key, Rid{key, 0});
+    }
+    ASSERT_EQ(bulk_loader.Finish(), scale);
+
+    int lower_key = scale / 10, upper_key = scale - scale / 10;
+    Iid lower = ih_->lower_bound((const char *)&lower_key);
+    Iid upper = ih_->lower_bound((const char *)&upper_key);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Rid> expected = PerEntryScan(ih_.get(), lower, upper);
+    std::chrono::duration<double> per_entry_time = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    std::vector<Rid> rids;
+    for (IxScan scan(ih_.get(), lower, upper, buffer_pool_manager_.get()); !scan.is_end(); scan.next()) {
+        rids.push_back(scan.rid());
+    }
+    std::chrono::duration<double> batch_time = std::chrono::steady_clock::now() - start;
+
+    ASSERT_EQ(rids.size(), upper_key - lower_key);
+    EXPECT_EQ(rids, expected);
+    EXPECT_EQ(rids.front().page_no, lower_key);
+    printf("rows=%zu per-entry=%.0f rows/s batched=%.0f rows/s (%.1fx)\n", rids.size(),
+           rids.size() / per_entry_time.count(), rids.size() / batch_time.count(),
+           per_entry_time.count() / batch_time.count());
+}
@@ -0,0 +1,495 @@
+#include "ix_bulk_loader.h"
+
+#include <algorithm>
+
+#include "storage/run_merger.h"
+
+/**
+ * @brief num_entries个条目平均分到num_nodes个结点时, 第i个结点的条目数量
+ */
+static int GetNodeEntries(int num_entries, int num_nodes, int i) {
+    return num_entries / num_nodes + (i < num_entries % num_nodes ? 1 : 0);
+}
+
+/**
+ * @brief 压缩格式的一层结点: 每个结点的条目数量和下界, 后一个结点的下界就是前一个结点的上界
+ */
+struct IxBulkLoader::Level {
+    std::vector<int> sizes;
+    std::vector<IxFence> lows;
+    std::vector<int> parents;  // 每个结点在上一层中的父结点
+};
+
+/**
+ * @brief 压缩格式按字节数把一层有序的key划分成结点
+ * 加入key后结点超过目标字节数时, 在这个key之前结束结点. 结点的公共前缀由两端的fence决定, 结束时才知道上界,
+ * 前缀可能比加入key时估计的短; 这时结点超过容量的话, 把末尾的key留给下一个结点.
+ * 叶子之间的分隔key取最短的分隔key, 内部结点之间的分隔key就是下一个结点的第一个key
+ */
+class IxBulkLoader::NodePacker {
+   public:
+    NodePacker(int col_len, int target, int capacity, bool is_leaf, Level *level)
+        : col_len_(col_len), target_(target), capacity_(capacity), is_leaf_(is_leaf), level_(level) {
+        level_->lows.push_back({true, ""});
+    }
+
+    void Add(std::string key) {
+        // 之前的key都不小于低界, 与key的公共前缀也是与它们的公共前缀; 上界按最长计算
+        int prefix_len = IxNodeHandle::GetPrefixLen(low(), {false, key});
+        int num_keys = static_cast<int>(keys_.size()) + 1;
+        int bytes = GetNodeBytes(num_keys, key_bytes_ + static_cast<int>(key.size()), col_len_, prefix_len);
+        if (!keys_.empty() && bytes > target_) {
+            Close(keys_.size(), key);
+        }
+        key_bytes_ += static_cast<int>(key.size());
+        keys_.push_back(std::move(key));
+    }
+
+    /** 最后一个结点的上界为正无穷, 没有公共前缀 */
+    void Finish() {
+        while (keys_.size() > 1 && GetSize(keys_.size(), {true, ""}) > capacity_) {
+            size_t n = keys_.size() - 1;
+            while (n > 1 && GetSize(n, {true, ""}) > capacity_) {
+                n--;
+            }
+            Close(n, keys_[n]);
+        }
+        level_->sizes.push_back(static_cast<int>(keys_.size()));
+    }
+
+   private:
+    const IxFence &low() const { return level_->lows.back(); }
+
+    int GetNodeBytes(int num_keys, int key_bytes, int high_len, int prefix_len) const {
+        return static_cast<int>(sizeof(IxPageHdr) + sizeof(IxKeyHeapHdr) + low().key.size()) + high_len +
+               num_keys * static_cast<int>(sizeof(IxKeySlot)) + key_bytes - num_keys * prefix_len;
+    }
+
+    /** @return 前n个key组成结点, 上界为high时的准确字节数 */
+    int GetSize(size_t n, const IxFence &high) const {
+        int key_bytes = 0;
+        for (size_t i = 0; i < n; i++) {
+            key_bytes += static_cast<int>(keys_[i].size());
+        }
+        return GetNodeBytes(static_cast<int>(n), key_bytes, static_cast<int>(high.key.size()),
+                            IxNodeHandle::GetPrefixLen(low(), high));
+    }
+
+    IxFence GetSeparator(size_t n, const std::string &next) const {
+        const std::string &after = n == keys_.size() ? next : keys_[n];
+        return {false, is_leaf_ ? IxNodeHandle::ShortestSeparator(keys_[n - 1], after) : after};
+    }
+
+    /** @brief 用前n个key结束一个结点, next是它们之后的key; 放不下时减少n */
+    void Close(size_t n, const std::string &next) {
+        IxFence separator = GetSeparator(n, next);
+        while (n > 1 && GetSize(n, separator) > capacity_) {
+            n--;
+            separator = GetSeparator(n, next);
+        }
+        level_->sizes.push_back(static_cast<int>(n));
+        level_->lows.push_back(std::move(separator));
+        for (size_t i = 0; i < n; i++) {
+            key_bytes_ -= static_cast<int>(keys_[i].size());
+        }
+        keys_.erase(keys_.begin(), keys_.begin() + static_cast<long>(n));
+    }
+
+    int col_len_;
+    int target_;
+    int capacity_;
+    bool is_leaf_;
+    Level *level_;
+    std::vector<std::string> keys_;  // 当前结点的key
+    int key_bytes_ = 0;              // keys_的总长度
+};
+
+IxBulkLoader::IxBulkLoader(IxIndexHandle *ih, double fill_factor, size_t sort_memory)
+    : ih_(ih),
+      col_len_(ih->file_hdr_.col_len),
+      entry_len_(ih->file_hdr_.col_len + static_cast<int>(sizeof(Rid))),
+      fill_factor_(fill_factor),
+      sort_memory_(std::max(sort_memory, static_cast<size_t>(entry_len_))) {}
+
+/**
+ * @brief 收集一个条目, 内存中的条目超过sort_memory_时先把它们排序后溢出到磁盘
+ */
+void IxBulkLoader::Add(const char *key, const Rid &rid) {
+    if (buffer_.size() + entry_len_ > sort_memory_) {
+        SpillBuffer();
+    }
+    char entry_key[IX_MAX_COL_LEN];
+    key = ih_->GetEntryKey(key, rid, entry_key);  // 非唯一索引的key附加rid, 之后不会再有重复的key
+    buffer_.insert(buffer_.end(), key, key + col_len_);
+    auto rid_data = reinterpret_cast<const char *>(&rid);
+    buffer_.insert(buffer_.end(), rid_data, rid_data + sizeof(Rid));
+}
+
+/**
+ * @brief 先按key比较, key相同时按rid比较, 使重复的key中rid最小的排在最前面
+ */
+int IxBulkLoader::CompareEntry(const char *a, const char *b) const {
+    int cmp = ix_compare(a, b, ih_->file_hdr_);
+    if (cmp != 0) {
+        return cmp;
+    }
+    Rid rid_a, rid_b;
+    memcpy(&rid_a, a + col_len_, sizeof(Rid));
+    memcpy(&rid_b, b + col_len_, sizeof(Rid));
+    if (rid_a.page_no != rid_b.page_no) {
+        return rid_a.page_no < rid_b.page_no ? -1 : 1;
+    }
+    return rid_a.slot_no < rid_b.slot_no ? -1 : (rid_a.slot_no > rid_b.slot_no ? 1 : 0);
+}
+
+/**
+ * @brief 对buffer_中的条目排序并去掉重复的key
+ *
+ * @return 指向buffer_中条目的指针, 按key有序
+ */
+std::vector<const char *> IxBulkLoader::SortBuffer() {
+    std::vector<const char *> entries;
+    entries.reserve(buffer_.size() / entry_len_);
+    for (size_t offset = 0; offset < buffer_.size(); offset += entry_len_) {
+        entries.push_back(buffer_.data() + offset);
+    }
+    std::sort(entries.begin(), entries.end(),
+              [this](const char *a, const char *b) { return CompareEntry(a, b) < 0; });
+    auto last = std::unique(entries.begin(), entries.end(), [this](const char *a, const char *b) {
+        return ix_compare(a, b, ih_->file_hdr_) == 0;
+    });
+    entries.erase(last, entries.end());
+    return entries;
+}
+
+/**
+ * @brief 把buffer_中的条目排序后写成一个有序段
+ */
+void IxBulkLoader::SpillBuffer() {
+    if (buffer_.empty()) {
+        return;
+    }
+    auto run = std::make_unique<SpillFile>(ih_->disk_manager_, entry_len_);
+    for (auto entry : SortBuffer()) {
+        run->write(entry);
+    }
+    runs_.push_back(std::move(run));
+    buffer_.clear();
+}
+
+/**
+ * @brief 归并所有有序段, 得到一个有序段; 归并时去掉不同有序段之间重复的key
+ * 有序段太多时先分组归并, 同时打开的有序段不超过sort_memory_能容纳的块数
+ * @note 构建B+树之前需要知道条目的准确数量, 因此归并结果先写回磁盘
+ */
+void IxBulkLoader::MergeRuns() {
+    auto compare = [this](const char *a, const char *b) { return CompareEntry(a, b); };
+    auto equal = [this](const char *a, const char *b) { return ix_compare(a, b, ih_->file_hdr_) == 0; };
+    runs_ = RunMerger::reduce(std::move(runs_), ih_->disk_manager_, entry_len_, compare,
+                              RunMerger::fan_in(sort_memory_, entry_len_), equal);
+    if (runs_.size() > 1) {
+        auto merged = RunMerger::merge(std::move(runs_), ih_->disk_manager_, entry_len_, compare, equal);
+        runs_.clear();
+        runs_.push_back(std::move(merged));
+    }
+}
+
+/**
+ * @brief 按填充率计算一层中num_entries个条目(叶子中的键值对或者下一层的结点)需要的结点数量
+ * @note 除了根结点, 平均分配之后每个结点的条目数量都不少于GetMinSize(), 且不会达到需要分裂的GetMaxSize()
+ */
+int IxBulkLoader::GetNumNodes(int num_entries) const {
+    int max_entries = ih_->file_hdr_.btree_order;
+    int min_entries = (max_entries + 1) / 2;
+    int node_entries = std::clamp(static_cast<int>(max_entries * fill_factor_), min_entries, max_entries);
+    int num_nodes = (num_entries + node_entries - 1) / node_entries;
+    if (num_nodes > 1 && num_entries / num_nodes < min_entries) {
+        num_nodes = std::max(1, num_entries / min_entries);
+    }
+    return num_nodes;
+}
+
+/**
+ * @brief 排序所有收集到的条目并构建B+树
+ */
+int IxBulkLoader::Finish() {
+    // 根结点是空的叶子并且没有其他结点时, 索引才是空的
+    bool is_empty = ih_->file_hdr_.root_page == IX_INIT_ROOT_PAGE && ih_->file_hdr_.num_pages == IX_INIT_NUM_PAGES;
+    if (is_empty) {
+        IxNodeHandle *root = ih_->FetchNode(IX_INIT_ROOT_PAGE);
+        is_empty = root->GetSize() == 0;
+        ih_->buffer_pool_manager_->UnpinPage(root->GetPageId(), false);
+        delete root;
+    }
+    if (!is_empty) {
+        throw InternalError("IxBulkLoader::Finish: bulk loading requires an empty index");
+    }
+
+    int num_entries;
+    std::vector<const char *> entries;
+    if (runs_.empty()) {
+        entries = SortBuffer();
+        num_entries = static_cast<int>(entries.size());
+    } else {
+        SpillBuffer();
+        MergeRuns();
+        num_entries = static_cast<int>(runs_[0]->size() / entry_len_);
+    }
+    // 按顺序读出条目, rewind之后从头开始; 压缩格式需要读两遍
+    size_t next = 0;
+    std::vector<char> entry(entry_len_);
+    auto rewind = [&]() {
+        next = 0;
+        if (!runs_.empty()) {
+            runs_[0]->rewind();
+        }
+    };
+    auto next_entry = [&]() -> const char * {
+        if (runs_.empty()) {
+            return entries[next++];
+        }
+        if (!runs_[0]->read(entry.data())) {
+            throw InternalError("IxBulkLoader::Finish: run ended before all entries were read");
+        }
+        return entry.data();
+    };
+    rewind();
+    if (ih_->file_hdr_.compress_keys) {
+        BuildCompressed(num_entries, next_entry, rewind);
+    } else {
+        Build(num_entries, next_entry);
+    }
+    std::vector<char>().swap(buffer_);
+    return num_entries;
+}
+
+/**
+ * @brief 由下往上逐层写出结点, 每层的结点从左到右平均分配条目
+ * 先算出每层的结点数量并分配好所有页号, 这样每个结点写出时就知道其父结点和前后叶子的页号, 只需要写一次
+ *
+ * @param num_entries 有序条目的数量
+ * @param next_entry 按顺序返回下一个条目
+ */
+void IxBulkLoader::Build(int num_entries, const std::function<const char *()> &next_entry) {
+    if (num_entries == 0) {
+        return;
+    }
+    IxFileHdr &file_hdr = ih_->file_hdr_;
+
+    // level_nodes[0]是叶子的数量, 最后一层只有根结点
+    std::vector<int> level_nodes = {GetNumNodes(num_entries)};
+    while (level_nodes.back() > 1) {
+        level_nodes.push_back(GetNumNodes(level_nodes.back()));
+    }
+    std::vector<std::vector<page_id_t>> pages = AllocatePages(level_nodes);
+
+    write_buf_ = DiskManager::AllocateAlignedBuffer(static_cast<size_t>(IX_BULK_LOAD_WRITE_PAGES) * PAGE_SIZE);
+    std::vector<char> page_buf(PAGE_SIZE);
+    auto page_hdr = reinterpret_cast<IxPageHdr *>(page_buf.data());
+    char *keys = page_buf.data() + sizeof(IxPageHdr);
+    auto rids = reinterpret_cast<Rid *>(keys + file_hdr.keys_size);
+
+    std::vector<char> child_first_keys;  // 下一层每个结点的第一个key, 作为本层指向它的key
+    std::vector<char> first_keys;
+    for (size_t level = 0; level < level_nodes.size(); level++) {
+        bool is_leaf = level == 0;
+        bool is_root = level + 1 == level_nodes.size();
+        int num_nodes = level_nodes[level];
+        int level_entries = is_leaf ? num_entries : level_nodes[level - 1];
+        first_keys.resize(static_cast<size_t>(num_nodes) * col_len_);
+        int child = 0;
+        int parent = 0;
+        int parent_left = is_root ? 0 : GetNodeEntries(num_nodes, level_nodes[level + 1], 0);  // 父结点还缺的孩子数
+        for (int i = 0; i < num_nodes; i++) {
+            int size = GetNodeEntries(level_entries, num_nodes, i);
+            memset(page_buf.data(), 0, PAGE_SIZE);
+            *page_hdr = {
+                .next_free_page_no = IX_NO_PAGE,
+                .parent = is_root ? IX_NO_PAGE : pages[level + 1][parent],
+                .num_key = size,
+                .is_leaf = is_leaf,
+                .prev_leaf = IX_NO_PAGE,
+                .next_leaf = IX_NO_PAGE,
+            };
+            if (is_leaf) {
+                page_hdr->prev_leaf = i == 0 ? IX_LEAF_HEADER_PAGE : pages[0][i - 1];
+                page_hdr->next_leaf = i + 1 == num_nodes ? IX_LEAF_HEADER_PAGE : pages[0][i + 1];
+                for (int k = 0; k < size; k++) {
+                    const char *entry = next_entry();
+                    memcpy(keys + k * col_len_, entry, col_len_);
+                    memcpy(&rids[k], entry + col_len_, sizeof(Rid));
+                }
+            } else {
+                for (int k = 0; k < size; k++, child++) {
+                    memcpy(keys + k * col_len_, child_first_keys.data() + static_cast<size_t>(child) * col_len_,
+                           col_len_);
+                    rids[k] = Rid{pages[level - 1][child], -1};
+                }
+            }
+            memcpy(first_keys.data() + static_cast<size_t>(i) * col_len_, keys, col_len_);
+            WritePage(pages[level][i], page_buf.data());
+            if (!is_root && --parent_left == 0 && ++parent < level_nodes[level + 1]) {
+                parent_left = GetNodeEntries(num_nodes, level_nodes[level + 1], parent);
+            }
+        }
+        child_first_keys.swap(first_keys);
+    }
+    FlushWrites();
+    write_buf_.reset();
+    LinkPages(pages);
+}
+
+/**
+ * @brief 压缩格式的构建: 结点是变长的, 按字节数而不是条目数量划分
+ * 第一遍读出所有key, 从左到右填充叶子, 估计的字节数(不计公共前缀, 上界按最长计算)超过填充率时开始新的叶子,
+ * 相邻叶子之间取最短的分隔key; 各层内部结点以下一层结点的下界为key, 同样按字节数划分.
+ * 第二遍再读一遍条目写出叶子, 最后写出内部结点
+ *
+ * @param rewind 从头开始重新读条目
+ */
+void IxBulkLoader::BuildCompressed(int num_entries, const std::function<const char *()> &next_entry,
+                                   const std::function<void()> &rewind) {
+    if (num_entries == 0) {
+        return;
+    }
+    int target = static_cast<int>(IxNodeHandle::GetCapacity(&ih_->file_hdr_) * fill_factor_);
+    std::vector<Level> levels(1);
+    {
+        NodePacker packer(col_len_, target, IxNodeHandle::GetCapacity(&ih_->file_hdr_), true, &levels[0]);
+        for (int i = 0; i < num_entries; i++) {
+            packer.Add(IxNodeHandle::TrimKey(next_entry(), col_len_));
+        }
+        packer.Finish();
+    }
+    // 每个内部结点的条目是(孩子的下界, 孩子的页号), 第一个条目的key就是结点的下界
+    while (levels.back().sizes.size() > 1) {
+        Level parent;
+        NodePacker packer(col_len_, target, IxNodeHandle::GetCapacity(&ih_->file_hdr_), false, &parent);
+        for (auto &low : levels.back().lows) {
+            packer.Add(low.key);
+        }
+        packer.Finish();
+        for (int i = 0; i < static_cast<int>(parent.sizes.size()); i++) {
+            levels.back().parents.insert(levels.back().parents.end(), parent.sizes[i], i);
+        }
+        levels.push_back(std::move(parent));
+    }
+    const IxFence inf = {true, ""};
+
+    std::vector<int> level_nodes;
+    for (auto &level : levels) {
+        level_nodes.push_back(static_cast<int>(level.sizes.size()));
+    }
+    std::vector<std::vector<page_id_t>> pages = AllocatePages(level_nodes);
+
+    write_buf_ = DiskManager::AllocateAlignedBuffer(static_cast<size_t>(IX_BULK_LOAD_WRITE_PAGES) * PAGE_SIZE);
+    std::vector<char> page_buf(PAGE_SIZE);
+    auto page_hdr = reinterpret_cast<IxPageHdr *>(page_buf.data());
+    rewind();
+    std::vector<IxEntry> node_entries;
+    for (size_t level = 0; level < levels.size(); level++) {
+        bool is_leaf = level == 0;
+        bool is_root = level + 1 == levels.size();
+        int child = 0;
+        for (int i = 0; i < level_nodes[level]; i++) {
+            node_entries.clear();
+            for (int k = 0; k < levels[level].sizes[i]; k++) {
+                if (is_leaf) {
+                    const char *entry = next_entry();
+                    Rid rid;
+                    memcpy(&rid, entry + col_len_, sizeof(Rid));
+                    node_entries.push_back({IxNodeHandle::TrimKey(entry, col_len_), rid});
+                } else {
+                    node_entries.push_back({levels[level - 1].lows[child].key, Rid{pages[level - 1][child], -1}});
+                    child++;
+                }
+            }
+            memset(page_buf.data(), 0, PAGE_SIZE);
+            *page_hdr = {
+                .next_free_page_no = IX_NO_PAGE,
+                .parent = is_root ? IX_NO_PAGE : pages[level + 1][levels[level].parents[i]],
+                .num_key = 0,
+                .is_leaf = is_leaf,
+                .prev_leaf = IX_NO_PAGE,
+                .next_leaf = IX_NO_PAGE,
+            };
+            if (is_leaf) {
+                page_hdr->prev_leaf = i == 0 ? IX_LEAF_HEADER_PAGE : pages[0][i - 1];
+                page_hdr->next_leaf = i + 1 == level_nodes[0] ? IX_LEAF_HEADER_PAGE : pages[0][i + 1];
+            }
+            const IxFence &high = i + 1 == level_nodes[level] ? inf : levels[level].lows[i + 1];
+            assert(IxNodeHandle::GetEncodedSize(node_entries, levels[level].lows[i], high) <=
+                   IxNodeHandle::GetCapacity(&ih_->file_hdr_));
+            IxNodeHandle::Encode(page_buf.data(), node_entries, levels[level].lows[i], high);
+            WritePage(pages[level][i], page_buf.data());
+        }
+    }
+    FlushWrites();
+    write_buf_.reset();
+    LinkPages(pages);
+}
+
+/**
+ * @brief 为每层的结点分配页号
+ * 第一个叶子复用原来的根结点, 因此file_hdr_.first_leaf不变; 其余结点按层从左到右分配页号
+ */
+std::vector<std::vector<page_id_t>> IxBulkLoader::AllocatePages(const std::vector<int> &level_nodes) {
+    std::vector<std::vector<page_id_t>> pages(level_nodes.size());
+    for (size_t level = 0; level < level_nodes.size(); level++) {
+        for (int i = 0; i < level_nodes[level]; i++) {
+            pages[level].push_back(level == 0 && i == 0 ? IX_INIT_ROOT_PAGE
+                                                        : ih_->disk_manager_->AllocatePage(ih_->fd_));
+        }
+    }
+    return pages;
+}
+
+/**
+ * @brief 所有结点写出之后, 把叶子接到leaf header上, 并更新file header
+ */
+void IxBulkLoader::LinkPages(const std::vector<std::vector<page_id_t>> &pages) {
+    IxFileHdr &file_hdr = ih_->file_hdr_;
+    BufferPoolManager *buffer_pool_manager = ih_->buffer_pool_manager_;
+    // leaf header可能已经在缓冲池中, 通过缓冲池修改
+    Page *leaf_header = buffer_pool_manager->FetchPage(PageId{ih_->fd_, IX_LEAF_HEADER_PAGE});
+    auto leaf_header_hdr = reinterpret_cast<IxPageHdr *>(leaf_header->GetData());
+    leaf_header_hdr->prev_leaf = pages[0].back();
+    leaf_header_hdr->next_leaf = pages[0].front();
+    buffer_pool_manager->UnpinPage(leaf_header->GetPageId(), true);
+
+    file_hdr.root_page = pages.back().front();
+    file_hdr.last_leaf = pages[0].back();
+    for (auto &level_pages : pages) {
+        file_hdr.num_pages += static_cast<int>(level_pages.size());
+    }
+    file_hdr.num_pages--;  // 第一个叶子是原来的根结点
+}
+
+/**
+ * @brief 写出一个结点, 页号与前面攒下的结点连续时合并成一次写入
+ * @note 原来的根结点已经在缓冲池中(Finish检查过它), 需要通过缓冲池修改, 否则缓冲池中是旧的内容
+ */
+void IxBulkLoader::WritePage(page_id_t page_no, const char *page_buf) {
+    if (page_no == IX_INIT_ROOT_PAGE) {
+        Page *page = ih_->buffer_pool_manager_->FetchPage(PageId{ih_->fd_, page_no});
+        memcpy(page->GetData(), page_buf, PAGE_SIZE);
+        ih_->buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+        return;
+    }
+    if (write_pages_ == IX_BULK_LOAD_WRITE_PAGES || (write_pages_ > 0 && page_no != write_start_ + write_pages_)) {
+        FlushWrites();
+    }
+    if (write_pages_ == 0) {
+        write_start_ = page_no;
+    }
+    memcpy(write_buf_.get() + static_cast<size_t>(write_pages_) * PAGE_SIZE, page_buf, PAGE_SIZE);
+    write_pages_++;
+}
+
+void IxBulkLoader::FlushWrites() {
+    if (write_pages_ == 0) {
+        return;
+    }
+    ih_->disk_manager_->write_page(ih_->fd_, write_start_, write_buf_.get(), write_pages_ * PAGE_SIZE);
+    write_pages_ = 0;
+}
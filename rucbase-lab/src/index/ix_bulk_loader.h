@@ -0,0 +1,79 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ix_index_handle.h"
+#include "storage/spill_file.h"
+
+/**
+ * @brief 自底向上批量构建B+树, 用于在已有数据的表上CREATE INDEX
+ * 先用Add收集(key, rid), 内存中的条目超过sort_memory时排序后写成一个有序段(run), 溢出到SpillFile;
+ * Finish时用RunMerger归并所有有序段(与外部排序相同, 同时打开的有序段受sort_memory限制),
+ * 按fill_factor从左到右填满叶子, 再逐层向上构建内部结点;
+ * 压缩格式的索引按字节数而不是条目数量填充结点.
+ * 除了原有的根结点和leaf header, 新结点按页号顺序直接写入磁盘, 不经过缓冲池
+ *
+ * @note 只能用于刚创建的空索引; 与insert_entry一样, 唯一索引中重复的key只保留先插入(rid最小)的一个,
+ * 非唯一索引的key附加了rid, 全部保留
+ */
+class IxBulkLoader {
+   public:
+    IxBulkLoader(IxIndexHandle *ih, double fill_factor = IX_BULK_LOAD_FILL_FACTOR,
+                 size_t sort_memory = IX_BULK_LOAD_SORT_MEMORY);
+
+    void Add(const char *key, const Rid &rid);
+
+    /**
+     * @brief 排序所有收集到的条目并构建B+树
+     *
+     * @return 插入索引的条目数量(去掉了重复的key)
+     * @note 索引不为空时抛出InternalError, 此时索引没有被修改
+     */
+    int Finish();
+
+    /** @return 目前溢出到磁盘的有序段数量 */
+    size_t GetNumRuns() const { return runs_.size(); }
+
+   private:
+    struct Level;
+    class NodePacker;
+
+    int CompareEntry(const char *a, const char *b) const;
+
+    std::vector<const char *> SortBuffer();
+
+    void SpillBuffer();
+
+    void MergeRuns();
+
+    int GetNumNodes(int num_entries) const;
+
+    void Build(int num_entries, const std::function<const char *()> &next_entry);
+
+    void BuildCompressed(int num_entries, const std::function<const char *()> &next_entry,
+                         const std::function<void()> &rewind);
+
+    std::vector<std::vector<page_id_t>> AllocatePages(const std::vector<int> &level_nodes);
+
+    void LinkPages(const std::vector<std::vector<page_id_t>> &pages);
+
+    void WritePage(page_id_t page_no, const char *page_buf);
+
+    void FlushWrites();
+
+    IxIndexHandle *ih_;
+    int col_len_;
+    int entry_len_;            // 每个条目为key(col_len)后接一个Rid
+    double fill_factor_;
+    size_t sort_memory_;
+    std::vector<char> buffer_;  // 内存中尚未排序的条目
+    std::vector<std::unique_ptr<SpillFile>> runs_;  // 溢出到磁盘的有序段, 段内已经去掉重复的key
+
+    // 页号连续的结点攒够IX_BULK_LOAD_WRITE_PAGES个后一次写入
+    AlignedBuffer write_buf_;
+    page_id_t write_start_ = INVALID_PAGE_ID;
+    int write_pages_ = 0;
+};
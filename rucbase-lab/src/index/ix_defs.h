@@ -3,17 +3,29 @@
 #include "defs.h"
 #include "storage/buffer_pool_manager.h"
 
+constexpr int IX_MAX_INDEX_COLS = 8;  // 一个索引最多包含的列数
+constexpr int IX_RID_KEY_LEN = 8;     // 非唯一索引在key末尾附加的Rid的长度
+
 struct IxFileHdr {
     page_id_t first_free_page_no;
     int num_pages;        // disk pages
     page_id_t root_page;  // root page no
-    ColType col_type;
-    int col_len;      // ColMeta->len
+    ColType col_type;  // 多列索引时为第一列的类型
+    int col_len;       // key的总长度, 单列索引即ColMeta->len
     int btree_order;  // children per page 每个结点最多可插入的键值对数量
     int keys_size;  // keys_size = (btree_order + 1) * col_len
     // first_leaf初始化之后没有进行修改，只不过是在测试文件中遍历叶子结点的时候用了
     page_id_t first_leaf;  // 在上层IxManager的open函数进行初始化，初始化为root page_no
     page_id_t last_leaf;
+    bool compress_keys;  // 结点使用IxKeyHeapHdr描述的变长格式, 只用于单列的TYPE_STRING
+    // 多列索引的key由各列按索引中的顺序拼接而成, 按列逐个比较(字典序)
+    int num_cols;
+    ColType col_types[IX_MAX_INDEX_COLS + 1];  // 多一列留给非唯一索引附加的Rid
+    int col_lens[IX_MAX_INDEX_COLS + 1];
+    // 非唯一索引在每个key末尾附加IX_RID_KEY_LEN字节的Rid(page_no, slot_no按大端存放, memcmp的顺序与Rid一致),
+    // 使树中的key仍然互不相同, key相同的键值对按Rid排列在一起. 附加的Rid并入最后一个TYPE_STRING列,
+    // 否则作为一个TYPE_STRING列追加在key schema末尾; col_len包含这部分
+    bool unique;
 };
 
 struct IxPageHdr {
@@ -25,6 +37,31 @@ struct IxPageHdr {
     page_id_t next_leaf;  // next leaf node's page_no, effective only when is_leaf is true
 };
 
+/**
+ * @brief 压缩格式(IxFileHdr::compress_keys)的结点在IxPageHdr之后的部分
+ * 页面布局: | IxPageHdr | IxKeyHeapHdr | IxKeySlot * num_key --> 空闲空间 <-- key堆 |
+ * 每个结点记录其key范围的上下界(fence): 下界是父结点中指向它的key, 上界是父结点中下一个key.
+ * 两个fence的公共前缀是结点中所有key的公共前缀, 只在结点中存一次; key去掉前缀和末尾填充的0之后存入key堆.
+ * 以后插入结点的key也在fence之间, 因此插入不会使前缀变短
+ */
+struct IxKeyHeapHdr {
+    uint16_t heap_begin;    // key堆占据[heap_begin, PAGE_SIZE), 向前增长
+    uint16_t heap_garbage;  // key堆中已删除的key占用的字节数, 空间不够时整理掉
+    uint16_t low_offset;    // 下界fence(去掉末尾的0)在页面中的位置
+    uint16_t low_len;
+    uint16_t high_offset;   // 上界fence
+    uint16_t high_len;
+    uint16_t prefix_len;    // 公共前缀的长度, 前缀就是下界fence的前prefix_len个字节
+    bool low_inf;           // 下界为负无穷(最左边的结点)
+    bool high_inf;          // 上界为正无穷(最右边的结点)
+};
+
+struct IxKeySlot {
+    uint16_t offset;  // key去掉前缀后剩下部分在页面中的位置
+    uint16_t len;
+    Rid rid;
+};
+
 // 这个其实和Rid结构类似
 struct Iid {
     int page_no;
@@ -1,40 +1,102 @@
 #include "ix_index_handle.h"
 
+#include <algorithm>
+#include <thread>
+
 #include "ix_scan.h"
 
 IxIndexHandle::IxIndexHandle(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, int fd)
     : disk_manager_(disk_manager), buffer_pool_manager_(buffer_pool_manager), fd_(fd) {
     // init file_hdr_
     disk_manager_->read_page(fd, IX_FILE_HDR_PAGE, (char *)&file_hdr_, sizeof(file_hdr_));
-    // disk_manager管理的fd对应的文件中，设置从原来编号+1开始分配page_no
-    disk_manager_->set_fd2pageno(fd, disk_manager_->get_fd2pageno(fd) + 1);
+    key_search_ = file_hdr_.num_cols == 1 ? &IxKeySearch::Get(file_hdr_.col_type) : nullptr;
+    max_pinned_pages_ = std::min(IX_PINNED_MAX_PAGES, buffer_pool_manager_->GetPoolSize() / 16);
+    // disk_manager管理的fd对应的文件中，从文件末尾开始分配page_no
+    // file_hdr_.num_pages只统计在用的页面, 回收的页面仍占据文件空间, 因此按文件大小计算
+    int file_pages = disk_manager_->GetFileSize(disk_manager_->GetFileName(fd)) / PAGE_SIZE;
+    disk_manager_->set_fd2pageno(fd, std::max(file_pages, IX_INIT_NUM_PAGES));
+    disk_manager_->LoadFreePages(fd, file_hdr_.first_free_page_no);
 }
 
 /**
  * @brief 用于查找指定键所在的叶子结点
+ * 乐观下降(pessimistic=false)时逐层加读锁, 拿到孩子的锁后释放父结点; INSERT/DELETE只对叶子加写锁,
+ * 叶子不安全(需要分裂或合并)时由调用者释放后以悲观方式重新下降.
+ * 悲观下降时逐层加写锁并记入事务的page set, 到达安全结点后释放其祖先
  *
  * @param key 要查找的目标key值
  * @param operation 查找到目标键值对后要进行的操作类型
- * @param transaction 事务参数，如果不需要则默认传入nullptr
+ * @param transaction 事务参数，INSERT/DELETE时用其page set记录加写锁的结点，FIND时可以传入nullptr
+ * @param pessimistic 是否悲观下降, 只用于INSERT/DELETE
  * @return 返回目标叶子结点
- * @note need to Unpin the leaf node outside!
+ * @note FIND返回的叶子加了读锁, 需要在外部RUnlatch并unpin; INSERT/DELETE返回的叶子在page set中, 由ReleasePageSet释放
  */
-IxNodeHandle *IxIndexHandle::FindLeafPage(const char *key, Operation operation, Transaction *transaction) {
-    // Todo:
-    // 1. 获取根节点
-    // 2. 从根节点开始不断向下查找目标key
-    // 3. 找到包含该key值的叶子结点停止查找，并返回叶子节点
-	//get root
-	IxNodeHandle *root = FetchNode(file_hdr_.root_page);
-	IxNodeHandle *cur = root;
-    
-	while(!cur->IsLeafPage()){ //traverse
-		IxNodeHandle *parent = cur;
-		cur = FetchNode(cur->InternalLookup(key));
-		//unpin page
-		buffer_pool_manager_->UnpinPage(parent->GetPageId(), false);
-	}
-	return cur; //get leaf node
+IxNodeHandle *IxIndexHandle::FindLeafPage(const char *key, Operation operation, Transaction *transaction,
+                                          bool pessimistic) {
+    if (pessimistic) {
+        root_latch_.lock();
+        transaction->AddIntoPageSet(nullptr);  // nullptr代表root_latch_
+    } else {
+        root_latch_.lock_shared();
+    }
+    // 乐观下降经过的上层内部结点可以常驻, 悲观下降要把结点记入page set并由ReleasePageSet unpin, 不使用常驻结点
+    int depth = 0;
+    PinnedNode *pinned = nullptr;
+    IxNodeHandle *node = pessimistic ? FetchNode(file_hdr_.root_page) : FetchDescentNode(file_hdr_.root_page, 0, &pinned);
+    // 结点是否为叶子在其生命周期内不变, 可以在加锁之前读取
+    if (pessimistic || (operation != Operation::FIND && node->IsLeafPage())) {
+        node->page->WLatch();
+    } else {
+        node->page->RLatch();
+    }
+    if (!pessimistic) {
+        root_latch_.unlock_shared();
+    } else {
+        transaction->AddIntoPageSet(node->page);
+        if (IsSafeNode(node, operation, true)) {
+            ReleaseAncestors(transaction, 1);
+        }
+    }
+    // 删除使结点的第一个key改变时, maintain_parent沿着第0个孩子指针向上修改祖先的key, 直到某个结点不是其父结点的
+    // 第0个孩子为止; anchor是这个父结点在page set中的下标, 即使路径下方出现安全结点也不能释放它.
+    // 压缩格式的父结点中是分隔key, 不需要maintain_parent
+    size_t anchor = transaction != nullptr ? transaction->GetPageSet()->size() - 1 : 0;
+    while (!node->IsLeafPage()) {
+        int child_idx = node->upper_bound(key) - 1;
+        PinnedNode *child_pinned = nullptr;
+        IxNodeHandle *child = pessimistic ? FetchNode(node->ValueAt(child_idx))
+                                          : FetchDescentNode(node->ValueAt(child_idx), depth + 1, &child_pinned);
+        bool write_latch = pessimistic || (operation != Operation::FIND && child->IsLeafPage());
+        if (write_latch) {
+            child->page->WLatch();
+        } else {
+            child->page->RLatch();
+        }
+        if (!pessimistic) {
+            ReleaseDescentNode(node, pinned);
+            pinned = child_pinned;
+        } else {
+            auto page_set = transaction->GetPageSet();
+            if (child_idx > 0) {
+                anchor = page_set->size() - 1;
+            }
+            page_set->push_back(child->page);
+            if (IsSafeNode(child, operation, false)) {
+                size_t count = operation == Operation::DELETE && !file_hdr_.compress_keys ? anchor : page_set->size() - 1;
+                ReleaseAncestors(transaction, count);
+                anchor -= std::min(anchor, count);
+            }
+        }
+        delete node;
+        node = child;
+        depth++;
+    }
+    descents_++;
+    descent_levels_ += depth + 1;
+    if (!pessimistic && operation != Operation::FIND) {
+        transaction->AddIntoPageSet(node->page);  // 乐观下降时只有叶子加了写锁
+    }
+	return node; //get leaf node
 }
 
 /**
@@ -51,18 +113,41 @@ bool IxIndexHandle::GetValue(const char *key, std::vector<Rid> *result, Transact
     // 2. 在叶子节点中查找目标key值的位置，并读取key对应的rid
     // 3. 把rid存入result参数中
     // 提示：使用完buffer_pool提供的page之后，记得unpin page；记得处理并发的上锁
-	std::scoped_lock lock{root_latch_}; //lock
-	IxNodeHandle *leaf = FindLeafPage(key, Operation::FIND, transaction);
-    Rid* rid = nullptr; //initial rid
-	//unpin page
-	buffer_pool_manager_->UnpinPage(leaf->GetPageId(), false);
-
-	if(leaf->LeafLookup(key, &rid)){ //get rid
-		result->push_back(*rid); //insert
-		return true;
+	if(file_hdr_.unique){
+		IxNodeHandle *leaf = FindLeafPage(key, Operation::FIND, transaction);
+		Rid* rid = nullptr; //initial rid
+		bool found = leaf->LeafLookup(key, &rid);
+		if(found) //get rid
+			result->push_back(*rid); //insert
+		leaf->page->RUnlatch();
+		buffer_pool_manager_->UnpinPage(leaf->GetPageId(), false);
+		delete leaf;
+		return found;
 	}
-	else
-		return false;
+	// 非唯一索引: key相同的键值对按rid排列在(key, 最小rid)和(key, 最大rid)之间, 可能跨越多个叶子
+	char low_key[IX_MAX_COL_LEN], high_key[IX_MAX_COL_LEN];
+	GetBoundKey(key, false, low_key);
+	GetBoundKey(key, true, high_key);
+	size_t old_size = result->size();
+	IxNodeHandle *leaf = FindLeafPage(low_key, Operation::FIND, transaction);
+	int pos = leaf->lower_bound(low_key);
+	while(true){
+		for(; pos < leaf->GetSize() && leaf->CompareKey(pos, high_key) <= 0; pos++)
+			result->push_back(*leaf->get_rid(pos));
+		// 当前叶子中还有更大的key, 或已经是最后一个叶子
+		page_id_t next_leaf = leaf->GetNextLeaf();
+		bool done = pos < leaf->GetSize() || next_leaf == IX_LEAF_HEADER_PAGE;
+		leaf->page->RUnlatch();
+		buffer_pool_manager_->UnpinPage(leaf->GetPageId(), false);
+		delete leaf;
+		if(done)
+			break;
+		// 与IxScan一样先释放当前叶子再锁下一个叶子, 只从左向右加锁
+		leaf = FetchNode(next_leaf);
+		leaf->page->RLatch();
+		pos = 0;
+	}
+	return result->size() > old_size;
 }
 
 /**
@@ -78,22 +163,50 @@ bool IxIndexHandle::insert_entry(const char *key, const Rid &value, Transaction
     // 2. 在该叶子节点中插入键值对
     // 3. 如果结点已满，分裂结点，并把新结点的相关信息插入父节点
     // 提示：记得unpin page；若当前叶子节点是最右叶子节点，则需要更新file_hdr_.last_leaf；记得处理并发的上锁
-	std::scoped_lock lock{root_latch_};//set lock
-
+	std::unique_ptr<Transaction> local_txn;
+	if(transaction == nullptr){ // 回滚等内部调用没有事务, 只用于记录page set
+		local_txn = std::make_unique<Transaction>(INVALID_TXN_ID);
+		transaction = local_txn.get();
+	}
+	char entry_key[IX_MAX_COL_LEN];
+	key = GetEntryKey(key, value, entry_key);  // 非唯一索引的key附加rid
+	// 乐观插入: 只对叶子加写锁, key已存在或插入后不需要分裂时直接完成
 	IxNodeHandle *leaf = FindLeafPage(key, Operation::INSERT, transaction);
-	int cur_size = leaf->GetSize(); //current size	    
-	if(leaf->Insert(key,value)== cur_size){// can not insert
-		buffer_pool_manager_->UnpinPage(leaf->GetPageId(), false);	
+	Rid *rid = nullptr;
+	if(leaf->LeafLookup(key, &rid)){ // can not insert
+		ReleasePageSet(transaction, false);
+		delete leaf;
+		return false;
+	}
+	if(IsSafeNode(leaf, Operation::INSERT, false)){
+		leaf->Insert(key, value);
+		ReleasePageSet(transaction, true);
+		delete leaf;
+		return true;
+	}
+	ReleasePageSet(transaction, false);
+	delete leaf;
+
+	// 叶子需要分裂, 悲观地重新下降: 从第一个不安全的祖先开始都持有写锁
+	leaf = FindLeafPage(key, Operation::INSERT, transaction, true);
+	int cur_size = leaf->GetSize(); //current size
+	if(leaf->Insert(key,value)== cur_size){// 重新下降之前其他线程插入了同一个key
+		ReleasePageSet(transaction, false);
+		delete leaf;
 		return false;
 	}
-	else if(leaf->GetSize() == leaf->GetMaxSize()){ // leaf is full
-		IxNodeHandle* new_node = Split(leaf); //split
+	else if(leaf->IsOverfull()){ // leaf is full
+		IxNodeHandle* new_node = Split(leaf, transaction); //split
 		if(leaf->GetPageNo() == file_hdr_.last_leaf)
 			file_hdr_.last_leaf = new_node->GetPageNo(); //renew last leaf
-		InsertIntoParent(leaf, new_node->get_key(0), new_node, transaction);
+		char separator[IX_MAX_COL_LEN];
+		new_node->GetLowKey(separator);
+		InsertIntoParent(leaf, separator, new_node, transaction);
 		buffer_pool_manager_->UnpinPage(new_node->GetPageId(), true);//unpin
+		delete new_node;
 	}
-	buffer_pool_manager_->UnpinPage(leaf->GetPageId(), false);
+	ReleasePageSet(transaction, true);  // 叶子已插入新键值对, 必须标记为脏页
+	delete leaf;
 	return true;
 }
 
@@ -104,13 +217,14 @@ bool IxIndexHandle::insert_entry(const char *key, const Rid &value, Transaction
  * @return 拆分得到的new_node
  * @note 本函数执行完毕后，原node和new node都需要在函数外面进行unpin
  */
-IxNodeHandle *IxIndexHandle::Split(IxNodeHandle *node) {
+IxNodeHandle *IxIndexHandle::Split(IxNodeHandle *node, Transaction *transaction) {
     // Todo:
     // 1. 将原结点的键值对平均分配，右半部分分裂为新的右兄弟结点
     //    需要初始化新节点的page_hdr内容
     // 2. 如果新的右兄弟结点是叶子结点，更新新旧节点的prev_leaf和next_leaf指针
     //    为新节点分配键值对，更新旧节点的键值对数记录
     // 3. 如果新的右兄弟结点不是叶子结点，更新该结点的所有孩子结点的父节点信息(使用IxIndexHandle::maintain_child())
+	splits_++;
 	IxNodeHandle* new_node = CreateNode(); //new node
 	//initial by *node
 	new_node->page_hdr->num_key = 0;
@@ -124,18 +238,16 @@ IxNodeHandle *IxIndexHandle::Split(IxNodeHandle *node) {
         new_node->page_hdr->next_leaf = node->page_hdr->next_leaf;
         node->page_hdr->next_leaf = new_node->GetPageNo();
 		
+		// 不对右边的叶子加锁(叶子之间只从左向右加锁会与自顶向下的加锁顺序形成环): 其prev_leaf只会被持有本结点写锁的线程修改
 		IxNodeHandle* next_node = FetchNode(new_node->page_hdr->next_leaf);
         next_node->page_hdr->prev_leaf = new_node->GetPageNo();
 		buffer_pool_manager_->UnpinPage(next_node->GetPageId(), true);
 	}
 
 	//split node into node(left) + new_node(right)
-	int pos = node->page_hdr->num_key / 2;
-    int num = node->GetSize() - pos;
-	new_node->insert_pairs(0, node->get_key(pos), node->get_rid(pos), num);
-	node->page_hdr->num_key = pos;
-    for(int i = 0; i < num; ++i) //renew child-nodes' father-node
-        maintain_child(new_node, i);
+	node->MoveHalfTo(new_node);
+    for(int i = 0; i < new_node->GetSize(); ++i) //renew child-nodes' father-node
+        maintain_child(new_node, i, transaction);
     return new_node;
 }
 
@@ -168,22 +280,28 @@ void IxIndexHandle::InsertIntoParent(IxNodeHandle *old_node, const char *key, Ix
 		new_root->page_hdr->parent = INVALID_PAGE_ID;
 		new_root->page_hdr->next_free_page_no = IX_NO_PAGE;
 
-		new_root->insert_pair(0, old_node->get_key(0), (Rid){old_node->GetPageNo(), -1});
+		char old_key[IX_MAX_COL_LEN];
+		old_node->GetLowKey(old_key);
+		new_root->insert_pair(0, old_key, (Rid){old_node->GetPageNo(), -1});
 		new_root->insert_pair(1, key, (Rid){new_node->GetPageNo(), -1});
 	
 		int new_root_page = new_root->GetPageNo();
 		file_hdr_.root_page = new_root_page;
 		new_node->page_hdr->parent = new_root_page;
 		old_node->page_hdr->parent = new_root_page;
+		buffer_pool_manager_->UnpinPage(new_root->GetPageId(), true);
+		ShiftPinnedLevels(1);
 	}
 	else{
 		IxNodeHandle* parent_node = FetchNode(old_node->GetParentPageNo());
 		int rid_idx = parent_node->find_child(old_node);
 		parent_node->insert_pair(rid_idx + 1, key, (Rid){new_node->GetPageId().page_no, -1});
 
-		if(parent_node->GetSize() == parent_node->GetMaxSize()){
-			IxNodeHandle* new_parent = Split(parent_node);
-			InsertIntoParent(parent_node, new_parent->get_key(0), new_parent, transaction);
+		if(parent_node->IsOverfull()){
+			IxNodeHandle* new_parent = Split(parent_node, transaction);
+			char separator[IX_MAX_COL_LEN];
+			new_parent->GetLowKey(separator);
+			InsertIntoParent(parent_node, separator, new_parent, transaction);
 			buffer_pool_manager_->UnpinPage(new_parent->GetPageId(), true);
 		}
 		buffer_pool_manager_->UnpinPage(parent_node->GetPageId(), true);
@@ -198,22 +316,52 @@ void IxIndexHandle::InsertIntoParent(IxNodeHandle *old_node, const char *key, Ix
  * @return 是否删除成功
  */
 bool IxIndexHandle::delete_entry(const char *key, Transaction *transaction) {
+    assert(file_hdr_.unique);  // 非唯一索引需要rid才能确定要删除的键值对
+    return delete_entry(key, Rid{}, transaction);
+}
+
+bool IxIndexHandle::delete_entry(const char *key, const Rid &rid, Transaction *transaction) {
     // Todo:
     // 1. 获取该键值对所在的叶子结点
     // 2. 在该叶子结点中删除键值对
     // 3. 如果删除成功需要调用CoalesceOrRedistribute来进行合并或重分配操作，并根据函数返回结果判断是否有结点需要删除
     // 4. 如果需要并发，并且需要删除叶子结点，则需要在事务的delete_page_set中添加删除结点的对应页面；记得处理并发的上锁
-	std::scoped_lock lock{root_latch_};
+	std::unique_ptr<Transaction> local_txn;
+	if(transaction == nullptr){
+		local_txn = std::make_unique<Transaction>(INVALID_TXN_ID);
+		transaction = local_txn.get();
+	}
+	char entry_key[IX_MAX_COL_LEN];
+	key = GetEntryKey(key, rid, entry_key);
+	// 乐观删除: 叶子删除后不需要合并, 且删除的不是第一个key(不需要修改祖先的key)时直接完成
 	IxNodeHandle *leaf = FindLeafPage(key, Operation::DELETE, transaction);
-    
+	int pos = leaf->lower_bound(key);
+	if(pos == leaf->GetSize() || leaf->CompareKey(pos, key) != 0){
+		ReleasePageSet(transaction, false);
+		delete leaf;
+		return false;
+	}
+	bool is_root = leaf->IsRootPage();
+	if(IsSafeNode(leaf, Operation::DELETE, is_root) && (pos != 0 || is_root || file_hdr_.compress_keys)){
+		leaf->erase_pair(pos);
+		ReleasePageSet(transaction, true);
+		delete leaf;
+		return true;
+	}
+	ReleasePageSet(transaction, false);
+	delete leaf;
+
+	leaf = FindLeafPage(key, Operation::DELETE, transaction, true);
 	int size = leaf->GetSize();
-	if(leaf->Remove(key) == size){// cannot remove
-		buffer_pool_manager_->UnpinPage(leaf->GetPageId(), false);	
+	if(leaf->Remove(key) == size){// 重新下降之前其他线程删除了同一个key
+		ReleasePageSet(transaction, false);
+		delete leaf;
 		return false;
 	}
 	else{
-		CoalesceOrRedistribute(leaf);
-		buffer_pool_manager_->UnpinPage(leaf->GetPageId(), true);
+		CoalesceOrRedistribute(leaf, transaction);
+		ReleasePageSet(transaction, true);  // 同时回收合并掉的结点
+		delete leaf;
 		return true;
 	}
 }
@@ -240,32 +388,38 @@ bool IxIndexHandle::CoalesceOrRedistribute(IxNodeHandle *node, Transaction *tran
     // NodeMinSize*2)，则只需要重新分配键值对（调用Redistribute函数）
     // 5. 如果不满足上述条件，则需要合并两个结点，将右边的结点合并到左边的结点（调用Coalesce函数）
 	if(node->IsRootPage()) //judge root
-		return AdjustRoot(node);
+		return AdjustRoot(node, transaction);
 
-	if(node->GetSize() >= node->GetMinSize()) { //no need to coalesce
+	if(!node->IsUnderfull()) { //no need to coalesce
 		maintain_parent(node);
 		return false;
 	}
 	IxNodeHandle *parent_node = FetchNode(node->GetParentPageNo()); 		
 	IxNodeHandle *brother_node = nullptr;
+	if(parent_node->GetSize() == 1){ // 压缩格式的父结点可能因为合并后放不下而只剩一个孩子, 此时没有兄弟结点
+		buffer_pool_manager_->UnpinPage(parent_node->GetPageId(), false);
+		delete parent_node;
+		return false;
+	}
 	int pos = parent_node->find_child(node);
+	// 兄弟结点从父结点的孩子指针中取: 内部结点没有prev_leaf/next_leaf, 相邻的叶子也可能不在同一个父结点下
+	// 兄弟结点加写锁后记入page set, 与路径上的结点一起释放
 	if(pos){
-		brother_node = FetchNode(node->GetPrevLeaf());
+		brother_node = FetchLatchedNode(parent_node->ValueAt(pos - 1), transaction);
 	}
 	else{
-		brother_node = FetchNode(node->GetNextLeaf());
+		brother_node = FetchLatchedNode(parent_node->ValueAt(pos + 1), transaction);
 	}
 	//unpin page
-	if(node->GetSize() + brother_node->GetSize() >= node->GetMinSize() * 2){
-		Redistribute(brother_node, node, parent_node, pos);
+	bool can_merge = pos ? node->CanMergeInto(brother_node) : brother_node->CanMergeInto(node);
+	if(!can_merge){
+		Redistribute(brother_node, node, parent_node, pos, transaction);
 		buffer_pool_manager_->UnpinPage(parent_node->GetPageId(), true);
-    	buffer_pool_manager_->UnpinPage(brother_node->GetPageId(), true);
 		return false;
 	}
 	else{
 	    Coalesce(&brother_node, &node, &parent_node, pos, transaction);
 		buffer_pool_manager_->UnpinPage(parent_node->GetPageId(), true);
-    	buffer_pool_manager_->UnpinPage(brother_node->GetPageId(), true);
         return true;
 	}
 }
@@ -277,23 +431,21 @@ bool IxIndexHandle::CoalesceOrRedistribute(IxNodeHandle *node, Transaction *tran
  * @return bool 根结点是否需要被删除
  * @note size of root page can be less than min size and this method is only called within coalesceOrRedistribute()
  */
-bool IxIndexHandle::AdjustRoot(IxNodeHandle *old_root_node) {
+bool IxIndexHandle::AdjustRoot(IxNodeHandle *old_root_node, Transaction *transaction) {
     // Todo:
     // 1. 如果old_root_node是内部结点，并且大小为1，则直接把它的孩子更新成新的根结点
     // 2. 如果old_root_node是叶结点，且大小为0，则直接更新root page
     // 3. 除了上述两种情况，不需要进行操作
+	// 根结点是叶子时即使删空也保留, 与新建的索引一样是一个空的根叶子, 之后的插入和查找仍从它开始
 	if(old_root_node->IsLeafPage()){ // if is leafnode
-		if(old_root_node->GetSize() == 0){
-			release_node_handle(*old_root_node);
-			file_hdr_.root_page = INVALID_PAGE_ID; //reset invalid
-			return true;
-		}
+		return false;
 	}
 	else if(old_root_node->GetSize() == 1){ //if size == 1
 		IxNodeHandle *new_root = FetchNode(old_root_node->ValueAt(0));
 		new_root->SetParentPageNo(INVALID_PAGE_ID);
 		file_hdr_.root_page = new_root->GetPageNo(); //renew root page
-		release_node_handle(*old_root_node); //delete old root
+		release_node_handle(*old_root_node, transaction); //delete old root
+		ShiftPinnedLevels(-1);
 		buffer_pool_manager_->UnpinPage(new_root->GetPageId(), true);
 		return true;
 	}
@@ -314,23 +466,29 @@ bool IxIndexHandle::AdjustRoot(IxNodeHandle *old_root_node) {
  * index>0，则neighbor是node前驱结点，表示：neighbor(left)  node(right)
  * 注意更新parent结点的相关kv对
  */
-void IxIndexHandle::Redistribute(IxNodeHandle *neighbor_node, IxNodeHandle *node, IxNodeHandle *parent, int index) {
+void IxIndexHandle::Redistribute(IxNodeHandle *neighbor_node, IxNodeHandle *node, IxNodeHandle *parent, int index,
+                                 Transaction *transaction) {
     // Todo:
     // 1. 通过index判断neighbor_node是否为node的前驱结点
     // 2. 从neighbor_node中移动一个键值对到node结点中
     // 3. 更新父节点中的相关信息，并且修改移动键值对对应孩字结点的父结点信息（maintain_child函数）
     // 注意：neighbor_node的位置不同，需要移动的键值对不同，需要分类讨论
+	redistributions_++;
+	if(file_hdr_.compress_keys){
+		RedistributeKeys(neighbor_node, node, parent, index, transaction);
+		return;
+	}
 	if(index != 0){ //neighbor is left
 		int pos = neighbor_node->GetSize() -1;
 		node->insert_pair(0, neighbor_node->get_key(pos), *neighbor_node->get_rid(pos));
 		neighbor_node->erase_pair(pos);
-		maintain_child(node, 0);
+		maintain_child(node, 0, transaction);
 		maintain_parent(node);
 	}
 	else{ // right
 		node->insert_pair(node->GetSize(), neighbor_node->get_key(0), *neighbor_node->get_rid(0));
 		neighbor_node->erase_pair(0);
-		maintain_child(node, node->GetSize() - 1);
+		maintain_child(node, node->GetSize() - 1, transaction);
 		maintain_parent(neighbor_node);
 	}
 }
@@ -356,25 +514,76 @@ bool IxIndexHandle::Coalesce(IxNodeHandle **neighbor_node, IxNodeHandle **node,
     // 2. 把node结点的键值对移动到neighbor_node中，并更新node结点孩子结点的父节点信息（调用maintain_child函数）
     // 3. 释放和删除node结点，并删除parent中node结点的信息，返回parent是否需要被删除
     // 提示：如果是叶子结点且为最右叶子结点，需要更新file_hdr_.last_leaf
+	merges_++;
 	if(index == 0){
 		std::swap(*neighbor_node, *node); //use std::swap
 		index+=1;
 	}
 	int before_num = (*neighbor_node)->GetSize();
     // insert all entry of node into neighbor_node
-    (*neighbor_node)->insert_pairs(before_num, (*node)->get_key(0), (*node)->get_rid(0), (*node)->GetSize());
+    (*node)->MoveAllTo(*neighbor_node);
     int after_num = (*neighbor_node)->GetSize();
     for(int i = before_num; i < after_num; ++i)
-        maintain_child(*neighbor_node, i);
+        maintain_child(*neighbor_node, i, transaction);
     // update lase_leaf    important!!! 
     if((*node)->GetPageNo() == file_hdr_.last_leaf)
         file_hdr_.last_leaf = (*neighbor_node)->GetPageNo();
-    erase_leaf(*node);
-    release_node_handle(**node);
+    if((*node)->IsLeafPage())
+        erase_leaf(*node);  // 内部结点不在叶子链表中
+    release_node_handle(**node, transaction);
     (*parent)->erase_pair(index);
     return CoalesceOrRedistribute(*parent, transaction);
 }
 
+/**
+ * @brief 压缩格式的重分配: 从兄弟结点移动一个键值对到node, 并用新的分隔key替换父结点中分隔两个结点的key
+ * 分隔key的长度会变化, 移动后两个结点或父结点超过容量时不做重分配, node保持不足的状态, 不影响查找
+ * 参数与Redistribute相同
+ */
+void IxIndexHandle::RedistributeKeys(IxNodeHandle *neighbor_node, IxNodeHandle *node, IxNodeHandle *parent, int index,
+                                     Transaction *transaction) {
+    IxNodeHandle *left = index != 0 ? neighbor_node : node;
+    IxNodeHandle *right = index != 0 ? node : neighbor_node;
+    int right_idx = index != 0 ? index : 1;  // 父结点中分隔left和right的key
+    std::vector<IxEntry> left_entries = left->GetEntries();
+    std::vector<IxEntry> right_entries = right->GetEntries();
+    if (index != 0) {
+        if (left_entries.size() < 2) {
+            return;
+        }
+        right_entries.insert(right_entries.begin(), left_entries.back());
+        left_entries.pop_back();
+    } else {
+        if (right_entries.size() < 2) {
+            return;
+        }
+        left_entries.push_back(right_entries.front());
+        right_entries.erase(right_entries.begin());
+    }
+    // 内部结点的第一个key就是其下界, 移动后right的第一个key就是新的分隔key
+    std::string separator = left->IsLeafPage()
+                                ? IxNodeHandle::ShortestSeparator(left_entries.back().key, right_entries.front().key)
+                                : right_entries.front().key;
+    IxFence separator_fence = {false, separator};
+    IxFence left_low = left->GetLowFence();
+    IxFence right_high = right->GetHighFence();
+    int capacity = IxNodeHandle::GetCapacity(&file_hdr_);
+    int parent_bytes = parent->GetUsedBytes() - parent->slots[right_idx].len +
+                       std::max(static_cast<int>(separator.size()) - parent->heap_hdr->prefix_len, 0);
+    if (IxNodeHandle::GetEncodedSize(left_entries, left_low, separator_fence) > capacity ||
+        IxNodeHandle::GetEncodedSize(right_entries, separator_fence, right_high) > capacity || parent_bytes > capacity) {
+        return;
+    }
+    left->Rebuild(left_entries, left_low, separator_fence);
+    right->Rebuild(right_entries, separator_fence, right_high);
+    Rid right_rid = *parent->get_rid(right_idx);
+    parent->erase_pair(right_idx);
+    char key[IX_MAX_COL_LEN] = {};
+    memcpy(key, separator.data(), separator.size());
+    parent->insert_pair(right_idx, key, right_rid);
+    maintain_child(node, index != 0 ? 0 : node->GetSize() - 1, transaction);
+}
+
 /** -- 以下为辅助函数 -- */
 /**
  * @brief 获取一个指定结点
@@ -386,10 +595,94 @@ bool IxIndexHandle::Coalesce(IxNodeHandle **neighbor_node, IxNodeHandle **node,
 IxNodeHandle *IxIndexHandle::FetchNode(int page_no) const {
     // assert(page_no < file_hdr_.num_pages); // 不再生效，由于删除操作，page_no可以大于个数
     Page *page = buffer_pool_manager_->FetchPage(PageId{fd_, page_no});
-    IxNodeHandle *node = new IxNodeHandle(&file_hdr_, page);
+    IxNodeHandle *node = new IxNodeHandle(&file_hdr_, page, key_search_);
     return node;
 }
 
+/**
+ * @brief 乐观下降时获取深度为depth的结点, 不加锁
+ * 常驻的上层结点直接使用其页面, 不经过缓冲池; 否则从缓冲池获取, 是内部结点且深度小于IX_PINNED_LEVELS时
+ * 把这次的pin转给常驻结点表
+ *
+ * @param pinned 结点常驻时返回其表项, 否则为nullptr
+ * @note 用完之后调用ReleaseDescentNode
+ */
+IxNodeHandle *IxIndexHandle::FetchDescentNode(page_id_t page_no, int depth, PinnedNode **pinned) {
+    *pinned = nullptr;
+    if (depth >= IX_PINNED_LEVELS) {
+        return FetchNode(page_no);
+    }
+    {
+        std::shared_lock lock{pinned_latch_};
+        auto it = pinned_nodes_.find(page_no);
+        if (it != pinned_nodes_.end()) {
+            pinned_hits_++;
+            *pinned = it->second.get();
+            (*pinned)->users++;
+            return new IxNodeHandle(&file_hdr_, (*pinned)->page, key_search_);
+        }
+    }
+    IxNodeHandle *node = FetchNode(page_no);
+    if (!node->IsLeafPage()) {
+        std::unique_lock lock{pinned_latch_};
+        if (pinned_nodes_.size() < max_pinned_pages_ && pinned_nodes_.count(page_no) == 0) {
+            auto entry = std::make_unique<PinnedNode>();
+            entry->page = node->page;
+            entry->depth = depth;
+            entry->users = 1;
+            *pinned = entry.get();
+            pinned_nodes_.emplace(page_no, std::move(entry));
+        }
+    }
+    return node;
+}
+
+/**
+ * @brief 释放FetchDescentNode得到并加了读锁的结点
+ */
+void IxIndexHandle::ReleaseDescentNode(IxNodeHandle *node, PinnedNode *pinned) {
+    node->page->RUnlatch();
+    if (pinned != nullptr) {
+        pinned->users--;  // 之后不能再访问pinned, 它可能已经被移出并释放
+    } else {
+        buffer_pool_manager_->UnpinPage(node->GetPageId(), false);
+    }
+}
+
+/**
+ * @brief 根结点分裂(delta=1)或降低(delta=-1)后调整常驻结点的深度, 移出超出IX_PINNED_LEVELS的结点
+ * @note 调用者持有root_latch_的写锁
+ */
+void IxIndexHandle::ShiftPinnedLevels(int delta) {
+    std::vector<std::unique_ptr<PinnedNode>> evicted;
+    {
+        std::unique_lock lock{pinned_latch_};
+        for (auto it = pinned_nodes_.begin(); it != pinned_nodes_.end();) {
+            it->second->depth += delta;
+            if (it->second->depth >= IX_PINNED_LEVELS) {
+                evicted.push_back(std::move(it->second));
+                it = pinned_nodes_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    for (auto &entry : evicted) {
+        UnpinPinnedNode(std::move(entry));
+    }
+}
+
+/**
+ * @brief 等已经移出常驻结点表的结点不再被下降使用, 然后unpin
+ * 正在使用它的下降只会继续向下加锁, 不会等待移出它的线程持有的结点, 因此可以在持有写锁时等待
+ */
+void IxIndexHandle::UnpinPinnedNode(std::unique_ptr<PinnedNode> pinned) {
+    while (pinned->users > 0) {
+        std::this_thread::yield();
+    }
+    buffer_pool_manager_->UnpinPage(pinned->page->GetPageId(), false);
+}
+
 /**
  * @brief 创建一个新结点
  *
@@ -401,21 +694,111 @@ IxNodeHandle *IxIndexHandle::FetchNode(int page_no) const {
  * 与Record的处理不同，Record将未插入满的记录页认为是free_page
  */
 IxNodeHandle *IxIndexHandle::CreateNode() {
-    file_hdr_.num_pages++;
+    {
+        std::scoped_lock lock{num_pages_latch_};
+        file_hdr_.num_pages++;
+    }
     PageId new_page_id = {.fd = fd_, .page_no = INVALID_PAGE_ID};
     // 从3开始分配page_no，第一次分配之后，new_page_id.page_no=3，file_hdr_.num_pages=4
     Page *page = buffer_pool_manager_->NewPage(&new_page_id);
     // 注意，和Record的free_page定义不同，此处【不能】加上：file_hdr_.first_free_page_no = page->GetPageId().page_no
-    IxNodeHandle *node = new IxNodeHandle(&file_hdr_, page);
+    IxNodeHandle *node = new IxNodeHandle(&file_hdr_, page, key_search_);
+    if (file_hdr_.compress_keys) {
+        node->InitKeyHeap();
+    }
+    return node;
+}
+
+/**
+ * @brief 对node执行operation之后是否不会修改其父结点(分裂或合并)
+ * @param is_root node是否为根结点: 根结点分裂或被替换时需要修改root_page
+ */
+bool IxIndexHandle::IsSafeNode(IxNodeHandle *node, Operation operation, bool is_root) {
+    switch (operation) {
+        case Operation::INSERT:
+            return node->IsSafeToInsert();
+        case Operation::DELETE:
+            if (is_root) {
+                // 根叶子删空或者内部根结点只剩一个孩子时由AdjustRoot替换根结点
+                return node->GetSize() > (node->IsLeafPage() ? 1 : 2);
+            }
+            return node->IsSafeToDelete();
+        default:
+            return true;
+    }
+}
+
+/**
+ * @brief 获取不在下降路径上的结点(合并或重分配时的兄弟结点)并加写锁, 记入事务的page set
+ * @note 兄弟结点是本线程已加写锁的父结点的孩子, 加锁顺序仍是自顶向下的
+ */
+IxNodeHandle *IxIndexHandle::FetchLatchedNode(int page_no, Transaction *transaction) {
+    IxNodeHandle *node = FetchNode(page_no);
+    node->page->WLatch();
+    transaction->AddIntoPageSet(node->page);
     return node;
 }
 
+/** @return page是否已经在本次操作的page set中(已加写锁) */
+bool IxIndexHandle::IsLatched(const Page *page, Transaction *transaction) const {
+    auto page_set = transaction->GetPageSet();
+    return std::find(page_set->begin(), page_set->end(), page) != page_set->end();
+}
+
+/**
+ * @brief 释放page set中前count个结点(安全结点的祖先)的写锁和pin, nullptr代表root_latch_
+ * @note 释放的祖先不会被本次操作修改, 不需要标记为脏页
+ */
+void IxIndexHandle::ReleaseAncestors(Transaction *transaction, size_t count) {
+    auto page_set = transaction->GetPageSet();
+    for (size_t i = 0; i < count; i++) {
+        Page *page = page_set->front();
+        page_set->pop_front();
+        if (page == nullptr) {
+            root_latch_.unlock();
+        } else {
+            page->WUnlatch();
+            buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+        }
+    }
+}
+
+/**
+ * @brief 操作结束时释放page set中的所有写锁和pin, 然后从缓冲池中删除deleted page set中的结点, 交给DiskManager复用
+ * @param is_dirty 是否修改过树; page set中剩下的是从第一个不安全的结点开始的路径, 统一标记为脏页
+ */
+void IxIndexHandle::ReleasePageSet(Transaction *transaction, bool is_dirty) {
+    auto page_set = transaction->GetPageSet();
+    auto deleted_page_set = transaction->GetDeletedPageSet();
+    std::vector<PageId> deleted_page_ids;
+    for (Page *page : *deleted_page_set) {
+        deleted_page_ids.push_back(page->GetPageId());
+    }
+    deleted_page_set->clear();
+    for (Page *page : *page_set) {
+        if (page == nullptr) {
+            root_latch_.unlock();
+        } else {
+            page->WUnlatch();
+            buffer_pool_manager_->UnpinPage(page->GetPageId(), is_dirty);
+        }
+    }
+    page_set->clear();
+    // 删除的结点已经从树中摘除, 其他线程不会再访问
+    for (auto &page_id : deleted_page_ids) {
+        buffer_pool_manager_->DeletePage(page_id);
+    }
+}
+
 /**
  * @brief 从node开始更新其父节点的第一个key，一直向上更新直到根节点
  *
  * @param node
  */
 void IxIndexHandle::maintain_parent(IxNodeHandle *node) {
+    if (file_hdr_.compress_keys) {
+        return;  // 压缩格式的父结点中是分隔key, 孩子的第一个key被删除后仍然有效
+    }
     IxNodeHandle *curr = node;
     while (curr->GetParentPageNo() != IX_NO_PAGE) {
         // Load its parent
@@ -432,6 +815,10 @@ void IxIndexHandle::maintain_parent(IxNodeHandle *node) {
         curr = parent;
 
         assert(buffer_pool_manager_->UnpinPage(parent->GetPageId(), true));
+        // parent的第一个key没有变, 不需要继续向上; 并发删除时更上层的结点可能没有加锁, 不能再访问
+        if (rank != 0) {
+            break;
+        }
     }
 }
 
@@ -447,28 +834,112 @@ void IxIndexHandle::erase_leaf(IxNodeHandle *leaf) {
     prev->SetNextLeaf(leaf->GetNextLeaf());
     buffer_pool_manager_->UnpinPage(prev->GetPageId(), true);
 
+    // 前驱是合并时的左兄弟, 已经加锁; 后继可能在其他子树中, 和Split一样不加锁, 只修改prev_leaf
     IxNodeHandle *next = FetchNode(leaf->GetNextLeaf());
     next->SetPrevLeaf(leaf->GetPrevLeaf());  // 注意此处是SetPrevLeaf()
     buffer_pool_manager_->UnpinPage(next->GetPageId(), true);
 }
 
 /**
- * @brief 删除node时，更新file_hdr_.num_pages
+ * @brief 删除node时，更新file_hdr_.num_pages, 并把其页面记入事务的deleted page set
+ * @note 此时node的页面还被pin住并加了写锁, 由ReleasePageSet在释放所有结点之后回收
  *
  * @param node
  */
-void IxIndexHandle::release_node_handle(IxNodeHandle &node) { file_hdr_.num_pages--; }
+void IxIndexHandle::release_node_handle(IxNodeHandle &node, Transaction *transaction) {
+    {
+        std::scoped_lock lock{num_pages_latch_};
+        file_hdr_.num_pages--;
+    }
+    std::unique_ptr<PinnedNode> pinned;
+    {
+        std::unique_lock lock{pinned_latch_};
+        auto it = pinned_nodes_.find(node.GetPageNo());
+        if (it != pinned_nodes_.end()) {
+            pinned = std::move(it->second);
+            pinned_nodes_.erase(it);
+        }
+    }
+    if (pinned != nullptr) {
+        UnpinPinnedNode(std::move(pinned));  // 常驻结点表持有的pin
+    }
+    transaction->AddIntoDeletedPageSet(node.page);
+}
+
+/**
+ * @brief 截断文件末尾连续的回收页面
+ *
+ * @return int 截掉的页面个数
+ */
+int IxIndexHandle::vacuum() {
+    std::unique_lock lock{root_latch_};
+    page_id_t num_pages = disk_manager_->get_fd2pageno(fd_);
+    return num_pages - disk_manager_->TruncateFreePages(fd_);
+}
+
+/**
+ * @brief 返回下降和结构修改的统计, 以及当前的树高和常驻结点数
+ */
+IxIndexStats IxIndexHandle::GetStats() {
+    IxIndexStats stats;
+    stats.descents = descents_;
+    stats.descent_levels = descent_levels_;
+    stats.pinned_hits = pinned_hits_;
+    stats.splits = splits_;
+    stats.merges = merges_;
+    stats.redistributions = redistributions_;
+    {
+        std::shared_lock lock{pinned_latch_};
+        stats.pinned_pages = pinned_nodes_.size();
+    }
+    // 沿最左边的孩子下降到叶子
+    std::shared_lock lock{root_latch_};
+    IxNodeHandle *node = FetchNode(file_hdr_.root_page);
+    node->page->RLatch();
+    stats.height = 1;
+    while (!node->IsLeafPage()) {
+        IxNodeHandle *child = FetchNode(node->ValueAt(0));
+        child->page->RLatch();
+        node->page->RUnlatch();
+        buffer_pool_manager_->UnpinPage(node->GetPageId(), false);
+        delete node;
+        node = child;
+        stats.height++;
+    }
+    node->page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(node->GetPageId(), false);
+    delete node;
+    return stats;
+}
+
+void IxIndexHandle::UnpinUpperLevels() {
+    std::unique_lock lock{pinned_latch_};
+    for (auto &[page_no, pinned] : pinned_nodes_) {
+        buffer_pool_manager_->UnpinPage(pinned->page->GetPageId(), false);
+    }
+    pinned_nodes_.clear();
+}
 
 /**
  * @brief 将node的第child_idx个孩子结点的父节点置为node
  */
-void IxIndexHandle::maintain_child(IxNodeHandle *node, int child_idx) {
+void IxIndexHandle::maintain_child(IxNodeHandle *node, int child_idx, Transaction *transaction) {
     if (!node->IsLeafPage()) {
         //  Current node is inner node, load its child and set its parent to current node
         int child_page_no = node->ValueAt(child_idx);
         IxNodeHandle *child = FetchNode(child_page_no);
+        // 其他线程可能在node加锁之前已经进入了child(node对它是安全的), 修改父指针前要等它离开;
+        // 它只会继续向下加锁, 不会等待本线程持有的结点. 本线程路径上的结点已经加锁
+        bool latched = transaction == nullptr || IsLatched(child->page, transaction);
+        if (!latched) {
+            child->page->WLatch();
+        }
         child->SetParentPageNo(node->GetPageNo());
+        if (!latched) {
+            child->page->WUnlatch();
+        }
         buffer_pool_manager_->UnpinPage(child->GetPageId(), true);
+        delete child;
     }
 }
 
@@ -483,11 +954,18 @@ void IxIndexHandle::maintain_child(IxNodeHandle *node, int child_idx) {
  */
 Rid IxIndexHandle::get_rid(const Iid &iid) const {
     IxNodeHandle *node = FetchNode(iid.page_no);
+    node->page->RLatch();
     if (iid.slot_no >= node->GetSize()) {
+        node->page->RUnlatch();
+        buffer_pool_manager_->UnpinPage(node->GetPageId(), false);
+        delete node;
         throw IndexEntryNotFoundError();
     }
+    Rid rid = *node->get_rid(iid.slot_no);
+    node->page->RUnlatch();
     buffer_pool_manager_->UnpinPage(node->GetPageId(), false);  // unpin it!
-    return *node->get_rid(iid.slot_no);
+    delete node;
+    return rid;
 }
 
 /** --以下函数将用于lab3执行层-- */
@@ -503,13 +981,16 @@ Iid IxIndexHandle::lower_bound(const char *key) {
     // int int_key = *(int *)key;
     // printf("my_lower_bound key=%d\n", int_key);
 
+    char entry_key[IX_MAX_COL_LEN];
+    key = GetBoundKey(key, false, entry_key);  // 非唯一索引从key相同的第一个键值对开始
     IxNodeHandle *node = FindLeafPage(key, Operation::FIND, nullptr);
     int key_idx = node->lower_bound(key);
-
-    Iid iid = {.page_no = node->GetPageNo(), .slot_no = key_idx};
+    Iid iid = LeafPosition(node, key_idx);
 
     // unpin leaf node
+    node->page->RUnlatch();
     buffer_pool_manager_->UnpinPage(node->GetPageId(), false);
+    delete node;
     return iid;
 }
 
@@ -523,22 +1004,99 @@ Iid IxIndexHandle::upper_bound(const char *key) {
     // int int_key = *(int *)key;
     // printf("my_upper_bound key=%d\n", int_key);
 
+    char entry_key[IX_MAX_COL_LEN];
+    key = GetBoundKey(key, true, entry_key);  // 非唯一索引跳过key相同的所有键值对
     IxNodeHandle *node = FindLeafPage(key, Operation::FIND, nullptr);
-    int key_idx = node->upper_bound(key);
-
-    Iid iid;
-    if (key_idx == node->GetSize()) {
-        // 这种情况无法根据iid找到rid，即后续无法调用ih->get_rid(iid)
-        iid = leaf_end();
-    } else {
-        iid = {.page_no = node->GetPageNo(), .slot_no = key_idx};
-    }
+    // 结点的upper_bound从1开始(用于内部结点), 叶子中第一个key也可能大于key
+    // (最左边的叶子, 或压缩格式中分隔key比叶子的第一个key短)
+    int key_idx = node->GetSize() > 0 && node->CompareKey(0, key) > 0 ? 0 : node->upper_bound(key);
+    Iid iid = LeafPosition(node, key_idx);
 
     // unpin leaf node
+    node->page->RUnlatch();
     buffer_pool_manager_->UnpinPage(node->GetPageId(), false);
+    delete node;
     return iid;
 }
 
+/**
+ * @brief 估计iid在索引的所有键值对中的相对位置(0~1), 两个位置之差就是扫描范围的选择率
+ * 从叶子开始沿父结点向上, 每一层按孩子在父结点中的下标细分区间, 只访问树高个结点;
+ * 假设同一个结点的各个子树大小相同, 结果只是估计值
+ */
+double IxIndexHandle::estimate_position(const Iid &iid) const {
+    IxNodeHandle *node = FetchNode(iid.page_no);
+    node->page->RLatch();
+    double pos = node->GetSize() > 0 ? std::min(1.0, static_cast<double>(iid.slot_no) / node->GetSize()) : 0;
+    page_id_t child_page_no = node->GetPageNo();
+    page_id_t parent_page_no = node->GetParentPageNo();
+    node->page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(node->GetPageId(), false);
+    delete node;
+    while (parent_page_no != IX_NO_PAGE) {
+        IxNodeHandle *parent = FetchNode(parent_page_no);
+        parent->page->RLatch();
+        int child_idx = 0;
+        while (child_idx < parent->GetSize() && parent->ValueAt(child_idx) != child_page_no) {
+            child_idx++;
+        }
+        bool found = child_idx < parent->GetSize();  // 并发的分裂或合并可能已经把结点移走, 此时不再细分
+        if (found) {
+            pos = (child_idx + pos) / parent->GetSize();
+        }
+        child_page_no = parent_page_no;
+        parent_page_no = parent->GetParentPageNo();
+        parent->page->RUnlatch();
+        buffer_pool_manager_->UnpinPage(parent->GetPageId(), false);
+        delete parent;
+        if (!found) {
+            break;
+        }
+    }
+    return pos;
+}
+
+/**
+ * @brief lower_bound/upper_bound在叶子中找到的位置: 位于叶子末尾时改为下一个叶子的开头,
+ * 使得返回的iid要么指向一个键值对, 要么就是leaf_end(), 可以作为IxScan的起点或终点
+ */
+Iid IxIndexHandle::LeafPosition(IxNodeHandle *leaf, int key_idx) const {
+    if (key_idx == leaf->GetSize() && leaf->GetNextLeaf() != IX_LEAF_HEADER_PAGE) {
+        return {.page_no = leaf->GetNextLeaf(), .slot_no = 0};
+    }
+    return {.page_no = leaf->GetPageNo(), .slot_no = key_idx};
+}
+
+/**
+ * @brief 树中存放的key: 唯一索引就是key本身; 非唯一索引在key之后附加rid, 写入entry_key中
+ * rid的page_no和slot_no按大端存放, 使附加部分按memcmp比较的顺序与(page_no, slot_no)一致
+ */
+const char *IxIndexHandle::GetEntryKey(const char *key, const Rid &rid, char *entry_key) const {
+    if (file_hdr_.unique) {
+        return key;
+    }
+    int key_len = file_hdr_.col_len - IX_RID_KEY_LEN;
+    memcpy(entry_key, key, key_len);
+    for (int i = 0; i < 4; i++) {
+        entry_key[key_len + i] = static_cast<char>(static_cast<uint32_t>(rid.page_no) >> (24 - 8 * i));
+        entry_key[key_len + 4 + i] = static_cast<char>(static_cast<uint32_t>(rid.slot_no) >> (24 - 8 * i));
+    }
+    return entry_key;
+}
+
+/**
+ * @brief 非唯一索引中与key相同的所有键值对的下界(upper=false, 附加的rid全为0x00)或上界(全为0xff)
+ */
+const char *IxIndexHandle::GetBoundKey(const char *key, bool upper, char *entry_key) const {
+    if (file_hdr_.unique) {
+        return key;
+    }
+    int key_len = file_hdr_.col_len - IX_RID_KEY_LEN;
+    memcpy(entry_key, key, key_len);
+    memset(entry_key + key_len, upper ? 0xff : 0x00, IX_RID_KEY_LEN);
+    return entry_key;
+}
+
 /**
  * @brief 指向第一个叶子的第一个结点
  * 用处在于可以作为IxScan的第一个
@@ -558,7 +1116,10 @@ Iid IxIndexHandle::leaf_begin() const {
  */
 Iid IxIndexHandle::leaf_end() const {
     IxNodeHandle *node = FetchNode(file_hdr_.last_leaf);
-    Iid iid = {.page_no = file_hdr_.last_leaf, .slot_no = node->GetSize()};
+    node->page->RLatch();
+    Iid iid = {.page_no = node->GetPageNo(), .slot_no = node->GetSize()};
+    node->page->RUnlatch();
     buffer_pool_manager_->UnpinPage(node->GetPageId(), false);  // unpin it!
+    delete node;
     return iid;
 }
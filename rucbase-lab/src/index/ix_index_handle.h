@@ -1,48 +1,100 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <shared_mutex>
+#include <unordered_map>
+
 #include "ix_defs.h"
 #include "ix_node_handle.h"
 #include "transaction/transaction.h"
 
 enum class Operation { FIND = 0, INSERT, DELETE };  // 三种操作：查找、插入、删除
 
+/**
+ * @brief 索引的下降和结构修改统计, 由SHOW INDEX STATS输出
+ */
+struct IxIndexStats {
+    size_t descents = 0;         // FindLeafPage从根结点下降到叶子的次数
+    size_t descent_levels = 0;   // 每次下降经过的层数之和, 除以descents为平均下降深度
+    size_t pinned_hits = 0;      // 下降时直接使用常驻的上层结点, 没有经过缓冲池的次数
+    size_t splits = 0;           // 结点分裂次数
+    size_t merges = 0;           // 结点合并次数
+    size_t redistributions = 0;  // 兄弟结点之间重分配的次数
+    int height = 0;              // 当前树高
+    size_t pinned_pages = 0;     // 当前常驻的上层结点数
+
+    double AvgDescentDepth() const { return descents == 0 ? 0 : static_cast<double>(descent_levels) / descents; }
+};
+
 /**
  * @brief B+树索引
  */
 class IxIndexHandle {
     friend class IxScan;
     friend class IxManager;
+    friend class IxBulkLoader;
 
    private:
     DiskManager *disk_manager_;
     BufferPoolManager *buffer_pool_manager_;
     int fd_;
     IxFileHdr file_hdr_;  // 存了root_page，但root_page初始化为2（第0页存FILE_HDR_PAGE，第1页存LEAF_HEADER_PAGE）
-    std::mutex root_latch_;  // 用于索引并发（请自行选择并发粒度在 Tree级 或 Page级 ）
+    // 保护file_hdr_.root_page, 相当于根结点之上的一个虚拟结点: 乐观下降时加共享锁, 悲观下降时加独占锁直到根结点安全
+    std::shared_mutex root_latch_;
+    std::mutex num_pages_latch_;  // 保护file_hdr_.num_pages, 不同子树上的分裂与合并会并发修改
+    const IxKeySearch *key_search_;  // 按file_hdr_.col_type选择的结点内查找函数, 传给每个IxNodeHandle; 多列索引为nullptr
+    /**
+     * @brief 常驻的上层结点: 深度小于IX_PINNED_LEVELS的内部结点在第一次乐观下降时保留一个pin, 之后乐观下降直接使用
+     * 其页面, 不再经过缓冲池的页表和替换器. users是正在使用它的下降次数, 代替这些下降各自的pin;
+     * 结点被删除或因根结点分裂而超出常驻的深度时移出, 等users归零后再unpin
+     */
+    struct PinnedNode {
+        Page *page;
+        int depth;  // 加入时由下降路径得到, 根结点分裂或降低时整体调整
+        std::atomic<int> users{0};
+    };
+    std::unordered_map<page_id_t, std::unique_ptr<PinnedNode>> pinned_nodes_;
+    std::shared_mutex pinned_latch_;  // 保护pinned_nodes_
+    size_t max_pinned_pages_;         // IX_PINNED_MAX_PAGES, 且不超过缓冲池的1/16, 避免小缓冲池被常驻结点占满
+    std::atomic<size_t> descents_{0}, descent_levels_{0}, pinned_hits_{0};
+    std::atomic<size_t> splits_{0}, merges_{0}, redistributions_{0};
 
    public:
     IxIndexHandle(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, int fd);
 
+    int GetFd() { return fd_; }
+
     // for search
     bool GetValue(const char *key, std::vector<Rid> *result, Transaction *transaction);
 
-    IxNodeHandle *FindLeafPage(const char *key, Operation operation, Transaction *transaction);
+    IxNodeHandle *FindLeafPage(const char *key, Operation operation, Transaction *transaction,
+                               bool pessimistic = false);
 
     // for insert
     bool insert_entry(const char *key, const Rid &value, Transaction *transaction);
 
-    IxNodeHandle *Split(IxNodeHandle *node);
+    IxNodeHandle *Split(IxNodeHandle *node, Transaction *transaction);
 
     void InsertIntoParent(IxNodeHandle *old_node, const char *key, IxNodeHandle *new_node, Transaction *transaction);
 
     // for delete
     bool delete_entry(const char *key, Transaction *transaction);
 
+    /**
+     * @brief 删除(key, rid)这个键值对, 非唯一索引必须用它区分key相同的键值对; 唯一索引忽略rid
+     */
+    bool delete_entry(const char *key, const Rid &rid, Transaction *transaction);
+
     bool CoalesceOrRedistribute(IxNodeHandle *node, Transaction *transaction = nullptr);
 
-    bool AdjustRoot(IxNodeHandle *old_root_node);
+    bool AdjustRoot(IxNodeHandle *old_root_node, Transaction *transaction);
+
+    void Redistribute(IxNodeHandle *neighbor_node, IxNodeHandle *node, IxNodeHandle *parent, int index,
+                      Transaction *transaction);
 
-    void Redistribute(IxNodeHandle *neighbor_node, IxNodeHandle *node, IxNodeHandle *parent, int index);
+    void RedistributeKeys(IxNodeHandle *neighbor_node, IxNodeHandle *node, IxNodeHandle *parent, int index,
+                          Transaction *transaction);
 
     bool Coalesce(IxNodeHandle **neighbor_node, IxNodeHandle **node, IxNodeHandle **parent, int index,
                   Transaction *transaction);
@@ -56,6 +108,17 @@ class IxIndexHandle {
 
     Iid leaf_begin() const;
 
+    double estimate_position(const Iid &iid) const;
+
+    int vacuum();
+
+    IxIndexStats GetStats();
+
+    /**
+     * @brief unpin所有常驻的上层结点, 关闭索引之前调用
+     */
+    void UnpinUpperLevels();
+
    private:
     // 辅助函数
     void UpdateRootPageNo(page_id_t root) { file_hdr_.root_page = root; }
@@ -67,14 +130,40 @@ class IxIndexHandle {
 
     IxNodeHandle *CreateNode();
 
+    IxNodeHandle *FetchDescentNode(page_id_t page_no, int depth, PinnedNode **pinned);
+
+    void ReleaseDescentNode(IxNodeHandle *node, PinnedNode *pinned);
+
+    void ShiftPinnedLevels(int delta);
+
+    void UnpinPinnedNode(std::unique_ptr<PinnedNode> pinned);
+
+    Iid LeafPosition(IxNodeHandle *leaf, int key_idx) const;
+
+    // for non-unique index
+    const char *GetEntryKey(const char *key, const Rid &rid, char *entry_key) const;
+
+    const char *GetBoundKey(const char *key, bool upper, char *entry_key) const;
+
+    // for concurrency control
+    bool IsSafeNode(IxNodeHandle *node, Operation operation, bool is_root);
+
+    IxNodeHandle *FetchLatchedNode(int page_no, Transaction *transaction);
+
+    bool IsLatched(const Page *page, Transaction *transaction) const;
+
+    void ReleaseAncestors(Transaction *transaction, size_t count);
+
+    void ReleasePageSet(Transaction *transaction, bool is_dirty);
+
     // for maintain data structure
     void maintain_parent(IxNodeHandle *node);
 
     void erase_leaf(IxNodeHandle *leaf);
 
-    void release_node_handle(IxNodeHandle &node);
+    void release_node_handle(IxNodeHandle &node, Transaction *transaction);
 
-    void maintain_child(IxNodeHandle *node, int child_idx);
+    void maintain_child(IxNodeHandle *node, int child_idx, Transaction *transaction);
 
     // for index test
     Rid get_rid(const Iid &iid) const;
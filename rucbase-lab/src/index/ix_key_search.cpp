@@ -0,0 +1,187 @@
+#include "ix_key_search.h"
+
+#include <cstring>
+
+#include "errors.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief key是否排在target之前: lower_bound找第一个不满足key<target的位置, upper_bound找第一个不满足key<=target的位置
+ * @note 与ix_compare一样只用<和>比较, FLOAT遇到NaN时的结果也与原来一致
+ */
+template <typename T, bool Upper>
+static inline bool KeyBefore(T key, T target) {
+    return Upper ? !(key > target) : key < target;
+}
+
+/**
+ * @brief 数出keys[0,n)中排在target之前的key, keys有序, 因此结果就是target在keys中的位置
+ */
+template <typename T, bool Upper>
+static int ScalarCount(const T *keys, int n, T target) {
+    int count = 0;
+    for (int i = 0; i < n; i++) {
+        count += KeyBefore<T, Upper>(keys[i], target);
+    }
+    return count;
+}
+
+#if defined(__x86_64__)
+// x86-64都支持SSE2, 不需要检查CPU
+template <bool Upper>
+static int Sse2CountInt(const int *keys, int n, int target) {
+    __m128i t = _mm_set1_epi32(target);
+    int count = 0;
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(keys + i));
+        // Upper时数出key>target的个数, 剩下的就是key<=target的
+        __m128i mask = Upper ? _mm_cmpgt_epi32(v, t) : _mm_cmplt_epi32(v, t);
+        int bits = __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(mask)));
+        count += Upper ? 4 - bits : bits;
+    }
+    return count + ScalarCount<int, Upper>(keys + i, n - i, target);
+}
+
+template <bool Upper>
+static int Sse2CountFloat(const float *keys, int n, float target) {
+    __m128 t = _mm_set1_ps(target);
+    int count = 0;
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_loadu_ps(keys + i);
+        __m128 mask = Upper ? _mm_cmpgt_ps(v, t) : _mm_cmplt_ps(v, t);
+        int bits = __builtin_popcount(_mm_movemask_ps(mask));
+        count += Upper ? 4 - bits : bits;
+    }
+    return count + ScalarCount<float, Upper>(keys + i, n - i, target);
+}
+
+template <bool Upper>
+__attribute__((target("avx2"))) static int Avx2CountInt(const int *keys, int n, int target) {
+    __m256i t = _mm256_set1_epi32(target);
+    int count = 0;
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys + i));
+        __m256i mask = Upper ? _mm256_cmpgt_epi32(v, t) : _mm256_cmpgt_epi32(t, v);
+        int bits = __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(mask)));
+        count += Upper ? 8 - bits : bits;
+    }
+    return count + ScalarCount<int, Upper>(keys + i, n - i, target);
+}
+
+template <bool Upper>
+__attribute__((target("avx2"))) static int Avx2CountFloat(const float *keys, int n, float target) {
+    __m256 t = _mm256_set1_ps(target);
+    int count = 0;
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 v = _mm256_loadu_ps(keys + i);
+        __m256 mask = Upper ? _mm256_cmp_ps(v, t, _CMP_GT_OQ) : _mm256_cmp_ps(v, t, _CMP_LT_OQ);
+        int bits = __builtin_popcount(_mm256_movemask_ps(mask));
+        count += Upper ? 8 - bits : bits;
+    }
+    return count + ScalarCount<float, Upper>(keys + i, n - i, target);
+}
+#endif
+
+/**
+ * @brief INT/FLOAT的查找: 无分支的二分查找, 每轮只根据一次比较移动base(编译成条件传送), 不会有分支预测失败;
+ * 剩下不超过IX_LINEAR_SEARCH_KEYS个key时由Count数出其中排在target之前的个数
+ * 循环中始终保证结果在[base, base+n]内
+ */
+template <typename T, bool Upper, int (*Count)(const T *, int, T)>
+static int BranchlessSearch(const char *keys, int begin, int end, const char *target, int col_len) {
+    const T *first = reinterpret_cast<const T *>(keys);
+    const T *base = first + begin;
+    T t;
+    memcpy(&t, target, sizeof(T));  // target可能来自记录, 不一定对齐
+    int n = end - begin;
+    while (n > IX_LINEAR_SEARCH_KEYS) {
+        int half = n / 2;
+        base = KeyBefore<T, Upper>(base[half], t) ? base + half : base;
+        n -= half;
+    }
+    return static_cast<int>(base - first) + Count(base, n, t);
+}
+
+/**
+ * @brief STRING的查找: 直接用memcmp的二分查找
+ */
+template <bool Upper>
+static int StringSearch(const char *keys, int begin, int end, const char *target, int col_len) {
+    int l = begin, r = end;
+    while (l < r) {
+        int mid = (l + r) / 2;
+        int cmp = memcmp(keys + mid * col_len, target, col_len);
+        if (Upper ? cmp <= 0 : cmp < 0) {
+            l = mid + 1;
+        } else {
+            r = mid;
+        }
+    }
+    return l;
+}
+
+template <typename T, int (*LowerCount)(const T *, int, T), int (*UpperCount)(const T *, int, T)>
+static constexpr IxKeySearch MakeSearch() {
+    return {BranchlessSearch<T, false, LowerCount>, BranchlessSearch<T, true, UpperCount>};
+}
+
+static constexpr IxKeySearch int_scalar_search = MakeSearch<int, ScalarCount<int, false>, ScalarCount<int, true>>();
+static constexpr IxKeySearch float_scalar_search =
+    MakeSearch<float, ScalarCount<float, false>, ScalarCount<float, true>>();
+#if defined(__x86_64__)
+static constexpr IxKeySearch int_sse2_search = MakeSearch<int, Sse2CountInt<false>, Sse2CountInt<true>>();
+static constexpr IxKeySearch float_sse2_search = MakeSearch<float, Sse2CountFloat<false>, Sse2CountFloat<true>>();
+static constexpr IxKeySearch int_avx2_search = MakeSearch<int, Avx2CountInt<false>, Avx2CountInt<true>>();
+static constexpr IxKeySearch float_avx2_search = MakeSearch<float, Avx2CountFloat<false>, Avx2CountFloat<true>>();
+#endif
+static constexpr IxKeySearch string_search = {StringSearch<false>, StringSearch<true>};
+
+IxSearchIsa IxKeySearch::GetBestIsa() {
+#if defined(__x86_64__)
+    static const IxSearchIsa best_isa = __builtin_cpu_supports("avx2") ? IxSearchIsa::AVX2 : IxSearchIsa::SSE2;
+    return best_isa;
+#else
+    return IxSearchIsa::SCALAR;
+#endif
+}
+
+const IxKeySearch &IxKeySearch::Get(ColType type) { return Get(type, GetBestIsa()); }
+
+const IxKeySearch &IxKeySearch::Get(ColType type, IxSearchIsa isa) {
+    if (isa > GetBestIsa()) {
+        isa = GetBestIsa();
+    }
+    switch (type) {
+        case TYPE_INT:
+#if defined(__x86_64__)
+            if (isa == IxSearchIsa::AVX2) {
+                return int_avx2_search;
+            }
+            if (isa == IxSearchIsa::SSE2) {
+                return int_sse2_search;
+            }
+#endif
+            return int_scalar_search;
+        case TYPE_FLOAT:
+#if defined(__x86_64__)
+            if (isa == IxSearchIsa::AVX2) {
+                return float_avx2_search;
+            }
+            if (isa == IxSearchIsa::SSE2) {
+                return float_sse2_search;
+            }
+#endif
+            return float_scalar_search;
+        case TYPE_STRING:
+            return string_search;
+        default:
+            throw InternalError("Unexpected data type");
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "defs.h"
+
+/** 二分查找把范围缩小到这么多个key之后, 改为线性地数出排在target之前的key(INT/FLOAT为一到两个cache line) */
+static constexpr int IX_LINEAR_SEARCH_KEYS = 16;
+
+/** 结点内查找使用的指令集 */
+enum class IxSearchIsa { SCALAR, SSE2, AVX2 };
+
+/**
+ * @brief 结点内按key类型特化的查找函数
+ * IxIndexHandle根据IxFileHdr::col_type选择一次, 之后每次查找不再像ix_compare那样对每个key判断类型.
+ * INT/FLOAT使用无分支的二分查找, 范围缩小到IX_LINEAR_SEARCH_KEYS以内后用SIMD比较剩下的key;
+ * STRING使用memcmp二分查找
+ *
+ * @note keys是按col_len紧密排列的有序key数组, 在[begin, end)中查找, 比较的结果与ix_compare一致
+ */
+struct IxKeySearch {
+    int (*lower_bound)(const char *keys, int begin, int end, const char *target, int col_len);  // 第一个>=target的位置
+    int (*upper_bound)(const char *keys, int begin, int end, const char *target, int col_len);  // 第一个>target的位置
+
+    /** @brief 按类型和当前CPU支持的指令集选择查找函数 */
+    static const IxKeySearch &Get(ColType type);
+
+    /** @brief 使用指定的指令集, CPU不支持时退回到它支持的指令集 */
+    static const IxKeySearch &Get(ColType type, IxSearchIsa isa);
+
+    /** @return 当前CPU支持的最好的指令集 */
+    static IxSearchIsa GetBestIsa();
+};
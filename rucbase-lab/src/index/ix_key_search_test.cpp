@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "ix_node_handle.h"
+
+/**
+ * @brief 原来IxNodeHandle中逐个key调用ix_compare的二分查找, 作为正确性和性能的参照
+ */
+static int ReferenceSearch(const char *keys, int begin, int end, const char *target, ColType type, int col_len,
+                           bool upper) {
+    int l = begin, r = end;
+    while (l < r) {
+        int mid = (l + r) / 2;
+        int cmp = ix_compare(keys + mid * col_len, target, type, col_len);
+        if (upper ? cmp <= 0 : cmp < 0) {
+            l = mid + 1;
+        } else {
+            r = mid;
+        }
+    }
+    return l;
+}
+
+static const IxSearchIsa all_isas[] = {IxSearchIsa::SCALAR, IxSearchIsa::SSE2, IxSearchIsa::AVX2};
+
+/**
+ * @brief 把有序的key按col_len紧密排列, 与结点中keys的布局相同
+ */
+template <typename T>
+static std::vector<char> PackKeys(const std::vector<T> &keys) {
+    std::vector<char> packed(keys.size() * sizeof(T));
+    memcpy(packed.data(), keys.data(), packed.size());
+    return packed;
+}
+
+/**
+ * @brief 对0~300个有序的key, 查找每个key、相邻key之间的值以及两端之外的值,
+ * 在每种指令集下lower_bound(从0开始)和upper_bound(从1开始)都与参照结果一致
+ */
+TEST(IxKeySearchTest, MatchesIxCompare) {
+    std::mt19937 rng(0);
+    for (int n = 0; n <= 300; n++) {
+        std::vector<int> int_keys;
+        for (int i = 0; i < n; i++) {
+            int_keys.push_back(i * 3 - 200 + static_cast<int>(rng() % 2));
+        }
+        std::vector<float> float_keys(int_keys.begin(), int_keys.end());
+        std::vector<char> str_keys(n * 4);
+        for (int i = 0; i < n; i++) {
+            char str_key[16];
+            snprintf(str_key, sizeof(str_key), "%04d", i * 3);
+            memcpy(str_keys.data() + i * 4, str_key, 4);
+        }
+        auto packed_ints = PackKeys(int_keys);
+        auto packed_floats = PackKeys(float_keys);
+
+        for (int target = -205; target <= n * 3 - 195; target++) {
+            float float_target = static_cast<float>(target) + 0.5f * static_cast<float>(target % 2);
+            char str_target[16];
+            snprintf(str_target, sizeof(str_target), "%04d", std::max(target, 0));
+            for (auto isa : all_isas) {
+                for (bool upper : {false, true}) {
+                    int begin = upper ? std::min(1, n) : 0;
+                    auto search = [&](const IxKeySearch &kernels, const std::vector<char> &keys, const char *t) {
+                        auto fn = upper ? kernels.upper_bound : kernels.lower_bound;
+                        return fn(keys.data(), begin, n, t, 4);
+                    };
+                    ASSERT_EQ(search(IxKeySearch::Get(TYPE_INT, isa), packed_ints, (const char *)&target),
+                              ReferenceSearch(packed_ints.data(), begin, n, (const char *)&target, TYPE_INT, 4, upper));
+                    ASSERT_EQ(search(IxKeySearch::Get(TYPE_FLOAT, isa), packed_floats, (const char *)&float_target),
+                              ReferenceSearch(packed_floats.data(), begin, n, (const char *)&float_target, TYPE_FLOAT, 4,
+                                              upper));
+                    ASSERT_EQ(search(IxKeySearch::Get(TYPE_STRING, isa), str_keys, str_target),
+                              ReferenceSearch(str_keys.data(), begin, n, str_target, TYPE_STRING, 4, upper));
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief 在不同btree_order大小的INT结点中随机查找, 比较逐个key调用ix_compare的二分查找和特化的查找函数
+ */
+TEST(IxKeySearchTest, SearchBenchmark) {
+    const int lookups = 1 << 20;
+    std::mt19937 rng(0);
+    printf("%-10s %12s %12s %12s %12s\n", "order", "ix_compare", "scalar", "sse2", "avx2");
+    for (int order : {8, 16, 32, 64, 128, 255, 511, 1019}) {
+        std::vector<int> keys(order);
+        for (int i = 0; i < order; i++) {
+            keys[i] = i * 2;
+        }
+        auto packed = PackKeys(keys);
+        std::vector<int> targets(4096);
+        for (auto &target : targets) {
+            target = static_cast<int>(rng() % (order * 2));
+        }
+
+        // 返回每次查找的平均纳秒数, 查找结果累加到checksum中, 防止被优化掉
+        auto measure = [&](const std::function<int(const char *)> &lower_bound, long long *checksum) {
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < lookups; i++) {
+                *checksum += lower_bound((const char *)&targets[i % targets.size()]);
+            }
+            std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+            return elapsed.count() / lookups;
+        };
+        long long expected = 0;
+        double reference_ns = measure(
+            [&](const char *t) { return ReferenceSearch(packed.data(), 0, order, t, TYPE_INT, 4, false); }, &expected);
+        printf("%-10d %10.1fns", order, reference_ns);
+        for (auto isa : all_isas) {
+            const IxKeySearch &kernels = IxKeySearch::Get(TYPE_INT, isa);
+            long long checksum = 0;
+            double ns = measure([&](const char *t) { return kernels.lower_bound(packed.data(), 0, order, t, 4); },
+                                &checksum);
+            EXPECT_EQ(checksum, expected);
+            printf(" %10.1fns", ns);
+        }
+        printf("\n");
+    }
+}
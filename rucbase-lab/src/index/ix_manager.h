@@ -1,7 +1,9 @@
 #pragma once
 
+#include <algorithm>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "ix_defs.h"
 #include "ix_index_handle.h"
@@ -16,17 +18,66 @@ class IxManager {
         : disk_manager_(disk_manager), buffer_pool_manager_(buffer_pool_manager) {}
 
     std::string get_index_name(const std::string &filename, int index_no) {
-        return filename + '.' + std::to_string(index_no) + ".idx";
+        return get_index_name(filename, std::vector<int>{index_no});
+    }
+
+    /**
+     * @brief 多列索引的文件名由各列的序号按索引中的顺序以'_'连接, 单列索引与原来的命名相同
+     */
+    std::string get_index_name(const std::string &filename, const std::vector<int> &index_cols) {
+        std::string ix_name = filename + '.';
+        for (size_t i = 0; i < index_cols.size(); i++) {
+            ix_name += (i > 0 ? "_" : "") + std::to_string(index_cols[i]);
+        }
+        return ix_name + ".idx";
     }
 
     bool exists(const std::string &filename, int index_no) {
-        auto ix_name = get_index_name(filename, index_no);
+        return exists(filename, std::vector<int>{index_no});
+    }
+
+    bool exists(const std::string &filename, const std::vector<int> &index_cols) {
+        auto ix_name = get_index_name(filename, index_cols);
         return disk_manager_->is_file(ix_name);
     }
 
-    void create_index(const std::string &filename, int index_no, ColType col_type, int col_len) {
-        std::string ix_name = get_index_name(filename, index_no);
-        assert(index_no >= 0);
+    /**
+     * @param compress_keys TYPE_STRING的索引是否使用前缀压缩的变长结点格式, 其他类型总是使用定长格式
+     */
+    void create_index(const std::string &filename, int index_no, ColType col_type, int col_len,
+                      bool compress_keys = IX_COMPRESS_STRING_KEYS, bool unique = true) {
+        create_index(filename, std::vector<int>{index_no}, {col_type}, {col_len}, compress_keys, unique);
+    }
+
+    /**
+     * @brief 创建多列索引, key由index_cols中的各列按顺序拼接而成, col_types和col_lens与index_cols一一对应
+     *
+     * @param compress_keys 单列TYPE_STRING的索引是否使用前缀压缩的变长结点格式, 其他索引总是使用定长格式
+     * @param unique 为false时允许多个键值对的key相同, key末尾附加Rid(见IxFileHdr::unique)
+     */
+    void create_index(const std::string &filename, const std::vector<int> &index_cols,
+                      std::vector<ColType> col_types, std::vector<int> col_lens,
+                      bool compress_keys = IX_COMPRESS_STRING_KEYS, bool unique = true) {
+        int num_cols = static_cast<int>(index_cols.size());
+        assert(num_cols > 0 && col_types.size() == index_cols.size() && col_lens.size() == index_cols.size());
+        if (num_cols > IX_MAX_INDEX_COLS) {
+            throw InternalError("IxManager::create_index: too many index columns");
+        }
+        if (!unique) {
+            if (col_types.back() == TYPE_STRING) {
+                col_lens.back() += IX_RID_KEY_LEN;
+            } else {
+                col_types.push_back(TYPE_STRING);
+                col_lens.push_back(IX_RID_KEY_LEN);
+                num_cols++;
+            }
+        }
+        ColType col_type = col_types[0];
+        int col_len = 0;
+        for (int len : col_lens) {
+            col_len += len;
+        }
+        std::string ix_name = get_index_name(filename, index_cols);
         // Create index file
         disk_manager_->create_file(ix_name);
         // Open index file
@@ -58,7 +109,12 @@ class IxManager {
             .keys_size = (btree_order + 1) * col_len,  // 用于IxNodeHandle初始化rids首地址
             .first_leaf = IX_INIT_ROOT_PAGE,
             .last_leaf = IX_INIT_ROOT_PAGE,
+            .compress_keys = compress_keys && num_cols == 1 && col_type == TYPE_STRING,
+            .num_cols = num_cols,
+            .unique = unique,
         };
+        std::copy(col_types.begin(), col_types.end(), fhdr.col_types);
+        std::copy(col_lens.begin(), col_lens.end(), fhdr.col_lens);
         disk_manager_->write_page(fd, IX_FILE_HDR_PAGE, (const char *)&fhdr, sizeof(fhdr));
 
         char page_buf[PAGE_SIZE];  // 在内存中初始化page_buf中的内容，然后将其写入磁盘
@@ -88,6 +144,9 @@ class IxManager {
                 .prev_leaf = IX_LEAF_HEADER_PAGE,
                 .next_leaf = IX_LEAF_HEADER_PAGE,
             };
+            if (fhdr.compress_keys) {
+                IxNodeHandle::Encode(page_buf, {}, {true, ""}, {true, ""});
+            }
             // Must write PAGE_SIZE here in case of future fetch_node()
             disk_manager_->write_page(fd, IX_INIT_ROOT_PAGE, page_buf, PAGE_SIZE);
         }
@@ -99,21 +158,34 @@ class IxManager {
     }
 
     void destroy_index(const std::string &filename, int index_no) {
-        std::string ix_name = get_index_name(filename, index_no);
+        destroy_index(filename, std::vector<int>{index_no});
+    }
+
+    void destroy_index(const std::string &filename, const std::vector<int> &index_cols) {
+        std::string ix_name = get_index_name(filename, index_cols);
         disk_manager_->destroy_file(ix_name);
     }
 
-    // 注意这里打开文件，创建并返回了index file handle的指针
     std::unique_ptr<IxIndexHandle> open_index(const std::string &filename, int index_no) {
-        std::string ix_name = get_index_name(filename, index_no);
+        return open_index(filename, std::vector<int>{index_no});
+    }
+
+    // 注意这里打开文件，创建并返回了index file handle的指针
+    std::unique_ptr<IxIndexHandle> open_index(const std::string &filename, const std::vector<int> &index_cols) {
+        std::string ix_name = get_index_name(filename, index_cols);
         int fd = disk_manager_->open_file(ix_name);
+        buffer_pool_manager_->ResetBufferPoolStats(fd);
         return std::make_unique<IxIndexHandle>(disk_manager_, buffer_pool_manager_, fd);
     }
 
-    void close_index(const IxIndexHandle *ih) {
-        disk_manager_->write_page(ih->fd_, IX_FILE_HDR_PAGE, (const char *)&ih->file_hdr_, sizeof(ih->file_hdr_));
-        // 缓冲区的所有页刷到磁盘，注意这句话必须写在close_file前面
+    void close_index(IxIndexHandle *ih) {
+        ih->UnpinUpperLevels();
+        // 缓冲区的所有页刷到磁盘，注意这句话必须写在close_file和SaveFreePages前面
         buffer_pool_manager_->FlushAllPages(ih->fd_);
+        // 合并掉的结点串成链表保存在页面自身中, 表头记在file header里, 下次打开索引时重新加载
+        IxFileHdr file_hdr = ih->file_hdr_;
+        file_hdr.first_free_page_no = disk_manager_->SaveFreePages(ih->fd_);
+        disk_manager_->write_page(ih->fd_, IX_FILE_HDR_PAGE, (const char *)&file_hdr, sizeof(file_hdr));
         disk_manager_->close_file(ih->fd_);
     }
 };
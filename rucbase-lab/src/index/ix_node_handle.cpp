@@ -1,5 +1,7 @@
 #include "ix_node_handle.h"
 
+#include <algorithm>
+
 /**
  * @brief 在当前node中查找第一个>=target的key_idx
  *
@@ -10,16 +12,11 @@ int IxNodeHandle::lower_bound(const char *target) const {
     // Todo:
     // 查找当前节点中第一个大于等于target的key，并返回key的位置给上层
     // 提示: 可以采用多种查找方式，如顺序遍历、二分查找等；使用ix_compare()函数进行比较
-	int l = 0, r = page_hdr->num_key, mid, flag;
-	while(l < r){ //use binary search
-		mid = (l+r)/2;
-		flag = ix_compare(get_key(mid), target, file_hdr->col_type, file_hdr->col_len);
-		if(flag < 0)
-			l = mid + 1;
-		else
-			r = mid;
-	}
-	return l;
+	if(heap_hdr != nullptr)
+		return CompressedSearch(0, target, false);
+	if(key_search == nullptr)
+		return CompositeSearch(0, target, false);
+	return key_search->lower_bound(keys, 0, page_hdr->num_key, target, file_hdr->col_len);
 }
 
 /**
@@ -32,16 +29,14 @@ int IxNodeHandle::upper_bound(const char *target) const {
     // Todo:
     // 查找当前节点中第一个大于target的key，并返回key的位置给上层
     // 提示: 可以采用多种查找方式：顺序遍历、二分查找等；使用ix_compare()函数进行比较
-	int l = 1, r = page_hdr->num_key, mid, flag;
-	while(l < r){ //use binary search
-		mid = (l+r)/2;
-		flag = ix_compare(get_key(mid), target, file_hdr->col_type, file_hdr->col_len);
-		if(flag > 0)
-			r = mid;
-		else
-			l = mid + 1;
-	}
-	return l;
+	// 结点中没有key时返回1, 与原来的二分查找一致
+	if(page_hdr->num_key <= 1)
+		return 1;
+	if(heap_hdr != nullptr)
+		return CompressedSearch(1, target, true);
+	if(key_search == nullptr)
+		return CompositeSearch(1, target, true);
+	return key_search->upper_bound(keys, 1, page_hdr->num_key, target, file_hdr->col_len);
 }
 
 /**
@@ -59,7 +54,7 @@ bool IxNodeHandle::LeafLookup(const char *key, Rid **value) {
     // 3. 如果存在，获取key对应的Rid，并赋值给传出参数value
     // 提示：可以调用lower_bound()和get_rid()函数。
 	int pos = lower_bound(key);
-	if(ix_compare(get_key(pos), key, file_hdr->col_type, file_hdr->col_len)==0 && pos != GetSize()){
+	if(pos != GetSize() && CompareKey(pos, key)==0){
 		*value = get_rid(pos);
 		return true;
 	}
@@ -103,6 +98,11 @@ void IxNodeHandle::insert_pairs(int pos, const char *key, const Rid *rid, int n)
     // 4. 更新当前节点的键数量
 	//check
 	assert(pos <= GetSize() && pos >= 0);
+	if(heap_hdr != nullptr){ // 压缩格式的key是变长的, 逐个插入
+		for(int i = 0; i < n; ++i)
+			insert_pair(pos + i, key + i * file_hdr->col_len, rid[i]);
+		return;
+	}
 	
 	int num = page_hdr->num_key - pos;
 	int k_len = file_hdr->col_len, r_len = sizeof(Rid); //define len
@@ -122,7 +122,31 @@ void IxNodeHandle::insert_pairs(int pos, const char *key, const Rid *rid, int n)
 /**
  * @brief 用于在结点中的指定位置插入单个键值对
  */
-void IxNodeHandle::insert_pair(int pos, const char *key, const Rid &rid) { insert_pairs(pos, key, &rid, 1); };
+void IxNodeHandle::insert_pair(int pos, const char *key, const Rid &rid) {
+    if (heap_hdr == nullptr) {
+        insert_pairs(pos, key, &rid, 1);
+        return;
+    }
+    assert(pos <= GetSize() && pos >= 0);
+    // key在结点的fence之间, 一定以结点的前缀开头
+    int prefix_len = heap_hdr->prefix_len;
+    assert(memcmp(GetPrefix(), key, prefix_len) == 0);
+    int len = file_hdr->col_len;
+    while (len > prefix_len && key[len - 1] == 0) {
+        len--;
+    }
+    len -= prefix_len;
+    int slots_end = static_cast<int>(sizeof(IxPageHdr) + sizeof(IxKeyHeapHdr) + (GetSize() + 1) * sizeof(IxKeySlot));
+    if (heap_hdr->heap_begin - len < slots_end) {
+        Rebuild(GetEntries(), GetLowFence(), GetHighFence());  // 整理掉删除留下的空间
+        assert(heap_hdr->heap_begin - len >= slots_end);
+    }
+    heap_hdr->heap_begin -= len;
+    memcpy(page->GetData() + heap_hdr->heap_begin, key + prefix_len, len);
+    memmove(slots + pos + 1, slots + pos, (GetSize() - pos) * sizeof(IxKeySlot));
+    slots[pos] = {heap_hdr->heap_begin, static_cast<uint16_t>(len), rid};
+    page_hdr->num_key++;
+}
 
 /**
  * @brief 用于在结点中插入单个键值对。
@@ -138,9 +162,8 @@ int IxNodeHandle::Insert(const char *key, const Rid &value) {
     // 3. 如果key不重复则插入键值对
     // 4. 返回完成插入操作之后的键值对数量
 	int pos = lower_bound(key);
-	int flag = ix_compare(get_key(pos), key, file_hdr->col_type, file_hdr->col_len);
 	
-	if(pos == GetSize() || flag >0)
+	if(pos == GetSize() || CompareKey(pos, key) >0)
 		insert_pair(pos, key, value);
     return GetSize(); // new size
 }
@@ -156,6 +179,12 @@ void IxNodeHandle::erase_pair(int pos) {
     // 2. 删除该位置的rid
     // 3. 更新结点的键值对数量
 	assert(pos < GetSize() && pos >=0); // check
+	if(heap_hdr != nullptr){ // key留在key堆中, 下次整理时去掉
+		heap_hdr->heap_garbage += slots[pos].len;
+		memmove(slots + pos, slots + pos + 1, (GetSize() - pos - 1) * sizeof(IxKeySlot));
+		page_hdr->num_key -= 1;
+		return;
+	}
 
 	int num = GetSize() - pos -1;
 	int k_len = file_hdr->col_len, r_len = sizeof(Rid);
@@ -179,9 +208,8 @@ int IxNodeHandle::Remove(const char *key) {
     // 2. 如果要删除的键值对存在，删除键值对
     // 3. 返回完成删除操作后的键值对数量
 	int pos = lower_bound(key);
-	int flag = ix_compare(get_key(pos), key, file_hdr->col_type, file_hdr->col_len);
 
-	if(pos != GetSize() && flag == 0)
+	if(pos != GetSize() && CompareKey(pos, key) == 0)
 		erase_pair(pos);
     return GetSize(); //return newsize
 }
@@ -215,3 +243,293 @@ page_id_t IxNodeHandle::RemoveAndReturnOnlyChild() {
     assert(GetSize() == 0);
     return child_page_no;
 }
+
+void IxNodeHandle::GetKey(int key_idx, char *key) const {
+    if (heap_hdr == nullptr) {
+        memcpy(key, get_key(key_idx), file_hdr->col_len);
+        return;
+    }
+    int prefix_len = heap_hdr->prefix_len;
+    const IxKeySlot &slot = slots[key_idx];
+    memcpy(key, GetPrefix(), prefix_len);
+    memcpy(key + prefix_len, page->GetData() + slot.offset, slot.len);
+    memset(key + prefix_len + slot.len, 0, file_hdr->col_len - prefix_len - slot.len);
+}
+
+int IxNodeHandle::CompareKey(int key_idx, const char *key) const {
+    if (heap_hdr == nullptr) {
+        return ix_compare(get_key(key_idx), key, *file_hdr);
+    }
+    int cmp = memcmp(GetPrefix(), key, heap_hdr->prefix_len);
+    return cmp != 0 ? cmp : CompareSuffix(key_idx, key);
+}
+
+void IxNodeHandle::GetLowKey(char *key) const {
+    if (heap_hdr == nullptr) {
+        memcpy(key, get_key(0), file_hdr->col_len);
+        return;
+    }
+    memcpy(key, page->GetData() + heap_hdr->low_offset, heap_hdr->low_len);
+    memset(key + heap_hdr->low_len, 0, file_hdr->col_len - heap_hdr->low_len);
+}
+
+bool IxNodeHandle::IsOverfull() const {
+    if (heap_hdr == nullptr) {
+        return page_hdr->num_key >= file_hdr->btree_order + 1;
+    }
+    return GetUsedBytes() > GetCapacity(file_hdr);
+}
+
+bool IxNodeHandle::IsUnderfull() const {
+    if (heap_hdr == nullptr) {
+        return page_hdr->num_key < (file_hdr->btree_order + 1) / 2;
+    }
+    return GetUsedBytes() < GetCapacity(file_hdr) / 3;
+}
+
+bool IxNodeHandle::IsSafeToInsert() const {
+    if (heap_hdr == nullptr) {
+        return page_hdr->num_key + 1 < file_hdr->btree_order + 1;
+    }
+    return GetUsedBytes() + static_cast<int>(sizeof(IxKeySlot)) + file_hdr->col_len <= GetCapacity(file_hdr);
+}
+
+bool IxNodeHandle::IsSafeToDelete() const {
+    if (heap_hdr == nullptr) {
+        return page_hdr->num_key > (file_hdr->btree_order + 1) / 2;
+    }
+    return GetUsedBytes() - static_cast<int>(sizeof(IxKeySlot)) - file_hdr->col_len >= GetCapacity(file_hdr) / 3;
+}
+
+void IxNodeHandle::MoveHalfTo(IxNodeHandle *recipient) {
+    if (heap_hdr == nullptr) {
+        int pos = GetSize() / 2;
+        recipient->insert_pairs(0, get_key(pos), get_rid(pos), GetSize() - pos);
+        SetSize(pos);
+        return;
+    }
+    std::vector<IxEntry> entries = GetEntries();
+    int n = static_cast<int>(entries.size());
+    assert(n >= 2);
+    // prefix_bytes[i]为前i个键值对的key和slot占用的字节数
+    std::vector<int> prefix_bytes(n + 1, 0);
+    for (int i = 0; i < n; i++) {
+        prefix_bytes[i + 1] = prefix_bytes[i] + static_cast<int>(sizeof(IxKeySlot) + entries[i].key.size());
+    }
+    // 分到左边的字节数在总数的40%~60%之间时, 选分隔key最短的位置, 使父结点中的key尽量短
+    auto separator = [&](int pos) {
+        return IsLeafPage() ? ShortestSeparator(entries[pos - 1].key, entries[pos].key) : entries[pos].key;
+    };
+    int total = prefix_bytes[n];
+    int best = static_cast<int>(std::lower_bound(prefix_bytes.begin() + 1, prefix_bytes.end() - 1, total / 2) -
+                                prefix_bytes.begin());
+    best = std::clamp(best, 1, n - 1);
+    std::string best_sep = separator(best);
+    for (int pos = 1; pos < n; pos++) {
+        if (prefix_bytes[pos] * 10 < total * 4 || prefix_bytes[pos] * 10 > total * 6) {
+            continue;
+        }
+        std::string sep = separator(pos);
+        if (sep.size() < best_sep.size()) {
+            best = pos;
+            best_sep = std::move(sep);
+        }
+    }
+    // 内部结点的第一个key就是其下界, 分隔key原本就是右结点的第一个key
+    std::vector<IxEntry> right(entries.begin() + best, entries.end());
+    entries.resize(best);
+    IxFence separator_fence = {false, best_sep};
+    recipient->Rebuild(right, separator_fence, GetHighFence());
+    Rebuild(entries, GetLowFence(), separator_fence);
+}
+
+bool IxNodeHandle::CanMergeInto(const IxNodeHandle *left) const {
+    if (heap_hdr == nullptr) {
+        return page_hdr->num_key + left->page_hdr->num_key < (file_hdr->btree_order + 1) / 2 * 2;
+    }
+    std::vector<IxEntry> entries = left->GetEntries();
+    std::vector<IxEntry> right = GetEntries();
+    entries.insert(entries.end(), right.begin(), right.end());
+    return GetEncodedSize(entries, left->GetLowFence(), GetHighFence()) <= GetCapacity(file_hdr);
+}
+
+void IxNodeHandle::MoveAllTo(IxNodeHandle *left) {
+    if (heap_hdr == nullptr) {
+        left->insert_pairs(left->GetSize(), get_key(0), get_rid(0), GetSize());
+        SetSize(0);
+        return;
+    }
+    // 内部结点的第一个key等于其下界, 也就是父结点中分隔两个结点的key
+    std::vector<IxEntry> entries = left->GetEntries();
+    std::vector<IxEntry> right = GetEntries();
+    entries.insert(entries.end(), right.begin(), right.end());
+    left->Rebuild(entries, left->GetLowFence(), GetHighFence());
+    SetSize(0);
+}
+
+void IxNodeHandle::InitKeyHeap() {
+    Rebuild({}, {true, ""}, {true, ""});
+}
+
+std::vector<IxEntry> IxNodeHandle::GetEntries() const {
+    std::vector<IxEntry> entries(GetSize());
+    std::string prefix(GetPrefix(), heap_hdr->prefix_len);
+    for (int i = 0; i < GetSize(); i++) {
+        const IxKeySlot &slot = slots[i];
+        if (slot.len > 0) {
+            entries[i].key = prefix + std::string(page->GetData() + slot.offset, slot.len);
+        } else {
+            entries[i].key = TrimKey(prefix.data(), heap_hdr->prefix_len);  // 前缀本身可能以0结尾
+        }
+        entries[i].rid = slot.rid;
+    }
+    return entries;
+}
+
+IxFence IxNodeHandle::GetLowFence() const {
+    return {heap_hdr->low_inf, std::string(page->GetData() + heap_hdr->low_offset, heap_hdr->low_len)};
+}
+
+IxFence IxNodeHandle::GetHighFence() const {
+    return {heap_hdr->high_inf, std::string(page->GetData() + heap_hdr->high_offset, heap_hdr->high_len)};
+}
+
+void IxNodeHandle::Rebuild(const std::vector<IxEntry> &entries, const IxFence &low, const IxFence &high) {
+    Encode(page->GetData(), entries, low, high);
+}
+
+int IxNodeHandle::GetUsedBytes() const {
+    return static_cast<int>(sizeof(IxPageHdr) + sizeof(IxKeyHeapHdr) + GetSize() * sizeof(IxKeySlot)) +
+           (PAGE_SIZE - heap_hdr->heap_begin - heap_hdr->heap_garbage);
+}
+
+int IxNodeHandle::GetEncodedSize(const std::vector<IxEntry> &entries, const IxFence &low, const IxFence &high) {
+    int prefix_len = GetPrefixLen(low, high);
+    int size = static_cast<int>(sizeof(IxPageHdr) + sizeof(IxKeyHeapHdr) + low.key.size() + high.key.size());
+    for (auto &entry : entries) {
+        size += static_cast<int>(sizeof(IxKeySlot)) + std::max(static_cast<int>(entry.key.size()) - prefix_len, 0);
+    }
+    return size;
+}
+
+void IxNodeHandle::Encode(char *data, const std::vector<IxEntry> &entries, const IxFence &low, const IxFence &high) {
+    auto page_hdr = reinterpret_cast<IxPageHdr *>(data);
+    auto heap_hdr = reinterpret_cast<IxKeyHeapHdr *>(data + sizeof(IxPageHdr));
+    auto slots = reinterpret_cast<IxKeySlot *>(heap_hdr + 1);
+    int heap_begin = PAGE_SIZE;
+    // 把str从第from个字节开始的部分放入key堆, 返回其位置
+    auto put = [&](const std::string &str, int from) {
+        int len = std::max(static_cast<int>(str.size()) - from, 0);
+        heap_begin -= len;
+        memcpy(data + heap_begin, str.data() + from, len);
+        return static_cast<uint16_t>(heap_begin);
+    };
+    heap_hdr->low_inf = low.inf;
+    heap_hdr->low_len = static_cast<uint16_t>(low.key.size());
+    heap_hdr->low_offset = put(low.key, 0);
+    heap_hdr->high_inf = high.inf;
+    heap_hdr->high_len = static_cast<uint16_t>(high.key.size());
+    heap_hdr->high_offset = put(high.key, 0);
+    int prefix_len = GetPrefixLen(low, high);
+    heap_hdr->prefix_len = static_cast<uint16_t>(prefix_len);
+    for (size_t i = 0; i < entries.size(); i++) {
+        slots[i].offset = put(entries[i].key, prefix_len);
+        slots[i].len = static_cast<uint16_t>(std::max(static_cast<int>(entries[i].key.size()) - prefix_len, 0));
+        slots[i].rid = entries[i].rid;
+    }
+    assert(reinterpret_cast<char *>(slots + entries.size()) <= data + heap_begin);
+    heap_hdr->heap_begin = static_cast<uint16_t>(heap_begin);
+    heap_hdr->heap_garbage = 0;
+    page_hdr->num_key = static_cast<int>(entries.size());
+}
+
+std::string IxNodeHandle::ShortestSeparator(const std::string &left, const std::string &right) {
+    assert(left < right);
+    // left < right且两者都去掉了末尾的0, 因此第一个不同的字节在right的范围内且不为0
+    size_t i = 0;
+    while (i < left.size() && left[i] == right[i]) {
+        i++;
+    }
+    return right.substr(0, i + 1);
+}
+
+std::string IxNodeHandle::TrimKey(const char *key, int col_len) {
+    while (col_len > 0 && key[col_len - 1] == 0) {
+        col_len--;
+    }
+    return std::string(key, col_len);
+}
+
+/**
+ * @brief 上下界的公共前缀长度, 有一端是无穷时没有公共前缀
+ * @note 只在两个fence都有的字节中比较, 得到的可能比实际的公共前缀短, 但一定是结点中所有key的公共前缀
+ */
+int IxNodeHandle::GetPrefixLen(const IxFence &low, const IxFence &high) {
+    if (low.inf || high.inf) {
+        return 0;
+    }
+    size_t len = std::min(low.key.size(), high.key.size());
+    size_t i = 0;
+    while (i < len && low.key[i] == high.key[i]) {
+        i++;
+    }
+    return static_cast<int>(i);
+}
+
+/**
+ * @brief 比较第key_idx个key去掉前缀后的部分与key的对应部分, key以结点的前缀开头
+ */
+int IxNodeHandle::CompareSuffix(int key_idx, const char *key) const {
+    int prefix_len = heap_hdr->prefix_len;
+    const IxKeySlot &slot = slots[key_idx];
+    int cmp = memcmp(page->GetData() + slot.offset, key + prefix_len, slot.len);
+    if (cmp != 0) {
+        return cmp;
+    }
+    // 结点中的key之后都是0
+    for (int i = prefix_len + slot.len; i < file_hdr->col_len; i++) {
+        if (key[i] != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 压缩格式的lower_bound/upper_bound: 先比较一次前缀, 前缀不同时target在所有key之前或之后,
+ * 否则只用key去掉前缀后的部分二分查找
+ */
+int IxNodeHandle::CompressedSearch(int begin, const char *target, bool upper) const {
+    int l = begin, r = GetSize();
+    int cmp = memcmp(GetPrefix(), target, heap_hdr->prefix_len);
+    if (cmp != 0) {
+        return cmp > 0 ? l : r;
+    }
+    while (l < r) {
+        int mid = (l + r) / 2;
+        int c = CompareSuffix(mid, target);
+        if (upper ? c <= 0 : c < 0) {
+            l = mid + 1;
+        } else {
+            r = mid;
+        }
+    }
+    return l;
+}
+
+/**
+ * @brief 多列索引的结点内查找: 用ix_compare按key schema逐列比较的二分查找
+ */
+int IxNodeHandle::CompositeSearch(int begin, const char *target, bool upper) const {
+    int l = begin, r = GetSize();
+    while (l < r) {
+        int mid = (l + r) / 2;
+        int cmp = ix_compare(get_key(mid), target, *file_hdr);
+        if (upper ? cmp <= 0 : cmp < 0) {
+            l = mid + 1;
+        } else {
+            r = mid;
+        }
+    }
+    return l;
+}
@@ -1,5 +1,9 @@
 #pragma once
+#include <string>
+#include <vector>
+
 #include "ix_defs.h"
+#include "ix_key_search.h"
 
 static const bool binary_search = true;  // 控制在lower_bound/uppper_bound函数中是否使用二分查找
 
@@ -25,6 +29,37 @@ inline int ix_compare(const char *a, const char *b, ColType type, int col_len) {
     }
 }
 
+/**
+ * @brief 按索引的key schema比较两个key: 多列索引从第一列开始逐列比较, 第一个不相等的列决定结果
+ */
+inline int ix_compare(const char *a, const char *b, const IxFileHdr &file_hdr) {
+    int offset = 0;
+    for (int i = 0; i < file_hdr.num_cols; i++) {
+        int cmp = ix_compare(a + offset, b + offset, file_hdr.col_types[i], file_hdr.col_lens[i]);
+        if (cmp != 0) {
+            return cmp;
+        }
+        offset += file_hdr.col_lens[i];
+    }
+    return 0;
+}
+
+/**
+ * @brief 压缩格式结点中解出来的键值对, key是完整的key去掉末尾的0
+ */
+struct IxEntry {
+    std::string key;
+    Rid rid;
+};
+
+/**
+ * @brief 压缩格式结点的上界或下界, inf表示负无穷(下界)或正无穷(上界)
+ */
+struct IxFence {
+    bool inf;
+    std::string key;
+};
+
 /**
  * @brief 树中的结点
  * 记录了root page，max size等；以及实现结点内部的查找/插入/删除操作
@@ -44,12 +79,24 @@ class IxNodeHandle {
     char *keys;
     /** page->data的第三部分，指针指向首地址，每个rid的长度为sizeof(Rid) */
     Rid *rids;
+    /** 按file_hdr->col_type特化的结点内查找函数，由IxIndexHandle选择; 多列索引为nullptr, 用ix_compare逐列比较 */
+    const IxKeySearch *key_search;
+    /** 压缩格式(file_hdr->compress_keys)时代替keys和rids: IxPageHdr之后的头部和按key排序的slot数组 */
+    IxKeyHeapHdr *heap_hdr = nullptr;
+    IxKeySlot *slots = nullptr;
 
    public:
-    IxNodeHandle(const IxFileHdr *file_hdr_, Page *page_) : file_hdr(file_hdr_), page(page_) {
+    IxNodeHandle(const IxFileHdr *file_hdr_, Page *page_, const IxKeySearch *key_search_)
+        : file_hdr(file_hdr_), page(page_), key_search(key_search_) {
         page_hdr = reinterpret_cast<IxPageHdr *>(page->GetData());
         keys = page->GetData() + sizeof(IxPageHdr);
         rids = reinterpret_cast<Rid *>(keys + file_hdr->keys_size);
+        if (file_hdr->compress_keys) {
+            heap_hdr = reinterpret_cast<IxKeyHeapHdr *>(keys);
+            slots = reinterpret_cast<IxKeySlot *>(heap_hdr + 1);
+            keys = nullptr;
+            rids = nullptr;
+        }
     }
 
     IxNodeHandle() = default;
@@ -109,16 +156,62 @@ class IxNodeHandle {
      */
     int find_child(IxNodeHandle *child);
 
+    /**
+     * @brief 把第key_idx个key完整地(col_len字节)复制到key中, 两种格式都可以使用
+     */
+    void GetKey(int key_idx, char *key) const;
+
+    /**
+     * @brief 比较第key_idx个key与key, 结果与ix_compare一致, 两种格式都可以使用
+     */
+    int CompareKey(int key_idx, const char *key) const;
+
+    /**
+     * @brief 结点在父结点中对应的key: 原格式为第一个key, 压缩格式为下界fence(负无穷时为全0)
+     */
+    void GetLowKey(char *key) const;
+
+    /** 需要分裂: 原格式为键值对数量达到GetMaxSize(), 压缩格式为占用的字节数超过GetCapacity() */
+    bool IsOverfull() const;
+
+    /** 需要合并或重分配: 原格式为少于GetMinSize()个键值对, 压缩格式为占用的字节数少于GetCapacity()的1/3 */
+    bool IsUnderfull() const;
+
+    /** 再插入任意一个键值对也不会分裂 */
+    bool IsSafeToInsert() const;
+
+    /** 再删除任意一个键值对也不需要合并或重分配 */
+    bool IsSafeToDelete() const;
+
+    /**
+     * @brief 分裂时把右半部分的键值对移到空结点recipient中
+     * 压缩格式按字节数平分, 并在中间附近选择最短的分隔key; 两个结点以分隔key为界重新设置fence
+     */
+    void MoveHalfTo(IxNodeHandle *recipient);
+
+    /**
+     * @brief 本结点(右)与左兄弟left合并后能否放进一个结点
+     */
+    bool CanMergeInto(const IxNodeHandle *left) const;
+
+    /**
+     * @brief 合并时把本结点(右)的所有键值对移到左兄弟left的末尾, 压缩格式的left上界改为本结点的上界
+     */
+    void MoveAllTo(IxNodeHandle *left);
+
     /** 以下为已经实现了的辅助函数 **/
-    char *get_key(int key_idx) const { return keys + key_idx * file_hdr->col_len; }
+    char *get_key(int key_idx) const {
+        assert(!file_hdr->compress_keys);  // 压缩格式的key不是定长存放的, 使用GetKey/CompareKey
+        return keys + key_idx * file_hdr->col_len;
+    }
 
-    Rid *get_rid(int rid_idx) const { return &rids[rid_idx]; }
+    Rid *get_rid(int rid_idx) const { return slots != nullptr ? &slots[rid_idx].rid : &rids[rid_idx]; }
 
-    void set_key(int key_idx, const char *key) { memcpy(keys + key_idx * file_hdr->col_len, key, file_hdr->col_len); }
+    void set_key(int key_idx, const char *key) { memcpy(get_key(key_idx), key, file_hdr->col_len); }
 
-    void set_rid(int rid_idx, const Rid &rid) { rids[rid_idx] = rid; }
+    void set_rid(int rid_idx, const Rid &rid) { *get_rid(rid_idx) = rid; }
 
-    int GetSize() { return page_hdr->num_key; }
+    int GetSize() const { return page_hdr->num_key; }
 
     void SetSize(int size) { page_hdr->num_key = size; }
 
@@ -143,7 +236,7 @@ class IxNodeHandle {
 
     page_id_t GetParentPageNo() { return page_hdr->parent; }
 
-    bool IsLeafPage() { return page_hdr->is_leaf; }
+    bool IsLeafPage() const { return page_hdr->is_leaf; }
 
     bool IsRootPage() { return GetParentPageNo() == INVALID_PAGE_ID; }
 
@@ -159,4 +252,60 @@ class IxNodeHandle {
      * @return the last child
      */
     page_id_t RemoveAndReturnOnlyChild();
+
+    /** 以下只用于压缩格式 **/
+    /**
+     * @brief 初始化为不含键值对, key范围为(负无穷, 正无穷)的结点
+     */
+    void InitKeyHeap();
+
+    /** @return 压缩格式结点中的所有键值对 */
+    std::vector<IxEntry> GetEntries() const;
+
+    IxFence GetLowFence() const;
+
+    IxFence GetHighFence() const;
+
+    /**
+     * @brief 按给定的键值对和fence重新编码整个结点, 同时整理掉key堆中删除留下的空间
+     */
+    void Rebuild(const std::vector<IxEntry> &entries, const IxFence &low, const IxFence &high);
+
+    /** @return 结点占用的字节数, 不含key堆中删除留下的空间 */
+    int GetUsedBytes() const;
+
+    /**
+     * @brief 压缩格式结点占用的字节数上限, 留出一个最长的键值对的空间, 使超过上限的结点仍能放进页面
+     */
+    static int GetCapacity(const IxFileHdr *file_hdr) {
+        return PAGE_SIZE - static_cast<int>(sizeof(IxKeySlot)) - file_hdr->col_len;
+    }
+
+    /** @return 按entries和fence编码之后占用的字节数 */
+    static int GetEncodedSize(const std::vector<IxEntry> &entries, const IxFence &low, const IxFence &high);
+
+    /**
+     * @brief 把entries和fence编码到页面data中IxPageHdr之后的部分, 并设置IxPageHdr::num_key
+     */
+    static void Encode(char *data, const std::vector<IxEntry> &entries, const IxFence &low, const IxFence &high);
+
+    /**
+     * @brief 叶子分裂时推到父结点的分隔key: 大于left且不大于right的最短的key, 即right在与left第一个不同的字节处截断
+     */
+    static std::string ShortestSeparator(const std::string &left, const std::string &right);
+
+    /** @return 去掉末尾的0之后的key */
+    static std::string TrimKey(const char *key, int col_len);
+
+    /** @return 以low和high为fence的结点的公共前缀长度 */
+    static int GetPrefixLen(const IxFence &low, const IxFence &high);
+
+   private:
+    const char *GetPrefix() const { return page->GetData() + heap_hdr->low_offset; }
+
+    int CompareSuffix(int key_idx, const char *key) const;
+
+    int CompressedSearch(int begin, const char *target, bool upper) const;
+
+    int CompositeSearch(int begin, const char *target, bool upper) const;
 };
\ No newline at end of file
@@ -1,22 +1,135 @@
 #include "ix_scan.h"
 
+#include <algorithm>
+#include <cstring>
+
+IxScan::IxScan(const IxIndexHandle *ih, const Iid &lower, const Iid &upper, BufferPoolManager *bpm,
+               int prefetch_window, bool load_keys)
+    : ih_(ih), iid_(lower), end_(upper), bpm_(bpm), prefetch_window_(prefetch_window), load_keys_(load_keys) {
+    if (!is_end()) {
+        load_batch();
+    }
+}
+
 /**
- * @brief 找到leaf page的下一个slot_no
+ * @brief 找到leaf page的下一个slot_no, 当前批用完时进入下一个叶子
  */
 void IxScan::next() {
     assert(!is_end());
-    IxNodeHandle *node = ih_->FetchNode(iid_.page_no);
-    assert(node->IsLeafPage());
-    assert(iid_.slot_no < node->GetSize());
     // increment slot no
     iid_.slot_no++;
-    if (iid_.page_no != ih_->file_hdr_.last_leaf && iid_.slot_no == node->GetSize()) {
+    bool next_leaf = next_leaf_ != IX_LEAF_HEADER_PAGE &&
+                     iid_.slot_no == batch_begin_ + static_cast<int>(batch_rids_.size()) && iid_ != end_;
+    if (next_leaf) {
         // go to next leaf
         iid_.slot_no = 0;
-        iid_.page_no = node->GetNextLeaf();
+        iid_.page_no = next_leaf_;
+        if (!is_end()) {
+            load_batch();
+            read_ahead();
+        }
+    }
+}
+
+/**
+ * @brief 对当前叶子加读锁, 复制从iid_.slot_no开始到扫描终点或叶子末尾的键值对, 同时记下下一个叶子和父结点
+ */
+void IxScan::load_batch() {
+    IxNodeHandle *node = ih_->FetchNode(iid_.page_no);
+    node->page->RLatch();
+    assert(node->IsLeafPage());
+    int end = iid_.page_no == end_.page_no ? std::min(end_.slot_no, node->GetSize()) : node->GetSize();
+    batch_begin_ = iid_.slot_no;
+    batch_rids_.clear();
+    for (int i = batch_begin_; i < end; i++) {
+        batch_rids_.push_back(*node->get_rid(i));
+    }
+    if (load_keys_) {
+        int col_len = ih_->file_hdr_.col_len;
+        batch_keys_.resize(batch_rids_.size() * col_len);
+        for (int i = batch_begin_; i < end; i++) {
+            node->GetKey(i, batch_keys_.data() + (i - batch_begin_) * col_len);
+        }
+    }
+    next_leaf_ = node->GetNextLeaf();
+    parent_ = node->GetParentPageNo();
+    node->page->RUnlatch();
+    bpm_->UnpinPage(node->GetPageId(), false);
+    delete node;
+    if (batch_rids_.empty() && !is_end()) {
+        throw IndexEntryNotFoundError();  // 并发的删除使扫描位置超出了叶子
     }
 }
 
-Rid IxScan::rid() const {
-    return ih_->get_rid(iid_);
+Rid IxScan::entry(char *key) const {
+    assert(load_keys_);
+    int col_len = ih_->file_hdr_.col_len;
+    memcpy(key, batch_keys_.data() + (iid_.slot_no - batch_begin_) * col_len, col_len);
+    return rid();
+}
+
+/**
+ * @brief 叶子链表预读: 扫描每进入一个新叶子时调用
+ * 后续叶子的page_no只能从父结点中得到: 已发出预读的叶子不足半个窗口时, 从父结点中取出排在最后一个已预读叶子
+ * 之后的兄弟叶子, 补足到prefetch_window_个. 跨越父结点的边界时只预读叶子链表中的下一个叶子,
+ * 等扫描进入下一个父结点的叶子后再继续按窗口预读
+ */
+void IxScan::read_ahead() {
+    if (prefetch_window_ <= 0) {
+        return;
+    }
+    if (!readahead_.empty() && readahead_.front() == iid_.page_no) {
+        readahead_.pop_front();
+    } else {
+        readahead_.clear();  // 叶子链表与预测的顺序不一致, 重新开始
+    }
+    if (static_cast<int>(readahead_.size()) > prefetch_window_ / 2) {
+        return;
+    }
+    page_id_t last = readahead_.empty() ? iid_.page_no : readahead_.back();
+    if (last == end_.page_no) {
+        return;
+    }
+    std::vector<page_id_t> page_nos;
+    read_siblings(last, &page_nos);
+    // 预读的叶子已经到了父结点的末尾: 至少预读叶子链表中的下一个叶子, 它可能属于下一个父结点
+    if (readahead_.empty() && next_leaf_ != IX_LEAF_HEADER_PAGE) {
+        readahead_.push_back(next_leaf_);
+        page_nos.push_back(next_leaf_);
+    }
+    if (!page_nos.empty()) {
+        bpm_->PrefetchPages(ih_->fd_, page_nos);
+    }
+}
+
+/**
+ * @brief 从load_batch记下的父结点中取出排在last之后的兄弟叶子, 加入readahead_和page_nos
+ * 父结点在load_batch之后可能已被并发的分裂或合并修改, 甚至被回收、复用或被VACUUM截断; 因此先确认页面仍在文件中,
+ * 加读锁后确认它仍是包含last的内部结点, 否则不从父结点预读
+ */
+void IxScan::read_siblings(page_id_t last, std::vector<page_id_t> *page_nos) {
+    if (parent_ == IX_NO_PAGE || parent_ >= ih_->disk_manager_->get_fd2pageno(ih_->fd_) ||
+        ih_->disk_manager_->IsFreePage(ih_->fd_, parent_)) {
+        return;
+    }
+    IxNodeHandle *parent = ih_->FetchNode(parent_);
+    parent->page->RLatch();
+    if (!parent->IsLeafPage()) {
+        int size = parent->GetSize();
+        int child_idx = 0;
+        while (child_idx < size && parent->ValueAt(child_idx) != last) {
+            child_idx++;
+        }
+        for (child_idx++; child_idx < size && static_cast<int>(readahead_.size()) < prefetch_window_; child_idx++) {
+            page_id_t page_no = parent->ValueAt(child_idx);
+            readahead_.push_back(page_no);
+            page_nos->push_back(page_no);
+            if (page_no == end_.page_no) {
+                break;
+            }
+        }
+    }
+    parent->page->RUnlatch();
+    bpm_->UnpinPage(parent->GetPageId(), false);
+    delete parent;
 }
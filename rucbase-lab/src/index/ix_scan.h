@@ -1,26 +1,52 @@
 #pragma once
 
+#include <deque>
+#include <vector>
+
 #include "ix_defs.h"
 #include "ix_index_handle.h"
 
 /**
  * @brief 用于直接遍历叶子结点，而不用FindLeafPage()来得到叶子结点
+ * 每进入一个叶子只fetch并加锁一次, 把扫描范围内的键值对成批复制出来, 之后在批内移动不再访问缓冲池
  */
 class IxScan : public RecScan {
     const IxIndexHandle *ih_;
     Iid iid_;  // 初始为lower（用于遍历的指针）
     Iid end_;  // 初始为upper
     BufferPoolManager *bpm_;
+    int prefetch_window_;               // 叶子预读窗口的页面数, 0表示不预读
+    std::deque<page_id_t> readahead_;  // 已经发出预读的后续叶子, 按叶子链表顺序排列
+    bool load_keys_;                    // 是否同时复制key, 只有需要entry()时才复制
+
+    // 当前叶子中从batch_begin_开始复制出来的一批键值对
+    int batch_begin_ = 0;
+    std::vector<Rid> batch_rids_;
+    std::vector<char> batch_keys_;  // 每个key为file_hdr_.col_len字节
+    page_id_t next_leaf_ = IX_NO_PAGE;
+    page_id_t parent_ = IX_NO_PAGE;
 
    public:
-    IxScan(const IxIndexHandle *ih, const Iid &lower, const Iid &upper, BufferPoolManager *bpm)
-        : ih_(ih), iid_(lower), end_(upper), bpm_(bpm) {}
+    IxScan(const IxIndexHandle *ih, const Iid &lower, const Iid &upper, BufferPoolManager *bpm,
+           int prefetch_window = PREFETCH_WINDOW, bool load_keys = false);
 
     void next() override;
 
     bool is_end() const override { return iid_ == end_; }
 
-    Rid rid() const override;
+    Rid rid() const override { return batch_rids_[iid_.slot_no - batch_begin_]; }
+
+    /**
+     * @brief 当前位置的key(含非唯一索引附加的rid)复制到key中, 返回rid; 需要以load_keys构造
+     */
+    Rid entry(char *key) const;
 
     const Iid &iid() const { return iid_; }
+
+   private:
+    void load_batch();
+
+    void read_ahead();
+
+    void read_siblings(page_id_t last, std::vector<page_id_t> *page_nos);
 };
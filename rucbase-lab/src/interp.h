@@ -14,12 +14,15 @@ const char *help_info = "Supported SQL syntax:\n"
                    "command:\n"
                    "  CREATE TABLE table_name (column_name type [, column_name type ...])\n"
                    "  DROP TABLE table_name\n"
-                   "  CREATE INDEX table_name (column_name)\n"
-                   "  DROP INDEX table_name (column_name)\n"
+                   "  CREATE INDEX table_name (column_name [, column_name ...])\n"
+                   "  DROP INDEX table_name (column_name [, column_name ...])\n"
+                   "  VACUUM table_name\n"
+                   "  SHOW BUFFER STATS\n"
+                   "  SHOW INDEX STATS\n"
                    "  INSERT INTO table_name VALUES (value [, value ...])\n"
                    "  DELETE FROM table_name [WHERE where_clause]\n"
                    "  UPDATE table_name SET column_name = value [, column_name = value ...] [WHERE where_clause]\n"
-                   "  SELECT selector FROM table_name [WHERE where_clause]\n"
+                   "  SELECT selector FROM table_name [WHERE where_clause] [ORDER BY order_column [, order_column ...]]\n"
                    "type:\n"
                    "  {INT | FLOAT | CHAR(n)}\n"
                    "where_clause:\n"
@@ -30,6 +33,8 @@ const char *help_info = "Supported SQL syntax:\n"
                    "  [table_name.]column_name\n"
                    "op:\n"
                    "  {= | <> | < | > | <= | >=}\n"
+                   "order_column:\n"
+                   "  column [ASC | DESC]\n"
                    "selector:\n"
                    "  {* | column [, column ...]}\n";
 
@@ -64,6 +69,18 @@ class Interp {
             sm_manager_->show_tables(context);
             if(context->txn_->GetTxnMode() == false)
                 txn_mgr_->Commit(context->txn_, context->log_mgr_);
+        } else if (auto x = std::dynamic_pointer_cast<ast::ShowBufferStats>(root)) {
+            // show buffer stats;
+            SetTransaction(txn_id, context);
+            sm_manager_->show_buffer_stats(context);
+            if(context->txn_->GetTxnMode() == false)
+                txn_mgr_->Commit(context->txn_, context->log_mgr_);
+        } else if (auto x = std::dynamic_pointer_cast<ast::ShowIndexStats>(root)) {
+            // show index stats;
+            SetTransaction(txn_id, context);
+            sm_manager_->show_index_stats(context);
+            if(context->txn_->GetTxnMode() == false)
+                txn_mgr_->Commit(context->txn_, context->log_mgr_);
         } else if (auto x = std::dynamic_pointer_cast<ast::DescTable>(root)) {
             // desc table;
             SetTransaction(txn_id, context);
@@ -96,13 +113,19 @@ class Interp {
         } else if (auto x = std::dynamic_pointer_cast<ast::CreateIndex>(root)) {
             // create index;
             SetTransaction(txn_id, context);
-            sm_manager_->create_index(x->tab_name, x->col_name, context);
+            sm_manager_->create_index(x->tab_name, x->col_names, context);
             if(context->txn_->GetTxnMode() == false)
                 txn_mgr_->Commit(context->txn_, context->log_mgr_);
         } else if (auto x = std::dynamic_pointer_cast<ast::DropIndex>(root)) {
             // drop index
             SetTransaction(txn_id, context);
-            sm_manager_->drop_index(x->tab_name, x->col_name, context);
+            sm_manager_->drop_index(x->tab_name, x->col_names, context);
+            if(context->txn_->GetTxnMode() == false)
+                txn_mgr_->Commit(context->txn_, context->log_mgr_);
+        } else if (auto x = std::dynamic_pointer_cast<ast::VacuumTable>(root)) {
+            // vacuum table
+            SetTransaction(txn_id, context);
+            sm_manager_->vacuum_table(x->tab_name, context);
             if(context->txn_->GetTxnMode() == false)
                 txn_mgr_->Commit(context->txn_, context->log_mgr_);
         } else if (auto x = std::dynamic_pointer_cast<ast::InsertStmt>(root)) {
@@ -143,8 +166,13 @@ class Interp {
                 TabCol sel_col = {.tab_name = sv_sel_col->tab_name, .col_name = sv_sel_col->col_name};
                 sel_cols.push_back(sel_col);
             }
+            std::vector<OrderByCol> order_cols;
+            for (auto &sv_order : x->orders) {
+                TabCol order_col = {.tab_name = sv_order->col->tab_name, .col_name = sv_order->col->col_name};
+                order_cols.push_back({.col = order_col, .desc = sv_order->desc});
+            }
             SetTransaction(txn_id, context);
-            ql_manager_->select_from(sel_cols, x->tabs, conds, context);
+            ql_manager_->select_from(sel_cols, x->tabs, conds, order_cols, context);
             if(context->txn_->GetTxnMode() == false)
                 txn_mgr_->Commit(context->txn_, context->log_mgr_);
         } else if (auto x = std::dynamic_pointer_cast<ast::TxnBegin>(root)) {
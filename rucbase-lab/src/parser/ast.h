@@ -25,6 +25,12 @@ struct Help : public TreeNode {
 struct ShowTables : public TreeNode {
 };
 
+struct ShowBufferStats : public TreeNode {
+};
+
+struct ShowIndexStats : public TreeNode {
+};
+
 struct TxnBegin : public TreeNode {
 };
 
@@ -75,20 +81,26 @@ struct DescTable : public TreeNode {
     DescTable(std::string tab_name_) : tab_name(std::move(tab_name_)) {}
 };
 
+struct VacuumTable : public TreeNode {
+    std::string tab_name;
+
+    VacuumTable(std::string tab_name_) : tab_name(std::move(tab_name_)) {}
+};
+
 struct CreateIndex : public TreeNode {
     std::string tab_name;
-    std::string col_name;
+    std::vector<std::string> col_names;  // 多列索引的各列, 按索引中的顺序
 
-    CreateIndex(std::string tab_name_, std::string col_name_) :
-            tab_name(std::move(tab_name_)), col_name(std::move(col_name_)) {}
+    CreateIndex(std::string tab_name_, std::vector<std::string> col_names_) :
+            tab_name(std::move(tab_name_)), col_names(std::move(col_names_)) {}
 };
 
 struct DropIndex : public TreeNode {
     std::string tab_name;
-    std::string col_name;
+    std::vector<std::string> col_names;  // 多列索引的各列, 按索引中的顺序
 
-    DropIndex(std::string tab_name_, std::string col_name_) :
-            tab_name(std::move(tab_name_)), col_name(std::move(col_name_)) {}
+    DropIndex(std::string tab_name_, std::vector<std::string> col_names_) :
+            tab_name(std::move(tab_name_)), col_names(std::move(col_names_)) {}
 };
 
 struct Expr : public TreeNode {
@@ -167,15 +179,24 @@ struct UpdateStmt : public TreeNode {
             tab_name(std::move(tab_name_)), set_clauses(std::move(set_clauses_)), conds(std::move(conds_)) {}
 };
 
+struct OrderBy : public TreeNode {
+    std::shared_ptr<Col> col;
+    bool desc;
+
+    OrderBy(std::shared_ptr<Col> col_, bool desc_) : col(std::move(col_)), desc(desc_) {}
+};
+
 struct SelectStmt : public TreeNode {
     std::vector<std::shared_ptr<Col>> cols;
     std::vector<std::string> tabs;
     std::vector<std::shared_ptr<BinaryExpr>> conds;
+    std::vector<std::shared_ptr<OrderBy>> orders;  // ORDER BY的各列, 没有ORDER BY时为空
 
     SelectStmt(std::vector<std::shared_ptr<Col>> cols_,
                std::vector<std::string> tabs_,
-               std::vector<std::shared_ptr<BinaryExpr>> conds_) :
-            cols(std::move(cols_)), tabs(std::move(tabs_)), conds(std::move(conds_)) {}
+               std::vector<std::shared_ptr<BinaryExpr>> conds_,
+               std::vector<std::shared_ptr<OrderBy>> orders_ = {}) :
+            cols(std::move(cols_)), tabs(std::move(tabs_)), conds(std::move(conds_)), orders(std::move(orders_)) {}
 };
 
 // Semantic value
@@ -207,6 +228,9 @@ struct SemValue {
 
     std::shared_ptr<BinaryExpr> sv_cond;
     std::vector<std::shared_ptr<BinaryExpr>> sv_conds;
+
+    std::shared_ptr<OrderBy> sv_order;
+    std::vector<std::shared_ptr<OrderBy>> sv_orders;
 };
 
 extern std::shared_ptr<ast::TreeNode> parse_tree;
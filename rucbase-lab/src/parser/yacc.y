@@ -22,7 +22,7 @@ using namespace ast;
 
 // keywords
 %token SHOW TABLES CREATE TABLE DROP DESC INSERT INTO VALUES DELETE FROM
-WHERE UPDATE SET SELECT INT CHAR FLOAT INDEX AND JOIN EXIT HELP TXN_BEGIN TXN_COMMIT TXN_ABORT TXN_ROLLBACK
+WHERE UPDATE SET SELECT INT CHAR FLOAT INDEX AND JOIN EXIT HELP TXN_BEGIN TXN_COMMIT TXN_ABORT TXN_ROLLBACK VACUUM BUFFER STATS ORDER BY ASC
 // non-keywords
 %token LEQ NEQ GEQ T_EOF
 
@@ -41,13 +41,15 @@ WHERE UPDATE SET SELECT INT CHAR FLOAT INDEX AND JOIN EXIT HELP TXN_BEGIN TXN_CO
 %type <sv_val> value
 %type <sv_vals> valueList
 %type <sv_str> tbName colName
-%type <sv_strs> tableList
+%type <sv_strs> tableList colNameList
 %type <sv_col> col
 %type <sv_cols> colList selector
 %type <sv_set_clause> setClause
 %type <sv_set_clauses> setClauses
 %type <sv_cond> condition
 %type <sv_conds> whereClause optWhereClause
+%type <sv_order> orderCol
+%type <sv_orders> orderList optOrderClause
 
 %%
 start:
@@ -104,6 +106,14 @@ dbStmt:
     {
         $$ = std::make_shared<ShowTables>();
     }
+    |   SHOW BUFFER STATS
+    {
+        $$ = std::make_shared<ShowBufferStats>();
+    }
+    |   SHOW INDEX STATS
+    {
+        $$ = std::make_shared<ShowIndexStats>();
+    }
     ;
 
 ddl:
@@ -119,11 +129,15 @@ ddl:
     {
         $$ = std::make_shared<DescTable>($2);
     }
-    |   CREATE INDEX tbName '(' colName ')'
+    |   VACUUM tbName
+    {
+        $$ = std::make_shared<VacuumTable>($2);
+    }
+    |   CREATE INDEX tbName '(' colNameList ')'
     {
         $$ = std::make_shared<CreateIndex>($3, $5);
     }
-    |   DROP INDEX tbName '(' colName ')'
+    |   DROP INDEX tbName '(' colNameList ')'
     {
         $$ = std::make_shared<DropIndex>($3, $5);
     }
@@ -142,9 +156,9 @@ dml:
     {
         $$ = std::make_shared<UpdateStmt>($2, $4, $5);
     }
-    |   SELECT selector FROM tableList optWhereClause
+    |   SELECT selector FROM tableList optWhereClause optOrderClause
     {
-        $$ = std::make_shared<SelectStmt>($2, $4, $5);
+        $$ = std::make_shared<SelectStmt>($2, $4, $5, $6);
     }
     ;
 
@@ -222,6 +236,43 @@ optWhereClause:
     }
     ;
 
+optOrderClause:
+        /* epsilon */
+    {
+        $$ = {};
+    }
+    |   ORDER BY orderList
+    {
+        $$ = $3;
+    }
+    ;
+
+orderList:
+        orderCol
+    {
+        $$ = std::vector<std::shared_ptr<OrderBy>>{$1};
+    }
+    |   orderList ',' orderCol
+    {
+        $$.push_back($3);
+    }
+    ;
+
+orderCol:
+        col
+    {
+        $$ = std::make_shared<OrderBy>($1, false);
+    }
+    |   col ASC
+    {
+        $$ = std::make_shared<OrderBy>($1, false);
+    }
+    |   col DESC
+    {
+        $$ = std::make_shared<OrderBy>($1, true);
+    }
+    ;
+
 whereClause:
         condition
     {
@@ -334,6 +385,17 @@ tableList:
     }
     ;
 
+colNameList:
+        colName
+    {
+        $$ = std::vector<std::string>{$1};
+    }
+    |   colNameList ',' colName
+    {
+        $$.push_back($3);
+    }
+    ;
+
 tbName: IDENTIFIER;
 
 colName: IDENTIFIER;
@@ -17,6 +17,7 @@ struct RmFileHdr {
     int num_records_per_page;  // 每个page最多能存储的元组个数
     int first_free_page_no;    // 文件中当前第一个可用的page no（初始化为-1）
     int bitmap_size;           // bitmap大小
+    int first_deallocated_page_no;  // 回收页面链表的表头（初始化为-1，旧文件中为0，均表示没有回收的页面）
 };
 
 // record page header（RmFileHandle::create_page函数进行初始化）
@@ -1,5 +1,7 @@
 #include "rm_file_handle.h"
 
+#include <algorithm>
+
 /**
  * @brief 由Rid得到指向RmRecord的指针
  *
@@ -13,14 +15,36 @@ std::unique_ptr<RmRecord> RmFileHandle::get_record(const Rid &rid, Context *cont
 	auto record = std::make_unique<RmRecord>(file_hdr_.record_size);
 	RmPageHandle ph = fetch_page_handle(rid.page_no);
 	if (!Bitmap::test(ph.bitmap, rid.slot_no)) {
+        buffer_pool_manager_->UnpinPage(ph.page->GetPageId(), false);
         throw RecordNotFoundError(rid.page_no, rid.slot_no);
     }
 	char *slot = ph.get_slot(rid.slot_no);
 	memcpy(record->data, slot, file_hdr_.record_size);
     record->size = file_hdr_.record_size;
+    buffer_pool_manager_->UnpinPage(ph.page->GetPageId(), false);
     return record;
 }
 
+/**
+ * @brief 读取同一个页面中多个slot上的记录, 页面只fetch一次
+ *
+ * @param page_no 记录所在的页面
+ * @param slot_nos 要读取的slot
+ * @return 与slot_nos一一对应的记录, slot上已经没有记录时为nullptr
+ */
+std::vector<std::unique_ptr<RmRecord>> RmFileHandle::get_page_records(int page_no, const std::vector<int> &slot_nos,
+                                                                      Context *context) const {
+    std::vector<std::unique_ptr<RmRecord>> records(slot_nos.size());
+    RmPageHandle ph = fetch_page_handle(page_no);
+    for (size_t i = 0; i < slot_nos.size(); i++) {
+        if (Bitmap::test(ph.bitmap, slot_nos[i])) {
+            records[i] = std::make_unique<RmRecord>(file_hdr_.record_size, ph.get_slot(slot_nos[i]));
+        }
+    }
+    buffer_pool_manager_->UnpinPage(ph.page->GetPageId(), false);
+    return records;
+}
+
 /**
  * @brief 在该记录文件（RmFileHandle）中插入一条记录
  *
@@ -46,6 +70,7 @@ Rid RmFileHandle::insert_record(char *buf, Context *context) {
 	char *slot = ph.get_slot(slot_no);
 	memcpy(slot, buf, file_hdr_.record_size);
     //Rid rid(ph.page->GetPageId().page_no, slot_no);
+    buffer_pool_manager_->UnpinPage(ph.page->GetPageId(), true);
     return Rid{ph.page->GetPageId().page_no, slot_no};
 }
 
@@ -61,6 +86,7 @@ void RmFileHandle::delete_record(const Rid &rid, Context *context) {
     // 注意考虑删除一条记录后页面未满的情况，需要调用release_page_handle()
 	RmPageHandle ph = fetch_page_handle(rid.page_no);
 	if (!Bitmap::test(ph.bitmap, rid.slot_no)) {
+        buffer_pool_manager_->UnpinPage(ph.page->GetPageId(), false);
         throw RecordNotFoundError(rid.page_no, rid.slot_no);
     }
 	//ph.page->is_dirty_ = true;
@@ -70,6 +96,7 @@ void RmFileHandle::delete_record(const Rid &rid, Context *context) {
     }
     Bitmap::reset(ph.bitmap, rid.slot_no);
     ph.page_hdr->num_records--;
+    buffer_pool_manager_->UnpinPage(ph.page->GetPageId(), true);
 }
 
 /**
@@ -84,11 +111,13 @@ void RmFileHandle::update_record(const Rid &rid, char *buf, Context *context) {
     // 2. 更新记录
 	RmPageHandle ph = fetch_page_handle(rid.page_no);
 	if (!Bitmap::test(ph.bitmap, rid.slot_no)) {
+        buffer_pool_manager_->UnpinPage(ph.page->GetPageId(), false);
         throw RecordNotFoundError(rid.page_no, rid.slot_no);
     }
 	//ph.page->is_dirty_ = true;
     char *slot = ph.get_slot(rid.slot_no);
     memcpy(slot, buf, file_hdr_.record_size);
+    buffer_pool_manager_->UnpinPage(ph.page->GetPageId(), true);
 }
 
 /** -- 以下为辅助函数 -- */
@@ -125,18 +154,19 @@ RmPageHandle RmFileHandle::create_new_page_handle() {
     // 1.使用缓冲池来创建一个新page
     // 2.更新page handle中的相关信息
     // 3.更新file_hdr_
-	PageId *page_id = new PageId;
-	page_id->fd = fd_;
+	PageId page_id;
+	page_id.fd = fd_;
 
 	Page *page = nullptr;
-	page = buffer_pool_manager_->NewPage(page_id);
+	page = buffer_pool_manager_->NewPage(&page_id);
 
 	RmPageHandle ph = RmPageHandle(&file_hdr_, page); // init
 	ph.page_hdr->num_records = 0;
 	ph.page_hdr->next_free_page_no = RM_NO_PAGE;
 	Bitmap::init(ph.bitmap, file_hdr_.bitmap_size);
 
-	file_hdr_.num_pages ++;
+	// 复用回收的页面时page_no小于num_pages, 文件页数不变
+	file_hdr_.num_pages = std::max(file_hdr_.num_pages, page_id.page_no + 1);
 	file_hdr_.first_free_page_no = page->GetPageId().page_no;
 
     return ph;
@@ -175,6 +205,44 @@ void RmFileHandle::release_page_handle(RmPageHandle &page_handle) {
 	file_hdr_.first_free_page_no = page_handle.page->GetPageId().page_no;
 }
 
+/**
+ * @brief 回收文件中没有记录的页面, 并截断文件末尾连续的回收页面
+ *
+ * @return int 从文件末尾截掉的页面个数
+ * @note 其余回收的页面由DiskManager::AllocatePage复用; 未满页面的链表按page_no从小到大重建,
+ * 插入时优先填满文件前部的页面, 使文件末尾的页面更容易变空而被截断
+ */
+int RmFileHandle::vacuum() {
+    int first_free_page_no = RM_NO_PAGE;
+    for (int page_no = file_hdr_.num_pages - 1; page_no >= RM_FIRST_RECORD_PAGE; page_no--) {
+        if (disk_manager_->IsFreePage(fd_, page_no)) {
+            continue;
+        }
+        RmPageHandle ph = fetch_page_handle(page_no);
+        if (ph.page_hdr->num_records == 0) {
+            PageId page_id = ph.page->GetPageId();
+            buffer_pool_manager_->UnpinPage(page_id, false);
+            if (buffer_pool_manager_->DeletePage(page_id)) {
+                continue;
+            }
+            // 页面正在被使用, 保留为未满页面
+            ph = fetch_page_handle(page_no);
+        }
+        if (ph.page_hdr->num_records < file_hdr_.num_records_per_page) {
+            ph.page_hdr->next_free_page_no = first_free_page_no;
+            first_free_page_no = page_no;
+            buffer_pool_manager_->UnpinPage(ph.page->GetPageId(), true);
+        } else {
+            buffer_pool_manager_->UnpinPage(ph.page->GetPageId(), false);
+        }
+    }
+    file_hdr_.first_free_page_no = first_free_page_no;
+    int num_pages = disk_manager_->TruncateFreePages(fd_);
+    int num_truncated = file_hdr_.num_pages - num_pages;
+    file_hdr_.num_pages = num_pages;
+    return num_truncated;
+}
+
 // used for recovery (lab4)
 void RmFileHandle::insert_record(const Rid &rid, char *buf) {
     if (rid.page_no < file_hdr_.num_pages) {
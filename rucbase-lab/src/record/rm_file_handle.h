@@ -3,6 +3,7 @@
 #include <assert.h>
 
 #include <memory>
+#include <vector>
 
 #include "bitmap.h"
 #include "common/context.h"
@@ -47,13 +48,14 @@ class RmFileHandle {      // TableHeap
 
    public:
     RmFileHandle(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, int fd)
-        : disk_manager_(disk_manager), buffer_pool_manager_(buffer_pool_manager), fd_(fd) {
+        : disk_manager_(disk_manager), buffer_pool_manager_(buffer_pool_manager), fd_(fd), file_hdr_{} {
         // 注意：这里从磁盘中读出文件描述符为fd的文件的file_hdr，读到内存中
         // 这里实际就是初始化file_hdr，只不过是从磁盘中读出进行初始化
         // init file_hdr_
         disk_manager_->read_page(fd, RM_FILE_HDR_PAGE, (char *)&file_hdr_, sizeof(file_hdr_));
         // disk_manager管理的fd对应的文件中，设置从file_hdr_.num_pages开始分配page_no
         disk_manager_->set_fd2pageno(fd, file_hdr_.num_pages);
+        disk_manager_->LoadFreePages(fd, file_hdr_.first_deallocated_page_no);
     }
 
     DISALLOW_COPY(RmFileHandle);
@@ -65,11 +67,16 @@ class RmFileHandle {      // TableHeap
 
     bool is_record(const Rid &rid) const {
         RmPageHandle page_handle = fetch_page_handle(rid.page_no);
-        return Bitmap::is_set(page_handle.bitmap, rid.slot_no);  // page的slot_no位置上是否有record
+        bool is_set = Bitmap::is_set(page_handle.bitmap, rid.slot_no);  // page的slot_no位置上是否有record
+        buffer_pool_manager_->UnpinPage(page_handle.page->GetPageId(), false);
+        return is_set;
     }
 
     std::unique_ptr<RmRecord> get_record(const Rid &rid, Context *context) const;
 
+    std::vector<std::unique_ptr<RmRecord>> get_page_records(int page_no, const std::vector<int> &slot_nos,
+                                                            Context *context) const;
+
     Rid insert_record(char *buf, Context *context);
 
     void insert_record(const Rid &rid, char *buf);
@@ -82,6 +89,8 @@ class RmFileHandle {      // TableHeap
 
     RmPageHandle fetch_page_handle(int page_no) const;
 
+    int vacuum();
+
    private:
     RmPageHandle create_page_handle();
 
@@ -235,4 +235,83 @@ TEST(RecordManagerTest, MultipleFilesTest) {
         std::string filename = filenames[i];
         rm_manager->destroy_file(filename);
     }
-}
\ No newline at end of file
+}
+/**
+ * @brief 测试vacuum回收空页面、截断文件末尾, 以及回收页面在重新打开文件后的复用
+ */
+TEST(RecordManagerTest, VacuumTest) {
+    srand((unsigned)time(nullptr));
+
+    char *result = new char[BUFFER_LENGTH];
+    int offset = 0;
+    Context *context = new Context(nullptr, nullptr, nullptr, result, &offset);
+
+    auto disk_manager = std::make_unique<DiskManager>();
+    auto buffer_pool_manager = std::make_unique<BufferPoolManager>(BUFFER_POOL_SIZE, disk_manager.get());
+    auto rm_manager = std::make_unique<RmManager>(disk_manager.get(), buffer_pool_manager.get());
+
+    std::string filename = "vacuum.txt";
+    if (disk_manager->is_file(filename)) {
+        disk_manager->destroy_file(filename);
+    }
+    rm_manager->create_file(filename, 256);
+    auto file_handle = rm_manager->open_file(filename);
+    int records_per_page = file_handle->file_hdr_.num_records_per_page;
+
+    // 写满10个页面
+    constexpr int NUM_PAGES = 10;
+    std::unordered_map<Rid, std::string, rid_hash_t, rid_equal_t> mock;
+    char write_buf[PAGE_SIZE];
+    for (int i = 0; i < NUM_PAGES * records_per_page; i++) {
+        rand_buf(file_handle->file_hdr_.record_size, write_buf);
+        Rid rid = file_handle->insert_record(write_buf, context);
+        mock[rid] = std::string(write_buf, file_handle->file_hdr_.record_size);
+    }
+    ASSERT_EQ(file_handle->file_hdr_.num_pages, NUM_PAGES + 1);
+
+    // 清空第3、4页和最后3页, 第5页删除一半记录
+    std::vector<Rid> rids;
+    for (auto &entry : mock) {
+        int page_no = entry.first.page_no;
+        if (page_no == 3 || page_no == 4 || page_no > NUM_PAGES - 3 ||
+            (page_no == 5 && entry.first.slot_no % 2 == 0)) {
+            rids.push_back(entry.first);
+        }
+    }
+    for (auto &rid : rids) {
+        file_handle->delete_record(rid, context);
+        mock.erase(rid);
+    }
+
+    EXPECT_EQ(file_handle->vacuum(), 3);
+    EXPECT_EQ(file_handle->file_hdr_.num_pages, NUM_PAGES - 2);
+    EXPECT_EQ(disk_manager->GetFileSize(filename), (NUM_PAGES - 2) * PAGE_SIZE);
+    EXPECT_EQ(disk_manager->GetNumFreePages(file_handle->GetFd()), 2u);
+    EXPECT_EQ(file_handle->file_hdr_.first_free_page_no, 5);
+    check_equal(file_handle.get(), mock);
+
+    // 回收的页面在重新打开文件后恢复: 先填满未满的第5页, 再复用第3、4页, 最后才扩展文件
+    rm_manager->close_file(file_handle.get());
+    file_handle = rm_manager->open_file(filename);
+    EXPECT_EQ(disk_manager->GetNumFreePages(file_handle->GetFd()), 2u);
+    check_equal(file_handle.get(), mock);
+    int num_free_slots = (records_per_page + 1) / 2 + 2 * records_per_page;
+    for (int i = 0; i <= num_free_slots; i++) {
+        rand_buf(file_handle->file_hdr_.record_size, write_buf);
+        Rid rid = file_handle->insert_record(write_buf, context);
+        if (i < (records_per_page + 1) / 2) {
+            EXPECT_EQ(rid.page_no, 5);
+        } else if (i < num_free_slots) {
+            EXPECT_TRUE(rid.page_no == 3 || rid.page_no == 4);
+        } else {
+            EXPECT_EQ(rid.page_no, NUM_PAGES - 2);
+        }
+        mock[rid] = std::string(write_buf, file_handle->file_hdr_.record_size);
+    }
+    EXPECT_EQ(file_handle->file_hdr_.num_pages, NUM_PAGES - 1);
+    EXPECT_EQ(disk_manager->GetNumFreePages(file_handle->GetFd()), 0u);
+    check_equal(file_handle.get(), mock);
+
+    rm_manager->close_file(file_handle.get());
+    rm_manager->destroy_file(filename);
+}
@@ -29,6 +29,7 @@ class RmManager {
         file_hdr.record_size = record_size;
         file_hdr.num_pages = 1;
         file_hdr.first_free_page_no = RM_NO_PAGE;
+        file_hdr.first_deallocated_page_no = RM_NO_PAGE;
         // We have: sizeof(hdr) + (n + 7) / 8 + n * record_size <= PAGE_SIZE
         file_hdr.num_records_per_page =
             (BITMAP_WIDTH * (PAGE_SIZE - 1 - (int)sizeof(RmFileHdr)) + 1) / (1 + record_size * BITMAP_WIDTH);
@@ -45,14 +46,19 @@ class RmManager {
     // 注意这里打开文件，创建并返回了record file handle的指针
     std::unique_ptr<RmFileHandle> open_file(const std::string &filename) {
         int fd = disk_manager_->open_file(filename);
+        // fd会被复用, 清除之前打开的文件留下的缓冲池统计
+        buffer_pool_manager_->ResetBufferPoolStats(fd);
         return std::make_unique<RmFileHandle>(disk_manager_, buffer_pool_manager_, fd);
     }
 
     void close_file(const RmFileHandle *file_handle) {
-        disk_manager_->write_page(file_handle->fd_, RM_FILE_HDR_PAGE, (char *)&file_handle->file_hdr_,
-                                  sizeof(file_handle->file_hdr_));
         // 缓冲区的所有页刷到磁盘，注意这句话必须写在close_file前面
+        // 也必须写在SaveFreePages前面: 扫描读入缓冲区的回收页面是旧的回收标记, 不能覆盖新写入的链表
         buffer_pool_manager_->FlushAllPages(file_handle->fd_);
+        // 回收的页面串成链表保存在页面自身中, 表头记在file header里, 下次打开文件时重新加载
+        RmFileHdr file_hdr = file_handle->file_hdr_;
+        file_hdr.first_deallocated_page_no = disk_manager_->SaveFreePages(file_handle->fd_);
+        disk_manager_->write_page(file_handle->fd_, RM_FILE_HDR_PAGE, (char *)&file_hdr, sizeof(file_hdr));
         disk_manager_->close_file(file_handle->fd_);
     }
 };
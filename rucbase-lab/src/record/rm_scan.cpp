@@ -7,7 +7,8 @@
  *
  * @param file_handle
  */
-RmScan::RmScan(const RmFileHandle *file_handle) : file_handle_(file_handle) {
+RmScan::RmScan(const RmFileHandle *file_handle, int prefetch_window)
+    : file_handle_(file_handle), prefetch_window_(prefetch_window), prefetch_end_(RM_FIRST_RECORD_PAGE) {
     // Todo:
     // 初始化file_handle和rid（指向第一个存放了记录的位置）
     rid_ = Rid{RM_FIRST_RECORD_PAGE, -1};
@@ -23,16 +24,44 @@ void RmScan::next() {
 	while (rid_.page_no < file_handle_->file_hdr_.num_pages) {
         RmPageHandle ph = file_handle_->fetch_page_handle(rid_.page_no);
         rid_.slot_no = Bitmap::next_bit(true, ph.bitmap, file_handle_->file_hdr_.num_records_per_page, rid_.slot_no);
+        file_handle_->buffer_pool_manager_->UnpinPage(ph.page->GetPageId(), false);
         if (rid_.slot_no < file_handle_->file_hdr_.num_records_per_page) {
             return;
     	}
         rid_.slot_no = -1;
         rid_.page_no++;
+        read_ahead();
     }
     // next record not found
     rid_.page_no = RM_NO_PAGE;
 }
 
+/**
+ * @brief 跳到rid(含)之后第一个存放了记录的位置, 用于按页面处理记录的扫描跳过已经处理的记录
+ */
+void RmScan::seek(const Rid &rid) {
+    bool new_page = rid.page_no != rid_.page_no;
+    rid_ = Rid{rid.page_no, rid.slot_no - 1};
+    if (new_page) {
+        read_ahead();
+    }
+    next();
+}
+
+/**
+ * @brief 顺序预读: 扫描每进入一个新页面时调用, 已发出预读的页面不足半个窗口时, 补足到prefetch_window_个
+ * @note 扫描在第一个页面结束之后才开始预读, 只有一个页面的小表不会产生多余的I/O
+ */
+void RmScan::read_ahead() {
+    int num_pages = file_handle_->file_hdr_.num_pages;
+    if (prefetch_window_ <= 0 || prefetch_end_ >= num_pages || prefetch_end_ - rid_.page_no > prefetch_window_ / 2) {
+        return;
+    }
+    page_id_t first = std::max(prefetch_end_, rid_.page_no);
+    prefetch_end_ = std::min(num_pages, rid_.page_no + prefetch_window_);
+    file_handle_->buffer_pool_manager_->PrefetchPages(file_handle_->fd_, first, prefetch_end_ - first);
+}
+
 /**
  * @brief ​ 判断是否到达文件末尾
  */
@@ -7,12 +7,19 @@ class RmFileHandle;
 class RmScan : public RecScan {
     const RmFileHandle *file_handle_;
     Rid rid_;
+    int prefetch_window_;      // 顺序预读窗口的页面数, 0表示不预读
+    page_id_t prefetch_end_;   // [rid_.page_no, prefetch_end_)之间的页面已经发出预读
 public:
-    RmScan(const RmFileHandle *file_handle);
+    RmScan(const RmFileHandle *file_handle, int prefetch_window = PREFETCH_WINDOW);
 
     void next() override;
 
     bool is_end() const override;
 
     Rid rid() const override;
+
+    void seek(const Rid &rid);
+
+private:
+    void read_ahead();
 };
@@ -0,0 +1,62 @@
+#include "replacer/atomic_clock_replacer.h"
+
+AtomicClockReplacer::AtomicClockReplacer(size_t num_pages)
+    : states_(new std::atomic<uint8_t>[num_pages]), capacity_(num_pages) {
+    for (size_t i = 0; i < capacity_; i++) {
+        states_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+AtomicClockReplacer::~AtomicClockReplacer() = default;
+
+/**
+ * @brief 转动时钟指针: 清除经过的帧的引用位, 淘汰第一个可淘汰且引用位为0的帧
+ * @note 最多转两圈: 第一圈清除所有引用位, 第二圈一定能找到victim(除非其他线程同时Unpin/Victim)
+ */
+bool AtomicClockReplacer::Victim(frame_id_t *frame_id) {
+    for (size_t i = 0; i < 2 * capacity_; i++) {
+        size_t pos = hand_.fetch_add(1, std::memory_order_relaxed) % capacity_;
+        uint8_t state = states_[pos].load(std::memory_order_acquire);
+        if (state == EVICTABLE) {
+            // 与其他线程的Victim竞争同一个帧时, 只有一个CAS会成功
+            if (states_[pos].compare_exchange_strong(state, 0, std::memory_order_acq_rel)) {
+                *frame_id = static_cast<frame_id_t>(pos);
+                return true;
+            }
+        } else if (state == (EVICTABLE | REFERENCED)) {
+            states_[pos].compare_exchange_strong(state, EVICTABLE, std::memory_order_acq_rel);
+        }
+    }
+    return false;
+}
+
+void AtomicClockReplacer::Pin(frame_id_t frame_id) { states_[frame_id].store(0, std::memory_order_release); }
+
+void AtomicClockReplacer::Unpin(frame_id_t frame_id) {
+    states_[frame_id].store(EVICTABLE | REFERENCED, std::memory_order_release);
+}
+
+size_t AtomicClockReplacer::Size() {
+    size_t size = 0;
+    for (size_t i = 0; i < capacity_; i++) {
+        size += states_[i].load(std::memory_order_acquire) != 0;
+    }
+    return size;
+}
+
+/**
+ * @brief 从时钟指针开始, 先列出引用位为0的可淘汰帧, 再列出引用位为1的可淘汰帧
+ */
+std::vector<frame_id_t> AtomicClockReplacer::PeekVictims(size_t max_frames) {
+    std::vector<frame_id_t> frame_ids;
+    size_t hand = hand_.load(std::memory_order_relaxed);
+    for (uint8_t wanted : {EVICTABLE, static_cast<uint8_t>(EVICTABLE | REFERENCED)}) {
+        for (size_t i = 0; i < capacity_ && frame_ids.size() < max_frames; i++) {
+            size_t pos = (hand + i) % capacity_;
+            if (states_[pos].load(std::memory_order_acquire) == wanted) {
+                frame_ids.push_back(static_cast<frame_id_t>(pos));
+            }
+        }
+    }
+    return frame_ids;
+}
@@ -0,0 +1,59 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Rucbase
+//
+// atomic_clock_replacer.h
+//
+// Identification: src/replacer/atomic_clock_replacer.h
+//
+// Copyright (c) 2022, RUC Deke Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "common/config.h"
+#include "replacer/replacer.h"
+
+/**
+ * AtomicClockReplacer implements the clock replacement policy without a latch.
+ *
+ * 每个帧只有一个字节的原子状态(可淘汰位+引用位). Pin/Unpin只是对该字节的一次原子store,
+ * 缓存命中路径上不同帧之间互不争用; 只有Victim会转动时钟指针扫描各帧, 并用CAS抢占victim.
+ * @note 同一帧上的Pin/Unpin/Victim之间的先后顺序由调用者保证(缓冲池在其latch下调用),
+ * 本类只保证不同帧的操作可以无锁地并发执行
+ */
+class AtomicClockReplacer : public Replacer {
+   public:
+    /**
+     * Create a new AtomicClockReplacer.
+     * @param num_pages the maximum number of pages the AtomicClockReplacer will be required to store
+     */
+    explicit AtomicClockReplacer(size_t num_pages);
+
+    ~AtomicClockReplacer() override;
+
+    bool Victim(frame_id_t *frame_id) override;
+
+    void Pin(frame_id_t frame_id) override;
+
+    void Unpin(frame_id_t frame_id) override;
+
+    /** @note 需要扫描所有帧, 不应在热路径上调用 */
+    size_t Size() override;
+
+    /** @note 与Size()一样需要扫描所有帧; 并发修改时结果只是近似的 */
+    std::vector<frame_id_t> PeekVictims(size_t max_frames) override;
+
+   private:
+    static constexpr uint8_t EVICTABLE = 1;   // 帧中有页面且没有被固定
+    static constexpr uint8_t REFERENCED = 2;  // 上次时钟指针经过之后被访问过
+
+    std::unique_ptr<std::atomic<uint8_t>[]> states_;  // 每个帧的状态, 为0表示空闲或被固定
+    std::atomic<size_t> hand_{0};                     // 时钟指针, 对capacity_取模后为下一个要检查的帧
+    size_t capacity_;
+};
@@ -0,0 +1,127 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Rucbase
+//
+// atomic_clock_replacer_test.cpp
+//
+// Identification: src/replacer/atomic_clock_replacer_test.cpp
+//
+// Copyright (c) 2022, RUC Deke Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "replacer/atomic_clock_replacer.h"
+
+#include <algorithm>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+/**
+ * @brief 与ClockReplacerTest.SimpleTest相同的场景, 淘汰顺序也相同
+ */
+TEST(AtomicClockReplacerTest, SimpleTest) {
+    AtomicClockReplacer clock_replacer(7);
+
+    // Scenario: unpin six elements, i.e. add them to the replacer.
+    for (frame_id_t i = 1; i <= 6; i++) {
+        clock_replacer.Unpin(i);
+    }
+    clock_replacer.Unpin(1);
+    EXPECT_EQ(6, clock_replacer.Size());
+
+    // Scenario: get three victims from the clock.
+    int value;
+    for (frame_id_t expected : {1, 2, 3}) {
+        ASSERT_TRUE(clock_replacer.Victim(&value));
+        EXPECT_EQ(expected, value);
+    }
+
+    // Scenario: pin elements in the replacer. 3 has already been victimized, so pinning 3 has no effect.
+    clock_replacer.Pin(3);
+    clock_replacer.Pin(4);
+    EXPECT_EQ(2, clock_replacer.Size());
+
+    // Scenario: unpin 4. The reference bit of 4 is set, so 5 and 6 are victimized first.
+    clock_replacer.Unpin(4);
+    for (frame_id_t expected : {5, 6, 4}) {
+        ASSERT_TRUE(clock_replacer.Victim(&value));
+        EXPECT_EQ(expected, value);
+    }
+    EXPECT_FALSE(clock_replacer.Victim(&value));
+}
+
+/**
+ * @brief 与ClockReplacerTest.CornerCaseTest相同的场景
+ */
+TEST(AtomicClockReplacerTest, CornerCaseTest) {
+    AtomicClockReplacer clock_replacer(4);
+    int value;
+    EXPECT_FALSE(clock_replacer.Victim(&value));
+
+    clock_replacer.Unpin(3);
+    clock_replacer.Unpin(2);
+    EXPECT_EQ(2, clock_replacer.Size());
+    ASSERT_TRUE(clock_replacer.Victim(&value));
+    EXPECT_EQ(2, value);
+    clock_replacer.Unpin(1);
+    EXPECT_EQ(2, clock_replacer.Size());
+    ASSERT_TRUE(clock_replacer.Victim(&value));
+    EXPECT_EQ(3, value);
+    ASSERT_TRUE(clock_replacer.Victim(&value));
+    EXPECT_EQ(1, value);
+    EXPECT_FALSE(clock_replacer.Victim(&value));
+    EXPECT_EQ(0, clock_replacer.Size());
+}
+
+/**
+ * @brief 多个线程并发地Pin/Unpin各自的帧, 同时多个线程并发地Victim, 每个帧恰好被淘汰一次
+ */
+TEST(AtomicClockReplacerTest, ConcurrencyTest) {
+    const int num_threads = 8;
+    const int share = 500;
+    const int value_size = num_threads * share;
+    for (int run = 0; run < 20; run++) {
+        AtomicClockReplacer clock_replacer(value_size);
+        std::vector<std::thread> threads;
+        for (int tid = 0; tid < num_threads; tid++) {
+            threads.emplace_back([tid, &clock_replacer]() {
+                for (int round = 0; round < 3; round++) {
+                    for (int i = 0; i < share; i++) {
+                        clock_replacer.Pin(tid * share + i);
+                        clock_replacer.Unpin(tid * share + i);
+                    }
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        EXPECT_EQ(value_size, clock_replacer.Size());
+
+        std::vector<std::vector<int>> victims(num_threads);
+        threads.clear();
+        for (int tid = 0; tid < num_threads; tid++) {
+            threads.emplace_back([tid, &clock_replacer, &victims]() {
+                int value;
+                while (clock_replacer.Victim(&value)) {
+                    victims[tid].push_back(value);
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        std::vector<int> out_values;
+        for (auto &values : victims) {
+            out_values.insert(out_values.end(), values.begin(), values.end());
+        }
+        std::sort(out_values.begin(), out_values.end());
+        ASSERT_EQ(value_size, out_values.size());
+        for (int i = 0; i < value_size; i++) {
+            EXPECT_EQ(i, out_values[i]);
+        }
+        EXPECT_EQ(0, clock_replacer.Size());
+    }
+}
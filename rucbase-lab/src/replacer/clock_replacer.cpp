@@ -88,3 +88,20 @@ size_t ClockReplacer::Size() {
 	}
     return size;
 }
+
+/**
+ * @brief 从hand_开始, 先列出UNTOUCHED的帧(本圈就会被淘汰), 再列出ACCESSED的帧(下一圈才会被淘汰)
+ */
+std::vector<frame_id_t> ClockReplacer::PeekVictims(size_t max_frames) {
+    const std::lock_guard<mutex_t> guard(mutex_);
+    std::vector<frame_id_t> frame_ids;
+    for (Status status : {Status::UNTOUCHED, Status::ACCESSED}) {
+        for (size_t i = 0; i < capacity_ && frame_ids.size() < max_frames; i++) {
+            frame_id_t frame_id = static_cast<frame_id_t>((hand_ + i) % capacity_);
+            if (circular_[frame_id] == status) {
+                frame_ids.push_back(frame_id);
+            }
+        }
+    }
+    return frame_ids;
+}
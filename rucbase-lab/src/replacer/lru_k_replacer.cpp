@@ -0,0 +1,113 @@
+#include "replacer/lru_k_replacer.h"
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k, size_t correlated_period)
+    : frames_(num_pages), k_(k), correlated_period_(correlated_period) {}
+
+LRUKReplacer::~LRUKReplacer() = default;
+
+/**
+ * @brief 计算帧在evictable_中的排序键, 调用者需持有latch_
+ * 引用不足K次的帧按最近一次引用排序(LRU), 满K次的帧按第K次最近引用排序
+ */
+LRUKReplacer::EvictKey LRUKReplacer::GetEvictKey(frame_id_t frame_id) const {
+    const FrameInfo &info = frames_[frame_id];
+    if (info.history.size() < k_) {
+        return {false, info.last, frame_id};
+    }
+    return {true, info.history[k_ - 1], frame_id};
+}
+
+/**
+ * @brief 淘汰backward K-distance最大的帧, 跳过最近correlated_period次访问内被引用过的帧
+ * @param[out] frame_id id of frame that was removed
+ * @return true if a victim frame was found, false otherwise
+ */
+bool LRUKReplacer::Victim(frame_id_t *frame_id) {
+    std::scoped_lock lock{latch_};
+    if (evictable_.empty()) {
+        return false;
+    }
+    // 最近correlated_period次访问最多引用了correlated_period个不同的帧, 因此最多跳过这么多个
+    auto victim = evictable_.begin();
+    for (auto it = evictable_.begin(); it != evictable_.end(); ++it) {
+        const FrameInfo &info = frames_[std::get<2>(*it)];
+        if (current_timestamp_ - info.last > correlated_period_) {
+            victim = it;
+            break;
+        }
+    }
+    *frame_id = std::get<2>(*victim);
+    evictable_.erase(victim);
+    // 帧中即将放入新的页面, 旧页面的引用历史不再有意义
+    FrameInfo &info = frames_[*frame_id];
+    info.history.clear();
+    info.last = 0;
+    info.evictable = false;
+    return true;
+}
+
+/**
+ * @brief 固定一个frame并记录一次引用
+ * @param frame_id the id of the frame to pin
+ */
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+    std::scoped_lock lock{latch_};
+    FrameInfo &info = frames_[frame_id];
+    if (info.evictable) {
+        evictable_.erase(GetEvictKey(frame_id));
+        info.evictable = false;
+    }
+    size_t now = ++current_timestamp_;
+    if (info.history.empty()) {
+        info.history.push_back(now);
+    } else if (now - info.last > correlated_period_) {
+        // 新的非相关引用: 之前的引用整体后移, 并把上一段相关引用持续的时间加到历史上,
+        // 使一段相关引用在计算K-distance时相当于发生在其结束的时刻
+        size_t correlated_span = info.last - info.history[0];
+        if (info.history.size() < k_) {
+            info.history.push_back(0);
+        }
+        for (size_t i = info.history.size() - 1; i > 0; i--) {
+            info.history[i] = info.history[i - 1] + correlated_span;
+        }
+        info.history[0] = now;
+    }
+    info.last = now;
+}
+
+/**
+ * @brief 取消固定一个frame, 使其可以被淘汰
+ * @param frame_id the id of the frame to unpin
+ */
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+    std::scoped_lock lock{latch_};
+    FrameInfo &info = frames_[frame_id];
+    if (info.evictable) {
+        return;
+    }
+    if (info.history.empty()) {
+        // 没有经过Pin直接放入replacer的帧(如预读的页面), 不计为引用, 只按放入的时刻参与LRU排序
+        info.last = current_timestamp_;
+    }
+    info.evictable = true;
+    evictable_.insert(GetEvictKey(frame_id));
+}
+
+/** @return replacer中能够victim的数量 */
+size_t LRUKReplacer::Size() {
+    std::scoped_lock lock{latch_};
+    return evictable_.size();
+}
+
+/**
+ * @brief 按evictable_的顺序列出即将被淘汰的帧
+ * @note 不考虑Victim对最近被引用过的帧的跳过, 结果只是近似的淘汰顺序
+ */
+std::vector<frame_id_t> LRUKReplacer::PeekVictims(size_t max_frames) {
+    std::scoped_lock lock{latch_};
+    std::vector<frame_id_t> frame_ids;
+    for (auto it = evictable_.begin(); it != evictable_.end() && frame_ids.size() < max_frames; ++it) {
+        frame_ids.push_back(std::get<2>(*it));
+    }
+    return frame_ids;
+}
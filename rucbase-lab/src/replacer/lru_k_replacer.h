@@ -0,0 +1,75 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Rucbase
+//
+// lru_k_replacer.h
+//
+// Identification: src/replacer/lru_k_replacer.h
+//
+// Copyright (c) 2022, RUC Deke Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include "common/config.h"
+#include "replacer/replacer.h"
+
+/**
+ * LRUKReplacer implements the LRU-K replacement policy (O'Neil et al., SIGMOD'93).
+ *
+ * 每次Pin视为对帧的一次引用. 被淘汰的是backward K-distance最大的帧, 即第K次最近引用最早的帧;
+ * 引用不足K次的帧的K-distance为+inf, 优先淘汰, 它们之间按最近一次引用做LRU.
+ * 只被顺序扫描读过一次的页面因此总是先于被反复访问的热点页面(如索引的内部节点)被淘汰.
+ *
+ * 与上一次引用间隔不超过correlated_period次访问的引用属于相关引用(例如扫描时对同一页面逐条get_record),
+ * 只更新最近引用时间, 不计为新的引用. 最近correlated_period次访问内被引用过的帧也不会被选为victim,
+ * 除非没有其他候选.
+ */
+class LRUKReplacer : public Replacer {
+   public:
+    /**
+     * Create a new LRUKReplacer.
+     * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+     * @param k the number of references tracked for each frame
+     * @param correlated_period references to a frame within this many accesses of its last reference are merged
+     */
+    explicit LRUKReplacer(size_t num_pages, size_t k = LRUK_REPLACER_K,
+                          size_t correlated_period = LRUK_CORRELATED_PERIOD);
+
+    ~LRUKReplacer() override;
+
+    bool Victim(frame_id_t *frame_id) override;
+
+    void Pin(frame_id_t frame_id) override;
+
+    void Unpin(frame_id_t frame_id) override;
+
+    size_t Size() override;
+
+    std::vector<frame_id_t> PeekVictims(size_t max_frames) override;
+
+   private:
+    // <引用满K次, 排序时间戳, frame_id>, 按字典序越小越先被淘汰
+    using EvictKey = std::tuple<bool, size_t, frame_id_t>;
+
+    struct FrameInfo {
+        std::vector<size_t> history;  // 最近K次非相关引用的时间戳, history[0]最新
+        size_t last = 0;              // 最近一次引用(包括相关引用)的时间戳
+        bool evictable = false;
+    };
+
+    EvictKey GetEvictKey(frame_id_t frame_id) const;
+
+    std::mutex latch_;
+    std::vector<FrameInfo> frames_;
+    std::set<EvictKey> evictable_;  // 所有可以被淘汰的帧
+    size_t current_timestamp_ = 0;  // 逻辑时钟, 每次引用加一
+    size_t k_;
+    size_t correlated_period_;
+};
@@ -0,0 +1,156 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Rucbase
+//
+// lru_k_replacer_test.cpp
+//
+// Identification: src/replacer/lru_k_replacer_test.cpp
+//
+// Copyright (c) 2022, RUC Deke Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "replacer/lru_k_replacer.h"
+
+#include <algorithm>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+/**
+ * @brief 模拟缓冲池访问一个帧: FetchPage时Pin, UnpinPage时Unpin
+ */
+static void Access(LRUKReplacer *replacer, frame_id_t frame_id) {
+    replacer->Pin(frame_id);
+    replacer->Unpin(frame_id);
+}
+
+/**
+ * @brief 引用不足K次的帧先于引用满K次的帧被淘汰, 同类帧内部的淘汰顺序
+ */
+TEST(LRUKReplacerTest, SimpleTest) {
+    LRUKReplacer replacer(7, 2, 0);
+
+    // 帧1~6各引用一次, 其中2, 4再引用一次
+    for (frame_id_t i = 1; i <= 6; i++) {
+        Access(&replacer, i);
+    }
+    Access(&replacer, 2);
+    Access(&replacer, 4);
+    EXPECT_EQ(6, replacer.Size());
+
+    // 只引用过一次的帧按LRU淘汰, 之后才是引用两次的帧, 按第2次最近引用的先后淘汰
+    int value;
+    for (frame_id_t expected : {1, 3, 5, 6, 2, 4}) {
+        ASSERT_TRUE(replacer.Victim(&value));
+        EXPECT_EQ(expected, value);
+    }
+    EXPECT_FALSE(replacer.Victim(&value));
+    EXPECT_EQ(0, replacer.Size());
+
+    // 被淘汰的帧放入新页面后重新计数
+    Access(&replacer, 4);
+    Access(&replacer, 1);
+    Access(&replacer, 1);
+    ASSERT_TRUE(replacer.Victim(&value));
+    EXPECT_EQ(4, value);
+}
+
+/**
+ * @brief 被Pin的帧不能被淘汰, 重复Unpin不会重复加入
+ */
+TEST(LRUKReplacerTest, PinTest) {
+    LRUKReplacer replacer(4, 2, 0);
+    Access(&replacer, 0);
+    Access(&replacer, 1);
+    replacer.Unpin(1);
+    EXPECT_EQ(2, replacer.Size());
+
+    replacer.Pin(0);
+    EXPECT_EQ(1, replacer.Size());
+    int value;
+    ASSERT_TRUE(replacer.Victim(&value));
+    EXPECT_EQ(1, value);
+    EXPECT_FALSE(replacer.Victim(&value));
+
+    replacer.Unpin(0);
+    ASSERT_TRUE(replacer.Victim(&value));
+    EXPECT_EQ(0, value);
+
+    // 没有被Pin过的帧(如预读的页面)也可以放入replacer, 但不计为引用
+    replacer.Unpin(3);
+    Access(&replacer, 2);
+    Access(&replacer, 2);
+    ASSERT_TRUE(replacer.Victim(&value));
+    EXPECT_EQ(3, value);
+}
+
+/**
+ * @brief 顺序扫描对同一页面的连续访问是相关引用, 不能让扫描页面看起来比热点页面更热
+ */
+TEST(LRUKReplacerTest, CorrelatedReferenceTest) {
+    const size_t correlated_period = 4;
+    LRUKReplacer replacer(16, 2, correlated_period);
+
+    // 热点帧0, 1各有两次间隔足够远的引用
+    Access(&replacer, 0);
+    Access(&replacer, 1);
+    for (frame_id_t i = 8; i < 8 + static_cast<frame_id_t>(correlated_period); i++) {
+        Access(&replacer, i);
+    }
+    Access(&replacer, 0);
+    Access(&replacer, 1);
+
+    // 扫描: 每个页面连续访问4次(next()一次, get_record()三次)
+    for (frame_id_t i = 2; i < 8; i++) {
+        for (int j = 0; j < 4; j++) {
+            Access(&replacer, i);
+        }
+    }
+    // 帧8~11以及扫描过的帧2~7都只算一次引用, 先于热点帧被淘汰;
+    // 只有最近被扫描的帧6, 7仍处于相关引用期内, 在没有其他候选时才被淘汰
+    int value;
+    std::vector<frame_id_t> victims;
+    for (int i = 0; i < 12; i++) {
+        ASSERT_TRUE(replacer.Victim(&value));
+        victims.push_back(value);
+    }
+    std::vector<frame_id_t> expected = {8, 9, 10, 11, 2, 3, 4, 5, 0, 1, 6, 7};
+    EXPECT_EQ(expected, victims);
+    EXPECT_FALSE(replacer.Victim(&value));
+}
+
+/**
+ * @brief 并发Unpin/Victim
+ */
+TEST(LRUKReplacerTest, ConcurrencyTest) {
+    const int num_threads = 5;
+    const int value_size = 1000;
+    LRUKReplacer replacer(value_size);
+    std::vector<std::thread> threads;
+    for (int tid = 0; tid < num_threads; tid++) {
+        threads.emplace_back([tid, &replacer]() {
+            int share = value_size / num_threads;
+            for (int i = 0; i < share; i++) {
+                Access(&replacer, tid * share + i);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(value_size, replacer.Size());
+
+    std::vector<int> out_values;
+    int result;
+    for (int i = 0; i < value_size; i++) {
+        ASSERT_TRUE(replacer.Victim(&result));
+        out_values.push_back(result);
+    }
+    std::sort(out_values.begin(), out_values.end());
+    for (int i = 0; i < value_size; i++) {
+        EXPECT_EQ(i, out_values[i]);
+    }
+    EXPECT_FALSE(replacer.Victim(&result));
+}
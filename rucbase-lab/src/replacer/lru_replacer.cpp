@@ -20,6 +20,7 @@ bool LRUReplacer::Victim(frame_id_t *frame_id) {
 	if(LRUlist_.size()!=0){
 		*frame_id = LRUlist_.back();
 		LRUlist_.pop_back();
+		LRUhash_.erase(*frame_id);
 		return true;
 	}
 	else return false;
@@ -34,9 +35,11 @@ void LRUReplacer::Pin(frame_id_t frame_id) {
     // Todo:
     // 固定指定id的frame
     // 在数据结构中移除该frame
-	LRUlist_.remove(frame_id);
-	//LRUlist_.erase(LRUhash_[frame_id]);
-	//LRUhash_.erase(frame_id);
+	auto it = LRUhash_.find(frame_id);
+	if(it != LRUhash_.end()){
+		LRUlist_.erase(it->second);
+		LRUhash_.erase(it);
+	}
 }
 
 /**
@@ -47,24 +50,27 @@ void LRUReplacer::Unpin(frame_id_t frame_id) {
     // Todo:
     //  支持并发锁
     //  选择一个frame取消固定
-	int flag = 1; 
-	latch_.lock();
-	std::list<frame_id_t>::iterator it = LRUlist_.begin();
-	while(it != LRUlist_.end()){
-		if(*it == frame_id){
-			flag = 0;
-			break;
-		}
-		++it;
-	}
-	if(flag)
+	std::scoped_lock lock{latch_};
+	if(LRUhash_.count(frame_id) == 0){
 		LRUlist_.push_front(frame_id);
-	latch_.unlock();
+		LRUhash_[frame_id] = LRUlist_.begin();
+	}
 }
 
 /** @return replacer中能够victim的数量 */
 size_t LRUReplacer::Size() {
     // Todo:
     // 改写return size
+    std::scoped_lock lock{latch_};
     return LRUlist_.size();
 }
+
+/** @return 最近最少使用的max_frames个frame, 即LRUlist_尾部 */
+std::vector<frame_id_t> LRUReplacer::PeekVictims(size_t max_frames) {
+    std::scoped_lock lock{latch_};
+    std::vector<frame_id_t> frame_ids;
+    for (auto it = LRUlist_.rbegin(); it != LRUlist_.rend() && frame_ids.size() < max_frames; ++it) {
+        frame_ids.push_back(*it);
+    }
+    return frame_ids;
+}
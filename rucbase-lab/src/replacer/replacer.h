@@ -12,6 +12,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include "common/config.h"
 
 /**
@@ -43,4 +45,11 @@ class Replacer {
 
     /** @return the number of elements in the replacer that can be victimized */
     virtual size_t Size() = 0;
+
+    /**
+     * Lists the frames that would be victimized next, in eviction order, without removing them.
+     * Used by the buffer pool's page cleaner to write dirty pages back before they are evicted.
+     * @param max_frames the maximum number of frames to list
+     */
+    virtual std::vector<frame_id_t> PeekVictims(size_t max_frames) = 0;
 };
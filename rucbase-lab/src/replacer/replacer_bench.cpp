@@ -0,0 +1,231 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Rucbase
+//
+// replacer_bench.cpp
+//
+// Identification: src/replacer/replacer_bench.cpp
+//
+// Copyright (c) 2022, RUC Deke Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <list>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "replacer/atomic_clock_replacer.h"
+#include "replacer/clock_replacer.h"
+#include "replacer/lru_k_replacer.h"
+#include "replacer/lru_replacer.h"
+
+/**
+ * @brief 只记录页面到帧映射的缓冲池, 与BufferPoolManager以同样的方式调用replacer:
+ * FetchPage命中时Pin, 缺页时优先使用空闲帧, 否则向replacer要victim, UnpinPage时Unpin
+ */
+class BufferPoolSimulator {
+   public:
+    BufferPoolSimulator(std::unique_ptr<Replacer> replacer, size_t pool_size)
+        : replacer_(std::move(replacer)), frame_pages_(pool_size) {
+        for (size_t i = 0; i < pool_size; i++) {
+            free_list_.push_back(static_cast<frame_id_t>(i));
+        }
+    }
+
+    /** @return 是否命中 */
+    bool Access(int64_t page) {
+        bool hit = true;
+        frame_id_t frame_id;
+        auto it = page_table_.find(page);
+        if (it != page_table_.end()) {
+            frame_id = it->second;
+        } else {
+            hit = false;
+            if (!free_list_.empty()) {
+                frame_id = free_list_.front();
+                free_list_.pop_front();
+            } else {
+                EXPECT_TRUE(replacer_->Victim(&frame_id));
+                page_table_.erase(frame_pages_[frame_id]);
+            }
+            page_table_[page] = frame_id;
+            frame_pages_[frame_id] = page;
+        }
+        replacer_->Pin(frame_id);
+        replacer_->Unpin(frame_id);
+        return hit;
+    }
+
+   private:
+    std::unique_ptr<Replacer> replacer_;
+    std::unordered_map<int64_t, frame_id_t> page_table_;
+    std::vector<int64_t> frame_pages_;
+    std::list<frame_id_t> free_list_;
+};
+
+/**
+ * @brief 点查询与顺序扫描交错的访问序列
+ * 点查询: B+树根节点 -> 内部节点 -> 叶子节点 -> 表中的一个随机页面;
+ * 顺序扫描: 每一步向后读若干页面, 每个页面由RmScan::next访问一次, 再对页上每条记录get_record访问一次
+ */
+class MixedTrace {
+   public:
+    static constexpr int NUM_INTERNALS = 8;
+    static constexpr int NUM_LEAVES = 400;
+    static constexpr int TABLE_PAGES = 16384;
+    static constexpr int RECORDS_PER_PAGE = 4;
+
+    struct Stats {
+        size_t index_hits = 0;
+        size_t index_accesses = 0;
+        size_t hits = 0;
+        size_t accesses = 0;
+    };
+
+    /**
+     * @param num_steps 步数, 每一步一次点查询
+     * @param scan_pages_per_step 每一步顺序扫描前进的页数, 0表示没有扫描
+     */
+    static Stats Replay(BufferPoolSimulator *pool, int num_steps, int scan_pages_per_step) {
+        Stats stats;
+        std::mt19937 rng(0);
+        std::uniform_int_distribution<int> leaf_dist(0, NUM_LEAVES - 1);
+        std::uniform_int_distribution<int> table_dist(0, TABLE_PAGES - 1);
+        auto access = [&](int64_t page, bool is_index) {
+            bool hit = pool->Access(page);
+            stats.hits += hit;
+            stats.accesses++;
+            if (is_index) {
+                stats.index_hits += hit;
+                stats.index_accesses++;
+            }
+        };
+        int scan_cursor = 0;
+        for (int step = 0; step < num_steps; step++) {
+            int leaf = leaf_dist(rng);
+            access(IndexPage(0), true);
+            access(IndexPage(1 + leaf % NUM_INTERNALS), true);
+            access(IndexPage(1 + NUM_INTERNALS + leaf), true);
+            access(TablePage(table_dist(rng)), false);
+            for (int i = 0; i < scan_pages_per_step; i++) {
+                for (int j = 0; j <= RECORDS_PER_PAGE; j++) {
+                    access(TablePage(scan_cursor), false);
+                }
+                scan_cursor = (scan_cursor + 1) % TABLE_PAGES;
+            }
+        }
+        return stats;
+    }
+
+   private:
+    static int64_t IndexPage(int page_no) { return page_no; }
+    static int64_t TablePage(int page_no) { return (int64_t{1} << 32) + page_no; }
+};
+
+class ReplacerBench : public ::testing::Test {
+   public:
+    static std::unique_ptr<Replacer> CreateReplacer(const std::string &name, size_t pool_size) {
+        if (name == "LRU") {
+            return std::make_unique<LRUReplacer>(pool_size);
+        }
+        if (name == "CLOCK") {
+            return std::make_unique<ClockReplacer>(pool_size);
+        }
+        if (name == "ATOMIC-CLOCK") {
+            return std::make_unique<AtomicClockReplacer>(pool_size);
+        }
+        return std::make_unique<LRUKReplacer>(pool_size);
+    }
+
+    void run_trace(const std::string &title, size_t pool_size, int num_steps, int scan_pages_per_step) {
+        printf("%s (pool_size=%zu, index=%d pages, table=%d pages, steps=%d)\n", title.c_str(), pool_size,
+               1 + MixedTrace::NUM_INTERNALS + MixedTrace::NUM_LEAVES, MixedTrace::TABLE_PAGES, num_steps);
+        printf("%12s %16s %16s %12s\n", "policy", "index hit ratio", "total hit ratio", "ns/access");
+        for (const std::string name : {"LRU", "CLOCK", "ATOMIC-CLOCK", "LRU-K"}) {
+            BufferPoolSimulator pool(CreateReplacer(name, pool_size), pool_size);
+            auto start = std::chrono::steady_clock::now();
+            MixedTrace::Stats stats = MixedTrace::Replay(&pool, num_steps, scan_pages_per_step);
+            std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+            printf("%12s %15.2f%% %15.2f%% %12.1f\n", name.c_str(), 100.0 * stats.index_hits / stats.index_accesses,
+                   100.0 * stats.hits / stats.accesses, elapsed.count() / stats.accesses);
+        }
+    }
+
+    /**
+     * @brief num_threads个线程并发地对随机帧Pin/Unpin(即缓存命中), 每victim_interval次再做一次Victim并放回victim
+     * @return 每秒完成的Pin/Unpin次数
+     */
+    static double run_pin_unpin(Replacer *replacer, size_t pool_size, int num_threads, int total_ops,
+                                int victim_interval) {
+        for (size_t i = 0; i < pool_size; i++) {
+            replacer->Unpin(static_cast<frame_id_t>(i));
+        }
+        int ops_per_thread = total_ops / num_threads;
+        std::vector<std::thread> threads;
+        auto start = std::chrono::steady_clock::now();
+        for (int tid = 0; tid < num_threads; tid++) {
+            threads.emplace_back([replacer, pool_size, ops_per_thread, victim_interval, tid]() {
+                std::mt19937 rng(tid);
+                std::uniform_int_distribution<frame_id_t> dist(0, static_cast<frame_id_t>(pool_size) - 1);
+                for (int i = 1; i <= ops_per_thread; i++) {
+                    frame_id_t frame_id = dist(rng);
+                    replacer->Pin(frame_id);
+                    replacer->Unpin(frame_id);
+                    if (victim_interval > 0 && i % victim_interval == 0 && replacer->Victim(&frame_id)) {
+                        replacer->Unpin(frame_id);
+                    }
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return ops_per_thread * num_threads / elapsed.count();
+    }
+
+    void run_scaling(const std::string &title, size_t pool_size, int total_ops, int victim_interval) {
+        const std::vector<std::string> names = {"LRU", "CLOCK", "ATOMIC-CLOCK"};
+        printf("%s (pool_size=%zu, %d ops in total)\n", title.c_str(), pool_size, total_ops);
+        printf("%8s", "threads");
+        for (auto &name : names) {
+            printf(" %18s", (name + " ops/s").c_str());
+        }
+        printf("\n");
+        for (int num_threads = 1; num_threads <= 64; num_threads *= 2) {
+            printf("%8d", num_threads);
+            for (auto &name : names) {
+                std::unique_ptr<Replacer> replacer = CreateReplacer(name, pool_size);
+                printf(" %18.0f", run_pin_unpin(replacer.get(), pool_size, num_threads, total_ops, victim_interval));
+            }
+            printf("\n");
+        }
+    }
+};
+
+/**
+ * @brief 只有点查询: 索引放得下缓冲池, 但点查询回表读到的随机页面同样会挤占索引页面
+ */
+TEST_F(ReplacerBench, PointLookupOnly) { run_trace("point lookups only", 1024, 200000, 0); }
+
+/**
+ * @brief 点查询的同时有一个大表的顺序扫描, 扫描页面会把索引页面挤出LRU/CLOCK缓冲池
+ */
+TEST_F(ReplacerBench, PointLookupWithScan) { run_trace("point lookups + sequential scan", 1024, 200000, 4); }
+
+/**
+ * @brief 缓存命中路径: 只有Pin/Unpin
+ */
+TEST_F(ReplacerBench, PinUnpinScaling) { run_scaling("Pin/Unpin, all hits", 65536, 1 << 22, 0); }
+
+/**
+ * @brief 每16次访问有一次缺页, 需要Victim
+ */
+TEST_F(ReplacerBench, PinUnpinVictimScaling) { run_scaling("Pin/Unpin + Victim every 16 ops", 65536, 1 << 22, 16); }
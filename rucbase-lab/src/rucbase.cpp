@@ -5,6 +5,8 @@
 #include <signal.h>
 #include <unistd.h>
 
+#include <limits>
+
 #include "errors.h"
 #include "interp.h"
 #include "recovery/log_recovery.h"
@@ -16,7 +18,8 @@
 static bool should_exit = false;
 
 auto disk_manager = std::make_unique<DiskManager>();
-auto buffer_pool_manager = std::make_unique<BufferPoolManager>(BUFFER_POOL_SIZE, disk_manager.get());
+auto buffer_pool_manager =
+    std::make_unique<BufferPoolManager>(BUFFER_POOL_SIZE, disk_manager.get(), BUFFER_POOL_INSTANCES);
 auto rm_manager = std::make_unique<RmManager>(disk_manager.get(), buffer_pool_manager.get());
 auto ix_manager = std::make_unique<IxManager>(disk_manager.get(), buffer_pool_manager.get());
 auto sm_manager =
@@ -148,6 +151,12 @@ void start_server() {
         log_manager->RunFlushThread();
     }
 
+    // 后台页面清理线程只写回日志已经持久化的页面
+    buffer_pool_manager->SetPersistentLsnSource([] {
+        return log_manager->GetLogMode() ? log_manager->GetPersistentLsn() : std::numeric_limits<lsn_t>::max();
+    });
+    buffer_pool_manager->StartPageCleaner();
+
     while (!should_exit) {
         std::cout << "Waiting for new connection..." << std::endl;
         pthread_t thread_id;
@@ -176,14 +185,15 @@ void start_server() {
     int ret = shutdown(sockfd_server, SHUT_WR);  // shut down the all or part of a full-duplex connection.
     if(ret == -1) { printf("%s\n", strerror(errno)); }
 //    assert(ret != -1);
+    buffer_pool_manager->StopPageCleaner();
     sm_manager->close_db();
     std::cout << " DB has been closed.\n";
     std::cout << "Server shuts down." << std::endl;
 }
 
 int main(int argc, char **argv) {
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " <database>" << std::endl;
+    if (argc != 2 && argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <database> [LRU|CLOCK|ATOMIC-CLOCK|LRU-K]" << std::endl;
         exit(1);
     }
 
@@ -199,6 +209,10 @@ int main(int argc, char **argv) {
                      "Welcome to RUC Database !\n"
                      "Type 'help;' for help.\n"
                      "\n";
+        // Replacement policy of the buffer pool is optionally passed by args
+        if (argc == 3) {
+            buffer_pool_manager->ResetReplacer(argv[2]);
+        }
         // Database name is passed by args
         std::string db_name = argv[1];
         if (!sm_manager->is_dir(db_name)) {
@@ -1,5 +1,7 @@
 #include "buffer_pool_manager.h"
 
+#include <algorithm>
+
 /**
  * @brief 从free_list或replacer中得到可淘汰帧页的 *frame_id
  * @param frame_id 帧页id指针,返回成功找到的可替换帧id
@@ -20,6 +22,72 @@ bool BufferPoolManager::FindVictimPage(frame_id_t *frame_id) {
 	}
 }
 
+/**
+ * @brief 为预读寻找一个不需要写回的帧: free_list中的帧或干净的victim
+ * @note victim是脏页时把它放回replacer并返回false, 预读只是提示, 不值得为它同步写回脏页
+ */
+bool BufferPoolManager::FindCleanVictimPage(frame_id_t *frame_id) {
+    if (!FindVictimPage(frame_id)) {
+        return false;
+    }
+    Page *page = &pages_[*frame_id];
+    if (page->IsDirty() || cleaning_pages_.count(page->GetPageId())) {
+        replacer_->Unpin(*frame_id);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 执行一次I/O操作(同步调用或等待future), 捕获其抛出的异常
+ * @return I/O失败时抛出的异常, 成功时为nullptr
+ */
+template <typename IoFunc>
+static std::exception_ptr CallIo(IoFunc &&io) {
+    try {
+        io();
+    } catch (...) {
+        return std::current_exception();
+    }
+    return nullptr;
+}
+
+/**
+ * @brief 如果victim是脏页, 把它的数据拷贝出来, 由调用者释放latch后写回磁盘
+ * @note 在写回完成之前victim页面记录在writeback_pages_中, FetchPage会等待写回完成后再读盘.
+ * 后台清理线程正在写回的页面也按脏页处理, 调用者需要等待cleaning_pages_中的写回完成后再写
+ * @return victim数据的拷贝, victim不是脏页时返回nullptr
+ */
+AlignedBuffer BufferPoolManager::TakeDirtyVictim(Page *page) {
+    if (!page->IsDirty() && !cleaning_pages_.count(page->GetPageId())) {
+        if (page->cleaned_) {
+            stalls_avoided_++;
+        }
+        return nullptr;
+    }
+    dirty_evictions_++;
+    Count(page->GetPageId().fd, &FileCounters::dirty_writes);
+    AlignedBuffer data = DiskManager::AllocateAlignedBuffer(PAGE_SIZE);
+    memcpy(data.get(), page->GetData(), PAGE_SIZE);
+    page->is_dirty_ = false;  // 清除脏位, UpdatePage不会在latch内写回
+    writeback_pages_.insert(page->GetPageId());
+    return data;
+}
+
+/**
+ * @brief victim写回失败时, 撤销帧上的新页面page_id并把victim放回原帧, 保留其脏数据
+ */
+void BufferPoolManager::RestoreVictim(Page *page, PageId page_id, frame_id_t frame_id, PageId victim_id,
+                                      const char *victim_data) {
+    page_table_.erase(page_id);
+    page_table_.insert(std::make_pair(victim_id, frame_id));
+    memcpy(page->data_, victim_data, PAGE_SIZE);
+    page->id_ = victim_id;
+    page->is_dirty_ = true;
+    page->pin_count_ = 0;
+    replacer_->Unpin(frame_id);
+}
+
 /**
  * @brief 更新页面数据, 为脏页则需写入磁盘，更新page元数据(data, is_dirty, page_id)和page table
  *
@@ -35,6 +103,10 @@ void BufferPoolManager::UpdatePage(Page *page, PageId new_page_id, frame_id_t ne
 	if(page->IsDirty()){
 		page->is_dirty_ = false;
 		disk_manager_->write_page(page->GetPageId().fd, page->GetPageId().page_no, page->GetData(), PAGE_SIZE);
+		Count(page->GetPageId().fd, &FileCounters::dirty_writes);
+	}
+	if (page->GetPageId().page_no != INVALID_PAGE_ID && new_page_id.page_no != INVALID_PAGE_ID) {
+		Count(page->GetPageId().fd, &FileCounters::evictions);
 	}
 		page_table_.erase(page->GetPageId()); //update page table
 		if(new_page_id.page_no != INVALID_PAGE_ID)
@@ -42,6 +114,7 @@ void BufferPoolManager::UpdatePage(Page *page, PageId new_page_id, frame_id_t ne
 
 		page->ResetMemory(); //reset data
 		page->id_ = new_page_id; //update
+		page->cleaned_ = false;
 }
 
 /**
@@ -61,15 +134,37 @@ Page *BufferPoolManager::FetchPage(PageId page_id) {
     // 2.     If R is dirty, write it back to the disk.
     // 3.     Delete R from the page table and insert P.
     // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
-	std::scoped_lock lock{latch_};
-	std::unordered_map<PageId, frame_id_t, PageIdHash>::iterator it = page_table_.find(page_id);
-	if(it != page_table_.end()){ //if exists in the pool
-		frame_id_t i = it->second; // get frame_id
-		replacer_->Pin(i);
-		pages_[i].pin_count_++;
-		//return nullptr;
-		return &pages_[i]; 
-	}
+    if (!instances_.empty()) {
+        return GetInstance(page_id)->FetchPage(page_id);
+    }
+    std::unique_lock lock{latch_};
+    std::optional<std::chrono::steady_clock::time_point> wait_start;
+    while (true) {
+        // 页面刚被淘汰且仍在写回, 或正由其他线程读入时, 等待I/O完成后重新查找
+        if (writeback_pages_.count(page_id)) {
+            wait_start = wait_start.value_or(std::chrono::steady_clock::now());
+            io_cv_.wait(lock);
+            continue;
+        }
+        auto it = page_table_.find(page_id);
+        if (it == page_table_.end()) {
+            break;
+        }
+        frame_id_t frame_id = it->second;
+        Page *page = &pages_[frame_id];
+        if (page->io_pending_) {
+            wait_start = wait_start.value_or(std::chrono::steady_clock::now());
+            io_cv_.wait(lock);
+            continue;
+        }
+        replacer_->Pin(frame_id);
+        page->pin_count_++;
+        Count(page_id.fd, &FileCounters::hits);
+        RecordPinWait(page_id.fd, wait_start);
+        return page;
+    }
+    Count(page_id.fd, &FileCounters::misses);
+    RecordPinWait(page_id.fd, wait_start);
 	//not exists in the pool
 	frame_id_t frame_id = -1;
 	
@@ -77,10 +172,48 @@ Page *BufferPoolManager::FetchPage(PageId page_id) {
 		return nullptr;
 	//else, find 
 	Page *R = &pages_[frame_id];
+    PageId victim_id = R->GetPageId();
+    AlignedBuffer victim_data = TakeDirtyVictim(R);
 	UpdatePage(R, page_id, frame_id);
-	disk_manager_->read_page(page_id.fd,page_id.page_no, R->data_, PAGE_SIZE);
 	replacer_->Pin(frame_id);
 	R->pin_count_ = 1;
+    R->io_pending_ = true;
+    if (victim_data != nullptr) {
+        // 等待后台清理线程对victim的写回完成, 保证最后落盘的是最新的数据
+        io_cv_.wait(lock, [&] { return cleaning_pages_.count(victim_id) == 0; });
+    }
+    lock.unlock();
+
+    // 释放latch后写回victim(数据已拷贝出)并读入新页面, 其他线程可以继续访问缓冲池.
+    // 单个页面的I/O直接在本线程执行: 缺页必须等待读完成, 交给I/O引擎只会多一次线程切换
+    std::exception_ptr write_error = nullptr;
+    std::exception_ptr read_error = nullptr;
+    if (victim_data != nullptr) {
+        write_error = CallIo([&] {
+            disk_manager_->write_page(victim_id.fd, victim_id.page_no, victim_data.get(), PAGE_SIZE);
+        });
+    }
+    if (write_error == nullptr) {
+        read_error = CallIo([&] { disk_manager_->read_page(page_id.fd, page_id.page_no, R->data_, PAGE_SIZE); });
+    }
+
+    lock.lock();
+    R->io_pending_ = false;
+    if (victim_data != nullptr) {
+        writeback_pages_.erase(victim_id);
+    }
+    if (write_error != nullptr) {
+        RestoreVictim(R, page_id, frame_id, victim_id, victim_data.get());
+    } else if (read_error != nullptr) {
+        page_table_.erase(page_id);
+        R->id_.page_no = INVALID_PAGE_ID;
+        R->pin_count_ = 0;
+        free_list_.push_back(frame_id);
+    }
+    io_cv_.notify_all();
+    if (write_error != nullptr || read_error != nullptr) {
+        std::rethrow_exception(write_error != nullptr ? write_error : read_error);
+    }
 	return R;
 }
 
@@ -97,6 +230,9 @@ bool BufferPoolManager::UnpinPage(PageId page_id, bool is_dirty) {
     // 1.1 P在页表中不存在 return false
     // 1.2 P在页表中存在 如何解除一次固定(pin_count)
     // 2. 页面是否需要置脏
+    if (!instances_.empty()) {
+        return GetInstance(page_id)->UnpinPage(page_id, is_dirty);
+    }
 	std::scoped_lock lock{latch_};
 	std::unordered_map<PageId, frame_id_t, PageIdHash>::iterator it = page_table_.find(page_id);
 	if(it == page_table_.end()) //if not exists in the pool
@@ -109,8 +245,10 @@ bool BufferPoolManager::UnpinPage(PageId page_id, bool is_dirty) {
 	page->pin_count_ --;
 	if(page->pin_count_ == 0)
 		replacer_->Unpin(frame_id);
-	if(is_dirty)
+	if(is_dirty){
 		page->is_dirty_ = true;
+		page->cleaned_ = false;
+	}
 	return true;
 }
 
@@ -126,18 +264,30 @@ bool BufferPoolManager::FlushPage(PageId page_id) {
     // 2. 存在时如何写回磁盘
     // 3. 写回后页面的脏位
     // Make sure you call DiskManager::WritePage!
-	std::scoped_lock lock{latch_};
-	if(page_id.page_no != INVALID_PAGE_ID){
-		for(size_t i=0;i<pool_size_;i++){
-			if(pages_[i].GetPageId() == page_id){
-				disk_manager_->write_page(page_id.fd,page_id.page_no, pages_[i].GetData(), PAGE_SIZE);
-				pages_[i].is_dirty_ = false;
-				return true;
-			}
-		}
-		return false;
-	}
-	else return false;   
+    if (!instances_.empty()) {
+        return GetInstance(page_id)->FlushPage(page_id);
+    }
+    std::unique_lock lock{latch_};
+    if (page_id.page_no == INVALID_PAGE_ID) {
+        return false;
+    }
+    while (true) {
+        auto it = page_table_.find(page_id);
+        if (it == page_table_.end()) {
+            return false;
+        }
+        Page *page = &pages_[it->second];
+        if (page->io_pending_ || cleaning_pages_.count(page_id)) {  // 页面内容尚未读入, 或后台正在写回
+            io_cv_.wait(lock);
+            continue;
+        }
+        disk_manager_->write_page(page_id.fd, page_id.page_no, page->GetData(), PAGE_SIZE);
+        if (page->IsDirty()) {
+            Count(page_id.fd, &FileCounters::dirty_writes);
+        }
+        page->is_dirty_ = false;
+        return true;
+    }
 }
 
 /**
@@ -153,7 +303,28 @@ Page *BufferPoolManager::NewPage(PageId *page_id) {
     // 3.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
     // 4.   Update P's metadata, zero out memory and add P to the page table. pin_count set to 1.
     // 5.   Set the page ID output parameter. Return a pointer to P.
-	std::scoped_lock lock{latch_};
+    if (!instances_.empty()) {
+        // 分区模式下需要先分配page_no才能确定新页面所属的子缓冲池; 该分区没有可用的帧时换下一个page_no,
+        // 直到每个分区都失败过一次. 之前跳过的page_no回收后会先被分配, 它们可能都属于同一个满的分区.
+        // 没有用上的page_no按分配的逆序归还, 全部失败时文件末尾分配的页面也一并退回
+        std::vector<page_id_t> unused;
+        std::unordered_set<BufferPoolManager *> full_instances;
+        Page *page = nullptr;
+        while (page == nullptr && full_instances.size() < instances_.size()) {
+            page_id->page_no = disk_manager_->AllocatePage(page_id->fd);
+            BufferPoolManager *instance = GetInstance(*page_id);
+            page = full_instances.count(instance) ? nullptr : instance->NewPageWithId(*page_id);
+            if (page == nullptr) {
+                unused.push_back(page_id->page_no);
+                full_instances.insert(instance);
+            }
+        }
+        for (auto it = unused.rbegin(); it != unused.rend(); ++it) {
+            disk_manager_->ReleasePage(page_id->fd, *it);
+        }
+        return page;
+    }
+	std::unique_lock lock{latch_};
 	frame_id_t frame_id = -1;
 
 	if (!FindVictimPage(&frame_id)) {
@@ -161,11 +332,150 @@ Page *BufferPoolManager::NewPage(PageId *page_id) {
     }
 
 	page_id->page_no = disk_manager_->AllocatePage(page_id->fd);
-	Page *page = &pages_[frame_id];
-	UpdatePage(page, *page_id, frame_id);
-	replacer_->Pin(frame_id);
-	page->pin_count_ = 1;
-	return page;
+    return InstallNewPage(lock, *page_id, frame_id);
+}
+
+/**
+ * @brief 在缓冲池中为已分配好page_no的页面创建帧, 供分区模式下的NewPage调用
+ * @param page_id 新页面的id, page_no已经由DiskManager::AllocatePage分配
+ * @return nullptr if all frames are pinned, otherwise pointer to new page
+ */
+Page *BufferPoolManager::NewPageWithId(PageId page_id) {
+    std::unique_lock lock{latch_};
+    frame_id_t frame_id = -1;
+    if (!FindVictimPage(&frame_id)) {
+        return nullptr;
+    }
+    return InstallNewPage(lock, page_id, frame_id);
+}
+
+/**
+ * @brief 把新页面放入victim帧并固定; 如果victim是脏页, 释放latch写回后再重新加锁
+ * @note 新页面内容全为0, 不需要读盘, 因此不设置io_pending_
+ */
+Page *BufferPoolManager::InstallNewPage(std::unique_lock<std::mutex> &lock, PageId page_id, frame_id_t frame_id) {
+    DropStalePage(lock, page_id, frame_id);
+    Page *page = &pages_[frame_id];
+    PageId victim_id = page->GetPageId();
+    AlignedBuffer victim_data = TakeDirtyVictim(page);
+    UpdatePage(page, page_id, frame_id);
+    replacer_->Pin(frame_id);
+    page->pin_count_ = 1;
+    if (victim_data != nullptr) {
+        io_cv_.wait(lock, [&] { return cleaning_pages_.count(victim_id) == 0; });
+        lock.unlock();
+        std::exception_ptr write_error = CallIo([&] {
+            disk_manager_->write_page(victim_id.fd, victim_id.page_no, victim_data.get(), PAGE_SIZE);
+        });
+        lock.lock();
+        writeback_pages_.erase(victim_id);
+        if (write_error != nullptr) {
+            RestoreVictim(page, page_id, frame_id, victim_id, victim_data.get());
+        }
+        io_cv_.notify_all();
+        if (write_error != nullptr) {
+            std::rethrow_exception(write_error);
+        }
+    }
+    return page;
+}
+
+/**
+ * @brief 复用的page_no在回收之后可能又被扫描或预读读入了缓冲池, 旧帧中只有回收标记, 直接丢弃
+ * @param frame_id 已经选好的新帧, 如果它就是旧帧则由UpdatePage替换, 不需要丢弃
+ */
+void BufferPoolManager::DropStalePage(std::unique_lock<std::mutex> &lock, PageId page_id, frame_id_t frame_id) {
+    auto it = page_table_.find(page_id);
+    while (it != page_table_.end() && it->second != frame_id && pages_[it->second].io_pending_) {
+        io_cv_.wait(lock);
+        it = page_table_.find(page_id);
+    }
+    if (it == page_table_.end() || it->second == frame_id) {
+        return;
+    }
+    frame_id_t stale_frame_id = it->second;
+    Page *stale = &pages_[stale_frame_id];
+    assert(stale->pin_count_ == 0);
+    stale->is_dirty_ = false;
+    UpdatePage(stale, PageId{page_id.fd, INVALID_PAGE_ID}, stale_frame_id);
+    replacer_->Pin(stale_frame_id);  // free_list中的帧不能再被replacer选为victim
+    free_list_.push_back(stale_frame_id);
+}
+
+/**
+ * @brief 预读fd中从first_page_no开始的count个连续页面
+ */
+size_t BufferPoolManager::PrefetchPages(int fd, page_id_t first_page_no, int count) {
+    std::vector<page_id_t> page_nos;
+    for (int i = 0; i < count; i++) {
+        page_nos.push_back(first_page_no + i);
+    }
+    return PrefetchPages(fd, page_nos);
+}
+
+/**
+ * @brief 预读指定页面: 在latch内为每个页面分配帧并标记io_pending_, 释放latch后把所有读请求作为一个批次
+ * 提交给异步I/O引擎, 不等待读完成. 读完成时由I/O线程调用FinishPrefetch
+ * @note 预读的页面pin_count_为0, 但读完成之前不在replacer中(free_list中的帧和victim帧都已不在replacer中),
+ * 因此不会被淘汰; 读完成后才加入replacer
+ */
+size_t BufferPoolManager::PrefetchPages(int fd, const std::vector<page_id_t> &page_nos) {
+    if (!instances_.empty()) {
+        std::vector<std::vector<page_id_t>> instance_page_nos(instances_.size());
+        for (page_id_t page_no : page_nos) {
+            instance_page_nos[PageIdHash()(PageId{fd, page_no}) % instances_.size()].push_back(page_no);
+        }
+        size_t num_prefetched = 0;
+        for (size_t i = 0; i < instances_.size(); i++) {
+            if (!instance_page_nos[i].empty()) {
+                num_prefetched += instances_[i]->PrefetchPages(fd, instance_page_nos[i]);
+            }
+        }
+        return num_prefetched;
+    }
+    std::vector<IoRequest> requests;
+    {
+        std::scoped_lock lock{latch_};
+        for (page_id_t page_no : page_nos) {
+            PageId page_id = {.fd = fd, .page_no = page_no};
+            if (page_table_.count(page_id) || writeback_pages_.count(page_id)) {
+                continue;
+            }
+            frame_id_t frame_id = -1;
+            if (!FindCleanVictimPage(&frame_id)) {
+                break;
+            }
+            Page *page = &pages_[frame_id];
+            UpdatePage(page, page_id, frame_id);  // victim是干净的, 不会写盘
+            page->io_pending_ = true;
+            requests.push_back({IoOp::READ, fd, page_no, page->data_, PAGE_SIZE,
+                                [this, frame_id](int err) { FinishPrefetch(frame_id, err); }});
+        }
+    }
+    // 回调需要获取latch, 因此必须在释放latch之后提交; 不需要等待返回的future
+    size_t num_prefetched = requests.size();
+    if (num_prefetched > 0) {
+        disk_manager_->submit_io(std::move(requests));
+    }
+    return num_prefetched;
+}
+
+/**
+ * @brief 预读完成: 清除io_pending_, 页面可以被访问和淘汰; 读失败时把帧放回free_list
+ * @param err 0表示成功, 否则为errno
+ */
+void BufferPoolManager::FinishPrefetch(frame_id_t frame_id, int err) {
+    std::scoped_lock lock{latch_};
+    Page *page = &pages_[frame_id];
+    page->io_pending_ = false;
+    if (err != 0) {
+        page_table_.erase(page->GetPageId());
+        page->id_.page_no = INVALID_PAGE_ID;
+        free_list_.push_back(frame_id);
+    } else if (page->pin_count_ == 0) {
+        replacer_->Unpin(frame_id);
+    }
+    io_cv_.notify_all();
 }
 
 /**
@@ -182,21 +492,31 @@ bool BufferPoolManager::DeletePage(PageId page_id) {
     // 2.2  If P exists, but has a non-zero pin-count, return false. Someone is using the page.
     // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free
     // list.
-	std::scoped_lock lock{latch_};
+    if (!instances_.empty()) {
+        return GetInstance(page_id)->DeletePage(page_id);
+    }
+	std::unique_lock lock{latch_};
 	std::unordered_map<PageId, frame_id_t, PageIdHash>::iterator it = page_table_.find(page_id);
+    while ((it != page_table_.end() && (pages_[it->second].io_pending_ || cleaning_pages_.count(page_id))) ||
+           writeback_pages_.count(page_id)) {
+        // 等待预读或写回完成, 否则写回的旧数据会覆盖回收后的页面
+        io_cv_.wait(lock);
+        it = page_table_.find(page_id);
+    }
 	if(it != page_table_.end()){
 		frame_id_t frame_id = it->second; 
 		Page *page = &pages_[frame_id];
 		if(page->pin_count_ > 0)
 			return false;
-		disk_manager_->DeallocatePage(page_id.page_no);
-		page_id.page_no =  INVALID_PAGE_ID;
-		UpdatePage(page, page_id, frame_id);
+		page->is_dirty_ = false;  // 页面即将被回收, 不需要写回
+		UpdatePage(page, PageId{page_id.fd, INVALID_PAGE_ID}, frame_id);
+		replacer_->Pin(frame_id);  // free_list中的帧不能再被replacer选为victim
 		free_list_.push_back(frame_id);
-		return true;
 	}
-    else
-		return true;
+	lock.unlock();
+	// 页面已不在缓冲池中, 在latch之外写回收标记, 之后AllocatePage才可能复用该页面
+	disk_manager_->DeallocatePage(page_id.fd, page_id.page_no);
+	return true;
 }
 
 /**
@@ -205,13 +525,336 @@ bool BufferPoolManager::DeletePage(PageId page_id) {
  * @param fd 指定的diskfile open句柄
  */
 void BufferPoolManager::FlushAllPages(int fd) {
+    if (!instances_.empty()) {
+        for (auto &instance : instances_) {
+            instance->FlushAllPages(fd);
+        }
+        return;
+    }
     // example for disk write
-    std::scoped_lock lock{latch_};
+    std::unique_lock lock{latch_};
+    // 等待该文件上所有在途的写回和读取完成
+    io_cv_.wait(lock, [this, fd] {
+        for (auto &page_id : writeback_pages_) {
+            if (page_id.fd == fd) {
+                return false;
+            }
+        }
+        for (auto &page_id : cleaning_pages_) {
+            if (page_id.fd == fd) {
+                return false;
+            }
+        }
+        for (size_t i = 0; i < pool_size_; i++) {
+            if (pages_[i].io_pending_ && pages_[i].GetPageId().fd == fd) {
+                return false;
+            }
+        }
+        return true;
+    });
+    // 固定所有页面(写回期间不会被淘汰)并清除脏位, 释放latch后作为一个批次提交给异步I/O引擎.
+    // 不能持有latch等待引擎: 预读的完成回调需要获取latch
+    std::vector<frame_id_t> flush_frames;
+    std::vector<IoRequest> requests;
     for (size_t i = 0; i < pool_size_; i++) {
         Page *page = &pages_[i];
         if (page->GetPageId().fd == fd && page->GetPageId().page_no != INVALID_PAGE_ID) {
-            disk_manager_->write_page(page->GetPageId().fd, page->GetPageId().page_no, page->GetData(), PAGE_SIZE);
-            page->is_dirty_ = false;
+            replacer_->Pin(i);
+            page->pin_count_++;
+            if (page->IsDirty()) {
+                Count(fd, &FileCounters::dirty_writes);
+            }
+            page->is_dirty_ = false;  // 写回期间再次被修改的页面会在unpin时重新置脏
+            flush_frames.push_back(i);
+            requests.push_back({IoOp::WRITE, fd, page->GetPageId().page_no, page->GetData(), PAGE_SIZE, nullptr});
+        }
+    }
+    lock.unlock();
+    std::vector<std::future<void>> futures = disk_manager_->submit_io(std::move(requests));
+    std::vector<std::exception_ptr> errors;
+    for (auto &future : futures) {
+        errors.push_back(CallIo([&] { future.get(); }));
+    }
+
+    lock.lock();
+    std::exception_ptr first_error = nullptr;
+    for (size_t i = 0; i < flush_frames.size(); i++) {
+        Page *page = &pages_[flush_frames[i]];
+        if (errors[i] != nullptr) {
+            page->is_dirty_ = true;
+            first_error = first_error != nullptr ? first_error : errors[i];
+        }
+        if (--page->pin_count_ == 0) {
+            replacer_->Unpin(flush_frames[i]);
+        }
+    }
+    if (first_error != nullptr) {
+        std::rethrow_exception(first_error);
+    }
+}
+
+/**
+ * @brief 更换页面替换策略, 只能在缓冲池中还没有页面时调用(如服务启动时)
+ */
+void BufferPoolManager::ResetReplacer(const std::string &replacer_type) {
+    if (!instances_.empty()) {
+        for (auto &instance : instances_) {
+            instance->ResetReplacer(replacer_type);
+        }
+        return;
+    }
+    std::scoped_lock lock{latch_};
+    if (!page_table_.empty()) {
+        throw InternalError("BufferPoolManager::ResetReplacer: buffer pool is in use");
+    }
+    Replacer *replacer = CreateReplacer(replacer_type, pool_size_);
+    if (replacer == nullptr) {
+        throw InternalError("BufferPoolManager::ResetReplacer: unknown replacer type " + replacer_type);
+    }
+    delete replacer_;
+    replacer_ = replacer;
+}
+
+Replacer *BufferPoolManager::CreateReplacer(const std::string &replacer_type, size_t num_pages) {
+    if (replacer_type == "LRU") {
+        return new LRUReplacer(num_pages);
+    }
+    if (replacer_type == "CLOCK") {
+        return new ClockReplacer(num_pages);
+    }
+    if (replacer_type == "ATOMIC-CLOCK") {
+        return new AtomicClockReplacer(num_pages);
+    }
+    if (replacer_type == "LRU-K") {
+        return new LRUKReplacer(num_pages);
+    }
+    return nullptr;
+}
+
+/**
+ * @brief 启动后台页面清理线程, 重复调用无效
+ */
+void BufferPoolManager::StartPageCleaner(double clean_ratio, std::chrono::milliseconds interval) {
+    std::scoped_lock lock{cleaner_latch_};
+    if (page_cleaner_.joinable()) {
+        return;
+    }
+    cleaner_stop_ = false;
+    page_cleaner_ = std::thread(&BufferPoolManager::PageCleanerLoop, this, clean_ratio, interval);
+}
+
+void BufferPoolManager::StopPageCleaner() {
+    {
+        std::scoped_lock lock{cleaner_latch_};
+        if (!page_cleaner_.joinable()) {
+            return;
+        }
+        cleaner_stop_ = true;
+    }
+    cleaner_cv_.notify_all();
+    page_cleaner_.join();
+}
+
+void BufferPoolManager::PageCleanerLoop(double clean_ratio, std::chrono::milliseconds interval) {
+    std::unique_lock lock{cleaner_latch_};
+    while (!cleaner_stop_) {
+        lock.unlock();
+        size_t num_cleaned = CleanPages(clean_ratio);
+        lock.lock();
+        // 本轮有进展时立即再检查一次, 否则休眠到下一个周期
+        if (num_cleaned == 0) {
+            cleaner_cv_.wait_for(lock, interval, [this] { return cleaner_stop_; });
+        }
+    }
+}
+
+/**
+ * @brief 后台清理一轮: 从各个(子)缓冲池挑选即将被淘汰的脏页, 把同一文件中page_no相邻的页面合并成一个写请求,
+ * 作为一个批次提交给异步I/O引擎
+ * @note 分区模式下相邻页面属于不同的子缓冲池, 因此在路由对象中统一合并
+ * @return 写回的页面数, 写回失败的页面会重新置脏, 不计入
+ */
+size_t BufferPoolManager::CleanPages(double clean_ratio) {
+    std::vector<CleaningPage> pages;
+    if (!instances_.empty()) {
+        for (auto &instance : instances_) {
+            instance->CollectPagesToClean(clean_ratio, &pages);
         }
+    } else {
+        CollectPagesToClean(clean_ratio, &pages);
+    }
+    if (pages.empty()) {
+        return 0;
+    }
+    std::sort(pages.begin(), pages.end(), [](const CleaningPage &a, const CleaningPage &b) {
+        return a.page_id.fd != b.page_id.fd ? a.page_id.fd < b.page_id.fd : a.page_id.page_no < b.page_id.page_no;
+    });
+
+    // 合并相邻页面: run_starts[i]为第i个写请求的第一个页面在pages中的下标
+    std::vector<size_t> run_starts;
+    for (size_t i = 0; i < pages.size(); i++) {
+        if (i == 0 || pages[i].page_id.fd != pages[i - 1].page_id.fd ||
+            pages[i].page_id.page_no != pages[i - 1].page_id.page_no + 1 ||
+            i - run_starts.back() >= PAGE_CLEANER_MAX_RUN) {
+            run_starts.push_back(i);
+        }
+    }
+    run_starts.push_back(pages.size());
+    std::vector<AlignedBuffer> buffers;
+    std::vector<IoRequest> requests;
+    for (size_t r = 0; r + 1 < run_starts.size(); r++) {
+        size_t num_pages = run_starts[r + 1] - run_starts[r];
+        char *buf = pages[run_starts[r]].data.get();
+        if (num_pages > 1) {
+            buffers.push_back(DiskManager::AllocateAlignedBuffer(num_pages * PAGE_SIZE));
+            buf = buffers.back().get();
+            for (size_t i = 0; i < num_pages; i++) {
+                memcpy(buf + i * PAGE_SIZE, pages[run_starts[r] + i].data.get(), PAGE_SIZE);
+            }
+        }
+        const PageId &first = pages[run_starts[r]].page_id;
+        requests.push_back({IoOp::WRITE, first.fd, first.page_no, buf, static_cast<int>(num_pages * PAGE_SIZE), nullptr});
+    }
+    std::vector<std::future<void>> futures = disk_manager_->submit_io(std::move(requests));
+
+    size_t num_cleaned = 0;
+    for (size_t r = 0; r + 1 < run_starts.size(); r++) {
+        bool success = CallIo([&] { futures[r].get(); }) == nullptr;
+        for (size_t i = run_starts[r]; i < run_starts[r + 1]; i++) {
+            pages[i].owner->FinishCleaning(pages[i], success);
+        }
+        if (success) {
+            num_cleaned += run_starts[r + 1] - run_starts[r];
+            pages[run_starts[r]].owner->write_batches_++;
+        }
+    }
+    return num_cleaned;
+}
+
+/**
+ * @brief 在latch内挑选需要清理的页面: 按replacer的淘汰顺序查看前clean_ratio比例的victim候选
+ * (free_list中的帧算作干净的候选), 其中的脏页拷贝出来并清除脏位
+ * @note 未被固定的页面不会被修改, 因此拷贝是一致的. 写回期间页面记录在cleaning_pages_中, 仍可以被访问,
+ * 再次修改后重新置脏即可. page LSN大于已持久化LSN的页面暂不写回(WAL)
+ */
+void BufferPoolManager::CollectPagesToClean(double clean_ratio, std::vector<CleaningPage> *pages) {
+    std::scoped_lock lock{latch_};
+    size_t num_candidates = free_list_.size() + replacer_->Size();
+    size_t window = static_cast<size_t>(clean_ratio * num_candidates);
+    if (window <= free_list_.size()) {
+        return;
+    }
+    lsn_t persistent_lsn = persistent_lsn_source_ ? persistent_lsn_source_() : INVALID_LSN;
+    for (frame_id_t frame_id : replacer_->PeekVictims(window - free_list_.size())) {
+        Page *page = &pages_[frame_id];
+        if (!page->IsDirty() || page->pin_count_ > 0 || page->io_pending_ || cleaning_pages_.count(page->GetPageId()) ||
+            (persistent_lsn_source_ && page->GetPageLsn() > persistent_lsn)) {
+            continue;
+        }
+        AlignedBuffer data = DiskManager::AllocateAlignedBuffer(PAGE_SIZE);
+        memcpy(data.get(), page->GetData(), PAGE_SIZE);
+        page->is_dirty_ = false;
+        cleaning_pages_.insert(page->GetPageId());
+        pages->push_back({this, frame_id, page->GetPageId(), std::move(data)});
+    }
+}
+
+/**
+ * @brief 清理的写回完成: 成功时标记页面已被清理, 失败时重新置脏
+ * @note 写回期间页面可能已被淘汰(淘汰者会等待写回完成后自己再写一次), 帧中可能已经是其他页面
+ */
+void BufferPoolManager::FinishCleaning(const CleaningPage &page, bool success) {
+    std::scoped_lock lock{latch_};
+    cleaning_pages_.erase(page.page_id);
+    Page *frame = &pages_[page.frame_id];
+    if (frame->GetPageId() == page.page_id) {
+        if (!success) {
+            frame->is_dirty_ = true;
+        } else if (!frame->IsDirty()) {
+            frame->cleaned_ = true;
+        }
+    }
+    if (success) {
+        pages_cleaned_++;
+        Count(page.page_id.fd, &FileCounters::dirty_writes);
+    }
+    io_cv_.notify_all();
+}
+
+void BufferPoolManager::SetPersistentLsnSource(std::function<lsn_t()> persistent_lsn_source) {
+    for (auto &instance : instances_) {
+        instance->SetPersistentLsnSource(persistent_lsn_source);
+    }
+    std::scoped_lock lock{latch_};
+    persistent_lsn_source_ = std::move(persistent_lsn_source);
+}
+
+PageCleanerStats BufferPoolManager::GetPageCleanerStats() {
+    PageCleanerStats stats;
+    for (auto &instance : instances_) {
+        PageCleanerStats instance_stats = instance->GetPageCleanerStats();
+        stats.pages_cleaned += instance_stats.pages_cleaned;
+        stats.write_batches += instance_stats.write_batches;
+        stats.stalls_avoided += instance_stats.stalls_avoided;
+        stats.dirty_evictions += instance_stats.dirty_evictions;
+    }
+    stats.pages_cleaned += pages_cleaned_;
+    stats.write_batches += write_batches_;
+    stats.stalls_avoided += stalls_avoided_;
+    stats.dirty_evictions += dirty_evictions_;
+    return stats;
+}
+
+/**
+ * @brief FetchPage等待过其他线程在该页面上的I/O时, 记录一次等待及其时长
+ * @param wait_start 第一次等待开始的时刻, 没有等待时为空
+ */
+void BufferPoolManager::RecordPinWait(int fd, std::optional<std::chrono::steady_clock::time_point> wait_start) {
+    if (!wait_start.has_value()) {
+        return;
+    }
+    auto wait_us =
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - *wait_start).count();
+    Count(fd, &FileCounters::pin_waits);
+    Count(fd, &FileCounters::pin_wait_us, static_cast<size_t>(wait_us));
+}
+
+BufferPoolStats BufferPoolManager::GetBufferPoolStats(int fd) {
+    BufferPoolStats stats;
+    for (auto &instance : instances_) {
+        stats += instance->GetBufferPoolStats(fd);
+    }
+    if (file_counters_ != nullptr && fd >= 0 && fd < DiskManager::MAX_FD) {
+        const FileCounters &counters = file_counters_[fd];
+        stats.hits += counters.hits.load(std::memory_order_relaxed);
+        stats.misses += counters.misses.load(std::memory_order_relaxed);
+        stats.evictions += counters.evictions.load(std::memory_order_relaxed);
+        stats.dirty_writes += counters.dirty_writes.load(std::memory_order_relaxed);
+        stats.pin_waits += counters.pin_waits.load(std::memory_order_relaxed);
+        stats.pin_wait_us += counters.pin_wait_us.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+BufferPoolStats BufferPoolManager::GetBufferPoolStats() {
+    BufferPoolStats stats;
+    for (int fd = 0; fd < DiskManager::MAX_FD; fd++) {
+        stats += GetBufferPoolStats(fd);
+    }
+    return stats;
+}
+
+void BufferPoolManager::ResetBufferPoolStats(int fd) {
+    for (auto &instance : instances_) {
+        instance->ResetBufferPoolStats(fd);
+    }
+    if (file_counters_ != nullptr && fd >= 0 && fd < DiskManager::MAX_FD) {
+        FileCounters &counters = file_counters_[fd];
+        counters.hits = 0;
+        counters.misses = 0;
+        counters.evictions = 0;
+        counters.dirty_writes = 0;
+        counters.pin_waits = 0;
+        counters.pin_wait_us = 0;
     }
 }
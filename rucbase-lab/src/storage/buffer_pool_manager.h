@@ -26,19 +26,65 @@
 #include <fcntl.h>
 #include <unistd.h>
 
+#include <atomic>
 #include <cassert>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <functional>
 #include <list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "common/logger.h"  // for debug
 #include "disk_manager.h"
 #include "errors.h"
+#include "frame_arena.h"
 #include "page.h"
+#include "replacer/atomic_clock_replacer.h"
 #include "replacer/clock_replacer.h"
+#include "replacer/lru_k_replacer.h"
 #include "replacer/lru_replacer.h"
 #include "replacer/replacer.h"
 
+/**
+ * @brief 后台页面清理线程的统计信息
+ */
+struct PageCleanerStats {
+    size_t pages_cleaned = 0;    // 后台线程写回的页面数
+    size_t write_batches = 0;    // 后台线程提交的写请求数, 相邻页面合并为一个写请求
+    size_t stalls_avoided = 0;   // 淘汰时victim已被后台线程写回, 前台省去的同步写次数
+    size_t dirty_evictions = 0;  // 淘汰时victim仍是脏页, 前台需要同步写回的次数
+};
+
+/**
+ * @brief 缓冲池中一个文件(或所有文件之和)的访问统计
+ */
+struct BufferPoolStats {
+    size_t hits = 0;          // FetchPage时页面已在缓冲池中(包括正在预读的页面)
+    size_t misses = 0;        // FetchPage时需要从磁盘读入页面
+    size_t evictions = 0;     // 页面被淘汰出缓冲池的次数
+    size_t dirty_writes = 0;  // 脏页写回磁盘的次数, 包括淘汰、刷盘和后台清理
+    size_t pin_waits = 0;     // FetchPage等待该页面上其他I/O(预读或淘汰写回)完成的次数
+    size_t pin_wait_us = 0;   // 上述等待的总时间(微秒)
+
+    double HitRatio() const { return hits + misses == 0 ? 0 : static_cast<double>(hits) / (hits + misses); }
+
+    BufferPoolStats &operator+=(const BufferPoolStats &other) {
+        hits += other.hits;
+        misses += other.misses;
+        evictions += other.evictions;
+        dirty_writes += other.dirty_writes;
+        pin_waits += other.pin_waits;
+        pin_wait_us += other.pin_wait_us;
+        return *this;
+    }
+};
+
 class BufferPoolManager {
    private:
     /**
@@ -47,9 +93,12 @@ class BufferPoolManager {
     size_t pool_size_;
     /**
      * @brief BufferPool中的Page对象数组(指针)
-     * @note 在构造函数中申请内存空间,折构函数中释放,大小为BUFFER_POOL_SIZE
+     * @note 在构造函数中申请内存空间,折构函数中释放,大小为BUFFER_POOL_SIZE.
+     * Page对象只保存帧的元数据, 第i帧的页面数据位于frames_->GetFrame(i)
      */
     Page *pages_;
+    /** 所有帧的页面数据, 可以使用大页映射 */
+    std::unique_ptr<FrameArena> frames_;
     /**
      * @brief 以自定义PageIdHash为哈希函数的<PageId,frame_id_t>哈希表.
      * @note 用于根据PageId定位其在BufferPool中的frame_id_t
@@ -71,17 +120,82 @@ class BufferPoolManager {
     /** This latch protects shared data structures */
     std::mutex latch_;
 
+    /**
+     * @brief 淘汰脏页的写回和缺页读取都在释放latch之后执行, I/O期间其他线程可以继续访问缓冲池
+     * @note writeback_pages_记录已被淘汰但尚未写回磁盘的页面, 在写回完成前不能重新读入;
+     * 正在读入的页面则由Page::io_pending_标记. 两者完成时都会通知io_cv_
+     */
+    std::unordered_set<PageId, PageIdHash> writeback_pages_;
+    std::condition_variable io_cv_;
+
+    /**
+     * @brief 后台清理线程正在写回的页面, 它们仍在缓冲池中且可以被访问
+     * @note 写回完成前FlushPage和DeletePage需要等待; 此时被淘汰的页面由前台等待写回完成后再写一次,
+     * 因为后台写回可能失败
+     */
+    std::unordered_set<PageId, PageIdHash> cleaning_pages_;
+    std::function<lsn_t()> persistent_lsn_source_;  // 返回已持久化的最大LSN, 为空时不检查WAL
+
+    std::atomic<size_t> pages_cleaned_{0};
+    std::atomic<size_t> write_batches_{0};
+    std::atomic<size_t> stalls_avoided_{0};
+    std::atomic<size_t> dirty_evictions_{0};
+
+    /**
+     * @brief 每个文件的访问计数器, 下标为fd
+     * @note 每个子缓冲池各有一份, 不同分区之间不争用同一缓存行; 计数只做relaxed原子加, 读取时不需要latch
+     */
+    struct FileCounters {
+        std::atomic<size_t> hits{0};
+        std::atomic<size_t> misses{0};
+        std::atomic<size_t> evictions{0};
+        std::atomic<size_t> dirty_writes{0};
+        std::atomic<size_t> pin_waits{0};
+        std::atomic<size_t> pin_wait_us{0};
+    };
+    std::unique_ptr<FileCounters[]> file_counters_;
+
+    /** 后台清理线程, 分区模式下只有路由对象启动一个线程, 依次清理各个子缓冲池 */
+    std::thread page_cleaner_;
+    std::mutex cleaner_latch_;  // 保护cleaner_stop_
+    std::condition_variable cleaner_cv_;
+    bool cleaner_stop_ = false;
+
+    /**
+     * @brief 分区模式下的子缓冲池
+     * @note 非空时本对象只做路由: 每个PageId按PageIdHash固定映射到其中一个子缓冲池,
+     * 子缓冲池各自拥有page table, free list, replacer和latch, 互不争用
+     */
+    std::vector<std::unique_ptr<BufferPoolManager>> instances_;
+
    public:
-    BufferPoolManager(size_t pool_size, DiskManager *disk_manager)
-        : pool_size_(pool_size), disk_manager_(disk_manager) {
+    /**
+     * @param pool_size 缓冲池的总帧数
+     * @param num_instances 分区个数, 大于1时启用分区模式, pool_size平均分配给各个子缓冲池
+     * @param replacer_type 页面替换策略, "LRU", "CLOCK", "ATOMIC-CLOCK"或"LRU-K", 无法识别时使用LRU
+     * @param huge_pages 帧数据是否使用大页映射, 见FrameArena
+     */
+    BufferPoolManager(size_t pool_size, DiskManager *disk_manager, size_t num_instances = 1,
+                      const std::string &replacer_type = REPLACER_TYPE, bool huge_pages = BUFFER_POOL_HUGE_PAGES)
+        : pool_size_(pool_size), pages_(nullptr), disk_manager_(disk_manager), replacer_(nullptr) {
+        if (num_instances > 1) {
+            for (size_t i = 0; i < num_instances; ++i) {
+                size_t instance_size = pool_size_ / num_instances + (i < pool_size_ % num_instances ? 1 : 0);
+                instances_.emplace_back(
+                    std::make_unique<BufferPoolManager>(instance_size, disk_manager_, 1, replacer_type, huge_pages));
+            }
+            return;
+        }
         // We allocate a consecutive memory space for the buffer pool.
+        // 页面数据和元数据分开存放: 数据按4KB对齐放在FrameArena中, 元数据是紧凑的Page数组
+        frames_ = std::make_unique<FrameArena>(pool_size_, huge_pages, BUFFER_POOL_NUMA_INTERLEAVE);
+        file_counters_ = std::make_unique<FileCounters[]>(DiskManager::MAX_FD);
         pages_ = new Page[pool_size_];
-        // can be changed to ClockReplacer
-        if (REPLACER_TYPE.compare("LRU"))
-            replacer_ = new LRUReplacer(pool_size_);
-        else if (REPLACER_TYPE.compare("CLOCK"))
-            replacer_ = new LRUReplacer(pool_size_);
-        else {
+        for (size_t i = 0; i < pool_size_; ++i) {
+            pages_[i].data_ = frames_->GetFrame(static_cast<frame_id_t>(i));
+        }
+        replacer_ = CreateReplacer(replacer_type, pool_size_);
+        if (replacer_ == nullptr) {
             LOG_WARN("BufferPoolManager Replacer type defined wrong, use LRU as replacer.\n");
             replacer_ = new LRUReplacer(pool_size_);
         }
@@ -96,6 +210,14 @@ class BufferPoolManager {
      *
      */
     ~BufferPoolManager() {
+        StopPageCleaner();
+        {
+            // 在途预读的完成回调会访问本对象
+            std::unique_lock lock{latch_};
+            for (size_t i = 0; pages_ != nullptr && i < pool_size_; i++) {
+                io_cv_.wait(lock, [this, i] { return !pages_[i].io_pending_; });
+            }
+        }
         delete[] pages_;
         delete replacer_;
     }
@@ -142,8 +264,127 @@ class BufferPoolManager {
      */
     void FlushAllPages(int fd);
 
+    /**
+     * Asynchronously reads pages [first_page_no, first_page_no + count) of fd into the buffer pool without pinning
+     * them. A later FetchPage of a prefetched page waits for the read instead of issuing its own.
+     * @return the number of pages whose reads were issued
+     */
+    size_t PrefetchPages(int fd, page_id_t first_page_no, int count);
+
+    /**
+     * Asynchronously reads the given pages of fd into the buffer pool without pinning them.
+     * Pages already in the buffer pool are skipped. Prefetching never evicts dirty pages: it stops early when
+     * there is no free frame and the next victim is dirty.
+     * @return the number of pages whose reads were issued
+     */
+    size_t PrefetchPages(int fd, const std::vector<page_id_t> &page_nos);
+
+    /**
+     * Replaces the replacement policy, e.g. with the one given on the server command line.
+     * @throws InternalError if replacer_type is unknown or some page is still in the buffer pool
+     */
+    void ResetReplacer(const std::string &replacer_type);
+
+    /**
+     * @return a new replacer of the given type ("LRU", "CLOCK", "ATOMIC-CLOCK" or "LRU-K") for num_pages frames,
+     * nullptr if the type is unknown
+     */
+    static Replacer *CreateReplacer(const std::string &replacer_type, size_t num_pages);
+
+    /**
+     * Starts the background page cleaner. It wakes up every interval and writes back the dirty pages among the
+     * next victims of the replacer, so that at least clean_ratio of the victim candidates (free frames and frames
+     * in the replacer), taken in eviction order, are clean.
+     */
+    void StartPageCleaner(double clean_ratio = PAGE_CLEANER_CLEAN_RATIO,
+                          std::chrono::milliseconds interval = std::chrono::milliseconds(PAGE_CLEANER_INTERVAL_MS));
+
+    /** Stops the background page cleaner and waits for its in-flight writes. */
+    void StopPageCleaner();
+
+    /**
+     * Runs one pass of the page cleaner in the calling thread.
+     * @return the number of pages written back
+     */
+    size_t CleanPages(double clean_ratio);
+
+    /**
+     * Sets the source of the largest LSN that is durable in the log. The page cleaner never writes a page whose
+     * page LSN is larger, so that the log record of every change reaches disk before the page itself (WAL).
+     */
+    void SetPersistentLsnSource(std::function<lsn_t()> persistent_lsn_source);
+
+    /** @return page cleaner counters, summed over all partitions */
+    PageCleanerStats GetPageCleanerStats();
+
+    /** @return access counters of the file fd, summed over all partitions */
+    BufferPoolStats GetBufferPoolStats(int fd);
+
+    /** @return access counters summed over all files and partitions */
+    BufferPoolStats GetBufferPoolStats();
+
+    /** Clears the counters of fd, called when a file is opened since file descriptors are reused */
+    void ResetBufferPoolStats(int fd);
+
+    /** @return the kind of pages backing the frame data, that of the first partition in partitioned mode */
+    FrameArena::Backing GetFrameBacking() const {
+        return instances_.empty() ? frames_->GetBacking() : instances_[0]->GetFrameBacking();
+    }
+
+    /** @return the total number of frames of all partitions */
+    size_t GetPoolSize() const { return pool_size_; }
+
+    /** @return the number of partitions, 1 if the buffer pool is not partitioned */
+    size_t GetNumInstances() const { return instances_.empty() ? 1 : instances_.size(); }
+
    private:
+    /** @return the partition that owns page_id, only valid in partitioned mode */
+    BufferPoolManager *GetInstance(const PageId &page_id) {
+        return instances_[PageIdHash()(page_id) % instances_.size()].get();
+    }
+
+    /**
+     * Creates a page whose page_no has already been allocated by DiskManager.
+     * Used by the partitioned NewPage, which must know the page_no before it can pick a partition.
+     */
+    Page *NewPageWithId(PageId page_id);
+
     bool FindVictimPage(frame_id_t *frame_id);
 
+    bool FindCleanVictimPage(frame_id_t *frame_id);
+
+    void FinishPrefetch(frame_id_t frame_id, int err);
+
+    AlignedBuffer TakeDirtyVictim(Page *page);
+
+    Page *InstallNewPage(std::unique_lock<std::mutex> &lock, PageId page_id, frame_id_t frame_id);
+
+    void DropStalePage(std::unique_lock<std::mutex> &lock, PageId page_id, frame_id_t frame_id);
+
+    void RestoreVictim(Page *page, PageId page_id, frame_id_t frame_id, PageId victim_id, const char *victim_data);
+
     void UpdatePage(Page *page, PageId new_page_id, frame_id_t new_frame_id);
+
+    void RecordPinWait(int fd, std::optional<std::chrono::steady_clock::time_point> wait_start);
+
+    /** @brief 文件fd的计数器加n, fd超出范围时忽略 */
+    void Count(int fd, std::atomic<size_t> FileCounters::*counter, size_t n = 1) {
+        if (fd >= 0 && fd < DiskManager::MAX_FD) {
+            (file_counters_[fd].*counter).fetch_add(n, std::memory_order_relaxed);
+        }
+    }
+
+    /** 后台清理线程选中的一个页面: 在owner的latch内拷贝出的数据, 写回完成后交还给owner */
+    struct CleaningPage {
+        BufferPoolManager *owner;
+        frame_id_t frame_id;
+        PageId page_id;
+        AlignedBuffer data;
+    };
+
+    void CollectPagesToClean(double clean_ratio, std::vector<CleaningPage> *pages);
+
+    void FinishCleaning(const CleaningPage &page, bool success);
+
+    void PageCleanerLoop(double clean_ratio, std::chrono::milliseconds interval);
 };
\ No newline at end of file
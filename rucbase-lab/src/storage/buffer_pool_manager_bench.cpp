@@ -0,0 +1,279 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Rucbase
+//
+// buffer_pool_manager_bench.cpp
+//
+// Identification: src/storage/buffer_pool_manager_bench.cpp
+//
+// Copyright (c) 2022, RUC Deke Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <fcntl.h>     // for posix_fadvise
+#include <sys/mman.h>  // for mincore
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+const std::string TEST_DB_NAME = "BufferPoolManagerBench_db";  // 以TEST_DB_NAME作为存放测试文件的根目录名
+
+class BufferPoolManagerBench : public ::testing::Test {
+   public:
+    std::unique_ptr<DiskManager> disk_manager_;
+
+   public:
+    void SetUp() override {
+        ::testing::Test::SetUp();
+        disk_manager_ = std::make_unique<DiskManager>();
+        if (disk_manager_->is_dir(TEST_DB_NAME)) {
+            disk_manager_->destroy_dir(TEST_DB_NAME);
+        }
+        disk_manager_->create_dir(TEST_DB_NAME);
+        assert(disk_manager_->is_dir(TEST_DB_NAME));
+        if (chdir(TEST_DB_NAME.c_str()) < 0) {
+            throw UnixError();
+        }
+    }
+
+    void TearDown() override {
+        if (chdir("..") < 0) {
+            throw UnixError();
+        }
+        assert(disk_manager_->is_dir(TEST_DB_NAME));
+    };
+
+    /**
+     * @brief 在fd对应的文件中写入num_pages个页面, 每页开头存放自己的page_no
+     */
+    void fill_file(int fd, int num_pages) {
+        char buf[PAGE_SIZE] = {0};
+        for (int page_no = 0; page_no < num_pages; page_no++) {
+            *reinterpret_cast<int *>(buf) = page_no;
+            disk_manager_->write_page(fd, page_no, buf, PAGE_SIZE);
+        }
+        disk_manager_->set_fd2pageno(fd, num_pages);
+    }
+
+    /**
+     * @brief num_threads个线程并发地随机FetchPage/UnpinPage, 返回每秒完成的操作数
+     * @param is_dirty UnpinPage时是否置脏, 置脏时被淘汰的页面都需要写回
+     */
+    double run_fetch_unpin(BufferPoolManager *bpm, int fd, int num_threads, int working_set, int ops_per_thread,
+                           bool is_dirty) {
+        std::vector<std::thread> threads;
+        auto start = std::chrono::steady_clock::now();
+        for (int tid = 0; tid < num_threads; tid++) {
+            threads.emplace_back([bpm, fd, tid, working_set, ops_per_thread, is_dirty]() {
+                std::mt19937 rng(tid);
+                std::uniform_int_distribution<int> dist(0, working_set - 1);
+                for (int i = 0; i < ops_per_thread; i++) {
+                    PageId page_id = {.fd = fd, .page_no = dist(rng)};
+                    Page *page = bpm->FetchPage(page_id);
+                    while (page == nullptr) {
+                        page = bpm->FetchPage(page_id);
+                    }
+                    EXPECT_EQ(page_id.page_no, *reinterpret_cast<int *>(page->GetData()));
+                    bpm->UnpinPage(page_id, is_dirty);
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return num_threads * ops_per_thread / elapsed.count();
+    }
+
+    void run_scaling(const std::string &title, int pool_size, int working_set, int ops_per_thread,
+                     bool is_dirty = false) {
+        const std::string filename = "bench_" + std::to_string(working_set);
+        disk_manager_->create_file(filename);
+        int fd = disk_manager_->open_file(filename);
+        fill_file(fd, working_set);
+
+        const std::vector<size_t> instance_counts = {1, 16};
+        printf("%s (pool_size=%d, working_set=%d pages)\n", title.c_str(), pool_size, working_set);
+        printf("%8s %18s %18s %10s\n", "threads", "1 instance ops/s", "16 instances ops/s", "speedup");
+        for (int num_threads = 1; num_threads <= 32; num_threads *= 2) {
+            std::vector<double> results;
+            for (size_t num_instances : instance_counts) {
+                BufferPoolManager bpm(pool_size, disk_manager_.get(), num_instances);
+                results.push_back(run_fetch_unpin(&bpm, fd, num_threads, working_set, ops_per_thread, is_dirty));
+            }
+            printf("%8d %18.0f %18.0f %9.2fx\n", num_threads, results[0], results[1], results[1] / results[0]);
+        }
+        disk_manager_->close_file(fd);
+    }
+
+    void run_page_cleaner(const std::string &title, int pool_size, int working_set, int ops_per_thread) {
+        const std::string filename = "cleaner_" + std::to_string(working_set);
+        disk_manager_->create_file(filename);
+        int fd = disk_manager_->open_file(filename);
+        fill_file(fd, working_set);
+
+        printf("%s (pool_size=%d, working_set=%d pages, %zu instances)\n", title.c_str(), pool_size, working_set,
+               static_cast<size_t>(BUFFER_POOL_INSTANCES));
+        printf("%8s %8s %12s %14s %14s %16s %16s\n", "threads", "cleaner", "ops/s", "pages cleaned", "write batches",
+               "stalls avoided", "dirty evictions");
+        for (int num_threads = 1; num_threads <= 16; num_threads *= 4) {
+            for (bool use_cleaner : {false, true}) {
+                BufferPoolManager bpm(pool_size, disk_manager_.get(), BUFFER_POOL_INSTANCES);
+                if (use_cleaner) {
+                    bpm.StartPageCleaner();
+                }
+                double ops = run_fetch_unpin(&bpm, fd, num_threads, working_set, ops_per_thread, true);
+                bpm.StopPageCleaner();
+                PageCleanerStats stats = bpm.GetPageCleanerStats();
+                printf("%8d %8s %12.0f %14zu %14zu %16zu %16zu\n", num_threads, use_cleaner ? "on" : "off", ops,
+                       stats.pages_cleaned, stats.write_batches, stats.stalls_avoided, stats.dirty_evictions);
+            }
+        }
+        disk_manager_->close_file(fd);
+    }
+
+    /**
+     * @brief 同一工作集分别使用普通页面和大页映射帧数据, 先读入全部页面, 再测量全部命中时的随机访问吞吐
+     */
+    void run_frame_backing(const std::string &title, int pool_size, int ops_per_thread) {
+        const std::string filename = "backing_" + std::to_string(pool_size);
+        disk_manager_->create_file(filename);
+        int fd = disk_manager_->open_file(filename);
+        fill_file(fd, pool_size);
+
+        printf("%s (pool_size=%d pages, %d MB of frame data)\n", title.c_str(), pool_size,
+               static_cast<int>(static_cast<int64_t>(pool_size) * PAGE_SIZE >> 20));
+        printf("%8s %10s %14s\n", "threads", "backing", "ops/s");
+        for (int num_threads = 1; num_threads <= 4; num_threads *= 4) {
+            for (bool huge_pages : {false, true}) {
+                BufferPoolManager bpm(pool_size, disk_manager_.get(), 1, REPLACER_TYPE, huge_pages);
+                for (int page_no = 0; page_no < pool_size; page_no++) {
+                    PageId page_id = {.fd = fd, .page_no = page_no};
+                    ASSERT_NE(nullptr, bpm.FetchPage(page_id));
+                    bpm.UnpinPage(page_id, false);
+                }
+                double ops = run_fetch_unpin(&bpm, fd, num_threads, pool_size, ops_per_thread, false);
+                printf("%8d %10s %14.0f\n", num_threads, FrameArena::BackingName(bpm.GetFrameBacking()), ops);
+            }
+        }
+        disk_manager_->close_file(fd);
+    }
+
+    /** @return 文件在操作系统页缓存中的字节数 */
+    static size_t cached_bytes(int fd, size_t file_size) {
+        void *addr = mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED) {
+            return 0;
+        }
+        size_t num_pages = (file_size + getpagesize() - 1) / getpagesize();
+        std::vector<unsigned char> resident(num_pages);
+        size_t bytes = 0;
+        if (mincore(addr, file_size, resident.data()) == 0) {
+            for (unsigned char r : resident) {
+                bytes += (r & 1) * getpagesize();
+            }
+        }
+        munmap(addr, file_size);
+        return bytes;
+    }
+
+    /** @return 本进程的常驻内存字节数 */
+    static size_t resident_bytes() {
+        std::ifstream statm("/proc/self/statm");
+        size_t total_pages = 0;
+        size_t resident_pages = 0;
+        statm >> total_pages >> resident_pages;
+        return resident_pages * getpagesize();
+    }
+
+    /**
+     * @brief 分别以普通读写和O_DIRECT打开大于缓冲池的文件, 冷启动后带预读地顺序扫描num_passes遍,
+     * 比较每遍的吞吐, 以及扫描后文件在操作系统页缓存中占用的内存
+     */
+    void run_direct_io(const std::string &title, int pool_size, int num_pages, int num_passes) {
+        const std::string filename = "scan_" + std::to_string(num_pages);
+        disk_manager_->create_file(filename);
+        int fill_fd = disk_manager_->open_file(filename);
+        fill_file(fill_fd, num_pages);
+        disk_manager_->close_file(fill_fd);
+        const size_t file_size = static_cast<size_t>(num_pages) * PAGE_SIZE;
+
+        printf("%s (pool_size=%d pages, file=%d pages, %d passes)\n", title.c_str(), pool_size, num_pages, num_passes);
+        printf("%8s %6s %14s %16s %16s\n", "mode", "pass", "pages/s", "page cache MB", "process RSS MB");
+        for (bool direct_io : {false, true}) {
+            DiskManager disk_manager(direct_io);
+            int fd = disk_manager.open_file(filename);
+            disk_manager.set_fd2pageno(fd, num_pages);
+            // 冷启动: 丢弃文件在页缓存中的数据
+            fdatasync(fd);
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            BufferPoolManager bpm(pool_size, &disk_manager, 1);
+            const char *mode = disk_manager.IsDirectIo(fd) ? "direct" : "buffered";
+            for (int pass = 1; pass <= num_passes; pass++) {
+                auto start = std::chrono::steady_clock::now();
+                for (int page_no = 0; page_no < num_pages; page_no++) {
+                    int prefetch_count = std::min(PREFETCH_WINDOW, num_pages - page_no - PREFETCH_WINDOW);
+                    if (page_no % PREFETCH_WINDOW == 0 && prefetch_count > 0) {
+                        bpm.PrefetchPages(fd, page_no + PREFETCH_WINDOW, prefetch_count);
+                    }
+                    PageId page_id = {.fd = fd, .page_no = page_no};
+                    Page *page = bpm.FetchPage(page_id);
+                    ASSERT_NE(nullptr, page);
+                    EXPECT_EQ(page_no, *reinterpret_cast<int *>(page->GetData()));
+                    bpm.UnpinPage(page_id, false);
+                }
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                printf("%8s %6d %14.0f %16.1f %16.1f\n", mode, pass, num_pages / elapsed.count(),
+                       cached_bytes(fd, file_size) / 1048576.0, resident_bytes() / 1048576.0);
+            }
+            disk_manager.close_file(fd);
+        }
+    }
+};
+
+/**
+ * @brief 工作集小于缓冲池: 几乎全部命中, 吞吐只受latch争用限制
+ */
+TEST_F(BufferPoolManagerBench, FetchUnpinHitScaling) {
+    run_scaling("FetchPage/UnpinPage, all hits", 4096, 2048, 10000);
+}
+
+/**
+ * @brief 工作集为缓冲池的两倍: 约一半的访问需要淘汰页面并从磁盘读取
+ */
+TEST_F(BufferPoolManagerBench, FetchUnpinMissScaling) {
+    run_scaling("FetchPage/UnpinPage, ~50% misses", 1024, 2048, 10000);
+}
+
+/**
+ * @brief 同上, 但所有页面都被置脏: 每次淘汰都要先写回victim再读取新页面
+ */
+TEST_F(BufferPoolManagerBench, FetchDirtyUnpinMissScaling) {
+    run_scaling("FetchPage/UnpinPage(dirty), ~50% misses", 1024, 2048, 10000, true);
+}
+
+/**
+ * @brief 所有页面都被置脏, 对比开启/关闭后台页面清理线程: 清理线程把淘汰时的同步写回移到后台
+ */
+TEST_F(BufferPoolManagerBench, PageCleaner) {
+    run_page_cleaner("FetchPage/UnpinPage(dirty), ~50% misses", 1024, 2048, 20000);
+}
+
+/**
+ * @brief 全部命中的随机访问, 比较帧数据使用4KB页面和2MB大页时的吞吐(TLB缺失)
+ */
+TEST_F(BufferPoolManagerBench, FrameBacking) { run_frame_backing("frame data backing, all hits", 16384, 1000000); }
+
+/**
+ * @brief 顺序扫描大于缓冲池的表: O_DIRECT模式下页面只缓存在缓冲池中, 不再占用操作系统页缓存
+ */
+TEST_F(BufferPoolManagerBench, DirectIoScan) { run_direct_io("sequential scan, buffered vs O_DIRECT", 4096, 32768, 3); }
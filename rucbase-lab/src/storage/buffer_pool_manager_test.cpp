@@ -28,8 +28,10 @@
 #include <cstring>
 #include <ctime>
 #include <string>
+#include <set>
 #include <thread>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -451,3 +453,518 @@ TEST_F(BufferPoolManagerTest, ConcurrencyTest) {
 
     disk_manager_->close_file(fd);
 }
+
+/**
+ * @brief 分区缓冲池测试（多文件）：页面按PageId分散到多个子缓冲池后，读写结果与单一缓冲池一致
+ * @note 生成若干测试文件partitioned_test_*
+ */
+TEST_F(BufferPoolManagerTest, PartitionedTest) {
+    const int num_files = 4;
+    const int num_instances = 8;
+    const size_t buffer_size = MAX_PAGES;  // 总帧数小于总页数，保证发生淘汰
+    auto bpm = std::make_unique<BufferPoolManager>(buffer_size, disk_manager_.get(), num_instances);
+    EXPECT_EQ(num_instances, bpm->GetNumInstances());
+
+    std::vector<int> fds;
+    for (int i = 0; i < num_files; i++) {
+        std::string filename = "partitioned_test_" + std::to_string(i);
+        disk_manager_->create_file(filename);
+        fds.push_back(disk_manager_->open_file(filename));
+    }
+
+    // NewPage: page_no在每个文件中依然连续分配
+    for (int fd : fds) {
+        for (page_id_t i = 0; i < MAX_PAGES; i++) {
+            PageId page_id = {.fd = fd, .page_no = INVALID_PAGE_ID};
+            Page *page = bpm->NewPage(&page_id);
+            ASSERT_NE(nullptr, page);
+            EXPECT_EQ(i, page_id.page_no);
+            snprintf(page->GetData(), PAGE_SIZE, "%d-%d", fd, page_id.page_no);
+            EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+        }
+    }
+
+    // 并发FetchPage: 每个线程负责一个文件
+    std::vector<std::thread> threads;
+    for (int fd : fds) {
+        threads.emplace_back([&bpm, fd]() {
+            for (int r = 0; r < 4; r++) {
+                for (page_id_t page_no = 0; page_no < MAX_PAGES; page_no++) {
+                    PageId page_id = {.fd = fd, .page_no = page_no};
+                    Page *page = bpm->FetchPage(page_id);
+                    while (page == nullptr) {
+                        page = bpm->FetchPage(page_id);
+                    }
+                    std::string expected = std::to_string(fd) + "-" + std::to_string(page_no);
+                    EXPECT_EQ(0, strcmp(expected.c_str(), page->GetData()));
+                    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    // FlushAllPages需要刷写所有子缓冲池中属于该文件的页面
+    char buf[PAGE_SIZE];
+    for (int fd : fds) {
+        bpm->FlushAllPages(fd);
+        for (page_id_t page_no = 0; page_no < MAX_PAGES; page_no++) {
+            disk_manager_->read_page(fd, page_no, buf, PAGE_SIZE);
+            std::string expected = std::to_string(fd) + "-" + std::to_string(page_no);
+            EXPECT_EQ(0, strcmp(expected.c_str(), buf));
+            EXPECT_EQ(true, bpm->DeletePage(PageId{fd, page_no}));
+        }
+        disk_manager_->close_file(fd);
+    }
+}
+
+/**
+ * @brief 分区缓冲池NewPage失败测试（单文件）：所有分区都没有可用的帧时NewPage失败，尝试过的page_no
+ * 不写磁盘直接归还，不占用文件中的页面
+ * @note 生成测试文件partitioned_new_page_test
+ */
+TEST_F(BufferPoolManagerTest, PartitionedNewPageFailureTest) {
+    const std::string filename = "partitioned_new_page_test";
+    disk_manager_->create_file(filename);
+    int fd = disk_manager_->open_file(filename);
+
+    BufferPoolManager bpm(2, disk_manager_.get(), 2);  // 每个分区只有一个帧
+    std::vector<PageId> pinned;
+    for (int i = 0; i < 2; i++) {
+        PageId page_id = {.fd = fd, .page_no = INVALID_PAGE_ID};
+        ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+        EXPECT_EQ(i, page_id.page_no);
+        pinned.push_back(page_id);
+    }
+    for (int i = 0; i < 3; i++) {
+        PageId page_id = {.fd = fd, .page_no = INVALID_PAGE_ID};
+        EXPECT_EQ(nullptr, bpm.NewPage(&page_id));
+    }
+    EXPECT_EQ(0u, disk_manager_->GetDiskFileStats(fd).writes);
+    EXPECT_EQ(0u, disk_manager_->GetNumFreePages(fd));
+
+    for (auto &page_id : pinned) {
+        EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+    }
+    PageId page_id = {.fd = fd, .page_no = INVALID_PAGE_ID};
+    ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+    EXPECT_EQ(2, page_id.page_no);
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+
+    disk_manager_->close_file(fd);
+}
+
+/**
+ * @brief 分区缓冲池满分区测试（单文件）：一个分区的帧全部被固定时，NewPage换用其他分区的page_no，
+ * 跳过的page_no在该分区有空闲帧后被复用
+ * @note 生成测试文件partitioned_full_partition_test
+ */
+TEST_F(BufferPoolManagerTest, PartitionedFullPartitionTest) {
+    const std::string filename = "partitioned_full_partition_test";
+    disk_manager_->create_file(filename);
+    int fd = disk_manager_->open_file(filename);
+
+    const int num_instances = 4;
+    BufferPoolManager bpm(num_instances, disk_manager_.get(), num_instances);  // 每个分区只有一个帧
+    PageId first_id = {.fd = fd, .page_no = INVALID_PAGE_ID};
+    ASSERT_NE(nullptr, bpm.NewPage(&first_id));  // 固定page 0, 它所在的分区一直是满的
+
+    std::set<page_id_t> page_nos = {first_id.page_no};
+    for (int i = 0; i < 8 * num_instances; i++) {
+        PageId page_id = {.fd = fd, .page_no = INVALID_PAGE_ID};
+        ASSERT_NE(nullptr, bpm.NewPage(&page_id)) << "round " << i;
+        EXPECT_EQ(0u, page_nos.count(page_id.page_no));
+        page_nos.insert(page_id.page_no);
+        EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+    }
+    EXPECT_EQ(0u, disk_manager_->GetDiskFileStats(fd).writes);
+
+    // 与page 0同一分区的page_no都被跳过了, 分区有空闲帧后从最小的开始复用
+    EXPECT_EQ(true, bpm.UnpinPage(first_id, false));
+    ASSERT_GT(disk_manager_->GetNumFreePages(fd), 0u);
+    PageId page_id = {.fd = fd, .page_no = INVALID_PAGE_ID};
+    ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+    EXPECT_EQ(0u, page_nos.count(page_id.page_no));
+    EXPECT_LT(page_id.page_no, *page_nos.rbegin());
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+
+    disk_manager_->close_file(fd);
+}
+
+/**
+ * @brief 脏页淘汰测试（单文件）：脏页的写回和缺页读取在latch之外执行，
+ * 页面被淘汰后立刻重新读入时必须读到写回之后的数据
+ * @note 生成测试文件dirty_eviction_test
+ */
+TEST_F(BufferPoolManagerTest, DirtyEvictionTest) {
+    const int num_threads = 4;
+    const int pages_per_thread = 16;
+    const int num_rounds = 50;
+    const int buffer_pool_size = 8;  // 远小于工作集, 几乎每次访问都会淘汰一个脏页
+
+    const std::string filename = "dirty_eviction_test";
+    disk_manager_->create_file(filename);
+    int fd = disk_manager_->open_file(filename);
+
+    BufferPoolManager bpm(buffer_pool_size, disk_manager_.get());
+    std::vector<PageId> page_ids;
+    for (int i = 0; i < num_threads * pages_per_thread; i++) {
+        PageId page_id = {.fd = fd, .page_no = INVALID_PAGE_ID};
+        Page *page = bpm.NewPage(&page_id);
+        while (page == nullptr) {
+            page = bpm.NewPage(&page_id);
+        }
+        *reinterpret_cast<int *>(page->GetData()) = 0;
+        EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+        page_ids.push_back(page_id);
+    }
+
+    // 每个线程反复给自己的页面计数器加1
+    std::vector<std::thread> threads;
+    for (int tid = 0; tid < num_threads; tid++) {
+        threads.emplace_back([&bpm, &page_ids, tid]() {
+            for (int round = 0; round < num_rounds; round++) {
+                for (int i = 0; i < pages_per_thread; i++) {
+                    PageId page_id = page_ids[tid * pages_per_thread + i];
+                    Page *page = bpm.FetchPage(page_id);
+                    while (page == nullptr) {
+                        page = bpm.FetchPage(page_id);
+                    }
+                    int *counter = reinterpret_cast<int *>(page->GetData());
+                    EXPECT_EQ(round, *counter);
+                    (*counter)++;
+                    EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    bpm.FlushAllPages(fd);
+    for (auto &page_id : page_ids) {
+        char buf[PAGE_SIZE];
+        disk_manager_->read_page(fd, page_id.page_no, buf, PAGE_SIZE);
+        EXPECT_EQ(num_rounds, *reinterpret_cast<int *>(buf));
+    }
+
+    disk_manager_->close_file(fd);
+}
+
+/**
+ * @brief 预读测试（单文件）：预读的页面在FetchPage时直接从缓冲池中得到，不再读盘；预读不会淘汰脏页
+ * @note 生成测试文件prefetch_test
+ */
+TEST_F(BufferPoolManagerTest, PrefetchTest) {
+    const int num_pages = 32;
+    const int buffer_pool_size = 16;
+    const std::string filename = "prefetch_test";
+    disk_manager_->create_file(filename);
+    int fd = disk_manager_->open_file(filename);
+    char buf[PAGE_SIZE] = {0};
+    for (int page_no = 0; page_no < num_pages; page_no++) {
+        *reinterpret_cast<int *>(buf) = page_no;
+        disk_manager_->write_page(fd, page_no, buf, PAGE_SIZE);
+    }
+    disk_manager_->set_fd2pageno(fd, num_pages);
+
+    for (size_t num_instances : {1, 4}) {
+        BufferPoolManager bpm(buffer_pool_size, disk_manager_.get(), num_instances);
+        // 缓冲池中有一个脏页, 预读最多只能使用其余的帧
+        PageId dirty_page_id = {.fd = fd, .page_no = 0};
+        Page *dirty_page = bpm.FetchPage(dirty_page_id);
+        ASSERT_NE(nullptr, dirty_page);
+        *reinterpret_cast<int *>(dirty_page->GetData()) = -1;
+        EXPECT_EQ(true, bpm.UnpinPage(dirty_page_id, true));
+
+        size_t num_prefetched = bpm.PrefetchPages(fd, 1, num_pages - 1);
+        EXPECT_GT(num_prefetched, 0);
+        EXPECT_LE(num_prefetched, buffer_pool_size - 1);
+        EXPECT_EQ(0, bpm.PrefetchPages(fd, 1, 1));  // 已经在缓冲池中的页面会被跳过
+
+        // FlushAllPages等待在途的预读完成; 之后修改磁盘上的数据, 缓冲池中预读的页面不受影响
+        bpm.FlushAllPages(fd);
+        EXPECT_EQ(-1, *reinterpret_cast<int *>(dirty_page->GetData()));
+        for (int page_no = 1; page_no < num_pages; page_no++) {
+            *reinterpret_cast<int *>(buf) = page_no + num_pages;
+            disk_manager_->write_page(fd, page_no, buf, PAGE_SIZE);
+        }
+        size_t num_cached = 0;
+        for (int page_no = 1; page_no < num_pages; page_no++) {
+            PageId page_id = {.fd = fd, .page_no = page_no};
+            Page *page = bpm.FetchPage(page_id);
+            ASSERT_NE(nullptr, page);
+            int value = *reinterpret_cast<int *>(page->GetData());
+            EXPECT_TRUE(value == page_no || value == page_no + num_pages);
+            num_cached += value == page_no;
+            EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+        }
+        EXPECT_EQ(num_prefetched, num_cached);
+
+        // 恢复磁盘上的数据
+        for (int page_no = 0; page_no < num_pages; page_no++) {
+            *reinterpret_cast<int *>(buf) = page_no;
+            disk_manager_->write_page(fd, page_no, buf, PAGE_SIZE);
+        }
+    }
+
+    disk_manager_->close_file(fd);
+}
+
+/**
+ * @brief 替换策略测试（单文件）：每种替换策略下缓冲池都能正确淘汰页面；ResetReplacer只能在缓冲池为空时调用
+ * @note 生成测试文件replacer_test
+ */
+TEST_F(BufferPoolManagerTest, ReplacerTypeTest) {
+    const int num_pages = 32;
+    const int buffer_pool_size = 8;
+    const std::string filename = "replacer_test";
+    disk_manager_->create_file(filename);
+    int fd = disk_manager_->open_file(filename);
+    char buf[PAGE_SIZE] = {0};
+    for (int page_no = 0; page_no < num_pages; page_no++) {
+        *reinterpret_cast<int *>(buf) = page_no;
+        disk_manager_->write_page(fd, page_no, buf, PAGE_SIZE);
+    }
+    disk_manager_->set_fd2pageno(fd, num_pages);
+
+    for (const std::string replacer_type : {"LRU", "CLOCK", "ATOMIC-CLOCK", "LRU-K"}) {
+        for (size_t num_instances : {1, 4}) {
+            BufferPoolManager bpm(buffer_pool_size, disk_manager_.get(), num_instances, replacer_type);
+            for (int round = 0; round < 3; round++) {
+                for (int page_no = 0; page_no < num_pages; page_no++) {
+                    PageId page_id = {.fd = fd, .page_no = page_no};
+                    Page *page = bpm.FetchPage(page_id);
+                    ASSERT_NE(nullptr, page);
+                    EXPECT_EQ(page_no, *reinterpret_cast<int *>(page->GetData()));
+                    EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+                }
+            }
+            // 缓冲池中已有页面时不能更换替换策略
+            EXPECT_THROW(bpm.ResetReplacer("LRU"), InternalError);
+        }
+    }
+
+    BufferPoolManager bpm(buffer_pool_size, disk_manager_.get());
+    EXPECT_THROW(bpm.ResetReplacer("MRU"), InternalError);
+    bpm.ResetReplacer("LRU-K");
+    PageId page_id = {.fd = fd, .page_no = 0};
+    ASSERT_NE(nullptr, bpm.FetchPage(page_id));
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+
+    disk_manager_->close_file(fd);
+}
+
+/**
+ * @brief 后台页面清理测试（单文件）：只写回page LSN已持久化的脏页，淘汰被清理过的页面时不再同步写回
+ * @note 生成测试文件cleaner_test
+ */
+TEST_F(BufferPoolManagerTest, PageCleanerTest) {
+    const int num_pages = 64;
+    const int buffer_pool_size = 16;
+    const std::string filename = "cleaner_test";
+    disk_manager_->create_file(filename);
+    int fd = disk_manager_->open_file(filename);
+    char buf[PAGE_SIZE] = {0};
+    for (int page_no = 0; page_no < num_pages; page_no++) {
+        *reinterpret_cast<int *>(buf + Page::OFFSET_PAGE_HDR) = page_no;
+        disk_manager_->write_page(fd, page_no, buf, PAGE_SIZE);
+    }
+    disk_manager_->set_fd2pageno(fd, num_pages);
+    auto disk_value = [&](int page_no) {
+        disk_manager_->read_page(fd, page_no, buf, PAGE_SIZE);
+        return *reinterpret_cast<int *>(buf + Page::OFFSET_PAGE_HDR);
+    };
+
+    for (size_t num_instances : {1, 4}) {
+        BufferPoolManager bpm(buffer_pool_size, disk_manager_.get(), num_instances);
+        // 缓冲池中的16个页面全部置脏, 第i个页面的page LSN为i
+        for (int page_no = 0; page_no < buffer_pool_size; page_no++) {
+            PageId page_id = {.fd = fd, .page_no = page_no};
+            Page *page = bpm.FetchPage(page_id);
+            ASSERT_NE(nullptr, page);
+            page->SetPageLsn(page_no);
+            *reinterpret_cast<int *>(page->GetData() + Page::OFFSET_PAGE_HDR) = page_no + 1000;
+            EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+        }
+
+        // 日志只持久化到LSN 7: 只有前8个页面可以写回
+        bpm.SetPersistentLsnSource([] { return 7; });
+        EXPECT_EQ(8, bpm.CleanPages(1.0));
+        for (int page_no = 0; page_no < buffer_pool_size; page_no++) {
+            EXPECT_EQ(page_no < 8 ? page_no + 1000 : page_no, disk_value(page_no));
+        }
+        PageCleanerStats stats = bpm.GetPageCleanerStats();
+        EXPECT_EQ(8, stats.pages_cleaned);
+        EXPECT_EQ(1, stats.write_batches);  // 页面0~7相邻, 即使分属不同的子缓冲池也合并为一次写
+
+        // 按淘汰顺序的前3/4个候选帧(页面0~11)中只有4个脏页
+        bpm.SetPersistentLsnSource([] { return 100; });
+        EXPECT_EQ(4, bpm.CleanPages(0.75));
+        EXPECT_EQ(0, bpm.CleanPages(0.75));
+
+        // 淘汰全部16个页面: 12个已被清理, 只有4个需要同步写回
+        for (int page_no = buffer_pool_size; page_no < num_pages; page_no++) {
+            PageId page_id = {.fd = fd, .page_no = page_no};
+            ASSERT_NE(nullptr, bpm.FetchPage(page_id));
+            EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+        }
+        stats = bpm.GetPageCleanerStats();
+        EXPECT_EQ(12, stats.pages_cleaned);
+        EXPECT_EQ(12, stats.stalls_avoided);
+        EXPECT_EQ(4, stats.dirty_evictions);
+        for (int page_no = 0; page_no < buffer_pool_size; page_no++) {
+            EXPECT_EQ(page_no + 1000, disk_value(page_no));
+        }
+
+        // 后台线程: 新的脏页最终都会被写回
+        bpm.StartPageCleaner(1.0, std::chrono::milliseconds(10));
+        for (int page_no = 0; page_no < buffer_pool_size; page_no++) {
+            PageId page_id = {.fd = fd, .page_no = page_no};
+            Page *page = bpm.FetchPage(page_id);
+            ASSERT_NE(nullptr, page);
+            *reinterpret_cast<int *>(page->GetData() + Page::OFFSET_PAGE_HDR) = page_no;
+            EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+        }
+        for (int i = 0; i < 500 && bpm.GetPageCleanerStats().pages_cleaned < 12 + buffer_pool_size; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        bpm.StopPageCleaner();
+        EXPECT_EQ(12 + buffer_pool_size, bpm.GetPageCleanerStats().pages_cleaned);
+        for (int page_no = 0; page_no < buffer_pool_size; page_no++) {
+            EXPECT_EQ(page_no, disk_value(page_no));
+        }
+    }
+
+    disk_manager_->close_file(fd);
+}
+
+/**
+ * @brief 帧内存测试（单文件）：普通页面和大页映射下, 帧数据都按4KB对齐且互不重叠, 元数据按cache line对齐,
+ * 页面经过淘汰和重新读入后内容不变
+ * @note 生成测试文件frame_arena_test
+ */
+TEST_F(BufferPoolManagerTest, FrameArenaTest) {
+    const int num_pages = 64;
+    const int buffer_pool_size = 16;
+    const std::string filename = "frame_arena_test";
+    disk_manager_->create_file(filename);
+    int fd = disk_manager_->open_file(filename);
+    char buf[PAGE_SIZE] = {0};
+    for (int page_no = 0; page_no < num_pages; page_no++) {
+        disk_manager_->write_page(fd, page_no, buf, PAGE_SIZE);
+    }
+    disk_manager_->set_fd2pageno(fd, num_pages);
+
+    int round = 0;
+    for (bool huge_pages : {false, true}) {
+        for (size_t num_instances : {1, 4}) {
+            BufferPoolManager bpm(buffer_pool_size, disk_manager_.get(), num_instances, REPLACER_TYPE, huge_pages);
+            if (!huge_pages) {
+                EXPECT_EQ(FrameArena::Backing::PLAIN, bpm.GetFrameBacking());
+            }
+            // 同时固定缓冲池能放下的所有页面, 它们的帧互不重叠
+            std::unordered_set<char *> frames;
+            for (int page_no = 0; page_no < buffer_pool_size; page_no++) {
+                Page *page = bpm.FetchPage({.fd = fd, .page_no = page_no});
+                ASSERT_NE(nullptr, page);
+                EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(page) % 64);
+                EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(page->GetData()) % PAGE_SIZE);
+                EXPECT_TRUE(frames.insert(page->GetData()).second);
+            }
+            for (int page_no = 0; page_no < buffer_pool_size; page_no++) {
+                EXPECT_EQ(true, bpm.UnpinPage({.fd = fd, .page_no = page_no}, false));
+            }
+            // 每轮读出上一轮写入的内容并改写整页的首尾, 页面在各轮之间都会被淘汰
+            for (int i = 0; i < 2; i++, round++) {
+                for (int page_no = 0; page_no < num_pages; page_no++) {
+                    PageId page_id = {.fd = fd, .page_no = page_no};
+                    Page *page = bpm.FetchPage(page_id);
+                    ASSERT_NE(nullptr, page);
+                    int *data = reinterpret_cast<int *>(page->GetData());
+                    if (round > 0) {
+                        EXPECT_EQ(page_no * 8 + round - 1, data[0]);
+                        EXPECT_EQ(page_no, data[PAGE_SIZE / sizeof(int) - 1]);
+                    }
+                    data[0] = page_no * 8 + round;
+                    data[PAGE_SIZE / sizeof(int) - 1] = page_no;
+                    EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+                }
+            }
+            bpm.FlushAllPages(fd);
+        }
+    }
+
+    disk_manager_->close_file(fd);
+}
+
+/**
+ * @brief 统计测试：按文件统计命中、缺页、淘汰和脏页写回, 分区模式下各子缓冲池的计数相加
+ * @note 生成测试文件stats_test_a, stats_test_b
+ */
+TEST_F(BufferPoolManagerTest, StatsTest) {
+    const int num_pages = 8;
+    const int buffer_pool_size = 4;
+    const std::string filename_a = "stats_test_a";
+    const std::string filename_b = "stats_test_b";
+    disk_manager_->create_file(filename_a);
+    disk_manager_->create_file(filename_b);
+    int fd_a = disk_manager_->open_file(filename_a);
+    int fd_b = disk_manager_->open_file(filename_b);
+    char buf[PAGE_SIZE] = {0};
+    for (int page_no = 0; page_no < num_pages; page_no++) {
+        disk_manager_->write_page(fd_a, page_no, buf, PAGE_SIZE);
+    }
+    disk_manager_->set_fd2pageno(fd_a, num_pages);
+
+    BufferPoolManager bpm(buffer_pool_size, disk_manager_.get(), 1);
+    DiskFileStats disk_before = disk_manager_->GetDiskFileStats(fd_a);
+    EXPECT_EQ(static_cast<size_t>(num_pages), disk_before.writes);
+    // 第一遍读入前4页全部缺页, 第二遍全部命中并置脏
+    for (int i = 0; i < 2; i++) {
+        for (int page_no = 0; page_no < buffer_pool_size; page_no++) {
+            ASSERT_NE(nullptr, bpm.FetchPage({.fd = fd_a, .page_no = page_no}));
+            EXPECT_EQ(true, bpm.UnpinPage({.fd = fd_a, .page_no = page_no}, i == 1));
+        }
+    }
+    // 后4页缺页, 淘汰前4个脏页
+    for (int page_no = buffer_pool_size; page_no < num_pages; page_no++) {
+        ASSERT_NE(nullptr, bpm.FetchPage({.fd = fd_a, .page_no = page_no}));
+        EXPECT_EQ(true, bpm.UnpinPage({.fd = fd_a, .page_no = page_no}, false));
+    }
+    BufferPoolStats stats = bpm.GetBufferPoolStats(fd_a);
+    EXPECT_EQ(4u, stats.hits);
+    EXPECT_EQ(8u, stats.misses);
+    EXPECT_EQ(4u, stats.evictions);
+    EXPECT_EQ(4u, stats.dirty_writes);
+    EXPECT_EQ(0u, stats.pin_waits);
+    EXPECT_DOUBLE_EQ(1.0 / 3, stats.HitRatio());
+    DiskFileStats disk_after = disk_manager_->GetDiskFileStats(fd_a);
+    EXPECT_EQ(8u, disk_after.reads - disk_before.reads);
+    EXPECT_EQ(4u, disk_after.writes - disk_before.writes);
+    EXPECT_EQ(8u * PAGE_SIZE, disk_after.bytes_read - disk_before.bytes_read);
+    // 其他文件的计数不受影响
+    EXPECT_EQ(0u, bpm.GetBufferPoolStats(fd_b).hits + bpm.GetBufferPoolStats(fd_b).misses);
+    EXPECT_EQ(12u, bpm.GetBufferPoolStats().hits + bpm.GetBufferPoolStats().misses);
+    bpm.ResetBufferPoolStats(fd_a);
+    EXPECT_EQ(0u, bpm.GetBufferPoolStats(fd_a).misses);
+
+    // 分区模式: 路由对象汇总各子缓冲池的计数
+    BufferPoolManager partitioned(num_pages * 4, disk_manager_.get(), 4);
+    for (int i = 0; i < 2; i++) {
+        for (int page_no = 0; page_no < num_pages; page_no++) {
+            ASSERT_NE(nullptr, partitioned.FetchPage({.fd = fd_a, .page_no = page_no}));
+            EXPECT_EQ(true, partitioned.UnpinPage({.fd = fd_a, .page_no = page_no}, false));
+        }
+    }
+    stats = partitioned.GetBufferPoolStats(fd_a);
+    EXPECT_EQ(static_cast<size_t>(num_pages), stats.hits);
+    EXPECT_EQ(static_cast<size_t>(num_pages), stats.misses);
+    EXPECT_EQ(0u, stats.evictions);
+
+    disk_manager_->close_file(fd_a);
+    disk_manager_->close_file(fd_b);
+}
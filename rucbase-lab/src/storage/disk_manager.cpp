@@ -5,9 +5,23 @@
 #include <sys/stat.h>  // for stat
 #include <unistd.h>    // for lseek
 
+#include <algorithm>
+
 #include "defs.h"
 
-DiskManager::DiskManager() { memset(fd2pageno_, 0, MAX_FD * (sizeof(std::atomic<page_id_t>) / sizeof(char))); }
+DiskManager::DiskManager(bool direct_io) : direct_io_(direct_io) {
+    memset(fd2pageno_, 0, MAX_FD * (sizeof(std::atomic<page_id_t>) / sizeof(char)));
+    std::fill(buffered_fds_, buffered_fds_ + MAX_FD, -1);
+}
+
+AlignedBuffer DiskManager::AllocateAlignedBuffer(size_t num_bytes) {
+    size_t size = (num_bytes + DIRECT_IO_ALIGNMENT - 1) / DIRECT_IO_ALIGNMENT * DIRECT_IO_ALIGNMENT;
+    auto *buf = static_cast<char *>(aligned_alloc(DIRECT_IO_ALIGNMENT, std::max(size, DIRECT_IO_ALIGNMENT)));
+    if (buf == nullptr) {
+        throw std::bad_alloc();
+    }
+    return AlignedBuffer(buf);
+}
 
 /**
  * @brief Write the contents of the specified page into disk file
@@ -18,8 +32,10 @@ void DiskManager::write_page(int fd, page_id_t page_no, const char *offset, int
     // 1.lseek()定位到文件头，通过(fd,page_no)可以定位指定页面及其在磁盘文件中的偏移量
     // 2.调用write()函数
     // 注意处理异常
-	lseek(fd, page_no*PAGE_SIZE, SEEK_SET);
-	if(write(fd, offset, num_bytes) != num_bytes)
+    // 使用pwrite()代替lseek()+write(): 不修改fd共享的文件偏移量, 多个线程(如分区缓冲池)可以并发读写同一文件
+    // O_DIRECT模式下不对齐的读写(如文件头)交给普通文件描述符
+	CountIo(fd, IoOp::WRITE, num_bytes);
+	if(pwrite(GetIoFd(fd, offset, num_bytes), offset, num_bytes, static_cast<off_t>(page_no) * PAGE_SIZE) != num_bytes)
 		throw UnixError();
 }
 
@@ -31,28 +47,177 @@ void DiskManager::read_page(int fd, page_id_t page_no, char *offset, int num_byt
     // 1.lseek()定位到文件头，通过(fd,page_no)可以定位指定页面及其在磁盘文件中的偏移量
     // 2.调用read()函数
     // 注意处理异常
-	lseek(fd, page_no*PAGE_SIZE, SEEK_SET);
-	if(read(fd, offset, num_bytes) < 0)
+	CountIo(fd, IoOp::READ, num_bytes);
+	if(pread(GetIoFd(fd, offset, num_bytes), offset, num_bytes, static_cast<off_t>(page_no) * PAGE_SIZE) < 0)
 		throw UnixError();
 }
 
+std::future<void> DiskManager::write_page_async(int fd, page_id_t page_no, const char *offset, int num_bytes,
+                                               std::function<void(int)> callback) {
+    std::vector<IoRequest> requests;
+    requests.push_back({IoOp::WRITE, fd, page_no, const_cast<char *>(offset), num_bytes, std::move(callback)});
+    return std::move(submit_io(std::move(requests)).front());
+}
+
+std::future<void> DiskManager::read_page_async(int fd, page_id_t page_no, char *offset, int num_bytes,
+                                              std::function<void(int)> callback) {
+    std::vector<IoRequest> requests;
+    requests.push_back({IoOp::READ, fd, page_no, offset, num_bytes, std::move(callback)});
+    return std::move(submit_io(std::move(requests)).front());
+}
+
+std::vector<std::future<void>> DiskManager::submit_io(std::vector<IoRequest> requests) {
+    for (auto &request : requests) {
+        CountIo(request.fd, request.op, request.num_bytes);
+        request.fd = GetIoFd(request.fd, request.buf, request.num_bytes);
+    }
+    return GetIoEngine()->Submit(std::move(requests));
+}
+
+DiskFileStats DiskManager::GetDiskFileStats(int fd) const {
+    DiskFileStats stats;
+    if (fd < 0 || fd >= MAX_FD) {
+        return stats;
+    }
+    const FileCounters &counters = file_counters_[fd];
+    stats.reads = counters.reads.load(std::memory_order_relaxed);
+    stats.writes = counters.writes.load(std::memory_order_relaxed);
+    stats.bytes_read = counters.bytes_read.load(std::memory_order_relaxed);
+    stats.bytes_written = counters.bytes_written.load(std::memory_order_relaxed);
+    return stats;
+}
+
+IoEngine *DiskManager::GetIoEngine() {
+    std::call_once(io_engine_once_, [this] { io_engine_ = IoEngine::Create(IO_QUEUE_DEPTH, IO_WORKER_THREADS); });
+    return io_engine_.get();
+}
+
+namespace {
+
+/**
+ * @brief 回收页面的尾部标记, 位于页面的最后sizeof(FreePageTail)个字节, 页面其余部分全为0
+ * @note 放在页面末尾而不是开头, 使记录文件的page header和bitmap为0, 顺序扫描把回收的页面看作空页面
+ */
+struct FreePageTail {
+    uint32_t magic;
+    page_id_t next_free_page_no;
+};
+
+constexpr uint32_t FREE_PAGE_MAGIC = 0x45455246;  // "FREE"
+constexpr size_t FREE_PAGE_TAIL_OFFSET = PAGE_SIZE - sizeof(FreePageTail);
+
+}  // namespace
+
 /**
  * @brief Allocate new page (operations like create index/table)
- * For now just keep an increasing counter
+ * 优先复用回收的页面, 否则使用自增分配策略, 指定文件的页面编号加1
  */
 page_id_t DiskManager::AllocatePage(int fd) {
-    // Todo:
-    // 简单的自增分配策略，指定文件的页面编号加1
-	fd2pageno_[fd]++;
-	return fd2pageno_[fd]-1;
+    std::scoped_lock lock{free_pages_latch_};
+    auto it = free_pages_.find(fd);
+    if (it != free_pages_.end() && !it->second.empty()) {
+        page_id_t page_no = *it->second.begin();
+        it->second.erase(it->second.begin());
+        return page_no;
+    }
+    return fd2pageno_[fd]++;
 }
 
 /**
  * @brief Deallocate page (operations like drop index/table)
- * Need bitmap in header page for tracking pages
- * This does not actually need to do anything for now.
+ * 先把页面写成空闲页面, 再加入回收集合, 避免页面被复用之后才写入
  */
-void DiskManager::DeallocatePage(__attribute__((unused)) page_id_t page_id) {}
+void DiskManager::DeallocatePage(int fd, page_id_t page_no) {
+    if (page_no <= 0 || page_no >= fd2pageno_[fd]) {
+        return;
+    }
+    WriteFreePage(fd, page_no, INVALID_PAGE_ID);
+    std::scoped_lock lock{free_pages_latch_};
+    free_pages_[fd].insert(page_no);
+}
+
+void DiskManager::ReleasePage(int fd, page_id_t page_no) {
+    std::scoped_lock lock{free_pages_latch_};
+    if (page_no == fd2pageno_[fd] - 1) {
+        fd2pageno_[fd]--;
+        return;
+    }
+    free_pages_[fd].insert(page_no);
+}
+
+void DiskManager::WriteFreePage(int fd, page_id_t page_no, page_id_t next_free_page_no) {
+    AlignedBuffer buf = AllocateAlignedBuffer(PAGE_SIZE);
+    memset(buf.get(), 0, PAGE_SIZE);
+    FreePageTail tail = {FREE_PAGE_MAGIC, next_free_page_no};
+    memcpy(buf.get() + FREE_PAGE_TAIL_OFFSET, &tail, sizeof(tail));
+    write_page(fd, page_no, buf.get(), PAGE_SIZE);
+}
+
+page_id_t DiskManager::SaveFreePages(int fd) {
+    std::vector<page_id_t> page_nos;
+    {
+        std::scoped_lock lock{free_pages_latch_};
+        auto it = free_pages_.find(fd);
+        if (it != free_pages_.end()) {
+            page_nos.assign(it->second.begin(), it->second.end());
+        }
+    }
+    page_id_t first_free_page_no = INVALID_PAGE_ID;
+    for (auto it = page_nos.rbegin(); it != page_nos.rend(); ++it) {
+        WriteFreePage(fd, *it, first_free_page_no);
+        first_free_page_no = *it;
+    }
+    return first_free_page_no;
+}
+
+void DiskManager::LoadFreePages(int fd, page_id_t first_free_page_no) {
+    AlignedBuffer buf = AllocateAlignedBuffer(PAGE_SIZE);
+    std::set<page_id_t> page_nos;
+    // 第0页总是文件头; 没有这个字段的旧文件头在此处读到0
+    page_id_t page_no = first_free_page_no;
+    while (page_no > 0 && page_no < fd2pageno_[fd] && page_nos.count(page_no) == 0) {
+        memset(buf.get(), 0, PAGE_SIZE);
+        read_page(fd, page_no, buf.get(), PAGE_SIZE);
+        FreePageTail tail;
+        memcpy(&tail, buf.get() + FREE_PAGE_TAIL_OFFSET, sizeof(tail));
+        if (tail.magic != FREE_PAGE_MAGIC) {
+            break;
+        }
+        page_nos.insert(page_no);
+        page_no = tail.next_free_page_no;
+    }
+    std::scoped_lock lock{free_pages_latch_};
+    free_pages_[fd] = std::move(page_nos);
+}
+
+size_t DiskManager::GetNumFreePages(int fd) {
+    std::scoped_lock lock{free_pages_latch_};
+    auto it = free_pages_.find(fd);
+    return it == free_pages_.end() ? 0 : it->second.size();
+}
+
+bool DiskManager::IsFreePage(int fd, page_id_t page_no) {
+    std::scoped_lock lock{free_pages_latch_};
+    auto it = free_pages_.find(fd);
+    return it != free_pages_.end() && it->second.count(page_no) > 0;
+}
+
+page_id_t DiskManager::TruncateFreePages(int fd) {
+    std::scoped_lock lock{free_pages_latch_};
+    auto &page_nos = free_pages_[fd];
+    page_id_t num_pages = fd2pageno_[fd];
+    while (!page_nos.empty() && *page_nos.rbegin() == num_pages - 1) {
+        page_nos.erase(std::prev(page_nos.end()));
+        num_pages--;
+    }
+    if (num_pages < fd2pageno_[fd]) {
+        if (ftruncate(fd, static_cast<off_t>(num_pages) * PAGE_SIZE) < 0) {
+            throw UnixError();
+        }
+        fd2pageno_[fd] = num_pages;
+    }
+    return num_pages;
+}
 
 bool DiskManager::is_dir(const std::string &path) {
     struct stat st;
@@ -135,9 +300,29 @@ int DiskManager::open_file(const std::string &path) {
         throw UnixError();
     }
 	else{
-		int fd = open(path.c_str(),O_RDWR);
+		int fd = direct_io_ ? OpenDirect(path) : -1;
+		if(fd >= 0){
+			// 不对齐的读写使用的普通文件描述符
+			int buffered_fd = open(path.c_str(), O_RDWR);
+			if(buffered_fd == -1){
+				close(fd);
+				throw UnixError();
+			}
+			buffered_fds_[fd] = buffered_fd;
+		}
+		else{
+			fd = open(path.c_str(),O_RDWR);
+		}
 		if(fd == -1)
 			throw UnixError();
+		if(fd < MAX_FD){
+			// 文件描述符会被复用, 清零上一个文件留下的统计
+			FileCounters &counters = file_counters_[fd];
+			counters.reads = 0;
+			counters.writes = 0;
+			counters.bytes_read = 0;
+			counters.bytes_written = 0;
+		}
 		path2fd_.insert(std::make_pair(path, fd));
 		fd2path_.insert(std::make_pair(fd,path));
 		return fd;
@@ -157,10 +342,39 @@ void DiskManager::close_file(int fd) {
 	else{
 		path2fd_.erase(fd2path_[fd]);
 		fd2path_.erase(fd);
+		{
+			std::scoped_lock lock{free_pages_latch_};
+			free_pages_.erase(fd);
+		}
+		if(buffered_fds_[fd] >= 0){
+			close(buffered_fds_[fd]);
+			buffered_fds_[fd] = -1;
+		}
 		close(fd);
 	}
 }
 
+/**
+ * @brief 以O_DIRECT打开文件, 并试读一次确认文件系统支持对齐的直接读写
+ * @return 文件描述符, 文件系统不支持O_DIRECT时返回-1
+ */
+int DiskManager::OpenDirect(const std::string &path) {
+    int fd = open(path.c_str(), O_RDWR | O_DIRECT);
+    if (fd < 0) {
+        if (errno == EINVAL) {
+            return -1;
+        }
+        throw UnixError();
+    }
+    // 有的文件系统(如部分FUSE实现)接受O_DIRECT标志, 但读写时才返回EINVAL
+    AlignedBuffer buf = AllocateAlignedBuffer(DIRECT_IO_ALIGNMENT);
+    if (pread(fd, buf.get(), DIRECT_IO_ALIGNMENT, 0) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
 int DiskManager::GetFileSize(const std::string &file_name) {
     struct stat stat_buf;
     int rc = stat(file_name.c_str(), &stat_buf);
@@ -193,8 +407,9 @@ bool DiskManager::ReadLog(char *log_data, int size, int offset, int prev_log_end
     }
 
     size = std::min(size, file_size - offset);
-    lseek(log_fd_, offset, SEEK_SET);
-    ssize_t bytes_read = read(log_fd_, log_data, size);
+    int fd = IsDirectIo(log_fd_) ? buffered_fds_[log_fd_] : log_fd_;  // 日志的读写不对齐
+    lseek(fd, offset, SEEK_SET);
+    ssize_t bytes_read = read(fd, log_data, size);
     if (bytes_read != size) {
         throw UnixError();
     }
@@ -207,8 +422,9 @@ void DiskManager::WriteLog(char *log_data, int size) {
     }
 
     // write from the file_end
-    lseek(log_fd_, 0, SEEK_END);
-    ssize_t bytes_write = write(log_fd_, log_data, size);
+    int fd = IsDirectIo(log_fd_) ? buffered_fds_[log_fd_] : log_fd_;  // 日志的读写不对齐
+    lseek(fd, 0, SEEK_END);
+    ssize_t bytes_write = write(fd, log_data, size);
     if (bytes_write != size) {
         throw UnixError();
     }
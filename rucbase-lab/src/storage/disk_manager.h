@@ -17,13 +17,38 @@
 #include <unistd.h>    // for open/close
 
 #include <atomic>
+#include <cstdint>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <set>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "common/config.h"
 #include "errors.h"  // for throw Exception
+#include "io_engine.h"
+
+/** @brief 释放AllocateAlignedBuffer申请的缓冲区 */
+struct AlignedBufferDeleter {
+    void operator()(char *buf) const { free(buf); }
+};
+
+/** @brief 按DIRECT_IO_ALIGNMENT对齐的I/O缓冲区, 可以直接用于O_DIRECT读写 */
+using AlignedBuffer = std::unique_ptr<char[], AlignedBufferDeleter>;
+
+/**
+ * @brief 一个文件的页面I/O统计(不包括日志读写), 由DiskManager::GetDiskFileStats返回
+ */
+struct DiskFileStats {
+    size_t reads = 0;          // 读请求数, 批量提交的每个请求计一次
+    size_t writes = 0;         // 写请求数
+    size_t bytes_read = 0;     // 读取的字节数
+    size_t bytes_written = 0;  // 写入的字节数
+};
 
 /**
  * @brief DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading
@@ -32,7 +57,10 @@
  */
 class DiskManager {
    public:
-    explicit DiskManager();
+    /**
+     * @param direct_io 是否以O_DIRECT打开文件, 见SetDirectIo
+     */
+    explicit DiskManager(bool direct_io = DISK_DIRECT_IO);
 
     ~DiskManager() = default;
 
@@ -51,17 +79,94 @@ class DiskManager {
      */
     void read_page(int fd, page_id_t page_no, char *offset, int num_bytes);
 
+    /**
+     * @brief 异步写入页面, 由IoEngine执行, 调用者需保证offset在返回的future就绪之前有效
+     * @param callback 可选的完成回调, 参数为0表示成功, 否则为errno
+     */
+    std::future<void> write_page_async(int fd, page_id_t page_no, const char *offset, int num_bytes,
+                                       std::function<void(int)> callback = nullptr);
+
+    /**
+     * @brief 异步读取页面, 由IoEngine执行, 调用者需保证offset在返回的future就绪之前有效
+     * @param callback 可选的完成回调, 参数为0表示成功, 否则为errno
+     */
+    std::future<void> read_page_async(int fd, page_id_t page_no, char *offset, int num_bytes,
+                                      std::function<void(int)> callback = nullptr);
+
+    /**
+     * @brief 批量提交页面读写请求, 一次提交可以让多个请求在磁盘上并行执行
+     * @return 与requests一一对应的future, 失败的请求在get()时抛出UnixError
+     */
+    std::vector<std::future<void>> submit_io(std::vector<IoRequest> requests);
+
+    /** @return 异步I/O引擎, 第一次调用时创建 */
+    IoEngine *GetIoEngine();
+
+    /**
+     * @brief 设置之后打开的文件是否使用O_DIRECT, 页面读写绕过操作系统的页缓存, 避免与缓冲池重复缓存
+     * @note 文件系统不支持O_DIRECT时open_file退化为普通的缓存读写. 使用O_DIRECT时, 缓冲区地址或字节数
+     * 没有按DIRECT_IO_ALIGNMENT对齐的读写(如文件头)经由同一文件的另一个普通文件描述符完成
+     */
+    void SetDirectIo(bool direct_io) { direct_io_ = direct_io; }
+
+    /** @return fd是否以O_DIRECT打开 */
+    bool IsDirectIo(int fd) const { return buffered_fds_[fd] >= 0; }
+
+    /** @return 大小为num_bytes(向上取整到DIRECT_IO_ALIGNMENT)的对齐缓冲区 */
+    static AlignedBuffer AllocateAlignedBuffer(size_t num_bytes);
+
+    /**
+     * @brief 文件fd打开以来的页面I/O统计
+     * @note 计数器只做relaxed原子加, 与正在进行的I/O并发读取时各项之间不保证一致
+     */
+    DiskFileStats GetDiskFileStats(int fd) const;
+
     /**
      * @brief Allocate a page on disk.
+     * 优先复用DeallocatePage回收的页面(page_no最小的), 没有回收的页面时在文件末尾分配新页面
      * @return the page_no of the allocated page
      */
     page_id_t AllocatePage(int fd);
 
     /**
      * @brief Deallocate a page on disk.
-     * @param page_id id of the page to deallocate
+     * 页面在磁盘上被写成空闲页面(除空闲页面标记外全为0, 顺序扫描时看作空页面), 之后可以被AllocatePage复用
+     * @param fd 页面所在文件开启后的文件描述符
+     * @param page_no id of the page to deallocate
+     * @note 调用者需保证页面已不在缓冲池中, 一般通过BufferPoolManager::DeletePage调用
      */
-    void DeallocatePage(page_id_t page_id);
+    void DeallocatePage(int fd, page_id_t page_no);
+
+    /**
+     * @brief 归还AllocatePage分配之后还没有使用(没有写入过)的页面, 不写磁盘
+     * 页面是文件中最后分配的页面时直接退回, 否则加入回收集合, 由SaveFreePages持久化
+     */
+    void ReleasePage(int fd, page_id_t page_no);
+
+    /**
+     * @brief 持久化fd中回收的页面: 把它们按page_no从小到大串成链表写入各自的页面中
+     * @return 链表头, 由上层写入文件头(RmFileHdr/IxFileHdr), 没有回收的页面时返回INVALID_PAGE_ID
+     * @note 在FlushAllPages之后调用, 否则缓冲池中读入的旧空闲页面会覆盖链表
+     */
+    page_id_t SaveFreePages(int fd);
+
+    /**
+     * @brief 打开文件时从文件头记录的链表头开始恢复回收的页面, 在set_fd2pageno之后调用
+     * @note 链表中的页面如果已不是空闲页面(例如上次没有正常关闭文件), 从该页面起停止恢复, 这些页面不会再被复用
+     */
+    void LoadFreePages(int fd, page_id_t first_free_page_no);
+
+    /** @return fd中回收的页面数 */
+    size_t GetNumFreePages(int fd);
+
+    /** @return page_no是否是fd中回收的页面 */
+    bool IsFreePage(int fd, page_id_t page_no);
+
+    /**
+     * @brief 截断文件末尾连续的回收页面, 缩小磁盘文件
+     * @return 截断之后文件中分配的页面数, 上层据此更新文件头中的num_pages
+     */
+    page_id_t TruncateFreePages(int fd);
 
     // 目录操作
     bool is_dir(const std::string &path);
@@ -104,10 +209,56 @@ class DiskManager {
     static constexpr int MAX_FD = 8192;
 
    private:
+    /** @return 读写buf的num_bytes字节时应使用的文件描述符 */
+    int GetIoFd(int fd, const char *buf, int num_bytes) const {
+        if (fd < 0 || fd >= MAX_FD || buffered_fds_[fd] < 0 ||
+            (reinterpret_cast<uintptr_t>(buf) % DIRECT_IO_ALIGNMENT == 0 && num_bytes % DIRECT_IO_ALIGNMENT == 0)) {
+            return fd;
+        }
+        return buffered_fds_[fd];
+    }
+
+    int OpenDirect(const std::string &path);
+
+    void WriteFreePage(int fd, page_id_t page_no, page_id_t next_free_page_no);
+
+    /** @brief 统计一次页面读写, fd超出范围时忽略 */
+    void CountIo(int fd, IoOp op, int num_bytes) {
+        if (fd < 0 || fd >= MAX_FD) {
+            return;
+        }
+        FileCounters &counters = file_counters_[fd];
+        if (op == IoOp::READ) {
+            counters.reads.fetch_add(1, std::memory_order_relaxed);
+            counters.bytes_read.fetch_add(num_bytes, std::memory_order_relaxed);
+        } else {
+            counters.writes.fetch_add(1, std::memory_order_relaxed);
+            counters.bytes_written.fetch_add(num_bytes, std::memory_order_relaxed);
+        }
+    }
+
     // 文件打开列表，用于记录文件是否被打开
     std::unordered_map<std::string, int> path2fd_;  //<Page文件磁盘路径,Page fd>哈希表
     std::unordered_map<int, std::string> fd2path_;  //<Page fd,Page文件磁盘路径>哈希表
 
     int log_fd_ = -1;                             // log file
     std::atomic<page_id_t> fd2pageno_[MAX_FD]{};  // 在文件fd中分配的page no个数
+
+    bool direct_io_;            // 新打开的文件是否使用O_DIRECT
+    int buffered_fds_[MAX_FD];  // 以O_DIRECT打开的文件对应的普通文件描述符, 用于不对齐的读写, 其他文件为-1
+
+    /** 每个文件的页面I/O计数器, open_file时清零 */
+    struct FileCounters {
+        std::atomic<size_t> reads{0};
+        std::atomic<size_t> writes{0};
+        std::atomic<size_t> bytes_read{0};
+        std::atomic<size_t> bytes_written{0};
+    };
+    FileCounters file_counters_[MAX_FD];
+
+    std::mutex free_pages_latch_;                               // 保护free_pages_, 以及分配页面时的fd2pageno_
+    std::unordered_map<int, std::set<page_id_t>> free_pages_;  // 每个文件中回收的页面, 按page_no排序
+
+    std::unique_ptr<IoEngine> io_engine_;  // 异步I/O引擎, 按需创建, 避免不使用异步接口的DiskManager启动I/O线程
+    std::once_flag io_engine_once_;
 };
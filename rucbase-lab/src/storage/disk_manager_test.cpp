@@ -159,3 +159,207 @@ TEST_F(DiskManagerTest, PageOperation) {
     disk_manager_->destroy_file(filename);
     EXPECT_EQ(disk_manager_->is_file(filename), false);
 }
+
+/**
+ * @brief 测试异步I/O引擎：io_uring（内核支持时）和线程池引擎批量读写页面的结果与同步读写一致
+ */
+TEST_F(DiskManagerTest, AsyncPageOperation) {
+    const std::string filename = "AsyncPageOperationTestFile";
+    if (disk_manager_->is_file(filename)) {
+        disk_manager_->destroy_file(filename);
+    }
+    disk_manager_->create_file(filename);
+    int fd = disk_manager_->open_file(filename);
+
+    std::vector<std::unique_ptr<IoEngine>> engines;
+    engines.push_back(std::make_unique<ThreadPoolIoEngine>(4));
+#ifdef RUCBASE_HAVE_IO_URING
+    try {
+        engines.push_back(std::make_unique<UringIoEngine>(16));  // 队列深度小于批量大小, 测试分批提交
+    } catch (UnixError &) {
+        // 内核禁用了io_uring, 只测试线程池引擎
+    }
+#endif
+
+    // 对齐的缓冲区, 以O_DIRECT打开文件时引擎也可以直接读写
+    const size_t size = MAX_PAGES * PAGE_SIZE;
+    AlignedBuffer data = DiskManager::AllocateAlignedBuffer(size);
+    AlignedBuffer buf = DiskManager::AllocateAlignedBuffer(size);
+    for (auto &engine : engines) {
+        // 一次提交MAX_PAGES个写请求, 再同步读回检查
+        rand_buf(data.get(), size);
+        std::atomic<int> num_callbacks{0};
+        std::vector<IoRequest> requests;
+        for (int page_no = 0; page_no < MAX_PAGES; page_no++) {
+            requests.push_back({IoOp::WRITE, fd, page_no, data.get() + page_no * PAGE_SIZE, PAGE_SIZE,
+                                [&num_callbacks](int err) {
+                                    EXPECT_EQ(err, 0);
+                                    num_callbacks++;
+                                }});
+        }
+        for (auto &future : engine->Submit(std::move(requests))) {
+            future.get();
+        }
+        EXPECT_EQ(num_callbacks, MAX_PAGES) << engine->Name();
+        for (int page_no = 0; page_no < MAX_PAGES; page_no++) {
+            disk_manager_->read_page(fd, page_no, buf.get(), PAGE_SIZE);
+            EXPECT_EQ(std::memcmp(buf.get(), data.get() + page_no * PAGE_SIZE, PAGE_SIZE), 0) << engine->Name();
+        }
+
+        // 一次提交MAX_PAGES个读请求
+        memset(buf.get(), 0, size);
+        requests.clear();
+        for (int page_no = 0; page_no < MAX_PAGES; page_no++) {
+            requests.push_back({IoOp::READ, fd, page_no, buf.get() + page_no * PAGE_SIZE, PAGE_SIZE, nullptr});
+        }
+        for (auto &future : engine->Submit(std::move(requests))) {
+            future.get();
+        }
+        EXPECT_EQ(std::memcmp(buf.get(), data.get(), size), 0) << engine->Name();
+
+        // 无效的fd: 错误通过future抛出
+        requests.clear();
+        requests.push_back({IoOp::WRITE, -1, 0, data.get(), PAGE_SIZE, nullptr});
+        auto futures = engine->Submit(std::move(requests));
+        EXPECT_THROW(futures.front().get(), UnixError) << engine->Name();
+    }
+
+    // DiskManager的异步接口
+    rand_buf(data.get(), PAGE_SIZE);
+    disk_manager_->write_page_async(fd, 0, data.get(), PAGE_SIZE).get();
+    memset(buf.get(), 0, size);
+    disk_manager_->read_page_async(fd, 0, buf.get(), PAGE_SIZE).get();
+    EXPECT_EQ(std::memcmp(buf.get(), data.get(), PAGE_SIZE), 0) << disk_manager_->GetIoEngine()->Name();
+
+    disk_manager_->close_file(fd);
+    disk_manager_->destroy_file(filename);
+}
+
+/**
+ * @brief 测试O_DIRECT模式：对齐的读写绕过页缓存，不对齐的读写（如文件头）经由普通文件描述符，两者看到的数据一致
+ * @note 文件系统不支持O_DIRECT时退化为普通读写，测试同样应当通过
+ */
+TEST_F(DiskManagerTest, DirectIoOperation) {
+    const std::string filename = "DirectIoTestFile";
+    if (disk_manager_->is_file(filename)) {
+        disk_manager_->destroy_file(filename);
+    }
+    disk_manager_->create_file(filename);
+    DiskManager buffered_disk_manager(false);
+    int fd = buffered_disk_manager.open_file(filename);
+    EXPECT_FALSE(buffered_disk_manager.IsDirectIo(fd));
+    buffered_disk_manager.close_file(fd);
+
+    DiskManager direct_disk_manager(true);
+    fd = direct_disk_manager.open_file(filename);
+    if (!direct_disk_manager.IsDirectIo(fd)) {
+        std::cerr << "O_DIRECT is not supported here, testing the buffered fallback" << std::endl;
+    }
+
+    // 对齐的缓冲区: 同步和异步读写整页
+    AlignedBuffer data = DiskManager::AllocateAlignedBuffer(MAX_PAGES * PAGE_SIZE);
+    AlignedBuffer buf = DiskManager::AllocateAlignedBuffer(MAX_PAGES * PAGE_SIZE);
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(data.get()) % DIRECT_IO_ALIGNMENT);
+    rand_buf(data.get(), MAX_PAGES * PAGE_SIZE);
+    for (int page_no = 0; page_no < MAX_PAGES / 2; page_no++) {
+        direct_disk_manager.write_page(fd, page_no, data.get() + page_no * PAGE_SIZE, PAGE_SIZE);
+    }
+    std::vector<IoRequest> requests;
+    requests.push_back({IoOp::WRITE, fd, MAX_PAGES / 2, data.get() + MAX_PAGES / 2 * PAGE_SIZE,
+                        MAX_PAGES / 2 * PAGE_SIZE, nullptr});
+    direct_disk_manager.submit_io(std::move(requests)).front().get();
+    direct_disk_manager.read_page_async(fd, 0, buf.get(), MAX_PAGES * PAGE_SIZE).get();
+    EXPECT_EQ(std::memcmp(buf.get(), data.get(), MAX_PAGES * PAGE_SIZE), 0);
+
+    // 不对齐的缓冲区和字节数: 读到的是O_DIRECT写入的数据
+    std::vector<char> unaligned(PAGE_SIZE + 1);
+    direct_disk_manager.read_page(fd, 3, unaligned.data() + 1, PAGE_SIZE);
+    EXPECT_EQ(std::memcmp(unaligned.data() + 1, data.get() + 3 * PAGE_SIZE, PAGE_SIZE), 0);
+    direct_disk_manager.read_page_async(fd, 5, unaligned.data() + 1, 100).get();
+    EXPECT_EQ(std::memcmp(unaligned.data() + 1, data.get() + 5 * PAGE_SIZE, 100), 0);
+
+    // 不对齐的写入(如文件头)之后, O_DIRECT读取能看到新数据
+    int header[3] = {7, 8, 9};
+    direct_disk_manager.write_page(fd, 0, reinterpret_cast<char *>(header), sizeof(header));
+    memcpy(data.get(), header, sizeof(header));
+    direct_disk_manager.read_page(fd, 0, buf.get(), PAGE_SIZE);
+    EXPECT_EQ(std::memcmp(buf.get(), data.get(), PAGE_SIZE), 0);
+
+    // O_DIRECT写入之后, 不对齐的读取不会读到页缓存中的旧数据
+    rand_buf(data.get(), PAGE_SIZE);
+    direct_disk_manager.write_page(fd, 0, data.get(), PAGE_SIZE);
+    direct_disk_manager.read_page(fd, 0, reinterpret_cast<char *>(header), sizeof(header));
+    EXPECT_EQ(std::memcmp(header, data.get(), sizeof(header)), 0);
+
+    direct_disk_manager.close_file(fd);
+    direct_disk_manager.destroy_file(filename);
+}
+
+/**
+ * @brief 测试回收页面的复用、保存/加载和截断
+ */
+TEST_F(DiskManagerTest, FreePageOperation) {
+    const std::string filename = "FreePageTestFile";
+    if (disk_manager_->is_file(filename)) {
+        disk_manager_->destroy_file(filename);
+    }
+    disk_manager_->create_file(filename);
+    int fd = disk_manager_->open_file(filename);
+    disk_manager_->set_fd2pageno(fd, 1);  // 第0页作为文件头
+
+    char buf[PAGE_SIZE] = {};
+    for (int i = 1; i < 10; i++) {
+        page_id_t page_no = disk_manager_->AllocatePage(fd);
+        EXPECT_EQ(page_no, i);
+        rand_buf(buf, PAGE_SIZE);
+        disk_manager_->write_page(fd, page_no, buf, PAGE_SIZE);
+    }
+    // 回收页面之后, 分配优先复用page_no最小的回收页面
+    for (page_id_t page_no : {7, 3, 5, 8, 9}) {
+        disk_manager_->DeallocatePage(fd, page_no);
+    }
+    disk_manager_->DeallocatePage(fd, 0);  // 文件头不能被回收
+    EXPECT_EQ(disk_manager_->GetNumFreePages(fd), 5u);
+    EXPECT_TRUE(disk_manager_->IsFreePage(fd, 5));
+    EXPECT_FALSE(disk_manager_->IsFreePage(fd, 4));
+    EXPECT_EQ(disk_manager_->AllocatePage(fd), 3);
+    EXPECT_EQ(disk_manager_->GetNumFreePages(fd), 4u);
+
+    // 回收的页面内容除尾部标记外全为0
+    char zeros[PAGE_SIZE] = {};
+    disk_manager_->read_page(fd, 5, buf, PAGE_SIZE);
+    EXPECT_EQ(std::memcmp(buf, zeros, PAGE_SIZE / 2), 0);
+
+    // 关闭文件前保存链表, 重新打开之后从链表头恢复
+    page_id_t first_free_page_no = disk_manager_->SaveFreePages(fd);
+    EXPECT_EQ(first_free_page_no, 5);
+    disk_manager_->close_file(fd);
+    fd = disk_manager_->open_file(filename);
+    disk_manager_->set_fd2pageno(fd, 10);
+    EXPECT_EQ(disk_manager_->GetNumFreePages(fd), 0u);
+    disk_manager_->LoadFreePages(fd, first_free_page_no);
+    EXPECT_EQ(disk_manager_->GetNumFreePages(fd), 4u);
+    for (page_id_t page_no : {5, 7, 8, 9}) {
+        EXPECT_TRUE(disk_manager_->IsFreePage(fd, page_no));
+    }
+
+    // 只截断文件末尾连续的回收页面
+    EXPECT_EQ(disk_manager_->TruncateFreePages(fd), 7);
+    EXPECT_EQ(disk_manager_->GetFileSize(filename), 7 * PAGE_SIZE);
+    EXPECT_EQ(disk_manager_->GetNumFreePages(fd), 1u);
+    EXPECT_EQ(disk_manager_->AllocatePage(fd), 5);
+    EXPECT_EQ(disk_manager_->AllocatePage(fd), 7);
+
+    // 被覆盖的页面不再有回收标记, 加载时在此处停止
+    disk_manager_->DeallocatePage(fd, 6);
+    disk_manager_->DeallocatePage(fd, 4);
+    first_free_page_no = disk_manager_->SaveFreePages(fd);
+    rand_buf(buf, PAGE_SIZE);
+    disk_manager_->write_page(fd, 6, buf, PAGE_SIZE);
+    disk_manager_->LoadFreePages(fd, first_free_page_no);
+    EXPECT_EQ(disk_manager_->GetNumFreePages(fd), 1u);
+    EXPECT_TRUE(disk_manager_->IsFreePage(fd, 4));
+
+    disk_manager_->close_file(fd);
+    disk_manager_->destroy_file(filename);
+}
@@ -0,0 +1,96 @@
+#include "storage/frame_arena.h"
+
+#include <dirent.h>           // for opendir
+#include <linux/mempolicy.h>  // for MPOL_INTERLEAVE
+#include <sys/mman.h>         // for mmap/madvise
+#include <sys/syscall.h>      // for SYS_mbind
+#include <unistd.h>           // for syscall
+
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+/** @return 系统中的NUMA节点数, 无法确定时返回1 */
+int CountNumaNodes() {
+    DIR *dir = opendir("/sys/devices/system/node");
+    if (dir == nullptr) {
+        return 1;
+    }
+    int num_nodes = 0;
+    while (struct dirent *entry = readdir(dir)) {
+        if (strncmp(entry->d_name, "node", 4) == 0 && entry->d_name[4] >= '0' && entry->d_name[4] <= '9') {
+            num_nodes++;
+        }
+    }
+    closedir(dir);
+    return num_nodes > 0 ? num_nodes : 1;
+}
+
+}  // namespace
+
+FrameArena::FrameArena(size_t num_frames, bool huge_pages, bool numa_interleave) {
+    size_t num_bytes = num_frames * PAGE_SIZE;
+    if (num_bytes == 0) {
+        num_bytes = PAGE_SIZE;
+    }
+    if (huge_pages) {
+        // 大页映射的长度必须是大页大小的整数倍
+        size_t huge_bytes = (num_bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+        void *addr = mmap(nullptr, huge_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (addr != MAP_FAILED) {
+            base_ = static_cast<char *>(addr);
+            mapped_bytes_ = huge_bytes;
+            backing_ = Backing::HUGETLB;
+        } else {
+            // 没有预留大页: 多映射一个大页的长度, 截掉首尾使起始地址按2MB对齐, 内核才能用透明大页映射整个区域
+            size_t reserve_bytes = huge_bytes + HUGE_PAGE_SIZE;
+            addr = mmap(nullptr, reserve_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (addr == MAP_FAILED) {
+                throw UnixError();
+            }
+            auto start = reinterpret_cast<uintptr_t>(addr);
+            uintptr_t aligned = (start + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+            if (aligned > start) {
+                munmap(addr, aligned - start);
+            }
+            if (start + reserve_bytes > aligned + huge_bytes) {
+                munmap(reinterpret_cast<void *>(aligned + huge_bytes), start + reserve_bytes - aligned - huge_bytes);
+            }
+            base_ = reinterpret_cast<char *>(aligned);
+            mapped_bytes_ = huge_bytes;
+            backing_ = madvise(base_, mapped_bytes_, MADV_HUGEPAGE) == 0 ? Backing::THP : Backing::PLAIN;
+        }
+    } else {
+        void *addr = mmap(nullptr, num_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (addr == MAP_FAILED) {
+            throw UnixError();
+        }
+        base_ = static_cast<char *>(addr);
+        mapped_bytes_ = num_bytes;
+        backing_ = Backing::PLAIN;
+    }
+    if (numa_interleave && CountNumaNodes() > 1) {
+        // 在首次访问之前设置内存策略; 直接使用系统调用, 不依赖libnuma. 不在允许范围内的节点会被内核忽略
+        unsigned long nodemask = ~0UL;
+        numa_interleaved_ = syscall(SYS_mbind, base_, mapped_bytes_, MPOL_INTERLEAVE, &nodemask,
+                                    sizeof(nodemask) * 8, 0) == 0;
+    }
+}
+
+FrameArena::~FrameArena() {
+    if (base_ != nullptr) {
+        munmap(base_, mapped_bytes_);
+    }
+}
+
+const char *FrameArena::BackingName(Backing backing) {
+    switch (backing) {
+        case Backing::HUGETLB:
+            return "hugetlb";
+        case Backing::THP:
+            return "thp";
+        default:
+            return "4k";
+    }
+}
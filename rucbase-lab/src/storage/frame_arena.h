@@ -0,0 +1,65 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Rucbase
+//
+// frame_arena.h
+//
+// Identification: src/storage/frame_arena.h
+//
+// Copyright (c) 2022, RUC Deke Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+#include "common/config.h"
+#include "errors.h"
+
+/**
+ * @brief 缓冲池帧数据所在的内存区域
+ * 所有帧的PAGE_SIZE字节数据连续存放在一段mmap得到的匿名内存中, 每帧按4KB对齐;
+ * 帧的元数据(PageId, pin count, 脏页标记, latch)由BufferPoolManager另外放在Page数组中,
+ * 扫描元数据时不会把页面数据带入cache/TLB
+ */
+class FrameArena {
+   public:
+    /** @brief 帧数据实际使用的页面类型 */
+    enum class Backing {
+        HUGETLB,  // MAP_HUGETLB, 使用系统预留的2MB大页
+        THP,      // 2MB对齐的普通映射, 通过madvise(MADV_HUGEPAGE)请求透明大页
+        PLAIN,    // 4KB普通页面
+    };
+
+    static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    /**
+     * @param num_frames 帧数
+     * @param huge_pages 是否使用大页: 优先MAP_HUGETLB, 没有预留大页时退化为THP, 内核不支持THP时使用普通页面
+     * @param numa_interleave 是否将内存交错分布到各个NUMA节点上, 避免整个缓冲池落在首次访问它的线程所在的节点
+     * @note 映射失败时抛出UnixError
+     */
+    FrameArena(size_t num_frames, bool huge_pages, bool numa_interleave);
+
+    ~FrameArena();
+
+    FrameArena(const FrameArena &) = delete;
+    FrameArena &operator=(const FrameArena &) = delete;
+
+    /** @return 第frame_id帧的数据, 初始全为0 */
+    inline char *GetFrame(frame_id_t frame_id) const { return base_ + static_cast<size_t>(frame_id) * PAGE_SIZE; }
+
+    Backing GetBacking() const { return backing_; }
+
+    /** @return 是否成功设置了NUMA交错分配策略, 只有一个节点或内核不支持时为false */
+    bool IsNumaInterleaved() const { return numa_interleaved_; }
+
+    static const char *BackingName(Backing backing);
+
+   private:
+    char *base_ = nullptr;
+    size_t mapped_bytes_ = 0;
+    Backing backing_ = Backing::PLAIN;
+    bool numa_interleaved_ = false;
+};
@@ -0,0 +1,262 @@
+#include "storage/io_engine.h"
+
+#include <string.h>  // for memset
+#include <unistd.h>  // for pread/pwrite
+
+#include <algorithm>
+
+#ifdef RUCBASE_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>     // for mmap
+#include <sys/syscall.h>  // for __NR_io_uring_*
+#include <sys/uio.h>      // for iovec
+#endif
+
+void IoEngine::Complete(IoRequest &request, std::promise<void> &promise, int err) {
+    if (request.callback) {
+        request.callback(err);
+    }
+    if (err == 0) {
+        promise.set_value();
+    } else {
+        errno = err;
+        promise.set_exception(std::make_exception_ptr(UnixError()));
+    }
+}
+
+std::unique_ptr<IoEngine> IoEngine::Create(unsigned queue_depth, size_t num_threads) {
+#ifdef RUCBASE_HAVE_IO_URING
+    try {
+        return std::make_unique<UringIoEngine>(queue_depth);
+    } catch (UnixError &) {
+        // 内核不支持io_uring, 或被seccomp等禁用, 退化为线程池
+    }
+#endif
+    return std::make_unique<ThreadPoolIoEngine>(num_threads);
+}
+
+/**
+ * ThreadPoolIoEngine
+ */
+ThreadPoolIoEngine::ThreadPoolIoEngine(size_t num_threads) {
+    for (size_t i = 0; i < num_threads; i++) {
+        workers_.emplace_back(&ThreadPoolIoEngine::WorkerLoop, this);
+    }
+}
+
+ThreadPoolIoEngine::~ThreadPoolIoEngine() {
+    {
+        std::scoped_lock lock{latch_};
+        stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto &worker : workers_) {
+        worker.join();
+    }
+}
+
+std::vector<std::future<void>> ThreadPoolIoEngine::Submit(std::vector<IoRequest> requests) {
+    std::vector<std::future<void>> futures;
+    futures.reserve(requests.size());
+    {
+        std::scoped_lock lock{latch_};
+        for (auto &request : requests) {
+            queue_.push_back(Task{std::move(request), std::promise<void>()});
+            futures.push_back(queue_.back().promise.get_future());
+        }
+    }
+    cv_.notify_all();
+    return futures;
+}
+
+void ThreadPoolIoEngine::WorkerLoop() {
+    while (true) {
+        std::unique_lock lock{latch_};
+        cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+        if (queue_.empty()) {
+            return;  // stop_且所有请求都已执行完
+        }
+        Task task = std::move(queue_.front());
+        queue_.pop_front();
+        lock.unlock();
+
+        IoRequest &request = task.request;
+        off_t offset = static_cast<off_t>(request.page_no) * PAGE_SIZE;
+        ssize_t ret = request.op == IoOp::READ ? pread(request.fd, request.buf, request.num_bytes, offset)
+                                               : pwrite(request.fd, request.buf, request.num_bytes, offset);
+        int err = 0;
+        if (ret < 0) {
+            err = errno;
+        } else if (request.op == IoOp::WRITE && ret != request.num_bytes) {
+            err = EIO;
+        }
+        Complete(request, task.promise, err);
+    }
+}
+
+#ifdef RUCBASE_HAVE_IO_URING
+
+/**
+ * UringIoEngine
+ */
+struct UringIoEngine::Pending {
+    IoRequest request;
+    std::promise<void> promise;
+    struct iovec iov;
+};
+
+// io_uring_cqe::user_data为0表示析构时提交的NOP, 通知reaper线程退出
+static constexpr uint64_t URING_STOP_USER_DATA = 0;
+
+UringIoEngine::UringIoEngine(unsigned queue_depth) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_fd_ = syscall(__NR_io_uring_setup, queue_depth, &params);
+    if (ring_fd_ < 0) {
+        throw UnixError();
+    }
+    sq_entries_ = params.sq_entries;
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = false;
+#ifdef IORING_FEAT_SINGLE_MMAP
+    single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+#endif
+    if (single_mmap) {
+        sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+    sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                    IORING_OFF_SQ_RING);
+    cq_ring_ = single_mmap ? sq_ring_
+                           : mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                                  IORING_OFF_CQ_RING);
+    sqes_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+    if (sq_ring_ == MAP_FAILED || cq_ring_ == MAP_FAILED || sqes_ == MAP_FAILED) {
+        int err = errno;
+        if (sq_ring_ != MAP_FAILED) munmap(sq_ring_, sq_ring_size_);
+        if (!single_mmap && cq_ring_ != MAP_FAILED) munmap(cq_ring_, cq_ring_size_);
+        if (sqes_ != MAP_FAILED) munmap(sqes_, sqes_size_);
+        close(ring_fd_);
+        errno = err;
+        throw UnixError();
+    }
+
+    char *sq = static_cast<char *>(sq_ring_);
+    sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    char *cq = static_cast<char *>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+
+    reaper_ = std::thread(&UringIoEngine::ReapLoop, this);
+}
+
+UringIoEngine::~UringIoEngine() {
+    {
+        std::unique_lock lock{submit_latch_};
+        cv_.wait(lock, [this] { return inflight_ == 0; });
+        PushSqe(IORING_OP_NOP, -1, nullptr, 0, 0, URING_STOP_USER_DATA);
+        Enter(1);
+    }
+    reaper_.join();
+    munmap(sqes_, sqes_size_);
+    if (cq_ring_ != sq_ring_) {
+        munmap(cq_ring_, cq_ring_size_);
+    }
+    munmap(sq_ring_, sq_ring_size_);
+    close(ring_fd_);
+}
+
+std::vector<std::future<void>> UringIoEngine::Submit(std::vector<IoRequest> requests) {
+    std::vector<std::future<void>> futures;
+    futures.reserve(requests.size());
+    std::unique_lock lock{submit_latch_};
+    size_t next = 0;
+    while (next < requests.size()) {
+        // 在途请求数不超过SQ大小, 从而CQ(至少为SQ的两倍)永远不会溢出
+        cv_.wait(lock, [this] { return inflight_ < sq_entries_; });
+        unsigned batch = 0;
+        for (; next < requests.size() && inflight_ < sq_entries_; next++, batch++, inflight_++) {
+            auto *pending = new Pending{std::move(requests[next]), std::promise<void>(), {}};
+            futures.push_back(pending->promise.get_future());
+            IoRequest &request = pending->request;
+            pending->iov.iov_base = request.buf;
+            pending->iov.iov_len = request.num_bytes;
+            PushSqe(request.op == IoOp::READ ? IORING_OP_READV : IORING_OP_WRITEV, request.fd, &pending->iov, 1,
+                    static_cast<uint64_t>(request.page_no) * PAGE_SIZE, reinterpret_cast<uint64_t>(pending));
+        }
+        Enter(batch);
+    }
+    return futures;
+}
+
+void UringIoEngine::PushSqe(unsigned char opcode, int fd, void *addr, unsigned len, uint64_t offset,
+                            uint64_t user_data) {
+    unsigned tail = *sq_tail_;  // 只有持有submit_latch_的线程会修改tail
+    unsigned index = tail & *sq_mask_;
+    struct io_uring_sqe *sqe = static_cast<struct io_uring_sqe *>(sqes_) + index;
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(addr);
+    sqe->len = len;
+    sqe->off = offset;
+    sqe->user_data = user_data;
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);  // sqe写完之后内核才能看到新的tail
+}
+
+void UringIoEngine::Enter(unsigned to_submit) {
+    while (to_submit > 0) {
+        int ret = syscall(__NR_io_uring_enter, ring_fd_, to_submit, 0, 0, nullptr, 0);
+        if (ret < 0) {
+            if (errno == EINTR || errno == EAGAIN) {
+                continue;
+            }
+            throw UnixError();
+        }
+        to_submit -= ret;
+    }
+}
+
+void UringIoEngine::ReapLoop() {
+    bool stop = false;
+    while (!stop) {
+        // 被信号打断时CQ可能为空, 下面的循环什么也不做, 重新等待即可
+        syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+        unsigned head = *cq_head_;
+        unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        unsigned completed = 0;
+        for (; head != tail; head++) {
+            struct io_uring_cqe *cqe = cqes_ + (head & *cq_mask_);
+            if (cqe->user_data == URING_STOP_USER_DATA) {
+                stop = true;
+                continue;
+            }
+            auto *pending = reinterpret_cast<Pending *>(cqe->user_data);
+            int err = 0;
+            if (cqe->res < 0) {
+                err = -cqe->res;
+            } else if (pending->request.op == IoOp::WRITE && cqe->res != pending->request.num_bytes) {
+                err = EIO;
+            }
+            Complete(pending->request, pending->promise, err);
+            delete pending;
+            completed++;
+        }
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+        if (completed > 0) {
+            std::scoped_lock lock{submit_latch_};
+            inflight_ -= completed;
+            cv_.notify_all();
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,163 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Rucbase
+//
+// io_engine.h
+//
+// Identification: src/storage/io_engine.h
+//
+// Copyright (c) 2022, RUC Deke Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <functional>
+#include <future>  // NOLINT
+#include <memory>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "errors.h"
+
+enum class IoOp { READ, WRITE };
+
+/**
+ * @brief 一次异步页面读写请求
+ */
+struct IoRequest {
+    IoOp op;
+    int fd;
+    page_id_t page_no;
+    char *buf;      // READ时为目标缓冲区, WRITE时为源缓冲区; 请求完成前调用者必须保证其有效
+    int num_bytes;  // 从页面开头读写的字节数
+    /**
+     * @brief 可选的完成回调, 在I/O线程中调用, 参数为0表示成功, 否则为errno
+     * @note 回调中不应执行耗时操作, 也不应再同步等待其他I/O请求
+     */
+    std::function<void(int)> callback;
+};
+
+/**
+ * @brief 异步I/O引擎, 支持一次批量提交多个页面读写请求
+ * 每个请求完成时先调用其callback, 再就绪对应的future; 失败的请求在future.get()时抛出UnixError
+ * @note READ与pread语义相同: 读到文件末尾时不会报错, 缓冲区剩余部分保持不变
+ */
+class IoEngine {
+   public:
+    virtual ~IoEngine() = default;
+
+    /**
+     * @brief 批量提交I/O请求
+     * @return 与requests一一对应的future
+     */
+    virtual std::vector<std::future<void>> Submit(std::vector<IoRequest> requests) = 0;
+
+    /** @return 引擎名称, 用于日志和benchmark输出 */
+    virtual const char *Name() const = 0;
+
+    /**
+     * @brief 创建当前平台可用的最优引擎: 优先使用io_uring, 内核不支持(或被禁用)时退化为线程池
+     * @param queue_depth io_uring提交队列的深度, 即同时在途的最大请求数
+     * @param num_threads 线程池引擎的工作线程数
+     */
+    static std::unique_ptr<IoEngine> Create(unsigned queue_depth, size_t num_threads);
+
+   protected:
+    /** 请求执行完成: 调用回调并设置future的结果 */
+    static void Complete(IoRequest &request, std::promise<void> &promise, int err);
+};
+
+/**
+ * @brief 基于线程池的后备引擎, 每个工作线程执行阻塞的pread/pwrite
+ */
+class ThreadPoolIoEngine : public IoEngine {
+   public:
+    explicit ThreadPoolIoEngine(size_t num_threads);
+
+    ~ThreadPoolIoEngine() override;
+
+    std::vector<std::future<void>> Submit(std::vector<IoRequest> requests) override;
+
+    const char *Name() const override { return "thread-pool"; }
+
+   private:
+    struct Task {
+        IoRequest request;
+        std::promise<void> promise;
+    };
+
+    void WorkerLoop();
+
+    std::vector<std::thread> workers_;
+    std::deque<Task> queue_;  // 待执行的请求
+    std::mutex latch_;        // 保护queue_和stop_
+    std::condition_variable cv_;
+    bool stop_ = false;
+};
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define RUCBASE_HAVE_IO_URING 1
+
+struct io_uring_cqe;  // 定义在<linux/io_uring.h>中, 只在io_engine.cpp中引入
+
+/**
+ * @brief 基于io_uring的引擎, 直接使用io_uring_setup/io_uring_enter系统调用, 不依赖liburing
+ * 提交线程在submit_latch_保护下填写SQ并调用一次io_uring_enter提交整个批次;
+ * 一个reaper线程阻塞等待CQ中的完成事件并分发回调
+ */
+class UringIoEngine : public IoEngine {
+   public:
+    /**
+     * @throws UnixError 内核不支持io_uring或创建失败
+     */
+    explicit UringIoEngine(unsigned queue_depth);
+
+    ~UringIoEngine() override;
+
+    std::vector<std::future<void>> Submit(std::vector<IoRequest> requests) override;
+
+    const char *Name() const override { return "io_uring"; }
+
+   private:
+    struct Pending;
+
+    void ReapLoop();
+
+    /** 在submit_latch_下将一个sqe放入SQ, 调用者保证SQ未满 */
+    void PushSqe(unsigned char opcode, int fd, void *addr, unsigned len, uint64_t offset, uint64_t user_data);
+
+    /** 在submit_latch_下把SQ中的to_submit个sqe提交给内核 */
+    void Enter(unsigned to_submit);
+
+    int ring_fd_ = -1;
+    unsigned sq_entries_ = 0;
+
+    // SQ/CQ ring的mmap区域
+    void *sq_ring_ = nullptr;
+    size_t sq_ring_size_ = 0;
+    void *cq_ring_ = nullptr;
+    size_t cq_ring_size_ = 0;
+    void *sqes_ = nullptr;
+    size_t sqes_size_ = 0;
+
+    // 指向ring中内核共享字段的指针
+    unsigned *sq_tail_ = nullptr;
+    unsigned *sq_mask_ = nullptr;
+    unsigned *sq_array_ = nullptr;
+    unsigned *cq_head_ = nullptr;
+    unsigned *cq_tail_ = nullptr;
+    unsigned *cq_mask_ = nullptr;
+    struct io_uring_cqe *cqes_ = nullptr;
+
+    std::mutex submit_latch_;        // 保护SQ和inflight_
+    std::condition_variable cv_;     // 在途请求数减少时唤醒等待提交的线程
+    unsigned inflight_ = 0;          // 已提交但尚未完成的请求数, 不超过sq_entries_
+    std::thread reaper_;
+};
+
+#endif
@@ -46,13 +46,15 @@ struct PageIdHash {
  @brief Page类声明, Page是rucbase数据块的单位.
  @note Page是负责数据操作Record模块的操作对象.
  @note Page对象在磁盘上有文件存储, 若在Buffer中则有帧偏移, 并非特指Buffer或Disk上的数据
+ @note Page对象本身只包含帧的元数据, 页面数据位于BufferPoolManager的FrameArena中;
+ 按cache line对齐, 相邻帧的latch和pin count不会落在同一个cache line上
  */
-class Page {
+class alignas(64) Page {
     friend class BufferPoolManager;
 
    public:
-    /** Constructor. Zeros out the page data. */
-    Page() { ResetMemory(); }
+    /** Constructor. 页面数据由BufferPoolManager分配帧时设置 */
+    Page() = default;
 
     /** Default destructor. */
     ~Page() = default;
@@ -91,9 +93,9 @@ class Page {
     PageId id_;
 
     /** The actual data that is stored within a page.
-     *  该页面在bufferPool中的偏移地址
+     *  该页面在bufferPool中的偏移地址, 指向FrameArena中按4KB对齐的PAGE_SIZE字节
      */
-    char data_[PAGE_SIZE] = {};
+    char *data_ = nullptr;
 
     /** 脏页判断 */
     bool is_dirty_ = false;
@@ -101,6 +103,12 @@ class Page {
     /** The pin count of this page. */
     int pin_count_ = 0;
 
+    /** 页面数据正在从磁盘读入, BufferPoolManager在latch之外执行读取, 完成前其他线程不能访问data_ */
+    bool io_pending_ = false;
+
+    /** 页面由后台清理线程写回后没有再被修改, 淘汰时省去了一次同步写 */
+    bool cleaned_ = false;
+
     /** Page latch. */
     ReaderWriterLatch rwlatch_;
 };
\ No newline at end of file
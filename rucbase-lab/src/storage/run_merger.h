@@ -0,0 +1,148 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include "common/macros.h"
+#include "spill_file.h"
+
+/**
+ * @brief 败者树: 从k个有序序列的当前元素中选出最小的一个. 内部结点记录比赛的败者, 某个序列的当前元素改变后
+ * 只需沿它到根的路径重新比较, 每取出一个元素比较log(k)次
+ */
+class LoserTree {
+   private:
+    int k_;
+    std::vector<int> tree_;              // tree_[0]为胜者, tree_[1, k)为内部结点的败者, -1表示还没有序列到达
+    std::function<bool(int, int)> less_;  // 序列a的当前元素是否排在序列b之前
+
+   public:
+    LoserTree(int k, std::function<bool(int, int)> less) : k_(k), tree_(k, -1), less_(std::move(less)) {
+        // 每个内部结点在两个子树各到达一次之后确定败者, 第二次到达的比赛胜者继续向上
+        for (int s = k_ - 1; s >= 0; s--) {
+            adjust(s);
+        }
+    }
+
+    int top() const { return tree_[0]; }
+
+    /**
+     * @brief 序列s的当前元素改变后, 从它的叶子开始重新比赛到根
+     */
+    void adjust(int s) {
+        for (int t = (s + k_) / 2; t > 0; t /= 2) {
+            if (tree_[t] == -1) {
+                tree_[t] = s;
+                return;
+            }
+            if (less_(tree_[t], s)) {
+                std::swap(s, tree_[t]);
+            }
+        }
+        tree_[0] = s;
+    }
+};
+
+/**
+ * @brief 用败者树对若干个有序的run做k路归并, 相等的元组按run的顺序输出
+ * 外部排序(SortExecutor)和批量建索引(IxBulkLoader)共用: 先把内存中排好序的元组写成SpillFile,
+ * 再用reduce把run的个数降到一次能归并的个数以内, 最后逐个取出归并结果
+ */
+class RunMerger {
+   public:
+    using Compare = std::function<int(const char *, const char *)>;
+    using Equal = std::function<bool(const char *, const char *)>;
+
+   private:
+    std::vector<std::unique_ptr<SpillFile>> runs_;
+    std::vector<std::vector<char>> heads_;  // 每个run的当前元组
+    std::vector<bool> exhausted_;           // 已经读完的run, 比任何元组都大
+    std::unique_ptr<LoserTree> tree_;
+
+   public:
+    RunMerger(std::vector<std::unique_ptr<SpillFile>> runs, size_t tuple_len, const Compare &compare)
+        : runs_(std::move(runs)), heads_(runs_.size(), std::vector<char>(tuple_len)), exhausted_(runs_.size()) {
+        assert(!runs_.empty());
+        for (size_t i = 0; i < runs_.size(); i++) {
+            runs_[i]->rewind();
+            exhausted_[i] = !runs_[i]->read(heads_[i].data());
+        }
+        tree_ = std::make_unique<LoserTree>(runs_.size(), [this, compare](int a, int b) {
+            if (exhausted_[a] || exhausted_[b]) {
+                return !exhausted_[a] || (exhausted_[b] && a < b);
+            }
+            int cmp = compare(heads_[a].data(), heads_[b].data());
+            return cmp < 0 || (cmp == 0 && a < b);
+        });
+    }
+
+    DISALLOW_COPY_AND_MOVE(RunMerger);
+
+    bool is_end() const { return exhausted_[tree_->top()]; }
+
+    const char *top() const { return heads_[tree_->top()].data(); }
+
+    void pop() {
+        int s = tree_->top();
+        exhausted_[s] = !runs_[s]->read(heads_[s].data());
+        tree_->adjust(s);
+    }
+
+    /** @return memory字节的内存一次能归并的run的个数, 每个打开的run占用一个SpillFile的块 */
+    static size_t fan_in(size_t memory, size_t tuple_len) {
+        return std::max<size_t>(2, memory / SpillFile::block_size(tuple_len));
+    }
+
+    /**
+     * @brief 把runs归并成一个新的run
+     *
+     * @param equal 不为空时, 与上一个写出的元组相等的元组不写出
+     */
+    static std::unique_ptr<SpillFile> merge(std::vector<std::unique_ptr<SpillFile>> runs, DiskManager *disk_manager,
+                                            size_t tuple_len, const Compare &compare, const Equal &equal = nullptr) {
+        auto out = std::make_unique<SpillFile>(disk_manager, tuple_len);
+        std::vector<char> last(tuple_len);
+        bool empty = true;
+        for (RunMerger merger(std::move(runs), tuple_len, compare); !merger.is_end(); merger.pop()) {
+            if (equal != nullptr && !empty && equal(last.data(), merger.top())) {
+                continue;
+            }
+            out->write(merger.top());
+            if (equal != nullptr) {
+                memcpy(last.data(), merger.top(), tuple_len);
+            }
+            empty = false;
+        }
+        return out;
+    }
+
+    /**
+     * @brief 每次归并相邻的fan_in个run, 直到剩下的run不超过fan_in个; 相邻归并保持相等元组的先后顺序
+     *
+     * @param equal 同merge
+     */
+    static std::vector<std::unique_ptr<SpillFile>> reduce(std::vector<std::unique_ptr<SpillFile>> runs,
+                                                          DiskManager *disk_manager, size_t tuple_len,
+                                                          const Compare &compare, size_t fan_in,
+                                                          const Equal &equal = nullptr) {
+        while (runs.size() > fan_in) {
+            std::vector<std::unique_ptr<SpillFile>> merged;
+            for (size_t i = 0; i < runs.size(); i += fan_in) {
+                auto end = runs.begin() + std::min(i + fan_in, runs.size());
+                std::vector<std::unique_ptr<SpillFile>> group(std::make_move_iterator(runs.begin() + i),
+                                                              std::make_move_iterator(end));
+                if (group.size() == 1) {
+                    merged.push_back(std::move(group.front()));
+                    continue;
+                }
+                merged.push_back(merge(std::move(group), disk_manager, tuple_len, compare, equal));
+            }
+            runs = std::move(merged);
+        }
+        return runs;
+    }
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <unistd.h>
+
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <string>
+
+#include "common/macros.h"
+#include "storage/disk_manager.h"
+
+/**
+ * @brief 溢出到磁盘的定长元组序列(外部排序和批量建索引的run, 哈希连接的分区)
+ * 通过DiskManager读写数据库目录下的临时文件, 每次读写SPILL_FILE_BLOCK_PAGES个页面; 元组不跨块存放.
+ * 元组顺序写入, 写完后rewind, 再从头顺序读出; 析构时关闭并删除文件
+ */
+class SpillFile {
+   private:
+    DiskManager *disk_manager_;
+    std::string path_;
+    int fd_;
+    size_t tuple_len_;
+    size_t block_size_;  // 字节数, PAGE_SIZE的整数倍, 至少能放下一个元组
+    AlignedBuffer block_;
+    size_t block_pos_ = 0;     // 下一个元组在block_中的偏移
+    page_id_t next_page_ = 0;  // 下一次读写的块的第一个页号
+    size_t num_tuples_ = 0;
+    size_t num_read_ = 0;
+    bool sealed_ = false;  // 已经rewind, 最后一个块已经写入
+
+   public:
+    SpillFile(DiskManager *disk_manager, size_t tuple_len) : disk_manager_(disk_manager), tuple_len_(tuple_len) {
+        static std::atomic<size_t> next_id{0};
+        path_ = "spill." + std::to_string(getpid()) + "." + std::to_string(next_id++);
+        block_size_ = block_size(tuple_len);
+        block_ = DiskManager::AllocateAlignedBuffer(block_size_);
+        disk_manager_->create_file(path_);
+        fd_ = disk_manager_->open_file(path_);
+    }
+
+    ~SpillFile() {
+        disk_manager_->close_file(fd_);
+        disk_manager_->destroy_file(path_);
+    }
+
+    DISALLOW_COPY(SpillFile);
+
+    void write(const char *tuple) {
+        assert(!sealed_);
+        if (block_pos_ + tuple_len_ > block_size_) {
+            write_block();
+        }
+        memcpy(block_.get() + block_pos_, tuple, tuple_len_);
+        block_pos_ += tuple_len_;
+        num_tuples_++;
+    }
+
+    /** 写完之后调用, 之后从第一个元组开始read */
+    void rewind() {
+        if (!sealed_ && block_pos_ > 0) {
+            write_block();
+        }
+        sealed_ = true;
+        next_page_ = 0;
+        num_read_ = 0;
+        block_pos_ = block_size_;  // 下一次read读入第一个块
+    }
+
+    /** @return 是否读到了元组, false表示已经读完 */
+    bool read(char *tuple) {
+        if (num_read_ == num_tuples_) {
+            return false;
+        }
+        if (block_pos_ + tuple_len_ > block_size_) {
+            disk_manager_->read_page(fd_, next_page_, block_.get(), block_size_);
+            next_page_ += block_size_ / PAGE_SIZE;
+            block_pos_ = 0;
+        }
+        memcpy(tuple, block_.get() + block_pos_, tuple_len_);
+        block_pos_ += tuple_len_;
+        num_read_++;
+        return true;
+    }
+
+    size_t size() const { return num_tuples_ * tuple_len_; }
+
+    /** @return 元组长度为tuple_len时每次读写的字节数, 也是一个SpillFile占用的内存 */
+    static size_t block_size(size_t tuple_len) {
+        size_t pages = std::max<size_t>(SPILL_FILE_BLOCK_PAGES, (tuple_len + PAGE_SIZE - 1) / PAGE_SIZE);
+        return pages * PAGE_SIZE;
+    }
+
+   private:
+    void write_block() {
+        disk_manager_->write_page(fd_, next_page_, block_.get(), block_size_);
+        next_page_ += block_size_ / PAGE_SIZE;
+        block_pos_ = 0;
+    }
+};
@@ -4,3 +4,4 @@
 #include <string>
 
 static const std::string DB_META_NAME = "db.meta";
+static const std::string BUFFER_STATS_FILE_NAME = "buffer_stats.json";
@@ -1,6 +1,10 @@
 #undef NDEBUG
 
 #include <cassert>
+#include <map>
+#include <random>
+#include <set>
+#include <sstream>
 #include <string>
 
 #include "gtest/gtest.h"
@@ -68,6 +72,32 @@ TEST(SystemManagerTest, SimpleTest) {
     }
     // Create index for table 2
     sm_manager->create_index(tab2, "b", context);
+    // Vacuum table 2 and its index
+    offset = 0;
+    sm_manager->vacuum_table(tab2, context);
+    assert(std::string(result, offset).find(tab2) != std::string::npos);
+    assert(std::string(result, offset).find(ix_manager->get_index_name(tab2, 1)) != std::string::npos);
+    // Buffer pool statistics of all open files, also dumped to the db directory
+    offset = 0;
+    sm_manager->show_buffer_stats(context);
+    assert(std::string(result, offset).find(tab2) != std::string::npos);
+    assert(std::string(result, offset).find("TOTAL") != std::string::npos);
+    {
+        std::stringstream ss;
+        sm_manager->dump_buffer_stats(ss);
+        assert(ss.str().find("\"file\":\"" + tab2 + "\"") != std::string::npos);
+        assert(disk_manager->is_file(BUFFER_STATS_FILE_NAME));
+    }
+    // B+tree statistics of all open indexes
+    offset = 0;
+    sm_manager->show_index_stats(context);
+    assert(std::string(result, offset).find(ix_manager->get_index_name(tab2, 1)) != std::string::npos);
+    // Cannot vacuum table that does not exist
+    try {
+        sm_manager->vacuum_table("tab3", context);
+        assert(0);
+    } catch (TableNotFoundError &) {
+    }
     // Drop index of table 1
     sm_manager->drop_index(tab1, "a", context);
     // Cannot drop index that does not exist
@@ -87,4 +117,141 @@ TEST(SystemManagerTest, SimpleTest) {
     // Clean up
     sm_manager->close_db();
     sm_manager->drop_db(db);
-}
\ No newline at end of file
+}
+using KeyList = std::vector<std::pair<int, std::string>>;
+
+/**
+ * @brief 按(a, c)扫描索引中[lower, upper)范围内的记录, 返回记录的(a, c)
+ */
+static KeyList ScanIndex(SmManager *sm_manager, const std::string &tab_name, IxIndexHandle *ih, const Iid &lower,
+                         const Iid &upper) {
+    KeyList result;
+    auto fh = sm_manager->fhs_.at(tab_name).get();
+    for (IxScan scan(ih, lower, upper, sm_manager->get_bpm()); !scan.is_end(); scan.next()) {
+        auto rec = fh->get_record(scan.rid(), nullptr);
+        result.emplace_back(*(int *)rec->data, std::string(rec->data + 8, strnlen(rec->data + 8, 16)));
+    }
+    return result;
+}
+
+// 多列索引: 元数据的持久化, 增删记录时所有索引的维护, 以及按key前缀的范围扫描
+TEST(SystemManagerTest, CompositeIndexTest) {
+    std::string db = "db_composite";
+    std::string tab = "tab";
+
+    auto disk_manager = std::make_unique<DiskManager>();
+    auto buffer_pool_manager = std::make_unique<BufferPoolManager>(BUFFER_POOL_SIZE, disk_manager.get());
+    auto rm_manager = std::make_unique<RmManager>(disk_manager.get(), buffer_pool_manager.get());
+    auto ix_manager = std::make_unique<IxManager>(disk_manager.get(), buffer_pool_manager.get());
+    auto sm_manager =
+        std::make_unique<SmManager>(disk_manager.get(), buffer_pool_manager.get(), rm_manager.get(), ix_manager.get());
+    char *result = new char[BUFFER_LENGTH];
+    int offset = 0;
+    Context *context = new Context(nullptr, nullptr, nullptr, result, &offset);
+
+    if (sm_manager->is_dir(db)) {
+        sm_manager->drop_db(db);
+    }
+    sm_manager->create_db(db);
+    sm_manager->open_db(db);
+    std::vector<ColDef> col_defs = {{.name = "a", .type = TYPE_INT, .len = 4},
+                                    {.name = "b", .type = TYPE_FLOAT, .len = 4},
+                                    {.name = "c", .type = TYPE_STRING, .len = 16}};
+    sm_manager->create_table(tab, col_defs, context);
+
+    // (a, c)互不相同: c唯一, a只有20种取值, 使每个a对应很多个c
+    std::mt19937 rng(0);
+    std::set<std::pair<int, std::string>> mock;
+    std::map<std::pair<int, std::string>, Rid> rids;
+    auto make_record = [&](int i, RmRecord *rec) {
+        memset(rec->data, 0, rec->size);
+        int a = static_cast<int>(rng() % 20);
+        float b = static_cast<float>(i);
+        char c[17];
+        snprintf(c, sizeof(c), "key%05d", static_cast<int>(rng() % 100000) * 10 + i % 10);
+        memcpy(rec->data, &a, sizeof(int));
+        memcpy(rec->data + 4, &b, sizeof(float));
+        memcpy(rec->data + 8, c, strlen(c));
+        return std::make_pair(a, std::string(c));
+    };
+    RmRecord rec(24);
+    for (int i = 0; i < 2000; i++) {
+        auto key = make_record(i, &rec);
+        if (mock.insert(key).second) {
+            rids[key] = sm_manager->fhs_.at(tab)->insert_record(rec.data, context);
+        }
+    }
+    // 多列索引从已有的记录构建, 单列索引与之共存
+    sm_manager->create_index(tab, std::vector<std::string>{"a", "c"}, context);
+    sm_manager->create_index(tab, "a", context);
+    try {
+        sm_manager->create_index(tab, std::vector<std::string>{"a", "c"}, context);
+        assert(0);
+    } catch (IndexExistsError &) {
+    }
+    // 记录的插入和删除通过回滚接口完成, 它们与执行器一样维护表上的所有索引
+    for (int i = 2000; i < 2500; i++) {
+        auto key = make_record(i, &rec);
+        if (mock.insert(key).second) {
+            sm_manager->rollback_delete(tab, rec, context);
+            auto &index = sm_manager->db_.get_table(tab).indexes[0];
+            std::vector<char> ix_key(index.col_tot_len);
+            sm_manager->db_.get_table(tab).get_index_key(index, rec.data, ix_key.data());
+            std::vector<Rid> found;
+            assert(sm_manager->get_index_handle(tab, index)->GetValue(ix_key.data(), &found, nullptr));
+            rids[key] = found[0];
+        }
+    }
+    for (int i = 0; i < 300; i++) {
+        auto it = std::next(mock.begin(), static_cast<int>(rng() % mock.size()));
+        sm_manager->rollback_insert(tab, rids.at(*it), context);
+        mock.erase(it);
+    }
+
+    // 索引的元数据随表的元数据一起保存
+    TabMeta tab_meta;
+    {
+        std::stringstream ss;
+        ss << sm_manager->db_.get_table(tab);
+        ss >> tab_meta;
+    }
+    assert(tab_meta.indexes.size() == 2);
+    assert(tab_meta.indexes[0].col_idxs == std::vector<int>({0, 2}));
+    assert(tab_meta.indexes[0].col_tot_len == 20);
+    assert(tab_meta.cols[0].index && !tab_meta.cols[2].index);
+    auto ih = sm_manager->get_index_handle(tab, tab_meta.indexes[0]);
+
+    // 整个索引按(a, c)的字典序排列
+    auto all = ScanIndex(sm_manager.get(), tab, ih, ih->leaf_begin(), ih->leaf_end());
+    assert(all == KeyList(mock.begin(), mock.end()));
+    // a的等值前缀: c填充最小值和最大值, 得到a相同的所有key
+    for (int a = -1; a <= 20; a++) {
+        char lower[20], upper[20];
+        memcpy(lower, &a, 4);
+        memcpy(upper, &a, 4);
+        memset(lower + 4, 0, 16);
+        memset(upper + 4, 0xff, 16);
+        auto found = ScanIndex(sm_manager.get(), tab, ih, ih->lower_bound(lower), ih->upper_bound(upper));
+        auto first = mock.lower_bound({a, ""});
+        auto last = mock.lower_bound({a + 1, ""});
+        assert(found == KeyList(first, last));
+        // 前缀之后的下一列上的范围: c > "key5"
+        memset(lower + 4, 0, 16);
+        memcpy(lower + 4, "key5", 4);
+        found = ScanIndex(sm_manager.get(), tab, ih, ih->upper_bound(lower), ih->upper_bound(upper));
+        first = mock.upper_bound({a, "key5"});
+        assert(found == KeyList(first, last));
+    }
+
+    sm_manager->drop_index(tab, std::vector<std::string>{"a", "c"}, context);
+    // 索引列的顺序不同就是不同的索引
+    try {
+        sm_manager->drop_index(tab, std::vector<std::string>{"c", "a"}, context);
+        assert(0);
+    } catch (IndexNotFoundError &) {
+    }
+    assert(sm_manager->db_.get_table(tab).indexes.size() == 1);
+    sm_manager->drop_table(tab, context);
+    sm_manager->close_db();
+    sm_manager->drop_db(db);
+}
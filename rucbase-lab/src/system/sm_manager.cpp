@@ -3,6 +3,7 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <fstream>
 
 #include "index/ix.h"
@@ -67,14 +68,11 @@ void SmManager::open_db(const std::string &db_name) {
         auto &tab = entry.second;
         // fhs_[tab.name] = rm_manager_->open_file(tab.name);
         fhs_.emplace(tab.name, rm_manager_->open_file(tab.name));
-        for (size_t i = 0; i < tab.cols.size(); i++) {
-            auto &col = tab.cols[i];
-            if (col.index) {
-                auto index_name = ix_manager_->get_index_name(tab.name, i);
-                assert(ihs_.count(index_name) == 0);
-                // ihs_[index_name] = ix_manager_->open_index(tab.name, i);
-                ihs_.emplace(index_name, ix_manager_->open_index(tab.name, i));
-            }
+        for (auto &index : tab.indexes) {
+            auto index_name = ix_manager_->get_index_name(tab.name, index.col_idxs);
+            assert(ihs_.count(index_name) == 0);
+            // ihs_[index_name] = ix_manager_->open_index(tab.name, i);
+            ihs_.emplace(index_name, ix_manager_->open_index(tab.name, index.col_idxs));
         }
     }
 }
@@ -171,57 +169,224 @@ void SmManager::drop_table(const std::string &tab_name, Context *context) {
 	rm_manager_->close_file(fhs_.at(tab_name).get());
 	rm_manager_->destroy_file(tab_name);
 	//close & destroy index file
-	for(auto &col: tab.cols){
-		if(col.index){ // if has index, then delete
-			drop_index(tab_name, col.name, context);
+	while(!tab.indexes.empty()){ // if has index, then delete
+		std::vector<std::string> col_names;
+		for(int col_idx: tab.indexes.back().col_idxs){
+			col_names.push_back(tab.cols[col_idx].name);
 		}
+		drop_index(tab_name, col_names, context);
 	}
 	db_.tabs_.erase(tab_name);
 	fhs_.erase(tab_name);
 }
 
 void SmManager::create_index(const std::string &tab_name, const std::string &col_name, Context *context) {
+    create_index(tab_name, std::vector<std::string>{col_name}, context);
+}
+
+void SmManager::create_index(const std::string &tab_name, const std::vector<std::string> &col_names,
+                             Context *context) {
     TabMeta &tab = db_.get_table(tab_name);
-    auto col = tab.get_col(col_name);
-    if (col->index) {
-        throw IndexExistsError(tab_name, col_name);
+    std::vector<int> col_idxs = get_index_cols(tab, col_names);
+    if (tab.find_index(col_idxs) != tab.indexes.end()) {
+        throw IndexExistsError(tab_name, col_names);
+    }
+    IndexMeta index = {.col_idxs = col_idxs, .col_tot_len = 0};
+    std::vector<ColType> col_types;
+    std::vector<int> col_lens;
+    for (int col_idx : col_idxs) {
+        col_types.push_back(tab.cols[col_idx].type);
+        col_lens.push_back(tab.cols[col_idx].len);
+        index.col_tot_len += tab.cols[col_idx].len;
     }
     // Create index file
-    int col_idx = col - tab.cols.begin();
-    ix_manager_->create_index(tab_name, col_idx, col->type, col->len);  // 这里调用了
+    // 表中的记录可能有相同的key, SQL创建的索引都是非唯一索引
+    ix_manager_->create_index(tab_name, col_idxs, col_types, col_lens, IX_COMPRESS_STRING_KEYS, false);
     // Open index file
-    auto ih = ix_manager_->open_index(tab_name, col_idx);
+    auto ih = ix_manager_->open_index(tab_name, col_idxs);
     // Get record file handle
     auto file_handle = fhs_.at(tab_name).get();
     // Index all records into index
-    for (RmScan rm_scan(file_handle); !rm_scan.is_end(); rm_scan.next()) {
-        auto rec = file_handle->get_record(rm_scan.rid(), context);  // rid是record的存储位置，作为value插入到索引里
-        const char *key = rec->data + col->offset;
-        // record data里以各个属性的offset进行分隔，属性的长度为col len，record里面每个属性的数据作为key插入索引里
-        ih->insert_entry(key, rm_scan.rid(), context->txn_);
+    // record data里以各个属性的offset进行分隔, 索引的各列拼接成key插入索引里, rid是record的存储位置，作为value
+    std::vector<char> key(index.col_tot_len);
+    if (IX_BULK_LOAD) {
+        // 收集所有(key, rid)排序后自底向上构建B+树, 比逐条插入少了每条记录从根结点开始的查找和结点分裂
+        IxBulkLoader bulk_loader(ih.get());
+        for (RmScan rm_scan(file_handle); !rm_scan.is_end(); rm_scan.next()) {
+            auto rec = file_handle->get_record(rm_scan.rid(), context);
+            tab.get_index_key(index, rec->data, key.data());
+            bulk_loader.Add(key.data(), rm_scan.rid());
+        }
+        bulk_loader.Finish();
+    } else {
+        for (RmScan rm_scan(file_handle); !rm_scan.is_end(); rm_scan.next()) {
+            auto rec = file_handle->get_record(rm_scan.rid(), context);
+            tab.get_index_key(index, rec->data, key.data());
+            ih->insert_entry(key.data(), rm_scan.rid(), context->txn_);
+        }
     }
     // Store index handle
-    auto index_name = ix_manager_->get_index_name(tab_name, col_idx);
+    auto index_name = ix_manager_->get_index_name(tab_name, col_idxs);
     assert(ihs_.count(index_name) == 0);
     // ihs_[index_name] = std::move(ih);
     ihs_.emplace(index_name, std::move(ih));
-    // Mark column index as created
-    col->index = true;
+    // Mark index as created, 单列索引同时标记在列上
+    tab.indexes.push_back(index);
+    if (col_idxs.size() == 1) {
+        tab.cols[col_idxs[0]].index = true;
+    }
 }
 
 void SmManager::drop_index(const std::string &tab_name, const std::string &col_name, Context *context) {
+    drop_index(tab_name, std::vector<std::string>{col_name}, context);
+}
+
+void SmManager::drop_index(const std::string &tab_name, const std::vector<std::string> &col_names,
+                           Context *context) {
     TabMeta &tab = db_.tabs_[tab_name];
-    auto col = tab.get_col(col_name);
-    if (!col->index) {
-        throw IndexNotFoundError(tab_name, col_name);
+    std::vector<int> col_idxs = get_index_cols(tab, col_names);
+    auto index = tab.find_index(col_idxs);
+    if (index == tab.indexes.end()) {
+        throw IndexNotFoundError(tab_name, col_names);
     }
-    int col_idx = col - tab.cols.begin();
-    auto index_name = ix_manager_->get_index_name(tab_name, col_idx);
+    auto index_name = ix_manager_->get_index_name(tab_name, col_idxs);
     ix_manager_->close_index(ihs_.at(index_name).get());
-    ix_manager_->destroy_index(tab_name, col_idx);
+    ix_manager_->destroy_index(tab_name, col_idxs);
     ihs_.erase(index_name);
-    col->index = false;
+    tab.indexes.erase(index);
+    if (col_idxs.size() == 1) {
+        tab.cols[col_idxs[0]].index = false;
+    }
+}
+
+std::vector<int> SmManager::get_index_cols(TabMeta &tab, const std::vector<std::string> &col_names) {
+    std::vector<int> col_idxs;
+    for (auto &col_name : col_names) {
+        col_idxs.push_back(tab.get_col(col_name) - tab.cols.begin());
+    }
+    return col_idxs;
+}
+
+/**
+ * @brief 回收表文件中的空页面, 并截断表文件和索引文件末尾连续的回收页面
+ * 索引文件中的回收页面来自B+树删除时合并掉的结点
+ */
+void SmManager::vacuum_table(const std::string &tab_name, Context *context) {
+    TabMeta &tab = db_.get_table(tab_name);
+    std::vector<std::string> captions = {"File", "Pages", "Free", "Truncated"};
+    RecordPrinter printer(captions.size());
+    printer.print_separator(context);
+    printer.print_record(captions, context);
+    printer.print_separator(context);
+
+    RmFileHandle *fh = fhs_.at(tab_name).get();
+    int num_truncated = fh->vacuum();
+    printer.print_record({tab_name, std::to_string(disk_manager_->get_fd2pageno(fh->GetFd())),
+                          std::to_string(disk_manager_->GetNumFreePages(fh->GetFd())), std::to_string(num_truncated)},
+                         context);
+    for (auto &index : tab.indexes) {
+        auto index_name = ix_manager_->get_index_name(tab_name, index.col_idxs);
+        IxIndexHandle *ih = ihs_.at(index_name).get();
+        num_truncated = ih->vacuum();
+        printer.print_record({index_name, std::to_string(disk_manager_->get_fd2pageno(ih->GetFd())),
+                              std::to_string(disk_manager_->GetNumFreePages(ih->GetFd())),
+                              std::to_string(num_truncated)},
+                             context);
+    }
+    printer.print_separator(context);
+}
+
+std::vector<std::pair<std::string, int>> SmManager::get_open_files() {
+    std::vector<std::pair<std::string, int>> files;
+    for (auto &entry : fhs_) {
+        files.emplace_back(entry.first, entry.second->GetFd());
+    }
+    for (auto &entry : ihs_) {
+        files.emplace_back(entry.first, entry.second->GetFd());
+    }
+    std::sort(files.begin(), files.end());
+    return files;
 }
+
+void SmManager::show_buffer_stats(Context *context) {
+    std::vector<std::string> captions = {"File",         "Hits",      "Misses",       "Hit ratio",  "Evictions",
+                                         "Dirty writes", "Pin waits", "Pin wait(us)", "Disk reads", "Disk writes"};
+    RecordPrinter printer(captions.size());
+    printer.print_separator(context);
+    printer.print_record(captions, context);
+    printer.print_separator(context);
+
+    auto format_row = [](const std::string &name, const BufferPoolStats &bp, const DiskFileStats &disk) {
+        char hit_ratio[16];
+        snprintf(hit_ratio, sizeof(hit_ratio), "%.2f%%", bp.HitRatio() * 100);
+        return std::vector<std::string>{name,
+                                        std::to_string(bp.hits),
+                                        std::to_string(bp.misses),
+                                        hit_ratio,
+                                        std::to_string(bp.evictions),
+                                        std::to_string(bp.dirty_writes),
+                                        std::to_string(bp.pin_waits),
+                                        std::to_string(bp.pin_wait_us),
+                                        std::to_string(disk.reads),
+                                        std::to_string(disk.writes)};
+    };
+    BufferPoolStats total_bp;
+    DiskFileStats total_disk;
+    for (auto &[name, fd] : get_open_files()) {
+        BufferPoolStats bp = buffer_pool_manager_->GetBufferPoolStats(fd);
+        DiskFileStats disk = disk_manager_->GetDiskFileStats(fd);
+        printer.print_record(format_row(name, bp, disk), context);
+        total_bp += bp;
+        total_disk.reads += disk.reads;
+        total_disk.writes += disk.writes;
+    }
+    printer.print_separator(context);
+    printer.print_record(format_row("TOTAL", total_bp, total_disk), context);
+    printer.print_separator(context);
+
+    std::ofstream ofs(BUFFER_STATS_FILE_NAME);
+    dump_buffer_stats(ofs);
+}
+
+void SmManager::dump_buffer_stats(std::ostream &os) {
+    // 文件名只可能是表名或"表名.列号.idx", 不含需要转义的字符
+    for (auto &[name, fd] : get_open_files()) {
+        BufferPoolStats bp = buffer_pool_manager_->GetBufferPoolStats(fd);
+        DiskFileStats disk = disk_manager_->GetDiskFileStats(fd);
+        os << "{\"file\":\"" << name << "\",\"hits\":" << bp.hits << ",\"misses\":" << bp.misses
+           << ",\"hit_ratio\":" << bp.HitRatio() << ",\"evictions\":" << bp.evictions
+           << ",\"dirty_writes\":" << bp.dirty_writes << ",\"pin_waits\":" << bp.pin_waits
+           << ",\"pin_wait_us\":" << bp.pin_wait_us << ",\"disk_reads\":" << disk.reads
+           << ",\"disk_writes\":" << disk.writes << ",\"bytes_read\":" << disk.bytes_read
+           << ",\"bytes_written\":" << disk.bytes_written << "}\n";
+    }
+}
+
+void SmManager::show_index_stats(Context *context) {
+    std::vector<std::string> captions = {"Index",        "Height",      "Descents", "Avg depth", "Pinned pages",
+                                         "Pinned hits", "Splits", "Merges",   "Redistributions"};
+    RecordPrinter printer(captions.size());
+    printer.print_separator(context);
+    printer.print_record(captions, context);
+    printer.print_separator(context);
+    std::vector<std::string> index_names;
+    for (auto &entry : ihs_) {
+        index_names.push_back(entry.first);
+    }
+    std::sort(index_names.begin(), index_names.end());
+    for (auto &name : index_names) {
+        IxIndexStats stats = ihs_.at(name)->GetStats();
+        char avg_depth[16];
+        snprintf(avg_depth, sizeof(avg_depth), "%.2f", stats.AvgDescentDepth());
+        printer.print_record({name, std::to_string(stats.height), std::to_string(stats.descents), avg_depth,
+                              std::to_string(stats.pinned_pages), std::to_string(stats.pinned_hits),
+                              std::to_string(stats.splits), std::to_string(stats.merges),
+                              std::to_string(stats.redistributions)},
+                             context);
+    }
+    printer.print_separator(context);
+}
+
 //*****************************
 //三种回滚操作，即恢复初始状态，lab4补充
 //*****************************
@@ -231,9 +396,10 @@ void SmManager::rollback_insert(const std::string &tab_name, const Rid &rid, Con
     auto tab = db_.get_table(tab_name);
     auto rec = fhs_.at(tab_name).get()->get_record(rid, context);
     // delete entry
-    for (size_t i=0; i<tab.cols.size(); i++){
-        if (tab.cols[i].index)
-            ihs_.at(get_ix_manager()->get_index_name(tab_name, i)).get()->delete_entry(rec->data+tab.cols[i].offset, nullptr);
+    for (auto &index : tab.indexes) {
+        std::vector<char> key(index.col_tot_len);
+        tab.get_index_key(index, rec->data, key.data());
+        get_index_handle(tab_name, index)->delete_entry(key.data(), rid, nullptr);
     }
     // delete record
     fhs_.at(tab_name).get()->delete_record(rid, context);
@@ -245,9 +411,10 @@ void SmManager::rollback_delete(const std::string &tab_name, const RmRecord &rec
     // insert record
     auto rid = fhs_.at(tab_name).get()->insert_record(record.data, context);
     // insert entry
-    for (size_t i=0; i<tab.cols.size(); i++){
-        if (tab.cols[i].index)
-            ihs_.at(get_ix_manager()->get_index_name(tab_name, i)).get()->insert_entry(record.data+tab.cols[i].offset, rid, context->txn_);
+    for (auto &index : tab.indexes) {
+        std::vector<char> key(index.col_tot_len);
+        tab.get_index_key(index, record.data, key.data());
+        get_index_handle(tab_name, index)->insert_entry(key.data(), rid, context->txn_);
     }
 }
 
@@ -256,15 +423,17 @@ void SmManager::rollback_update(const std::string &tab_name, const Rid &rid, con
     auto tab = db_.get_table(tab_name);
     auto rec = fhs_.at(tab_name).get()->get_record(rid, context);
     // delete entry
-    for (size_t i=0; i<tab.cols.size(); i++){
-        if (tab.cols[i].index)
-            ihs_.at(get_ix_manager()->get_index_name(tab_name, i)).get()->delete_entry(rec->data+tab.cols[i].offset, nullptr);
+    for (auto &index : tab.indexes) {
+        std::vector<char> key(index.col_tot_len);
+        tab.get_index_key(index, rec->data, key.data());
+        get_index_handle(tab_name, index)->delete_entry(key.data(), rid, nullptr);
     }
     // update record
     fhs_.at(tab_name).get()->update_record(rid, record.data, context);
     // insert entry
-    for (size_t i=0; i<tab.cols.size(); i++){
-        if (tab.cols[i].index)
-            ihs_.at(get_ix_manager()->get_index_name(tab_name, i)).get()->insert_entry(record.data+tab.cols[i].offset, rid, context->txn_);
+    for (auto &index : tab.indexes) {
+        std::vector<char> key(index.col_tot_len);
+        tab.get_index_key(index, record.data, key.data());
+        get_index_handle(tab_name, index)->insert_entry(key.data(), rid, context->txn_);
     }
 }
\ No newline at end of file
@@ -60,6 +60,8 @@ class SmManager {
 
     BufferPoolManager *get_bpm() { return buffer_pool_manager_; }
 
+    DiskManager *get_disk_manager() { return disk_manager_; }  // called in some excutors to spill tuples to disk
+
     // Database management
     bool is_dir(const std::string &db_name);
 
@@ -85,10 +87,41 @@ class SmManager {
     // Index management
     void create_index(const std::string &tab_name, const std::string &col_name, Context *context);
 
+    /**
+     * @brief 在col_names中的列上创建索引, 多列时key为各列按col_names的顺序拼接, 按字典序比较
+     */
+    void create_index(const std::string &tab_name, const std::vector<std::string> &col_names, Context *context);
+
     void drop_index(const std::string &tab_name, const std::string &col_name, Context *context);
 
+    void drop_index(const std::string &tab_name, const std::vector<std::string> &col_names, Context *context);
+
+    /** @return 表tab_name上的索引index的句柄 */
+    IxIndexHandle *get_index_handle(const std::string &tab_name, const IndexMeta &index) {
+        return ihs_.at(ix_manager_->get_index_name(tab_name, index.col_idxs)).get();
+    }
+
     void apply_drop_index(const std::string &tab_name, const std::string &col_name, Context *context);
 
+    // Space management
+    void vacuum_table(const std::string &tab_name, Context *context);
+
+    // Statistics
+    /**
+     * @brief 按文件打印缓冲池和磁盘I/O统计, 并把同样的数据写入数据库目录下的BUFFER_STATS_FILE_NAME
+     */
+    void show_buffer_stats(Context *context);
+
+    /**
+     * @brief 以JSON Lines格式输出每个已打开的表文件和索引文件的统计, 每行一个文件
+     */
+    void dump_buffer_stats(std::ostream &os);
+
+    /**
+     * @brief 打印每个已打开索引的树高、平均下降深度、常驻上层结点和分裂/合并/重分配次数
+     */
+    void show_index_stats(Context *context);
+
     // Transaction rollback management
     /**
      * @brief rollback the insert operation
@@ -147,4 +180,11 @@ class SmManager {
      * @param col_name the name of the column on which index is created
      */
     void rollback_drop_index(const std::string &tab_name, const std::string &col_name, Context *context);
+
+   private:
+    /** @return col_names中各列在表tab中的位置 */
+    std::vector<int> get_index_cols(TabMeta &tab, const std::vector<std::string> &col_names);
+
+    /** @return 所有已打开的表文件和索引文件, (文件名, fd)按文件名排序 */
+    std::vector<std::pair<std::string, int>> get_open_files();
 };
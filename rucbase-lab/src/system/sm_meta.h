@@ -1,6 +1,7 @@
 #pragma once
 
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <map>
 #include <string>
@@ -15,7 +16,7 @@ struct ColMeta {
     ColType type;          // 字段类型
     int len;               // 字段长度
     int offset;            // 字段位于记录中的偏移量
-    bool index;            // 该字段上是否建立索引
+    bool index;            // 该字段上是否建立单列索引
 
     friend std::ostream &operator<<(std::ostream &os, const ColMeta &col) {
         // ColMeta中有各个基本类型的变量，然后调用重载的这些变量的操作符<<（具体实现逻辑在defs.h）
@@ -28,9 +29,36 @@ struct ColMeta {
     }
 };
 
+/**
+ * @brief 表上的一个索引, 索引的key由cols中的若干列按col_idxs的顺序拼接而成, 单列索引只有一列
+ */
+struct IndexMeta {
+    std::vector<int> col_idxs;  // 索引列在TabMeta::cols中的位置
+    int col_tot_len;            // key的总长度
+
+    friend std::ostream &operator<<(std::ostream &os, const IndexMeta &index) {
+        os << index.col_idxs.size();
+        for (int col_idx : index.col_idxs) {
+            os << ' ' << col_idx;
+        }
+        return os << ' ' << index.col_tot_len;
+    }
+
+    friend std::istream &operator>>(std::istream &is, IndexMeta &index) {
+        size_t n;
+        is >> n;
+        index.col_idxs.resize(n);
+        for (auto &col_idx : index.col_idxs) {
+            is >> col_idx;
+        }
+        return is >> index.col_tot_len;
+    }
+};
+
 struct TabMeta {
     std::string name;
     std::vector<ColMeta> cols;
+    std::vector<IndexMeta> indexes;  // 表上的所有索引, 包括单列索引
 
     /**
      * @brief 根据列名在本表元数据结构体中查找是否有该名字的列
@@ -67,11 +95,35 @@ struct TabMeta {
         // lab3 task1 Todo End
     }
 
+    /**
+     * @brief 查找由col_idxs中的列(按顺序)组成的索引
+     *
+     * @return 索引的元数据, 没有这个索引时返回indexes.end()
+     */
+    std::vector<IndexMeta>::iterator find_index(const std::vector<int> &col_idxs) {
+        return std::find_if(indexes.begin(), indexes.end(),
+                            [&](const IndexMeta &index) { return index.col_idxs == col_idxs; });
+    }
+
+    /**
+     * @brief 从记录rec中取出索引的各列, 拼接成索引的key写入key(长度为index.col_tot_len)
+     */
+    void get_index_key(const IndexMeta &index, const char *rec, char *key) const {
+        for (int col_idx : index.col_idxs) {
+            memcpy(key, rec + cols[col_idx].offset, cols[col_idx].len);
+            key += cols[col_idx].len;
+        }
+    }
+
     friend std::ostream &operator<<(std::ostream &os, const TabMeta &tab) {
         os << tab.name << '\n' << tab.cols.size() << '\n';
         for (auto &col : tab.cols) {
             os << col << '\n';  // col是ColMeta类型，然后调用重载的ColMeta的操作符<<
         }
+        os << tab.indexes.size() << '\n';
+        for (auto &index : tab.indexes) {
+            os << index << '\n';
+        }
         return os;
     }
 
@@ -83,6 +135,12 @@ struct TabMeta {
             is >> col;
             tab.cols.push_back(col);
         }
+        is >> n;
+        for (size_t i = 0; i < n; i++) {
+            IndexMeta index;
+            is >> index;
+            tab.indexes.push_back(index);
+        }
         return is;
     }
 };